@@ -0,0 +1,12 @@
+package java.lang;
+
+import java.lang.String;
+
+public class StackOverflowError extends Throwable {
+    public StackOverflowError() {
+        super();
+    }
+    public StackOverflowError(String str) {
+        super(str);
+    }
+}
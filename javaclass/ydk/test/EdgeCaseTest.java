@@ -0,0 +1,170 @@
+package ydk.test;
+
+import ydk.lang.IO;
+
+public class EdgeCaseTest {
+    static class Counter {
+        int value;
+    }
+
+    static class Base {
+    }
+
+    static class Derived extends Base {
+    }
+
+    static class Leaf extends Derived {
+    }
+
+    static class Unused {
+    }
+
+    static void check(String name, int actual) {
+        IO.print(name);
+        IO.print(' ');
+        IO.print(actual);
+        IO.print('\n');
+    }
+
+    static int add(int a, int b) { return a + b; }
+    static int sub(int a, int b) { return a - b; }
+    static int mul(int a, int b) { return a * b; }
+    static int neg(int a) { return -a; }
+    static int inc(int a) { a += 1; return a; }
+
+    static int shl(int a, int s) { return a << s; }
+    static int shr(int a, int s) { return a >> s; }
+    static int ushr(int a, int s) { return a >>> s; }
+    static long lshl(long a, int s) { return a << s; }
+
+    static int fcmp(float a, float b) {
+        if (a < b) return -1;
+        if (a > b) return 1;
+        if (a == b) return 0;
+        return 2;
+    }
+
+    static int dcmp(double a, double b) {
+        if (a < b) return -1;
+        if (a > b) return 1;
+        if (a == b) return 0;
+        return 2;
+    }
+
+    static int f2i(float f) { return (int) f; }
+    static int d2i(double d) { return (int) d; }
+    static int i2c(int v) { return (char) v; }
+    static int div(int a, int b) { return a / b; }
+    static int rem(int a, int b) { return a % b; }
+
+    // Switches at different offsets get different alignment padding
+    static int table(int v) {
+        switch (v) {
+            case 1: return 10;
+            case 2: return 20;
+            case 3: return 30;
+            default: return -1;
+        }
+    }
+
+    static int tableNeg(int v) {
+        switch (-v) {
+            case 1: return 10;
+            case 2: return 20;
+            case 3: return 30;
+            default: return -1;
+        }
+    }
+
+    static int tableSum(int a, int b) {
+        switch (a + b) {
+            case 1: return 10;
+            case 2: return 20;
+            case 3: return 30;
+            default: return -1;
+        }
+    }
+
+    static int lookup(int v) {
+        switch (v) {
+            case -1000: return 1;
+            case 1000: return 2;
+            case 100000: return 3;
+            default: return 0;
+        }
+    }
+
+    static int lookupSum(int a, int b) {
+        switch (a + b) {
+            case -1000: return 1;
+            case 1000: return 2;
+            case 100000: return 3;
+            default: return 0;
+        }
+    }
+
+    // Fields of an object must survive synchronizing on it
+    static int locked(Counter c, int n) {
+        synchronized (c) {
+            synchronized (c) {
+                c.value += n;
+            }
+        }
+        return c.value;
+    }
+
+    static int isBase(Object o) { return o instanceof Base ? 1 : 0; }
+    static int isDerived(Object o) { return o instanceof Derived ? 1 : 0; }
+    static int isUnused(Object o) { return o instanceof Unused ? 1 : 0; }
+
+    public static void main(String[] args) {
+        check("iadd", add(0x7fffffff, 1));
+        check("isub", sub(0x80000000, 1));
+        check("imul", mul(0x10000, 0x10000));
+        check("ineg", neg(0x80000000));
+        check("iinc", inc(0x7fffffff));
+
+        check("ishl", shl(1, 33));
+        check("ishr", shr(-16, 34));
+        check("iushr", ushr(-1, 33));
+        check("lshl", (int) lshl(1L, 65));
+
+        check("fcmpLess", fcmp(1.0f, 2.0f));
+        check("fcmpNaN", fcmp(0.0f / 0.0f, 1.0f));
+        check("fcmpNaN", fcmp(1.0f, 0.0f / 0.0f));
+        check("dcmpGreater", dcmp(2.0, 1.0));
+        check("dcmpNaN", dcmp(0.0 / 0.0, 1.0));
+        check("dcmpNaN", dcmp(1.0, 0.0 / 0.0));
+
+        check("f2iMax", f2i(1e20f));
+        check("f2iMin", f2i(-1e20f));
+        check("f2iNaN", f2i(0.0f / 0.0f));
+        check("d2iMax", d2i(1e300));
+        check("d2iMin", d2i(-1e300));
+        check("d2iNaN", d2i(0.0 / 0.0));
+
+        check("i2c", i2c(-1));
+        check("idiv", div(0x80000000, -1));
+        check("irem", rem(0x80000000, -1));
+
+        check("table", table(2));
+        check("tableDefault", table(5));
+        check("tableNeg", tableNeg(-3));
+        check("tableSum", tableSum(1, 0));
+        check("lookup", lookup(-1000));
+        check("lookup", lookup(100000));
+        check("lookupDefault", lookup(7));
+        check("lookupSum", lookupSum(999, 1));
+
+        Counter c = new Counter();
+        c.value = 5;
+        check("monitor", locked(c, 2));
+        check("monitor", locked(c, 3));
+
+        check("instanceofBase", isBase(new Derived()));
+        check("instanceofDerived", isDerived(new Base()));
+        check("instanceofNull", isBase(null));
+        check("instanceofLeaf", isBase(new Leaf()));
+        check("instanceofUnloaded", isUnused(new Base()));
+    }
+}
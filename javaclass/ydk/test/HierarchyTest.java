@@ -0,0 +1,42 @@
+package ydk.test;
+
+import ydk.lang.IO;
+
+public class HierarchyTest {
+    static class Shape {
+        int sides() { return 0; }
+    }
+
+    static class Square extends Shape {
+        int sides() { return 4; }
+    }
+
+    static void check(String name, int actual) {
+        IO.print(name);
+        IO.print(' ');
+        IO.print(actual);
+        IO.print('\n');
+    }
+
+    // No loaded class overrides sides() until Square is, which happens while
+    // the loop still runs, both of its iterations invoke sides() at one site
+    static int count(Shape s, boolean square) {
+        int total = 0;
+        for (int i = 0; i < 2; i++) {
+            total = total * 10 + s.sides();
+            if (square) {
+                s = new Square();
+            }
+        }
+        return total;
+    }
+
+    public static void main(String[] args) {
+        check("bound", count(new Shape(), false));
+        check("bound", count(new Shape(), false));
+        check("overridden", count(new Shape(), true));
+        check("recompiled", count(new Square(), false));
+        check("recompiled", count(new Square(), false));
+        check("recompiled", count(new Shape(), false));
+    }
+}
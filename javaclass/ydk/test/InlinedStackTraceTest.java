@@ -0,0 +1,23 @@
+package ydk.test;
+
+public class InlinedStackTraceTest {
+    static int check(int v) throws WithReasonException {
+        if (v == 2) {
+            throw new WithReasonException("Thrown while inlined twice");
+        }
+        return v;
+    }
+
+    // Both run straight through, so they're inlined into hot() one into
+    // the other, only check() is actually invoked
+    static int step(int v) throws WithReasonException { return check(v) + 1; }
+    static int scale(int v) throws WithReasonException { return step(v) * 2; }
+
+    static int hot(int v) throws WithReasonException { return scale(v) - 1; }
+
+    public static void main(String[] args) throws WithReasonException {
+        for (int i = 0; i < 3; i++) {
+            hot(i);
+        }
+    }
+}
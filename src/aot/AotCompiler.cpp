@@ -0,0 +1,696 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "../interpreter/Decoder.h"
+#include "../runtime/JavaClass.h"
+#include "AotCompiler.h"
+#include "AotRuntime.h"
+
+using namespace std;
+
+static const char* const conditions[] = {"==", "!=", "<", ">=", ">", "<="};
+static const char* const arithmetics[] = {"+", "-", "*", "/"};
+
+// Union member holding a value of given tag, nullptr for the second half of
+// a long or double
+static const char* member(SlotTag tag) {
+    switch (tag) {
+        case SlotTag::Int:
+            return "i";
+        case SlotTag::Float:
+            return "f";
+        case SlotTag::Long:
+            return "j";
+        case SlotTag::Double:
+            return "d";
+        case SlotTag::Ref:
+            return "ref";
+        default:
+            return nullptr;
+    }
+}
+
+static const char* tagName(SlotTag tag) {
+    static const char* const names[] = {"AotTop",  "AotInt",    "AotFloat",
+                                        "AotLong", "AotDouble", "AotRef"};
+    return names[static_cast<int>(tag)];
+}
+
+static string stackSlot(size_t slot) { return "S[" + to_string(slot) + "]"; }
+
+static string localSlot(size_t slot) { return "L[" + to_string(slot) + "]"; }
+
+static string label(int32_t index) { return "I" + to_string(index); }
+
+// Class and method names may hold any character but a NUL
+static string quote(const string& str) {
+    string result = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\' || c == '?') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20 ||
+                   static_cast<unsigned char>(c) >= 0x7f) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\%03o",
+                     static_cast<unsigned char>(c));
+            result += escaped;
+        } else {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+static uint64_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static uint64_t doubleBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Slots taken by the value a load or store of local variable copies
+static size_t slotCount(u1 opcode) {
+    switch (opcode) {
+        case op_lload:
+        case op_dload:
+        case op_lstore:
+        case op_dstore:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+// Java integer arithmetic wraps around, so it's done on unsigned values
+static string wrapping(bool wide, const string& lhs, const char* op,
+                       const string& rhs) {
+    const char* type = wide ? "int64_t" : "int32_t";
+    const char* unsignedType = wide ? "uint64_t" : "uint32_t";
+    return string("(") + type + ")((" + unsignedType + ")" + lhs + " " + op +
+           " (" + unsignedType + ")" + rhs + ")";
+}
+
+int AotCompiler::compileClass(const JavaClass* jc) {
+    this->jc = jc;
+    int count = 0;
+    FOR_EACH(k, jc->raw.methodsCount) {
+        MethodInfo* m = &jc->raw.methods[k];
+        if (m->exec.code != nullptr && compileMethod(m)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool AotCompiler::compileMethod(MethodInfo* m) {
+    decoded = decodeMethod(m, m->exec.code);
+    vector<TypeState> typeStates;
+    if (!decoded->exceptionTable.empty() ||
+        !inferTypes(jc, m, decoded, typeStates)) {
+        return false;
+    }
+    states = &typeStates;
+
+    // Only branch targets get labels
+    const size_t n = decoded->code.size();
+    vector<bool> targets(n, false);
+    for (size_t i = 0; i < n; i++) {
+        const Instruction& insn = decoded->code[i];
+        const u1 opcode = originalOpcode(loadOpcode(&insn));
+        if (!typeStates[i].reached) {
+            continue;
+        }
+        if ((opcode >= op_ifeq && opcode <= op_goto) || opcode == op_ifnull ||
+            opcode == op_ifnonnull) {
+            targets[insn.operand] = true;
+        } else if (opcode == op_tableswitch || opcode == op_lookupswitch) {
+            const int32_t* table = decoded->switchTables.data() + insn.operand;
+            const int32_t count = opcode == op_tableswitch
+                                      ? table[2] - table[1] + 1
+                                      : table[1];
+            targets[table[0]] = true;
+            for (int32_t k = 0; k < count; k++) {
+                targets[opcode == op_tableswitch ? table[3 + k]
+                                                 : table[3 + 2 * k]] = true;
+            }
+        }
+    }
+
+    const string name = jc->getString(m->nameIndex);
+    const string descriptor = jc->getString(m->descriptorIndex);
+    const string function = "m" + to_string(methodCount);
+    body.str("");
+    body << "\n// " << jc->getClassName() << "." << name << descriptor << "\n"
+         << "static AotSlot* " << function
+         << "(JitContext* ctx, AotSlot* L, AotSlot*) {\n"
+         << "    // Operand stack lies right above local variables\n"
+         << "    AotSlot* const S = L + " << m->exec.maxLocal << ";\n";
+    for (size_t i = 0; i < n; i++) {
+        if (!typeStates[i].reached) {
+            continue;
+        }
+        if (targets[i]) {
+            body << label(static_cast<int32_t>(i)) << ":\n";
+        }
+        if (!emitInstruction(static_cast<u4>(i), typeStates[i].stack.size())) {
+            return false;
+        }
+    }
+    body << "}\n";
+
+    functions << body.str();
+    table << "    {" << quote(jc->getClassName()) << ", " << quote(name)
+          << ", " << quote(descriptor) << ", 0x" << hex
+          << codeFingerprint(m, decoded) << dec << "ULL, " << function
+          << "},\n";
+    methodCount++;
+    return true;
+}
+
+string AotCompiler::source() const {
+    ostringstream out;
+    out << "// Generated by yvm-aot, do not edit\n"
+        << "#include \"aot/AotRuntime.h\"\n\n"
+        << "static const AotHelpers* rt;\n"
+        << functions.str() << "\n";
+    if (methodCount > 0) {
+        out << "static const AotMethod methods[] = {\n"
+            << table.str() << "};\n";
+    } else {
+        out << "static const AotMethod* const methods = nullptr;\n";
+    }
+    out << "\nextern \"C\" const AotModule* " << YVM_AOT_MODULE_SYMBOL
+        << "(const AotHelpers* helpers) {\n"
+        << "    static const AotModule module{YVM_AOT_ABI_VERSION, "
+        << methodCount << ", methods};\n"
+        << "    rt = helpers;\n"
+        << "    return &module;\n"
+        << "}\n";
+    return out.str();
+}
+
+void AotCompiler::emitConstant(size_t slot, uint64_t bits, SlotTag tag) {
+    const string dst = stackSlot(slot);
+    if (tag == SlotTag::Long || tag == SlotTag::Double) {
+        body << "    " << dst << ".j = (int64_t)0x" << hex << bits << dec
+             << "ULL;\n";
+        body << "    " << stackSlot(slot + 1) << ".tag = AotTop;\n";
+    } else if (tag == SlotTag::Ref) {
+        body << "    " << dst << ".ref = nullptr;\n";
+    } else {
+        body << "    " << dst << ".i = (int32_t)0x" << hex << bits << dec
+             << "u;\n";
+    }
+    body << "    " << dst << ".tag = " << tagName(tag) << ";\n";
+}
+
+void AotCompiler::emitCopy(const string& dst, const string& src, SlotTag tag) {
+    // The second half of a long or double holds nothing but its tag
+    if (member(tag) != nullptr) {
+        body << "    " << dst << "." << member(tag) << " = " << src << "."
+             << member(tag) << ";\n";
+    }
+    body << "    " << dst << ".tag = " << tagName(tag) << ";\n";
+}
+
+void AotCompiler::emitShuffle(size_t depth, size_t popped,
+                              const char* pushed) {
+    // Popped slots are copied into t0, t1... from the deepest one, each digit
+    // of pushed names the slot to be pushed
+    const size_t base = depth - popped;
+    body << "    {\n";
+    FOR_EACH(k, popped) {
+        body << "        AotSlot t" << k << " = " << stackSlot(base + k)
+             << ";\n";
+    }
+    for (size_t k = 0; pushed[k] != '\0'; k++) {
+        body << "        " << stackSlot(base + k) << " = t" << pushed[k]
+             << ";\n";
+    }
+    body << "    }\n";
+}
+
+void AotCompiler::emitSlowPath(u4 i, size_t depth) {
+    body << "    if (!rt->slowPath(ctx, S + " << depth << ", " << i
+         << ")) return nullptr;\n";
+}
+
+void AotCompiler::emitBranch(const string& condition, int32_t target) {
+    body << "    if (" << condition << ") goto " << label(target) << ";\n";
+}
+
+bool AotCompiler::emitInstruction(u4 i, size_t depth) {
+    const Instruction& insn = decoded->code[i];
+    const TypeState& state = (*states)[i];
+    const ConstantPool& cp = jc->getConstPool();
+    const size_t d = depth;
+    const u1 opcode = originalOpcode(loadOpcode(&insn));
+
+    switch (opcode) {
+        case op_nop:
+        case op_pop:
+        case op_pop2:
+            break;
+        case op_aconst_null:
+            emitConstant(d, 0, SlotTag::Ref);
+            break;
+        case op_bipush:
+        case op_sipush:
+            emitConstant(d, static_cast<uint32_t>(insn.operand), SlotTag::Int);
+            break;
+        case op_lconst_0:
+        case op_lconst_1:
+            emitConstant(d, opcode - op_lconst_0, SlotTag::Long);
+            break;
+        case op_fconst_0:
+        case op_fconst_1:
+        case op_fconst_2:
+            emitConstant(d, floatBits(static_cast<float>(opcode - op_fconst_0)),
+                         SlotTag::Float);
+            break;
+        case op_dconst_0:
+        case op_dconst_1:
+            emitConstant(d,
+                         doubleBits(static_cast<double>(opcode - op_dconst_0)),
+                         SlotTag::Double);
+            break;
+        case op_ldc:
+            // Strings are created at runtime
+            if (cp.is(insn.index, TAG_Integer)) {
+                emitConstant(d, static_cast<uint32_t>(cp.intValue(insn.index)),
+                             SlotTag::Int);
+            } else if (cp.is(insn.index, TAG_Float)) {
+                emitConstant(d, floatBits(cp.floatValue(insn.index)),
+                             SlotTag::Float);
+            } else {
+                emitSlowPath(i, d);
+            }
+            break;
+        case op_ldc2_w:
+            if (cp.is(insn.index, TAG_Long)) {
+                emitConstant(d, static_cast<uint64_t>(cp.longValue(insn.index)),
+                             SlotTag::Long);
+            } else if (cp.is(insn.index, TAG_Double)) {
+                emitConstant(d, doubleBits(cp.doubleValue(insn.index)),
+                             SlotTag::Double);
+            } else {
+                return false;
+            }
+            break;
+
+        // Local variables are copied with their inferred tags
+        case op_iload:
+        case op_fload:
+        case op_aload:
+        case op_lload:
+        case op_dload:
+            FOR_EACH(k, slotCount(opcode)) {
+                emitCopy(stackSlot(d + k), localSlot(insn.index + k),
+                         state.locals[insn.index + k]);
+            }
+            break;
+        case op_istore:
+        case op_fstore:
+        case op_astore:
+        case op_lstore:
+        case op_dstore: {
+            const size_t n = slotCount(opcode);
+            for (size_t k = 0; k < n; k++) {
+                emitCopy(localSlot(insn.index + k), stackSlot(d - n + k),
+                         state.stack[d - n + k]);
+            }
+            break;
+        }
+        case op_iinc: {
+            const string local = localSlot(insn.index) + ".i";
+            body << "    " << local << " = "
+                 << wrapping(false, local, "+",
+                             to_string(insn.operand))
+                 << ";\n";
+            break;
+        }
+
+        // Stack manipulations move whole slots with their tags
+        case op_dup:
+            emitShuffle(d, 1, "00");
+            break;
+        case op_dup_x1:
+            emitShuffle(d, 2, "101");
+            break;
+        case op_dup_x2:
+            emitShuffle(d, 3, "2012");
+            break;
+        case op_dup2:
+            emitShuffle(d, 2, "0101");
+            break;
+        case op_dup2_x1:
+            emitShuffle(d, 3, "12012");
+            break;
+        case op_dup2_x2:
+            emitShuffle(d, 4, "230123");
+            break;
+        case op_swap:
+            emitShuffle(d, 2, "10");
+            break;
+
+        // Integer arithmetic, results overwrite the first operand in place
+        case op_iadd:
+        case op_isub:
+        case op_imul:
+        case op_iand:
+        case op_ior:
+        case op_ixor:
+        case op_ladd:
+        case op_lsub:
+        case op_lmul:
+        case op_land:
+        case op_lor:
+        case op_lxor: {
+            const char* op = "^";
+            if (opcode == op_iadd || opcode == op_ladd) {
+                op = "+";
+            } else if (opcode == op_isub || opcode == op_lsub) {
+                op = "-";
+            } else if (opcode == op_imul || opcode == op_lmul) {
+                op = "*";
+            } else if (opcode == op_iand || opcode == op_land) {
+                op = "&";
+            } else if (opcode == op_ior || opcode == op_lor) {
+                op = "|";
+            }
+            // Long variant of each operation follows its int variant
+            const bool wide = (opcode & 1) != 0;
+            const size_t size = wide ? 2 : 1;
+            const char* field = wide ? ".j" : ".i";
+            const string lhs = stackSlot(d - 2 * size) + field;
+            body << "    " << lhs << " = "
+                 << wrapping(wide, lhs, op, stackSlot(d - size) + field)
+                 << ";\n";
+            break;
+        }
+        case op_ineg:
+        case op_lneg: {
+            const bool wide = opcode == op_lneg;
+            const string value = stackSlot(d - (wide ? 2 : 1)) +
+                                 (wide ? ".j" : ".i");
+            body << "    " << value << " = " << wrapping(wide, "0", "-", value)
+                 << ";\n";
+            break;
+        }
+        case op_ishl:
+        case op_ishr:
+        case op_iushr:
+        case op_lshl:
+        case op_lshr:
+        case op_lushr: {
+            const bool wide = (opcode - op_ishl) % 2 != 0;
+            const string value =
+                stackSlot(d - 1 - (wide ? 2 : 1)) + (wide ? ".j" : ".i");
+            const string count = "(" + stackSlot(d - 1) + ".i & " +
+                                 (wide ? "63" : "31") + ")";
+            const char* type = wide ? "int64_t" : "int32_t";
+            const char* unsignedType = wide ? "uint64_t" : "uint32_t";
+            body << "    " << value << " = ";
+            if (opcode == op_ishr || opcode == op_lshr) {
+                body << value << " >> " << count;
+            } else {
+                body << "(" << type << ")((" << unsignedType << ")" << value
+                     << (opcode == op_ishl || opcode == op_lshl ? " << "
+                                                                : " >> ")
+                     << count << ")";
+            }
+            body << ";\n";
+            break;
+        }
+        case op_idiv:
+        case op_irem:
+        case op_ldiv:
+        case op_lrem: {
+            // Division by zero throws from runtime helper, and dividing the
+            // minimum value by -1 must not trap
+            const bool wide = opcode == op_ldiv || opcode == op_lrem;
+            const size_t size = wide ? 2 : 1;
+            const char* field = wide ? ".j" : ".i";
+            const string lhs = stackSlot(d - 2 * size) + field;
+            const string rhs = stackSlot(d - size) + field;
+            body << "    if (" << rhs << " == 0) {\n    ";
+            emitSlowPath(i, d);
+            body << "    } else {\n        " << lhs << " = " << rhs
+                 << " == -1 ? ";
+            if (opcode == op_idiv || opcode == op_ldiv) {
+                body << wrapping(wide, "0", "-", lhs) << " : " << lhs << " / "
+                     << rhs;
+            } else {
+                body << "0 : " << lhs << " % " << rhs;
+            }
+            body << ";\n    }\n";
+            break;
+        }
+        case op_lcmp:
+            body << "    " << stackSlot(d - 4) << ".i = " << stackSlot(d - 4)
+                 << ".j > " << stackSlot(d - 2) << ".j ? 1 : "
+                 << stackSlot(d - 4) << ".j < " << stackSlot(d - 2)
+                 << ".j ? -1 : 0;\n";
+            body << "    " << stackSlot(d - 4) << ".tag = AotInt;\n";
+            break;
+
+        // Floating-point arithmetic except remainders
+        case op_fadd:
+        case op_fsub:
+        case op_fmul:
+        case op_fdiv:
+            body << "    " << stackSlot(d - 2) << ".f = " << stackSlot(d - 2)
+                 << ".f " << arithmetics[(opcode - op_fadd) / 4] << " "
+                 << stackSlot(d - 1) << ".f;\n";
+            break;
+        case op_dadd:
+        case op_dsub:
+        case op_dmul:
+        case op_ddiv:
+            body << "    " << stackSlot(d - 4) << ".d = " << stackSlot(d - 4)
+                 << ".d " << arithmetics[(opcode - op_dadd) / 4] << " "
+                 << stackSlot(d - 2) << ".d;\n";
+            break;
+        case op_fneg:
+            body << "    " << stackSlot(d - 1) << ".f = -" << stackSlot(d - 1)
+                 << ".f;\n";
+            break;
+        case op_dneg:
+            body << "    " << stackSlot(d - 2) << ".d = -" << stackSlot(d - 2)
+                 << ".d;\n";
+            break;
+        case op_fcmpl:
+        case op_fcmpg:
+        case op_dcmpl:
+        case op_dcmpg: {
+            // Comparisons with NaN give 1 for fcmpg/dcmpg and -1 otherwise
+            const bool wide = opcode == op_dcmpl || opcode == op_dcmpg;
+            const size_t size = wide ? 2 : 1;
+            const char* field = wide ? ".d" : ".f";
+            body << "    {\n        " << (wide ? "double" : "float")
+                 << " a = " << stackSlot(d - 2 * size) << field
+                 << ", b = " << stackSlot(d - size) << field << ";\n"
+                 << "        " << stackSlot(d - 2 * size)
+                 << ".i = a > b ? 1 : a == b ? 0 : a < b ? -1 : "
+                 << (opcode == op_fcmpg || opcode == op_dcmpg ? "1" : "-1")
+                 << ";\n    }\n";
+            body << "    " << stackSlot(d - 2 * size) << ".tag = AotInt;\n";
+            break;
+        }
+
+        // Conversions, narrowing floating-point values saturates and NaN
+        // becomes 0
+        case op_i2l:
+            body << "    " << stackSlot(d - 1) << ".j = " << stackSlot(d - 1)
+                 << ".i;\n";
+            body << "    " << stackSlot(d - 1) << ".tag = AotLong;\n";
+            body << "    " << stackSlot(d) << ".tag = AotTop;\n";
+            break;
+        case op_l2i:
+            body << "    " << stackSlot(d - 2) << ".i = (int32_t)"
+                 << stackSlot(d - 2) << ".j;\n";
+            body << "    " << stackSlot(d - 2) << ".tag = AotInt;\n";
+            break;
+        case op_i2b:
+        case op_i2c:
+        case op_i2s:
+            body << "    " << stackSlot(d - 1) << ".i = "
+                 << (opcode == op_i2b
+                         ? "(int8_t)"
+                         : opcode == op_i2c ? "(uint16_t)" : "(int16_t)")
+                 << stackSlot(d - 1) << ".i;\n";
+            break;
+        case op_i2f:
+        case op_l2f:
+        case op_i2d:
+        case op_l2d:
+        case op_f2d:
+        case op_d2f: {
+            const bool wide =
+                opcode == op_l2f || opcode == op_l2d || opcode == op_d2f;
+            const bool toDouble =
+                opcode == op_i2d || opcode == op_l2d || opcode == op_f2d;
+            const size_t slot = d - (wide ? 2 : 1);
+            const char* from = opcode == op_i2f || opcode == op_i2d
+                                   ? ".i"
+                                   : opcode == op_f2d
+                                         ? ".f"
+                                         : opcode == op_d2f ? ".d" : ".j";
+            body << "    " << stackSlot(slot) << (toDouble ? ".d" : ".f")
+                 << " = (" << (toDouble ? "double" : "float") << ")"
+                 << stackSlot(slot) << from << ";\n";
+            body << "    " << stackSlot(slot) << ".tag = "
+                 << (toDouble ? "AotDouble" : "AotFloat") << ";\n";
+            if (toDouble && !wide) {
+                body << "    " << stackSlot(slot + 1) << ".tag = AotTop;\n";
+            }
+            break;
+        }
+        case op_f2i:
+        case op_f2l:
+        case op_d2i:
+        case op_d2l: {
+            const bool fromDouble = opcode == op_d2i || opcode == op_d2l;
+            const bool toLong = opcode == op_f2l || opcode == op_d2l;
+            const size_t slot = d - (fromDouble ? 2 : 1);
+            const char* limit = toLong ? "9223372036854775808.0"
+                                       : "2147483648.0";
+            const char* suffix = fromDouble ? "" : "f";
+            const char* bits = toLong ? "64" : "32";
+            body << "    {\n        " << (fromDouble ? "double" : "float")
+                 << " v = " << stackSlot(slot) << (fromDouble ? ".d" : ".f")
+                 << ";\n        " << stackSlot(slot) << (toLong ? ".j" : ".i")
+                 << " = v != v ? 0 : v >= " << limit << suffix << " ? INT"
+                 << bits << "_MAX : v <= -" << limit << suffix << " ? INT"
+                 << bits << "_MIN : (int" << bits << "_t)v;\n    }\n";
+            body << "    " << stackSlot(slot) << ".tag = "
+                 << (toLong ? "AotLong" : "AotInt") << ";\n";
+            if (toLong && !fromDouble) {
+                body << "    " << stackSlot(slot + 1) << ".tag = AotTop;\n";
+            }
+            break;
+        }
+
+        // Branches
+        case op_ifeq:
+        case op_ifne:
+        case op_iflt:
+        case op_ifge:
+        case op_ifgt:
+        case op_ifle:
+            emitBranch(stackSlot(d - 1) + ".i " + conditions[opcode - op_ifeq] +
+                           " 0",
+                       insn.operand);
+            break;
+        case op_if_icmpeq:
+        case op_if_icmpne:
+        case op_if_icmplt:
+        case op_if_icmpge:
+        case op_if_icmpgt:
+        case op_if_icmple:
+            emitBranch(stackSlot(d - 2) + ".i " +
+                           conditions[opcode - op_if_icmpeq] + " " +
+                           stackSlot(d - 1) + ".i",
+                       insn.operand);
+            break;
+        case op_ifnull:
+        case op_ifnonnull:
+            emitBranch(stackSlot(d - 1) + ".ref " +
+                           (opcode == op_ifnull ? "==" : "!=") + " nullptr",
+                       insn.operand);
+            break;
+        case op_if_acmpeq:
+        case op_if_acmpne:
+            emitBranch(string(opcode == op_if_acmpeq ? "" : "!") +
+                           "rt->sameReference(" + stackSlot(d - 2) +
+                           ".ref, " + stackSlot(d - 1) + ".ref)",
+                       insn.operand);
+            break;
+        case op_goto:
+            body << "    goto " << label(insn.operand) << ";\n";
+            break;
+        case op_tableswitch:
+        case op_lookupswitch: {
+            const int32_t* table = decoded->switchTables.data() + insn.operand;
+            body << "    switch (" << stackSlot(d - 1) << ".i) {\n";
+            if (opcode == op_tableswitch) {
+                for (int32_t k = 0; k < table[2] - table[1] + 1; k++) {
+                    body << "        case " << table[1] + k << ": goto "
+                         << label(table[3 + k]) << ";\n";
+                }
+            } else {
+                for (int32_t k = 0; k < table[1]; k++) {
+                    body << "        case " << table[2 + 2 * k] << ": goto "
+                         << label(table[3 + 2 * k]) << ";\n";
+                }
+            }
+            body << "        default: goto " << label(table[0]) << ";\n"
+                 << "    }\n";
+            break;
+        }
+
+        // Return value is left in its slot and copied by caller
+        case op_ireturn:
+        case op_freturn:
+        case op_areturn:
+            body << "    return &" << stackSlot(d - 1) << ";\n";
+            break;
+        case op_lreturn:
+        case op_dreturn:
+            body << "    return &" << stackSlot(d - 2) << ";\n";
+            break;
+        case op_return:
+            body << "    return &" << stackSlot(0) << ";\n";
+            break;
+
+        // Instructions calling back into runtime
+        case op_athrow:
+            emitSlowPath(i, d);
+            body << "    return nullptr;\n";
+            break;
+        case op_frem:
+        case op_drem:
+        case op_iaload:
+        case op_laload:
+        case op_faload:
+        case op_daload:
+        case op_aaload:
+        case op_baload:
+        case op_caload:
+        case op_saload:
+        case op_iastore:
+        case op_lastore:
+        case op_fastore:
+        case op_dastore:
+        case op_aastore:
+        case op_bastore:
+        case op_castore:
+        case op_sastore:
+        case op_getstatic:
+        case op_putstatic:
+        case op_getfield:
+        case op_putfield:
+        case op_invokevirtual:
+        case op_invokespecial:
+        case op_invokestatic:
+        case op_invokeinterface:
+        case op_new:
+        case op_newarray:
+        case op_anewarray:
+        case op_arraylength:
+        case op_instanceof:
+            emitSlowPath(i, d);
+            break;
+        default:
+            // jsr/ret, monitors, checkcast, multianewarray and invokedynamic
+            // are left to interpreter as they are by baseline compiler
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef YVM_AOTCOMPILER_H
+#define YVM_AOTCOMPILER_H
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../classfile/ClassFile.h"
+#include "../interpreter/Instruction.h"
+#include "../interpreter/TypeInference.h"
+
+class JavaClass;
+
+//--------------------------------------------------------------------------------
+// Ahead-of-time compiler of yvm-aot. Each method is translated into a C++
+// function that works on its interpreter frame the same way as machine code
+// of TemplateJIT: operand stack depths and slot tags are known from type
+// inference, so every slot is addressed directly, and instructions touching
+// heap, constant pool or other methods call back into the VM through
+// AotHelpers. The host compiler then optimizes the whole method at once.
+// Methods that have exception handlers or instructions neither tier compiles
+// are left to interpreter
+//--------------------------------------------------------------------------------
+class AotCompiler {
+public:
+    // Translate methods of a loaded class, returns how many were translated
+    int compileClass(const JavaClass* jc);
+
+    // Source of a module holding every method translated so far
+    std::string source() const;
+
+private:
+    bool compileMethod(MethodInfo* m);
+    bool emitInstruction(u4 i, size_t depth);
+    void emitConstant(size_t slot, uint64_t bits, SlotTag tag);
+    void emitCopy(const std::string& dst, const std::string& src,
+                  SlotTag tag);
+    void emitShuffle(size_t depth, size_t popped, const char* pushed);
+    void emitSlowPath(u4 i, size_t depth);
+    void emitBranch(const std::string& condition, int32_t target);
+
+    // Methods translated so far, and the entry of each in module table
+    std::ostringstream functions;
+    std::ostringstream table;
+    int methodCount = 0;
+
+    // Method being translated, its body is only kept if every instruction
+    // could be translated
+    const JavaClass* jc = nullptr;
+    const DecodedCode* decoded = nullptr;
+    const std::vector<TypeState>* states = nullptr;
+    std::ostringstream body;
+};
+
+#endif  // YVM_AOTCOMPILER_H
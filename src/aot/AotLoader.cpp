@@ -0,0 +1,88 @@
+#include <dlfcn.h>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include "../interpreter/Decoder.h"
+#include "../jit/TemplateJIT.h"
+#include "../runtime/JavaClass.h"
+#include "../runtime/RuntimeEnv.h"
+#include "AotLoader.h"
+
+using namespace std;
+
+static_assert(sizeof(AotSlot) == sizeof(JValue) &&
+                  offsetof(AotSlot, tag) == offsetof(JValue, tag),
+              "AotSlot must be laid out as JValue");
+static_assert(AotTop == static_cast<int>(SlotTag::Top) &&
+                  AotInt == static_cast<int>(SlotTag::Int) &&
+                  AotFloat == static_cast<int>(SlotTag::Float) &&
+                  AotLong == static_cast<int>(SlotTag::Long) &&
+                  AotDouble == static_cast<int>(SlotTag::Double) &&
+                  AotRef == static_cast<int>(SlotTag::Ref),
+              "AotTag must number slot tags as SlotTag");
+
+// Methods of all loaded modules, keyed by class name, method name and
+// descriptor. Modules are loaded before any method was decoded and never
+// unloaded
+static unordered_map<string, const AotMethod*> aotMethods;
+
+static string methodKey(const string& className, const string& name,
+                        const string& descriptor) {
+    return className + "." + name + descriptor;
+}
+
+void AotLoader::load(const string& path) {
+    // A name without slash would be searched in library paths instead
+    const string file = path.find('/') == string::npos ? "./" + path : path;
+    void* handle = dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        throw runtime_error("can not load " + path + ": " + dlerror());
+    }
+    auto init = reinterpret_cast<AotModuleInit>(
+        dlsym(handle, YVM_AOT_MODULE_SYMBOL));
+    if (init == nullptr) {
+        throw runtime_error(path + " is not a module built by yvm-aot");
+    }
+
+    static const AotHelpers helpers{&AotLoader::slowPath,
+                                    &AotLoader::sameReference};
+    const AotModule* module = init(&helpers);
+    if (module->abiVersion != YVM_AOT_ABI_VERSION) {
+        throw runtime_error(path + " was built for another version of yvm");
+    }
+    FOR_EACH(i, module->methodCount) {
+        const AotMethod& m = module->methods[i];
+        aotMethods[methodKey(m.className, m.name, m.descriptor)] = &m;
+    }
+    yrt.aot = true;
+}
+
+void AotLoader::bind(const MethodInfo* m, DecodedCode* decoded) {
+    const JavaClass* jc = m->exec.jc;
+    auto iter = aotMethods.find(methodKey(jc->getClassName(),
+                                          jc->getString(m->nameIndex),
+                                          jc->getString(m->descriptorIndex)));
+    // A method whose code, frame limits or referenced constants changed since
+    // it was compiled is interpreted
+    if (iter == aotMethods.end() ||
+        iter->second->fingerprint != codeFingerprint(m, decoded)) {
+        return;
+    }
+
+    auto* compiled = new CompiledMethod;
+    compiled->entry = reinterpret_cast<CompiledEntry>(iter->second->entry);
+    compiled->osrEntry = nullptr;
+    decoded->compiled.store(compiled, memory_order_relaxed);
+    // Baseline compiler never replaces it
+    decoded->compileAttempted.store(true, memory_order_relaxed);
+}
+
+bool AotLoader::slowPath(JitContext* ctx, AotSlot* sp, uint32_t index) {
+    return TemplateJIT::slowPath(ctx, reinterpret_cast<JValue*>(sp), index);
+}
+
+bool AotLoader::sameReference(const void* value1, const void* value2) {
+    return TemplateJIT::sameReference(static_cast<const JType*>(value1),
+                                      static_cast<const JType*>(value2));
+}
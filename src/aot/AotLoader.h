@@ -0,0 +1,31 @@
+#ifndef YVM_AOTLOADER_H
+#define YVM_AOTLOADER_H
+
+#include <string>
+#include "../classfile/ClassFile.h"
+#include "../interpreter/Instruction.h"
+#include "AotRuntime.h"
+
+//--------------------------------------------------------------------------------
+// Methods compiled ahead of time by yvm-aot. Shared objects given by --aot are
+// loaded at startup, and their methods are bound when the VM decodes them. A
+// bound method runs the same way as one compiled by TemplateJIT, but it needs
+// no warm-up
+//--------------------------------------------------------------------------------
+class AotLoader {
+public:
+    // Load a shared object, throws runtime_error if it's not a module built
+    // for this VM
+    static void load(const std::string& path);
+
+    // Bind compiled code to a method that was just decoded, if a module has
+    // compiled it from the same instruction stream
+    static void bind(const MethodInfo* m, DecodedCode* decoded);
+
+private:
+    // Runtime helpers called by compiled code
+    static bool slowPath(JitContext* ctx, AotSlot* sp, uint32_t index);
+    static bool sameReference(const void* value1, const void* value2);
+};
+
+#endif  // YVM_AOTLOADER_H
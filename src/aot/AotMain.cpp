@@ -0,0 +1,102 @@
+#include <boost/program_options.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include "../runtime/JavaClass.h"
+#include "../runtime/MethodArea.h"
+#include "../runtime/RuntimeEnv.h"
+#include "AotCompiler.h"
+
+// Generated sources include "aot/AotRuntime.h" from here
+#ifndef YVM_AOT_INCLUDE_DIR
+#define YVM_AOT_INCLUDE_DIR "."
+#endif
+
+static bool endsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    using namespace boost::program_options;
+
+    // Command arguments handling
+    options_description opts("Usage");
+    opts.add_options()("help", "List help documentations and usages.")(
+        "runtime", value<std::vector<std::string>>(),
+        "Attach java runtime libraries where yvm-aot would lookup classes at")(
+        "output,o", value<std::string>(),
+        "Shared object to build, or C++ source to write if it ends with .cpp")(
+        "class", value<std::vector<std::string>>(),
+        "Classes whose methods would be compiled");
+    positional_options_description p;
+    p.add("class", -1);
+
+    variables_map vm;
+    store(command_line_parser(argc, argv).options(opts).positional(p).run(),
+          vm);
+    notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << opts
+                  << "Compiled methods are bound by yvm --aot=<output> when "
+                     "their classes are loaded. The shared object is built "
+                     "by $CXX, or c++ if it's not set.\n";
+        return 0;
+    }
+    if (!vm.count("class")) {
+        std::cerr << "Fatal error: no class specified.\n";
+        return 1;
+    }
+    if (!vm.count("runtime")) {
+        std::cerr << "Fatal error: no runtime attached into yvm-aot\n";
+        return 1;
+    }
+    if (!vm.count("output")) {
+        std::cerr << "Fatal error: no output specified.\n";
+        return 1;
+    }
+
+    // Classes are loaded the same way yvm loads them, so methods are decoded
+    // into the instruction streams they are bound to
+    yrt.ma = new MethodArea(vm["runtime"].as<std::vector<std::string>>());
+    AotCompiler compiler;
+    for (std::string name : vm["class"].as<std::vector<std::string>>()) {
+        for (auto& c : name) {
+            if (c == '.') {
+                c = '/';
+            }
+        }
+        JavaClass* jc = yrt.ma->loadClassIfAbsent(name);
+        if (jc == nullptr) {
+            std::cerr << "Fatal error: can not load class " << name << "\n";
+            return 1;
+        }
+        std::cout << name << ": " << compiler.compileClass(jc)
+                  << " methods compiled\n";
+    }
+
+    const std::string output = vm["output"].as<std::string>();
+    const std::string source =
+        endsWith(output, ".cpp") ? output : output + ".cpp";
+    std::ofstream out(source);
+    out << compiler.source();
+    out.close();
+    if (!out) {
+        std::cerr << "Fatal error: can not write " << source << "\n";
+        return 1;
+    }
+
+    if (source != output) {
+        const char* cxx = std::getenv("CXX");
+        const std::string command =
+            std::string(cxx != nullptr ? cxx : "c++") +
+            " -std=c++11 -O2 -shared -fPIC -I\"" YVM_AOT_INCLUDE_DIR
+            "\" -o \"" + output + "\" \"" + source + "\"";
+        if (std::system(command.c_str()) != 0) {
+            std::cerr << "Fatal error: failed to build " << output << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef YVM_AOTRUNTIME_H
+#define YVM_AOTRUNTIME_H
+
+#include <cstdint>
+
+//--------------------------------------------------------------------------------
+// Interface between the VM and shared objects built from sources that yvm-aot
+// generated. Generated sources include nothing but this header, so AotSlot and
+// AotTag mirror JValue and SlotTag, the VM checks they agree when it's built
+//--------------------------------------------------------------------------------
+#define YVM_AOT_ABI_VERSION 1
+#define YVM_AOT_MODULE_SYMBOL "yvm_aot_module"
+
+struct JitContext;
+
+enum AotTag : uint8_t {
+    AotTop = 0,
+    AotInt,
+    AotFloat,
+    AotLong,
+    AotDouble,
+    AotRef
+};
+
+struct AotSlot {
+    union {
+        int32_t i;
+        float f;
+        int64_t j;
+        double d;
+        void* ref;
+    };
+    AotTag tag;
+};
+
+// Compiled methods run on interpreter frames like methods compiled by
+// TemplateJIT, they return the slot holding return value or nullptr if an
+// exception was thrown
+typedef AotSlot* (*AotEntry)(JitContext* ctx, AotSlot* locals,
+                             AotSlot* stack);
+
+// Runtime helpers handed to a module when it's loaded. slowPath executes
+// instruction index of current method, see TemplateJIT::slowPath()
+struct AotHelpers {
+    bool (*slowPath)(JitContext* ctx, AotSlot* sp, uint32_t index);
+    bool (*sameReference)(const void* value1, const void* value2);
+};
+
+// A method is bound only if the VM computes the same fingerprint from its
+// code and the constants it refers to, see codeFingerprint()
+struct AotMethod {
+    const char* className;
+    const char* name;
+    const char* descriptor;
+    uint64_t fingerprint;
+    AotEntry entry;
+};
+
+struct AotModule {
+    uint32_t abiVersion;
+    uint32_t methodCount;
+    const AotMethod* methods;
+};
+
+// Exported by every module as YVM_AOT_MODULE_SYMBOL
+typedef const AotModule* (*AotModuleInit)(const AotHelpers* helpers);
+
+#endif  // YVM_AOTRUNTIME_H
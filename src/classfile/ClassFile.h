@@ -1,6 +1,10 @@
 #ifndef YVM_RAWCLASSFILE_H
 #define YVM_RAWCLASSFILE_H
 
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include "../interpreter/Instruction.h"
 #include "../interpreter/Internal.h"
 #include "../misc/Utils.h"
 
@@ -37,75 +41,89 @@ enum VariableInfoTag {
 };
 
 //--------------------------------------------------------------------------------
-// constant pool definitions
+// Constant pool is laid out as structure of arrays, each entry has a tag byte
+// and a 64-bit payload, contents of Utf8 entries are kept in one arena. Tag is
+// zero for index 0 and the unusable slot following a Long or Double. Payload
+// of an entry depends on its tag:
+//   Class, String, MethodType    index of referenced Utf8 entry
+//   Fieldref, Methodref,         class index | name and type index << 16
+//   InterfaceMethodref
+//   NameAndType                  name index | descriptor index << 16
+//   Integer, Float               bits of value in low 32 bits
+//   Long, Double                 bits of value
+//   Utf8                         offset in arena | length << 32
+//   MethodHandle                 reference kind | reference index << 16
+//   InvokeDynamic                bootstrap method index | name and type
+//                                index << 16
 //--------------------------------------------------------------------------------
-struct ConstantPoolInfo {
-    virtual ~ConstantPoolInfo() = default;
-    ;
-};
-
-#define DEF_CONSTANT_WITH_2_FIELDS(name, type, field)  \
-    struct CONSTANT_##name : public ConstantPoolInfo { \
-        static const u1 tag = ConstantTag::TAG_##name; \
-        type field;                                    \
-    };
-
-#define DEF_CONSTANT_WITH_3_FIELDS(name, type1, field1, type2, field2) \
-    struct CONSTANT_##name : public ConstantPoolInfo {                 \
-        static const u1 tag = ConstantTag::TAG_##name;                 \
-        type1 field1;                                                  \
-        type2 field2;                                                  \
-    };
-#define DEF_CONSTANT_WITH_4_FIELDS(name, type1, field1, type2, field2, type3, \
-                                   field3)                                    \
-    struct CONSTANT_##name : public ConstantPoolInfo {                        \
-        static const u1 tag = ConstantTag::TAG_##name;                        \
-        type1 field1;                                                         \
-        type2 field2;                                                         \
-        type3 field3;                                                         \
-    };
+struct ConstantPool {
+    std::vector<u1> tags;
+    std::vector<uint64_t> payloads;
+    // Utf8 contents end with '\0' for simplicity
+    std::vector<char> utf8Arena;
 
-DEF_CONSTANT_WITH_2_FIELDS(Class, u2, nameIndex);
+    forceinline u1 tag(u2 index) const { return tags[index]; }
 
-DEF_CONSTANT_WITH_3_FIELDS(Fieldref, u2, classIndex, u2, nameAndTypeIndex);
+    forceinline bool is(u2 index, ConstantTag tag) const {
+        return tags[index] == tag;
+    }
 
-DEF_CONSTANT_WITH_3_FIELDS(Methodref, u2, classIndex, u2, nameAndTypeIndex);
+    // Low and high half of a payload packed from two indexes
+    forceinline u2 lowIndex(u2 index) const {
+        return static_cast<u2>(payloads[index]);
+    }
 
-DEF_CONSTANT_WITH_3_FIELDS(InterfaceMethodref, u2, classIndex, u2,
-                           nameAndTypeIndex);
+    forceinline u2 highIndex(u2 index) const {
+        return static_cast<u2>(payloads[index] >> 16);
+    }
 
-DEF_CONSTANT_WITH_2_FIELDS(String, u2, stringIndex);
+    // Utf8 index of a Class, String or MethodType
+    forceinline u2 nameIndex(u2 index) const { return lowIndex(index); }
 
-// Add extra *val* field to represent float value. We can use this value as long
-// as we parsed it This could reduce redundant computation, so we add the same
-// field to Integer/Float/Long/Double.
-DEF_CONSTANT_WITH_3_FIELDS(Integer, u4, bytes, int32_t, val);
+    // Class index and name and type index of a Fieldref, Methodref or
+    // InterfaceMethodref
+    forceinline u2 classIndex(u2 index) const { return lowIndex(index); }
 
-DEF_CONSTANT_WITH_3_FIELDS(Float, u4, bytes, float, val);
+    forceinline u2 nameAndTypeIndex(u2 index) const {
+        return highIndex(index);
+    }
 
-DEF_CONSTANT_WITH_4_FIELDS(Long, u4, highBytes, u4, lowBytes, int64_t, val);
+    // Utf8 indexes of a NameAndType
+    forceinline u2 natNameIndex(u2 index) const { return lowIndex(index); }
 
-DEF_CONSTANT_WITH_4_FIELDS(Double, u4, highBytes, u4, lowBytes, double, val);
+    forceinline u2 natDescriptorIndex(u2 index) const {
+        return highIndex(index);
+    }
 
-DEF_CONSTANT_WITH_3_FIELDS(NameAndType, u2, nameIndex, u2, descriptorIndex);
+    forceinline int32_t intValue(u2 index) const {
+        return static_cast<int32_t>(static_cast<u4>(payloads[index]));
+    }
 
-// It's a special structure whose a field is an array of dynamic size
-// We need override destructor functions to realse these memory while the object
-// was destorying
-struct CONSTANT_Utf8 : public ConstantPoolInfo {
-    static const u1 tag = TAG_Utf8;
-    u2 length;
-    u1* bytes;
+    forceinline float floatValue(u2 index) const {
+        const u4 bits = static_cast<u4>(payloads[index]);
+        float val;
+        memcpy(&val, &bits, sizeof(val));
+        return val;
+    }
 
-    ~CONSTANT_Utf8() override { delete[] bytes; }
-};
+    forceinline int64_t longValue(u2 index) const {
+        return static_cast<int64_t>(payloads[index]);
+    }
 
-DEF_CONSTANT_WITH_3_FIELDS(MethodHandle, u1, referenceKind, u2, referenceIndex);
+    forceinline double doubleValue(u2 index) const {
+        double val;
+        memcpy(&val, &payloads[index], sizeof(val));
+        return val;
+    }
 
-DEF_CONSTANT_WITH_2_FIELDS(MethodType, u2, descriptorIndex);
+    forceinline const char* utf8(u2 index) const {
+        return utf8Arena.data() + static_cast<u4>(payloads[index]);
+    }
 
-DEF_CONSTANT_WITH_3_FIELDS(InvokeDynamic, u2, bootstrapMethodAttrIndex, u2,
-                           nameAndTypeIndex);
+    forceinline u2 utf8Length(u2 index) const {
+        return static_cast<u2>(payloads[index] >> 32);
+    }
+};
 
 //--------------------------------------------------------------------------------
 // attributes definitions
@@ -569,6 +587,41 @@ struct FieldInfo {
     }
 };
 
+//--------------------------------------------------------------------------------
+// Shape of a method derived from its descriptor. It's computed once when the
+// class file was parsed, so that invocations never parse descriptors
+//--------------------------------------------------------------------------------
+struct MethodShape {
+    int returnType;
+    std::vector<int> parameterTypes;
+    // Slots taken by parameters, excluding this reference
+    u2 parameterSlots;
+};
+
+struct RuntimeEnv;
+struct JType;
+class JavaClass;
+typedef JType* (*NativeFunction)(RuntimeEnv*, JType**, int);
+
+//--------------------------------------------------------------------------------
+// Execution descriptor of a method, it's resolved once after the method was
+// parsed. Invocations read code, frame limits and native function from it
+// instead of scanning attributes of method
+//--------------------------------------------------------------------------------
+struct ExecutionDescriptor {
+    // Declaring class
+    const JavaClass* jc;
+    // Code attribute, nullptr if the method is native or abstract
+    const ATTR_Code* code;
+    // Limits of frame, a native method takes its arguments as locals
+    u2 maxStack;
+    u2 maxLocal;
+    // Registered native function, nullptr if absent
+    NativeFunction nativeFunc;
+    // Descriptor character of return type
+    char returnType;
+};
+
 //--------------------------------------------------------------------------------
 // method info definition
 //--------------------------------------------------------------------------------
@@ -578,10 +631,16 @@ struct MethodInfo {
     u2 descriptorIndex;
     u2 attributeCount;
     AttributeInfo** attributes;
+    MethodShape shape;
+    ExecutionDescriptor exec;
+
+    // Pre-decoded instruction stream, created on first invocation
+    std::atomic<DecodedCode*> decoded{nullptr};
 
     ~MethodInfo() {
         FOR_EACH(i, attributeCount) { delete attributes[i]; }
         delete[] attributes;
+        delete decoded.load();
     }
 };
 
@@ -593,7 +652,7 @@ struct ClassFile {
     u2 minorVersion;
     u2 majorVersion;
     u2 constPoolCount;
-    ConstantPoolInfo** constPoolInfo;
+    ConstantPool constPool;
     u2 accessFlags;
     u2 thisClass;
     u2 superClass;
@@ -607,9 +666,6 @@ struct ClassFile {
     AttributeInfo** attributes;
 
     ~ClassFile() {
-        FOR_EACH(i, constPoolCount) { delete constPoolInfo[i]; }
-        delete[] constPoolInfo;
-
         if (interfacesCount > 0) {
             delete[] interfaces;
         }
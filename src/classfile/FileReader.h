@@ -51,6 +51,8 @@ public:
         return getu1(u1buf);
     };
 
+    void readBytes(char* buf, std::streamsize length) { fin.read(buf, length); }
+
 private:
     std::ifstream fin;
     std::string filePath;
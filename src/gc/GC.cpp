@@ -1,4 +1,5 @@
 #include <atomic>
+#include "../interpreter/TypeInference.h"
 #include "../runtime/JavaClass.h"
 #include "../runtime/JavaHeap.hpp"
 #include "../runtime/JavaType.h"
@@ -133,8 +134,7 @@ void ConcurrentGC::sweep() {
         // DITTO
         for (auto pos = yrt.jheap->monitorContainer.data.begin();
              pos != yrt.jheap->monitorContainer.data.end();) {
-            if (objectBitmap.find(pos->first) == objectBitmap.cend() ||
-                arrayBitmap.find(pos->first) == arrayBitmap.cend()) {
+            if (objectBitmap.find(pos->first) == objectBitmap.cend()) {
                 yrt.jheap->monitorContainer.data.erase(pos++);
             } else {
                 ++pos;
@@ -152,14 +152,30 @@ void ConcurrentGC::markAndSweep() {
     auto* temp = frames->top();
     while (temp != nullptr) {
         stackMarkFuture.push_back(gcThreadPool.submit([this, temp]() -> void {
-            for (int i = 0; i < temp->maxStack; i++) {
-                this->mark(temp->stackSlots[i]);
+            // Slots above stack top are dead, and only slots tagged as
+            // reference could refer to objects on java heap
+            for (int i = 0; i < temp->stackTop; i++) {
+                if (temp->stackSlots[i].tag == SlotTag::Ref) {
+                    this->mark(temp->stackSlots[i].ref);
+                }
             }
         }));
 
         localMarkFuture.push_back(gcThreadPool.submit([this, temp]() -> void {
+            // A suspended bytecode frame has a reference map at its current
+            // instruction, locals it does not mark are dead even though they
+            // still hold stale references
+            const uint32_t* refMap = nullptr;
+            if (temp->decoded != nullptr && temp->pc != nullptr) {
+                refMap = findReferenceMap(
+                    temp->decoded,
+                    static_cast<u4>(temp->pc - temp->decoded->code.data()));
+            }
             for (int i = 0; i < temp->maxLocal; i++) {
-                this->mark(temp->localSlots[i]);
+                if (temp->localSlots[i].tag == SlotTag::Ref &&
+                    (refMap == nullptr || (refMap[i / 32] >> (i % 32)) & 1)) {
+                    this->mark(temp->localSlots[i].ref);
+                }
             }
         }));
         temp = temp->next;
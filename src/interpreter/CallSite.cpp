@@ -1,26 +1,24 @@
 #include "CallSite.h"
+#include "Decoder.h"
 
 CallSite::CallSite()
-    : jc(nullptr), code(nullptr), exception(nullptr), callable(false) {}
+    : jc(nullptr),
+      method(nullptr),
+      exec(nullptr),
+      decoded(nullptr),
+      callable(false) {}
 
 CallSite CallSite::makeCallSite(const JavaClass* jc, MethodInfo* m) {
     CallSite cs;
     cs.callable = m != nullptr ? true : false;
-    cs.accessFlags = m->accessFlags;
+    if (!cs.callable) {
+        return cs;
+    }
     cs.jc = jc;
-
-    FOR_EACH(i, m->attributeCount) {
-        if (typeid(*m->attributes[i]) == typeid(ATTR_Code)) {
-            cs.code = dynamic_cast<ATTR_Code*>(m->attributes[i])->code;
-            cs.codeLength = ((ATTR_Code*)m->attributes[i])->codeLength;
-            cs.maxLocal = dynamic_cast<ATTR_Code*>(m->attributes[i])->maxLocals;
-            cs.maxStack = dynamic_cast<ATTR_Code*>(m->attributes[i])->maxStack;
-            cs.exceptionLen = dynamic_cast<ATTR_Code*>(m->attributes[i])
-                                  ->exceptionTableLength;
-            cs.exception =
-                dynamic_cast<ATTR_Code*>(m->attributes[i])->exceptionTable;
-            break;
-        }
+    cs.method = m;
+    cs.exec = &m->exec;
+    if (m->exec.code != nullptr) {
+        cs.decoded = decodeMethod(m, m->exec.code);
     }
     return cs;
 }
@@ -2,6 +2,7 @@
 #define _CALLSITE_H
 
 #include "../runtime/JavaClass.h"
+#include "Instruction.h"
 
 struct CallSite {
     explicit CallSite();
@@ -11,13 +12,9 @@ struct CallSite {
     static CallSite makeCallSite(const JavaClass* jc, MethodInfo* m);
 
     const JavaClass* jc;
-    u2 accessFlags;
-    u1* code;
-    u4 codeLength;
-    u2 maxStack;
-    u2 maxLocal;
-    u2 exceptionLen;
-    ExceptionTable* exception;
+    MethodInfo* method;
+    const ExecutionDescriptor* exec;
+    DecodedCode* decoded;
     bool callable;
 };
 
@@ -0,0 +1,547 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "../aot/AotLoader.h"
+#include "../jit/TemplateJIT.h"
+#include "../misc/Debug.h"
+#include "../runtime/RuntimeEnv.h"
+#include "Decoder.h"
+#include "TypeInference.h"
+
+using namespace std;
+
+DecodedCode* decodeMethod(MethodInfo* m, const ATTR_Code* codeAttr) {
+    DecodedCode* decoded = m->decoded.load(memory_order_acquire);
+    if (decoded == nullptr) {
+        // Several threads may decode the same method simultaneously, only
+        // one of them wins and the others discard their own copies
+        DecodedCode* fresh =
+            decodeByteCode(codeAttr->code, codeAttr->codeLength,
+                           codeAttr->exceptionTableLength,
+                           codeAttr->exceptionTable);
+        buildReferenceMaps(m->exec.jc, m, fresh);
+#ifdef YVM_SUPERINSTRUCTIONS
+        fuseSuperinstructions(fresh);
+#endif
+        if (yrt.aot) {
+            AotLoader::bind(m, fresh);
+        }
+        if (m->decoded.compare_exchange_strong(decoded, fresh,
+                                               memory_order_acq_rel,
+                                               memory_order_acquire)) {
+            decoded = fresh;
+        } else {
+            delete fresh->compiled.load(memory_order_relaxed);
+            delete fresh;
+        }
+    }
+    return decoded;
+}
+
+DecodedCode* decodeByteCode(const u1* code, u4 codeLength, u2 exceptLen,
+                            const ExceptionTable* exceptTab) {
+    auto* decoded = new DecodedCode;
+    // Instruction index of each bytecode offset, -1 if an offset is not the
+    // beginning of an instruction
+    vector<int32_t> indexOf(codeLength + 1, -1);
+    // Branch targets are recorded as bytecode offsets at first and translated
+    // after all instructions were decoded
+    vector<size_t> branches;
+    vector<size_t> switchTargets;
+    size_t inlineCacheCount = 0;
+
+    u4 op = 0;
+    while (op < codeLength) {
+        const u4 currentOffset = op;
+        Instruction insn{code[op], 0, 0};
+        indexOf[currentOffset] = static_cast<int32_t>(decoded->code.size());
+
+        switch (code[op]) {
+            case op_bipush:
+                insn.operand = static_cast<int8_t>(consumeU1(code, op));
+                break;
+            case op_sipush:
+                insn.operand = static_cast<int16_t>(consumeU2(code, op));
+                break;
+            case op_ldc:
+                insn.index = consumeU1(code, op);
+                break;
+            case op_ldc_w:
+                insn.opcode = op_ldc;
+                insn.index = consumeU2(code, op);
+                break;
+            case op_iload:
+            case op_lload:
+            case op_fload:
+            case op_dload:
+            case op_aload:
+            case op_istore:
+            case op_lstore:
+            case op_fstore:
+            case op_dstore:
+            case op_astore:
+            case op_ret:
+            case op_newarray:
+                insn.index = consumeU1(code, op);
+                break;
+            case op_iinc:
+                insn.index = consumeU1(code, op);
+                insn.operand = static_cast<int8_t>(consumeU1(code, op));
+                break;
+            case op_getfield:
+            case op_putfield:
+                insn.index = consumeU2(code, op);
+                insn.operand =
+                    static_cast<int32_t>(decoded->fieldCaches.size());
+                decoded->fieldCaches.emplace_back();
+                break;
+            case op_getstatic:
+            case op_putstatic:
+                insn.index = consumeU2(code, op);
+                insn.operand =
+                    static_cast<int32_t>(decoded->staticFieldCaches.size());
+                decoded->staticFieldCaches.emplace_back();
+                break;
+            case op_invokevirtual:
+                insn.index = consumeU2(code, op);
+                insn.operand = static_cast<int32_t>(inlineCacheCount++);
+                break;
+            case op_ldc2_w:
+            case op_invokespecial:
+            case op_invokestatic:
+            case op_new:
+            case op_anewarray:
+            case op_checkcast:
+            case op_instanceof:
+                insn.index = consumeU2(code, op);
+                break;
+            case op_invokeinterface:
+                insn.index = consumeU2(code, op);
+                insn.operand = static_cast<int32_t>(inlineCacheCount++);
+                op += 2;  // count and zero paddings
+                break;
+            case op_invokedynamic:
+                insn.index = consumeU2(code, op);
+                op += 2;  // zero paddings
+                break;
+            case op_multianewarray:
+                insn.index = consumeU2(code, op);
+                insn.operand = consumeU1(code, op);
+                break;
+            case op_ifeq:
+            case op_ifne:
+            case op_iflt:
+            case op_ifge:
+            case op_ifgt:
+            case op_ifle:
+            case op_if_icmpeq:
+            case op_if_icmpne:
+            case op_if_icmplt:
+            case op_if_icmpge:
+            case op_if_icmpgt:
+            case op_if_icmple:
+            case op_if_acmpeq:
+            case op_if_acmpne:
+            case op_goto:
+            case op_jsr:
+            case op_ifnull:
+            case op_ifnonnull:
+                insn.operand = currentOffset +
+                               static_cast<int16_t>(consumeU2(code, op));
+                branches.push_back(decoded->code.size());
+                break;
+            case op_goto_w:
+            case op_jsr_w:
+                insn.opcode = code[op] == op_goto_w ? op_goto : op_jsr;
+                insn.operand = currentOffset +
+                               static_cast<int32_t>(consumeU4(code, op));
+                branches.push_back(decoded->code.size());
+                break;
+            case op_tableswitch: {
+                // 0~3 bytes padding, operands start at an address that is a
+                // multiple of four bytes from the start of current method
+                op = ((op + 4) & ~3u) - 1;
+                const int32_t defaultOffset = consumeU4(code, op);
+                const int32_t low = consumeU4(code, op);
+                const int32_t high = consumeU4(code, op);
+                if (low > high) {
+                    throw runtime_error("invalid tableswitch bounds");
+                }
+                insn.operand =
+                    static_cast<int32_t>(decoded->switchTables.size());
+                switchTargets.push_back(decoded->switchTables.size());
+                decoded->switchTables.push_back(currentOffset + defaultOffset);
+                decoded->switchTables.push_back(low);
+                decoded->switchTables.push_back(high);
+                for (int64_t i = low; i <= high; i++) {
+                    switchTargets.push_back(decoded->switchTables.size());
+                    decoded->switchTables.push_back(
+                        currentOffset +
+                        static_cast<int32_t>(consumeU4(code, op)));
+                }
+                break;
+            }
+            case op_lookupswitch: {
+                // DITTO
+                op = ((op + 4) & ~3u) - 1;
+                const int32_t defaultOffset = consumeU4(code, op);
+                const int32_t npairs = consumeU4(code, op);
+                insn.operand =
+                    static_cast<int32_t>(decoded->switchTables.size());
+                switchTargets.push_back(decoded->switchTables.size());
+                decoded->switchTables.push_back(currentOffset + defaultOffset);
+                decoded->switchTables.push_back(npairs);
+                for (int32_t i = 0; i < npairs; i++) {
+                    decoded->switchTables.push_back(consumeU4(code, op));
+                    switchTargets.push_back(decoded->switchTables.size());
+                    decoded->switchTables.push_back(
+                        currentOffset +
+                        static_cast<int32_t>(consumeU4(code, op)));
+                }
+                break;
+            }
+            case op_wide: {
+                insn.opcode = consumeU1(code, op);
+                insn.index = consumeU2(code, op);
+                if (insn.opcode == op_iinc) {
+                    insn.operand = static_cast<int16_t>(consumeU2(code, op));
+                }
+                break;
+            }
+            default:
+                // Remaining instructions have no operands
+                break;
+        }
+        if (op >= codeLength) {
+            throw runtime_error("truncated bytecode");
+        }
+        // Implicit operands of shorthand forms are made explicit, so that
+        // superinstructions read operands of any form in the same way
+        if (insn.opcode >= op_iconst_m1 && insn.opcode <= op_iconst_5) {
+            insn.operand = insn.opcode - op_iconst_0;
+        } else if (insn.opcode >= op_iload_0 && insn.opcode <= op_aload_3) {
+            insn.index = (insn.opcode - op_iload_0) % 4;
+        } else if (insn.opcode >= op_istore_0 && insn.opcode <= op_astore_3) {
+            insn.index = (insn.opcode - op_istore_0) % 4;
+        }
+
+        decoded->code.push_back(insn);
+        decoded->bytecodePC.push_back(currentOffset);
+        op++;
+    }
+    indexOf[codeLength] = static_cast<int32_t>(decoded->code.size());
+    decoded->inlineCaches = vector<InlineCache>(inlineCacheCount);
+
+    auto translate = [&](int64_t target) -> int32_t {
+        if (target < 0 || target >= codeLength || indexOf[target] < 0) {
+            throw runtime_error("invalid branch target");
+        }
+        return indexOf[target];
+    };
+    // Each backward branch owns a counter of loop iterations, a method with
+    // too many of them lets the last counter be shared
+    u2 loopCount = 0;
+    for (size_t i : branches) {
+        Instruction& insn = decoded->code[i];
+        insn.operand = translate(insn.operand);
+        if (static_cast<size_t>(insn.operand) <= i) {
+            if (loopCount < UINT16_MAX) {
+                loopCount++;
+            }
+            insn.index = loopCount;
+        }
+    }
+    decoded->loops = vector<LoopProfile>(loopCount);
+    for (size_t i : switchTargets) {
+        decoded->switchTables[i] = translate(decoded->switchTables[i]);
+    }
+
+    FOR_EACH(i, exceptLen) {
+        // End of protected range is exclusive, it may be the end of code
+        if (exceptTab[i].endPC > codeLength ||
+            indexOf[exceptTab[i].endPC] < 0) {
+            throw runtime_error("invalid exception table");
+        }
+        ExceptionHandler handler{};
+        handler.startPC = translate(exceptTab[i].startPC);
+        handler.endPC = indexOf[exceptTab[i].endPC];
+        handler.handlerPC = translate(exceptTab[i].handlerPC);
+        handler.catchType = exceptTab[i].catchType;
+        decoded->exceptionTable.push_back(handler);
+    }
+    return decoded;
+}
+
+static bool isIntLoad(u1 opcode) {
+    return opcode == op_iload || (opcode >= op_iload_0 && opcode <= op_iload_3);
+}
+
+static bool isIntStore(u1 opcode) {
+    return opcode == op_istore ||
+           (opcode >= op_istore_0 && opcode <= op_istore_3);
+}
+
+static bool isRefLoad(u1 opcode) {
+    return opcode == op_aload || (opcode >= op_aload_0 && opcode <= op_aload_3);
+}
+
+static bool isIntConst(u1 opcode) {
+    return (opcode >= op_iconst_m1 && opcode <= op_iconst_5) ||
+           opcode == op_bipush || opcode == op_sipush;
+}
+
+void fuseSuperinstructions(DecodedCode* decoded) {
+    vector<Instruction>& code = decoded->code;
+    const size_t n = code.size();
+    auto opcodeAt = [&](size_t i) -> u1 {
+        return i < n ? code[i].opcode : static_cast<u1>(op_nop);
+    };
+
+    for (size_t i = 0; i < n; i++) {
+        const u1 first = code[i].opcode;
+        if (isIntLoad(first) && isIntLoad(opcodeAt(i + 1)) &&
+            opcodeAt(i + 2) >= op_if_icmpeq &&
+            opcodeAt(i + 2) <= op_if_icmple) {
+            code[i].opcode = op_iload_iload_if_icmpeq +
+                             (code[i + 2].opcode - op_if_icmpeq);
+        } else if (isIntLoad(first) && isIntConst(opcodeAt(i + 1)) &&
+                   opcodeAt(i + 2) == op_iadd &&
+                   isIntStore(opcodeAt(i + 3))) {
+            code[i].opcode = op_iload_iconst_iadd_istore;
+        } else if (isRefLoad(first) && isIntLoad(opcodeAt(i + 1)) &&
+                   (opcodeAt(i + 2) == op_iaload ||
+                    opcodeAt(i + 2) == op_baload ||
+                    opcodeAt(i + 2) == op_caload ||
+                    opcodeAt(i + 2) == op_saload)) {
+            code[i].opcode = op_aload_iload_iaload;
+        } else if (isRefLoad(first) && opcodeAt(i + 1) == op_getfield) {
+            code[i].opcode = op_aload_getfield;
+        } else if (first == op_iinc && opcodeAt(i + 1) == op_goto) {
+            code[i].opcode = op_iinc_goto;
+        }
+    }
+}
+
+u1 originalOpcode(u1 opcode) {
+    if (opcode >= op_iconst_m1 && opcode <= op_iconst_5) {
+        return op_bipush;
+    } else if (opcode >= op_iload_0 && opcode <= op_aload_3) {
+        return op_iload + (opcode - op_iload_0) / 4;
+    } else if (opcode >= op_istore_0 && opcode <= op_astore_3) {
+        return op_istore + (opcode - op_istore_0) / 4;
+    }
+    switch (opcode) {
+        case op_fast_getfield:
+            return op_getfield;
+        case op_fast_putfield:
+            return op_putfield;
+        case op_fast_getstatic:
+            return op_getstatic;
+        case op_fast_putstatic:
+            return op_putstatic;
+        case op_iinc_goto:
+            return op_iinc;
+        case op_aload_getfield:
+        case op_aload_iload_iaload:
+            return op_aload;
+        case op_iload_iconst_iadd_istore:
+        case op_iload_iload_if_icmpeq:
+        case op_iload_iload_if_icmpne:
+        case op_iload_iload_if_icmplt:
+        case op_iload_iload_if_icmpge:
+        case op_iload_iload_if_icmpgt:
+        case op_iload_iload_if_icmple:
+            return op_iload;
+        default:
+            return opcode;
+    }
+}
+
+u4 superinstructionLength(u1 opcode) {
+    switch (opcode) {
+        case op_iinc_goto:
+        case op_aload_getfield:
+            return 2;
+        case op_aload_iload_iaload:
+        case op_iload_iload_if_icmpeq:
+        case op_iload_iload_if_icmpne:
+        case op_iload_iload_if_icmplt:
+        case op_iload_iload_if_icmpge:
+        case op_iload_iload_if_icmpgt:
+        case op_iload_iload_if_icmple:
+            return 3;
+        case op_iload_iconst_iadd_istore:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+#ifdef YVM_DEBUG_PROFILE_SUPERINSTRUCTIONS
+// Sequences are keyed by their original opcodes packed into one integer, the
+// earliest instruction in the most significant byte
+using SequenceCounts = unordered_map<u4, uint64_t>;
+
+struct SequenceRecorder {
+    const Instruction* last = nullptr;
+    u4 window = 0;
+    int length = 0;
+    SequenceCounts pairs;
+    SequenceCounts triples;
+};
+
+// Each thread counts into its own recorder. Executing threads are never
+// joined, so recorders are owned by the profile and merged when it dumps
+struct SequenceProfile {
+    mutex lock;
+    vector<unique_ptr<SequenceRecorder>> recorders;
+
+    SequenceRecorder* newRecorder() {
+        lock_guard<mutex> guard(lock);
+        recorders.emplace_back(new SequenceRecorder);
+        return recorders.back().get();
+    }
+
+    static void dump(const char* title, const SequenceCounts& counts,
+                     int length) {
+        vector<pair<u4, uint64_t>> sorted(counts.begin(), counts.end());
+        sort(sorted.begin(), sorted.end(),
+             [](const pair<u4, uint64_t>& a, const pair<u4, uint64_t>& b) {
+                 return a.second > b.second;
+             });
+        cerr << title << "\n";
+        for (size_t i = 0; i < sorted.size() && i < 20; i++) {
+            cerr << "  " << sorted[i].second;
+            for (int k = length - 1; k >= 0; k--) {
+                const char* name =
+                    Inspector::opcodeName((sorted[i].first >> (k * 8)) & 0xff);
+                cerr << " " << (name != nullptr ? name : "?");
+            }
+            cerr << "\n";
+        }
+    }
+
+    ~SequenceProfile() {
+        SequenceCounts pairs, triples;
+        lock_guard<mutex> guard(lock);
+        for (auto& r : recorders) {
+            for (auto& p : r->pairs) pairs[p.first] += p.second;
+            for (auto& t : r->triples) triples[t.first] += t.second;
+        }
+        dump("most frequent opcode pairs:", pairs, 2);
+        dump("most frequent opcode triples:", triples, 3);
+    }
+};
+
+static SequenceProfile sequenceProfile;
+
+void profileSequence(const Instruction* pc) {
+    static thread_local SequenceRecorder* recorder =
+        sequenceProfile.newRecorder();
+    if (pc != recorder->last + 1) {
+        recorder->length = 0;
+    }
+    recorder->last = pc;
+    recorder->window =
+        ((recorder->window << 8) | originalOpcode(loadOpcode(pc))) & 0xffffff;
+    recorder->length = min(recorder->length + 1, 3);
+    if (recorder->length >= 2) {
+        recorder->pairs[recorder->window & 0xffff]++;
+    }
+    if (recorder->length == 3) {
+        recorder->triples[recorder->window]++;
+    }
+}
+#endif
+
+// FNV-1a
+static void mixFingerprint(uint64_t& hash, uint64_t value, int bytes) {
+    FOR_EACH(k, bytes) {
+        hash = (hash ^ ((value >> (k * 8)) & 0xff)) * 0x100000001b3ULL;
+    }
+}
+
+// Hash contents of a constant pool entry rather than its index, entries it
+// refers to are hashed recursively, so a changed constant value, name or
+// descriptor changes the hash
+static void mixConstant(uint64_t& hash, const ConstantPool& cp, u2 index) {
+    mixFingerprint(hash, cp.tag(index), 1);
+    switch (cp.tag(index)) {
+        case TAG_Utf8:
+            FOR_EACH(k, cp.utf8Length(index)) {
+                mixFingerprint(hash, static_cast<u1>(cp.utf8(index)[k]), 1);
+            }
+            mixFingerprint(hash, cp.utf8Length(index), 2);
+            break;
+        case TAG_Class:
+        case TAG_String:
+        case TAG_MethodType:
+            mixConstant(hash, cp, cp.nameIndex(index));
+            break;
+        case TAG_Fieldref:
+        case TAG_Methodref:
+        case TAG_InterfaceMethodref:
+        case TAG_NameAndType:
+            mixConstant(hash, cp, cp.lowIndex(index));
+            mixConstant(hash, cp, cp.highIndex(index));
+            break;
+        default:
+            mixFingerprint(hash, cp.payloads[index], 8);
+            break;
+    }
+}
+
+static bool refersToConstant(u1 opcode) {
+    switch (opcode) {
+        case op_ldc:
+        case op_ldc2_w:
+        case op_getstatic:
+        case op_putstatic:
+        case op_getfield:
+        case op_putfield:
+        case op_invokevirtual:
+        case op_invokespecial:
+        case op_invokestatic:
+        case op_invokeinterface:
+        case op_invokedynamic:
+        case op_new:
+        case op_anewarray:
+        case op_checkcast:
+        case op_instanceof:
+        case op_multianewarray:
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint64_t codeFingerprint(const MethodInfo* m, const DecodedCode* decoded) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const ConstantPool& cp = m->exec.jc->getConstPool();
+    mixFingerprint(hash, m->exec.maxStack, 2);
+    mixFingerprint(hash, m->exec.maxLocal, 2);
+    for (const Instruction& insn : decoded->code) {
+        mixFingerprint(hash, insn.opcode, 1);
+        mixFingerprint(hash, insn.index, 2);
+        mixFingerprint(hash, static_cast<uint32_t>(insn.operand), 4);
+        if (refersToConstant(originalOpcode(insn.opcode))) {
+            mixConstant(hash, cp, insn.index);
+        }
+    }
+    for (int32_t value : decoded->switchTables) {
+        mixFingerprint(hash, static_cast<uint32_t>(value), 4);
+    }
+    for (const ExceptionHandler& handler : decoded->exceptionTable) {
+        mixFingerprint(hash, handler.startPC, 4);
+        mixFingerprint(hash, handler.endPC, 4);
+        mixFingerprint(hash, handler.handlerPC, 4);
+        if (handler.catchType != 0) {
+            mixConstant(hash, cp, handler.catchType);
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,61 @@
+#ifndef YVM_DECODER_H
+#define YVM_DECODER_H
+
+#include "../classfile/ClassFile.h"
+#include "Instruction.h"
+
+//--------------------------------------------------------------------------------
+// Get the pre-decoded instruction stream of given method. Bytecode is decoded
+// only once, the first caller decodes it, infers reference maps of it and
+// publishes the result on MethodInfo, later callers reuse it.
+//--------------------------------------------------------------------------------
+DecodedCode* decodeMethod(MethodInfo* m, const ATTR_Code* codeAttr);
+
+//--------------------------------------------------------------------------------
+// Translate raw bytecode into internal instruction stream. Multi-byte and
+// wide operands are widened to fixed-width fields, ldc_w, goto_w, jsr_w and
+// wide prefixed instructions are folded into their ordinary forms.
+//--------------------------------------------------------------------------------
+DecodedCode* decodeByteCode(const u1* code, u4 codeLength, u2 exceptLen,
+                            const ExceptionTable* exceptTab);
+
+//--------------------------------------------------------------------------------
+// Rewrite leading instructions of frequent sequences to superinstructions,
+// see Internal.h. It must run after all analyses of original instructions
+//--------------------------------------------------------------------------------
+void fuseSuperinstructions(DecodedCode* decoded);
+
+//--------------------------------------------------------------------------------
+// Standard opcode an instruction of internal instruction stream stands for when
+// it's executed on its own. Quickened instructions are mapped back to their
+// original forms, superinstructions to their leading instructions, shorthand
+// loads, stores and int constants to their general forms since decoder made
+// their implicit operands explicit
+//--------------------------------------------------------------------------------
+u1 originalOpcode(u1 opcode);
+
+//--------------------------------------------------------------------------------
+// Number of instructions a superinstruction stands for, it's 1 for any other
+// instruction. aload_getfield only executes its aload until the getfield was
+// quickened
+//--------------------------------------------------------------------------------
+u4 superinstructionLength(u1 opcode);
+
+#ifdef YVM_DEBUG_PROFILE_SUPERINSTRUCTIONS
+//--------------------------------------------------------------------------------
+// Count the instruction about to be executed together with the one or two
+// instructions executed right before it, as long as they are adjacent in the
+// same instruction stream. Counts of all threads are dumped to stderr on exit
+//--------------------------------------------------------------------------------
+void profileSequence(const Instruction* pc);
+#endif
+
+//--------------------------------------------------------------------------------
+// Hash of everything code compiled ahead of time depends on: frame limits of a
+// method, its instruction stream as decoder produced it before any instruction
+// was quickened, and contents of constant pool entries the instructions refer
+// to. Such code is only bound to methods of the same fingerprint
+//--------------------------------------------------------------------------------
+uint64_t codeFingerprint(const MethodInfo* m, const DecodedCode* decoded);
+
+#endif  // YVM_DECODER_H
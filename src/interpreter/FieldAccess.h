@@ -0,0 +1,63 @@
+#ifndef YVM_FIELDACCESS_H
+#define YVM_FIELDACCESS_H
+
+#include <stdexcept>
+#include "../misc/Utils.h"
+#include "../runtime/JavaClass.h"
+#include "../runtime/JavaHeap.hpp"
+#include "../runtime/JavaType.h"
+#include "Instruction.h"
+
+//--------------------------------------------------------------------------------
+// Get the slot of a resolved field within the given object. Fields declared by
+// the same class have a fixed distance to the end of object fields
+//--------------------------------------------------------------------------------
+forceinline u4 getFieldSlot(const FieldCache& cache, const JObject* objectref) {
+    if (likely(objectref->jc == cache.receiverClass)) {
+        return cache.slot;
+    }
+    return objectref->jc->getInstanceFieldCount() - cache.slotFromEnd;
+}
+
+//--------------------------------------------------------------------------------
+// Read a field of given object through the cache of a quickened getfield
+//--------------------------------------------------------------------------------
+forceinline JValue getFieldValue(const FieldCache& cache, JObject* objectref) {
+    if (objectref == nullptr) {
+        throw std::runtime_error("null pointer");
+    }
+    JType* field = yrt.jheap->getFieldByOffset(
+        *objectref, getFieldSlot(cache, objectref));
+    return unboxValue(field, cache.type);
+}
+
+//--------------------------------------------------------------------------------
+// Write a field of given object through the cache of a quickened putfield
+//--------------------------------------------------------------------------------
+forceinline void putFieldValue(const FieldCache& cache, JObject* objectref,
+                               const JValue& value) {
+    if (objectref == nullptr) {
+        throw std::runtime_error("null pointer");
+    }
+    const u4 slot = getFieldSlot(cache, objectref);
+    if (value.tag == SlotTag::Ref) {
+        yrt.jheap->putFieldByOffset(*objectref, slot, value.ref);
+    } else {
+        // Primitive fields were boxed when creating object, we update them in
+        // place
+        assignBoxedValue(yrt.jheap->getFieldByOffset(*objectref, slot), value);
+    }
+}
+
+forceinline void putStaticValue(const StaticFieldCache& field,
+                                const JValue& value) {
+    if (value.tag == SlotTag::Ref) {
+        *field.slot = value.ref;
+    } else {
+        // Primitive static variables were boxed when linking class, we
+        // update them in place
+        assignBoxedValue(*field.slot, value);
+    }
+}
+
+#endif  // YVM_FIELDACCESS_H
@@ -0,0 +1,150 @@
+#ifndef YVM_INSTRUCTION_H
+#define YVM_INSTRUCTION_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "../misc/Option.h"
+#include "Internal.h"
+
+class JavaClass;
+struct CompiledMethod;
+struct CompiledTrace;
+struct JType;
+struct MethodInfo;
+struct MethodShape;
+
+//--------------------------------------------------------------------------------
+// Internal instruction format. Methods are pre-decoded from class file bytecode
+// into a stream of fixed-width instructions when they were invoked the first
+// time, so the interpreter never decodes big-endian operands nor computes
+// branch targets at runtime. All branch targets and exception handler ranges
+// are absolute indexes of instruction stream rather than bytecode offsets
+//--------------------------------------------------------------------------------
+struct Instruction {
+    u1 opcode;
+    // Local variable index, constant pool index, array type, or the loop
+    // counter of a backward branch counting from 1
+    u2 index;
+    // Immediate value, absolute branch target, offset of switch table or
+    // index of resolution cache
+    int32_t operand;
+};
+
+//--------------------------------------------------------------------------------
+// Instructions are quickened in place while other threads may be executing
+// them. A quickened opcode is published by a release store once everything
+// its fast form reads has been written, and opcodes that may be quickened are
+// read by acquire loads, which are plain loads on x86-64
+//--------------------------------------------------------------------------------
+inline u1 loadOpcode(const Instruction* insn) {
+    return __atomic_load_n(&insn->opcode, __ATOMIC_ACQUIRE);
+}
+
+inline void publishOpcode(Instruction* insn, u1 opcode) {
+    __atomic_store_n(&insn->opcode, opcode, __ATOMIC_RELEASE);
+}
+
+//--------------------------------------------------------------------------------
+// Resolved field of a quickened getfield/putfield. The field slot is cached for
+// objects of receiverClass, objects of other classes compute it from
+// slotFromEnd, since a field always has the same distance to the end of object
+// fields, see JavaHeap::findFieldOffset()
+//--------------------------------------------------------------------------------
+struct FieldCache {
+    const JavaClass* receiverClass;
+    u4 slot;
+    u4 slotFromEnd;
+    char type;
+};
+
+//--------------------------------------------------------------------------------
+// Resolved static field of a quickened getstatic/putstatic. Static variables
+// never move once their class was linked, so we refer to them directly
+//--------------------------------------------------------------------------------
+struct StaticFieldCache {
+    JType** slot;
+    char type;
+};
+
+//--------------------------------------------------------------------------------
+// Inline cache of an invokevirtual/invokeinterface. It remembers receiver
+// classes seen at the call site together with methods selected for them, the
+// first entry serves monomorphic call sites and the rest form a bounded
+// polymorphic table. An entry never changes once its receiver class was
+// published, a call site whose entries are all taken is megamorphic
+//--------------------------------------------------------------------------------
+struct InlineCacheEntry {
+    std::atomic<const JavaClass*> receiverClass{nullptr};
+    const JavaClass* jc;
+    MethodInfo* method;
+};
+
+struct InlineCache {
+    // Shape of referenced method, the receiver is located by it
+    std::atomic<const MethodShape*> shape{nullptr};
+    // Referenced method is entry methodIndex of vtable of methodClass, they
+    // are written before shape is published
+    const JavaClass* methodClass;
+    int methodIndex;
+    InlineCacheEntry entries[YVM_INLINE_CACHE_SIZE];
+};
+
+//--------------------------------------------------------------------------------
+// Profile of a loop closed by a backward branch. Its iterations are counted
+// until either the whole method or a trace of the loop body got compiled, see
+// TemplateJIT and TraceJIT
+//--------------------------------------------------------------------------------
+struct LoopProfile {
+    std::atomic<u4> backedges{0};
+    std::atomic<u1> traceAttempts{0};
+    std::atomic<CompiledTrace*> trace{nullptr};
+};
+
+struct ExceptionHandler {
+    u4 startPC;
+    u4 endPC;
+    u4 handlerPC;
+    u2 catchType;
+};
+
+struct DecodedCode {
+    std::vector<Instruction> code;
+
+    // Switch tables are flattened without paddings. A tableswitch is laid
+    // out as [default, low, high, target...] and a lookupswitch as
+    // [default, npairs, match, target, match, target...]
+    std::vector<int32_t> switchTables;
+
+    std::vector<ExceptionHandler> exceptionTable;
+
+    // Each getfield/putfield/getstatic/putstatic owns a cache, it's filled
+    // when the instruction was quickened
+    std::vector<FieldCache> fieldCaches;
+    std::vector<StaticFieldCache> staticFieldCaches;
+
+    // Each invokevirtual/invokeinterface owns an inline cache
+    std::vector<InlineCache> inlineCaches;
+
+    // Bytecode offset of each instruction
+    std::vector<u4> bytecodePC;
+
+    // Reference maps of local variables at instructions that may suspend
+    // current frame while GC runs, see buildReferenceMaps(). refMapPCs is
+    // sorted and each map takes refMapWords words of refMaps, they are empty
+    // if types of the method could not be inferred
+    std::vector<u4> refMapPCs;
+    std::vector<uint32_t> refMaps;
+    u4 refMapWords = 0;
+
+    // Invocations and loops profiled by compilers, and machine code baseline
+    // compiler compiled for the method when it got hot. The counters are only
+    // approximate when several threads run the method, it's compiled at most
+    // once. loops are indexed by loop counters of backward branches
+    std::atomic<u4> invocationCount{0};
+    std::vector<LoopProfile> loops;
+    std::atomic<bool> compileAttempted{false};
+    std::atomic<CompiledMethod*> compiled{nullptr};
+};
+
+#endif  // YVM_INSTRUCTION_H
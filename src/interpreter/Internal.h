@@ -225,6 +225,28 @@ typedef uint8_t u1;
 #define op_goto_w 200
 #define op_jsr_w 201
 #define op_breakpoint 202
+
+// Quickened opcodes never appear in class files. Generic instructions are
+// rewritten to them in pre-decoded instruction stream after resolution
+#define op_fast_getfield 203
+#define op_fast_putfield 204
+#define op_fast_getstatic 205
+#define op_fast_putstatic 206
+
+// Superinstructions never appear in class files either. The first instruction
+// of a frequent sequence is rewritten to them while the rest are kept in place,
+// so that branches into the middle of a sequence still execute it piecewise
+#define op_iinc_goto 207
+#define op_aload_getfield 208
+#define op_aload_iload_iaload 209
+#define op_iload_iconst_iadd_istore 210
+#define op_iload_iload_if_icmpeq 211
+#define op_iload_iload_if_icmpne 212
+#define op_iload_iload_if_icmplt 213
+#define op_iload_iload_if_icmpge 214
+#define op_iload_iload_if_icmpgt 215
+#define op_iload_iload_if_icmple 216
+
 #define op_impdep1 254
 #define op_impdep2 255
 
@@ -1,42 +1,259 @@
 #include "../classfile/AccessFlag.h"
 #include "../classfile/ClassFile.h"
+#include "../jit/TemplateJIT.h"
+#include "../jit/TraceJIT.h"
 #include "../misc/Debug.h"
 #include "../misc/Option.h"
 #include "../runtime/JavaClass.h"
 #include "../runtime/JavaHeap.hpp"
 #include "CallSite.h"
+#include "Decoder.h"
+#include "FieldAccess.h"
+#include "Instruction.h"
 #include "Interpreter.hpp"
 #include "MethodResolve.h"
 #include "SymbolicRef.h"
 
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 
 using namespace std;
 
-#define IS_COMPUTATIONAL_TYPE_1(value) \
-    (typeid(*value) != typeid(JDouble) && typeid(*value) != typeid(JLong))
-#define IS_COMPUTATIONAL_TYPE_2(value) \
-    (typeid(*value) == typeid(JDouble) || typeid(*value) == typeid(JLong))
+//--------------------------------------------------------------------------------
+// Instruction dispatching. Each handler is written once and expanded either to
+// a label of computed goto (direct threading, every handler jumps to the next
+// one through the dispatch table) or to a case of the portable big switch.
+// Handlers must end with NEXT() unless they leave current method. While a trace
+// is being recorded, every instruction is dispatched to recordInstruction
+// first, which then executes it by EXECUTE().
+//--------------------------------------------------------------------------------
+#if defined(YVM_THREADED_DISPATCH) && !(defined __GNUC__ || defined __clang__)
+#undef YVM_THREADED_DISPATCH
+#endif
+
+#if defined(YVM_DEBUG_SHOW_BYTECODE)
+#define TRACE_OPCODE() Inspector::printOpcode(&pc->opcode, 0)
+#elif defined(YVM_DEBUG_PROFILE_SUPERINSTRUCTIONS)
+#define TRACE_OPCODE() profileSequence(pc)
+#else
+#define TRACE_OPCODE()
+#endif
+
+#ifdef YVM_THREADED_DISPATCH
+#define INTERPRETER_LOOP
+#define HANDLE(opcode) L_##opcode:
+#define DEFAULT_HANDLER L_default:
+#define DISPATCH()                  \
+    do {                            \
+        TRACE_OPCODE();             \
+        goto *handlers[loadOpcode(pc)]; \
+    } while (0)
+#define EXECUTE() goto *dispatchTable[loadOpcode(pc)]
+#define SELECT_HANDLERS() \
+    (handlers = recorder != nullptr ? recordTable : dispatchTable)
+#define RECORD_4                                                   \
+    &&recordInstruction, &&recordInstruction, &&recordInstruction, \
+        &&recordInstruction
+#define RECORD_32                                                         \
+    RECORD_4, RECORD_4, RECORD_4, RECORD_4, RECORD_4, RECORD_4, RECORD_4, \
+        RECORD_4
+#define RECORD_TABLE                                                  \
+    RECORD_32, RECORD_32, RECORD_32, RECORD_32, RECORD_32, RECORD_32, \
+        RECORD_32, RECORD_32
+#define DISPATCH_TABLE \
+    &&L_op_nop, &&L_op_aconst_null, &&L_op_iconst_m1, &&L_op_iconst_0,       \
+    &&L_op_iconst_1, &&L_op_iconst_2, &&L_op_iconst_3, &&L_op_iconst_4,      \
+    &&L_op_iconst_5, &&L_op_lconst_0, &&L_op_lconst_1, &&L_op_fconst_0,      \
+    &&L_op_fconst_1, &&L_op_fconst_2, &&L_op_dconst_0, &&L_op_dconst_1,      \
+    &&L_op_bipush, &&L_op_sipush, &&L_op_ldc, &&L_op_ldc_w, &&L_op_ldc2_w,   \
+    &&L_op_iload, &&L_op_lload, &&L_op_fload, &&L_op_dload, &&L_op_aload,    \
+    &&L_op_iload_0, &&L_op_iload_1, &&L_op_iload_2, &&L_op_iload_3,          \
+    &&L_op_lload_0, &&L_op_lload_1, &&L_op_lload_2, &&L_op_lload_3,          \
+    &&L_op_fload_0, &&L_op_fload_1, &&L_op_fload_2, &&L_op_fload_3,          \
+    &&L_op_dload_0, &&L_op_dload_1, &&L_op_dload_2, &&L_op_dload_3,          \
+    &&L_op_aload_0, &&L_op_aload_1, &&L_op_aload_2, &&L_op_aload_3,          \
+    &&L_op_iaload, &&L_op_laload, &&L_op_faload, &&L_op_daload,              \
+    &&L_op_aaload, &&L_op_baload, &&L_op_caload, &&L_op_saload,              \
+    &&L_op_istore, &&L_op_lstore, &&L_op_fstore, &&L_op_dstore,              \
+    &&L_op_astore, &&L_op_istore_0, &&L_op_istore_1, &&L_op_istore_2,        \
+    &&L_op_istore_3, &&L_op_lstore_0, &&L_op_lstore_1, &&L_op_lstore_2,      \
+    &&L_op_lstore_3, &&L_op_fstore_0, &&L_op_fstore_1, &&L_op_fstore_2,      \
+    &&L_op_fstore_3, &&L_op_dstore_0, &&L_op_dstore_1, &&L_op_dstore_2,      \
+    &&L_op_dstore_3, &&L_op_astore_0, &&L_op_astore_1, &&L_op_astore_2,      \
+    &&L_op_astore_3, &&L_op_iastore, &&L_op_lastore, &&L_op_fastore,         \
+    &&L_op_dastore, &&L_op_aastore, &&L_op_bastore, &&L_op_castore,          \
+    &&L_op_sastore, &&L_op_pop, &&L_op_pop2, &&L_op_dup, &&L_op_dup_x1,      \
+    &&L_op_dup_x2, &&L_op_dup2, &&L_op_dup2_x1, &&L_op_dup2_x2, &&L_op_swap, \
+    &&L_op_iadd, &&L_op_ladd, &&L_op_fadd, &&L_op_dadd, &&L_op_isub,         \
+    &&L_op_lsub, &&L_op_fsub, &&L_op_dsub, &&L_op_imul, &&L_op_lmul,         \
+    &&L_op_fmul, &&L_op_dmul, &&L_op_idiv, &&L_op_ldiv, &&L_op_fdiv,         \
+    &&L_op_ddiv, &&L_op_irem, &&L_op_lrem, &&L_op_frem, &&L_op_drem,         \
+    &&L_op_ineg, &&L_op_lneg, &&L_op_fneg, &&L_op_dneg, &&L_op_ishl,         \
+    &&L_op_lshl, &&L_op_ishr, &&L_op_lshr, &&L_op_iushr, &&L_op_lushr,       \
+    &&L_op_iand, &&L_op_land, &&L_op_ior, &&L_op_lor, &&L_op_ixor,           \
+    &&L_op_lxor, &&L_op_iinc, &&L_op_i2l, &&L_op_i2f, &&L_op_i2d,            \
+    &&L_op_l2i, &&L_op_l2f, &&L_op_l2d, &&L_op_f2i, &&L_op_f2l, &&L_op_f2d,  \
+    &&L_op_d2i, &&L_op_d2l, &&L_op_d2f, &&L_op_i2b, &&L_op_i2c, &&L_op_i2s,  \
+    &&L_op_lcmp, &&L_op_fcmpl, &&L_op_fcmpg, &&L_op_dcmpl, &&L_op_dcmpg,     \
+    &&L_op_ifeq, &&L_op_ifne, &&L_op_iflt, &&L_op_ifge, &&L_op_ifgt,         \
+    &&L_op_ifle, &&L_op_if_icmpeq, &&L_op_if_icmpne, &&L_op_if_icmplt,       \
+    &&L_op_if_icmpge, &&L_op_if_icmpgt, &&L_op_if_icmple, &&L_op_if_acmpeq,  \
+    &&L_op_if_acmpne, &&L_op_goto, &&L_op_jsr, &&L_op_ret,                   \
+    &&L_op_tableswitch, &&L_op_lookupswitch, &&L_op_ireturn, &&L_op_lreturn, \
+    &&L_op_freturn, &&L_op_dreturn, &&L_op_areturn, &&L_op_return,           \
+    &&L_op_getstatic, &&L_op_putstatic, &&L_op_getfield, &&L_op_putfield,    \
+    &&L_op_invokevirtual, &&L_op_invokespecial, &&L_op_invokestatic,         \
+    &&L_op_invokeinterface, &&L_op_invokedynamic, &&L_op_new,                \
+    &&L_op_newarray, &&L_op_anewarray, &&L_op_arraylength, &&L_op_athrow,    \
+    &&L_op_checkcast, &&L_op_instanceof, &&L_op_monitorenter,                \
+    &&L_op_monitorexit, &&L_op_wide, &&L_op_multianewarray, &&L_op_ifnull,   \
+    &&L_op_ifnonnull, &&L_op_goto_w, &&L_op_jsr_w, &&L_op_breakpoint,        \
+    &&L_op_fast_getfield, &&L_op_fast_putfield, &&L_op_fast_getstatic,       \
+    &&L_op_fast_putstatic, &&L_op_iinc_goto, &&L_op_aload_getfield,          \
+    &&L_op_aload_iload_iaload, &&L_op_iload_iconst_iadd_istore,              \
+    &&L_op_iload_iload_if_icmpeq, &&L_op_iload_iload_if_icmpne,              \
+    &&L_op_iload_iload_if_icmplt, &&L_op_iload_iload_if_icmpge,              \
+    &&L_op_iload_iload_if_icmpgt, &&L_op_iload_iload_if_icmple, &&L_default, \
+    &&L_default, &&L_default, &&L_default, &&L_default, &&L_default,         \
+    &&L_default, &&L_default, &&L_default, &&L_default, &&L_default,         \
+    &&L_default, &&L_default, &&L_default, &&L_default, &&L_default,         \
+    &&L_default, &&L_default, &&L_default, &&L_default, &&L_default,         \
+    &&L_default, &&L_default, &&L_default, &&L_default, &&L_default,         \
+    &&L_default, &&L_default, &&L_default, &&L_default, &&L_default,         \
+    &&L_default, &&L_default, &&L_default, &&L_default, &&L_default,         \
+    &&L_default, &&L_op_impdep1, &&L_op_impdep2
+#else
+#define INTERPRETER_LOOP                 \
+    dispatch:                            \
+    TRACE_OPCODE();                      \
+    if (unlikely(recorder != nullptr)) { \
+        goto recordInstruction;          \
+    }                                    \
+    execute:                             \
+    switch (loadOpcode(pc))
+#define HANDLE(opcode) case opcode:
+#define DEFAULT_HANDLER default:
+#define DISPATCH() goto dispatch
+#define EXECUTE() goto execute
+#define SELECT_HANDLERS()
+#endif
+
+#define NEXT()      \
+    do {            \
+        pc++;       \
+        DISPATCH(); \
+    } while (0)
+
+// Branch targets are absolute indexes of instruction stream
+#define JUMP(target)          \
+    do {                      \
+        pc = code + (target); \
+        DISPATCH();           \
+    } while (0)
+
+// Take the branch of given instruction, backward branches count iterations of
+// their loops
+#define BRANCH(insn)                 \
+    do {                             \
+        if ((insn)->index != 0) {    \
+            branch = (insn);         \
+            goto loopBackedge;       \
+        }                            \
+        JUMP((insn)->operand);       \
+    } while (0)
+
+//--------------------------------------------------------------------------------
+// The operand stack pointer lives in a register while interpreting, it must be
+// written back before calling anything that inspects or grows current frame,
+// i.e. method invocation, class initialization and garbage collection
+//--------------------------------------------------------------------------------
+#define FLUSH_SP() \
+    (frame->stackTop = static_cast<int>(sp - frame->stackSlots))
+#define RELOAD_SP() (sp = frame->stackSlots + frame->stackTop)
+
+// GC finds live local variables of a suspended frame by its current
+// instruction, it must be written back before anything that may run java code
+#define FLUSH_PC() (frame->pc = pc)
+
+//--------------------------------------------------------------------------------
+// Load the method executed by top frame into registers of interpreter, it's
+// done when entering a method, returning to a caller or unwinding to a caller
+//--------------------------------------------------------------------------------
+#define LOAD_FRAME()                                                    \
+    do {                                                                \
+        frame = frames->top();                                          \
+        jc = frame->jc;                                                 \
+        decoded = frame->decoded;                                       \
+        locals = frame->localSlots;                                     \
+        RELOAD_SP();                                                    \
+        code = decoded->code.data();                                    \
+        switchTables = decoded->switchTables.data();                    \
+        fieldCaches = decoded->fieldCaches.data();                      \
+        staticFieldCaches = decoded->staticFieldCaches.data();          \
+        inlineCaches = decoded->inlineCaches.data();                    \
+        pc = frame->pc != nullptr ? frame->pc : code;                   \
+    } while (0)
+
+// Instructions are dispatched directly again once a recording ended
+#define STOP_RECORDING()   \
+    do {                   \
+        recorder.reset();  \
+        SELECT_HANDLERS(); \
+    } while (0)
+
+// Exceptions thrown by callee are only checked after method invocation
+#define CHECK_PENDING_EXCEPTION()                         \
+    do {                                                  \
+        if (unlikely(exception.hasUnhandledException())) { \
+            goto pendingException;                        \
+        }                                                 \
+    } while (0)
 
 #pragma warning(disable : 4715)
 #pragma warning(disable : 4244)
 
+// Serializes rewriting of instructions and filling of inline caches since
+// methods are shared by threads
+static mutex quickeningMutex;
+
+//--------------------------------------------------------------------------------
+// Number of operand stack slots taken by arguments of given call, including the
+// receiver of an instance method
+//--------------------------------------------------------------------------------
+static forceinline int getArgumentSlots(const CallSite &csite,
+                                        bool isObjectMethod) {
+    return csite.method->shape.parameterSlots + (isObjectMethod ? 1 : 0);
+}
+
 Interpreter::~Interpreter() { delete frames; }
 
-JType *Interpreter::execNativeMethod(const string &className,
-                                     const string &methodName,
-                                     const string &methodDescriptor) {
-    string nativeMethod(className);
-    nativeMethod.append(".");
-    nativeMethod.append(methodName);
-    nativeMethod.append(".");
-    nativeMethod.append(methodDescriptor);
-    if (yrt.nativeMethods.find(nativeMethod) != yrt.nativeMethods.end()) {
-        return ((*yrt.nativeMethods.find(nativeMethod)).second)(
-            &yrt, frames->top()->localSlots, frames->top()->maxLocal);
+JValue Interpreter::execNativeMethod(const MethodInfo *m) {
+    const NativeFunction nativeFunc = m->exec.nativeFunc;
+    if (nativeFunc != nullptr) {
+        // Native methods accept boxed arguments, so we box primitive values
+        // of local variables temporarily and release them after invocation
+        Slots *slots = frames->top();
+        vector<JType *> args(slots->maxLocal);
+        for (int i = 0; i < slots->maxLocal; i++) {
+            args[i] = boxValue(slots->localSlots[i]);
+        }
+        JType *result = nativeFunc(&yrt, args.data(), slots->maxLocal);
+        for (int i = 0; i < slots->maxLocal; i++) {
+            if (slots->localSlots[i].tag != SlotTag::Ref) {
+                delete args[i];
+            }
+        }
+
+        JValue returnValue = unboxValue(result, m->exec.returnType);
+        if (returnValue.tag != SlotTag::Ref) {
+            delete result;
+        }
+        return returnValue;
     }
 
     GC_SAFE_POINT
@@ -44,1442 +261,1521 @@ JType *Interpreter::execNativeMethod(const string &className,
         yrt.gc->stopTheWorld();
         yrt.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);
     }
-    return nullptr;
+    return JValue{};
 }
 
-JType *Interpreter::execByteCode(const JavaClass *jc, u1 *code, u4 codeLength,
-                                 u2 exceptLen, ExceptionTable *exceptTab) {
-    for (decltype(codeLength) op = 0; op < codeLength; op++) {
-        // If callee propagates a unhandled exception, try to handle  it. When
-        // we can not handle it, propagates it to upper and returns
-        if (exception.hasUnhandledException()) {
-            op--;
-            auto *throwobj = frames->top()->pop<JObject>();
-            if (throwobj == nullptr) {
-                throw runtime_error("null pointer");
-            }
-            if (!hasInheritanceRelationship(
-                    throwobj->jc,
-                    yrt.ma->loadClassIfAbsent("java/lang/Throwable"))) {
-                throw runtime_error("it's not a throwable object");
-            }
+//--------------------------------------------------------------------------------
+// Execute the method of top frame. Bytecode methods it invokes are executed
+// within the same dispatch loop, their frames are pushed and popped explicitly
+// instead of recursing on native stack, so the depth of java calls is only
+// limited by the frame stack. It returns when the top frame of entry returns
+// or throws an exception which it can not handle
+//--------------------------------------------------------------------------------
+JValue Interpreter::execByteCode(const JavaClass *jc, const MethodInfo *m,
+                                 DecodedCode *decoded) {
+    // Frames above the entry frame are only touched by this loop, so we cache
+    // current frame as well as its stack pointer and local variables in
+    // registers
+    Slots *const entryFrame = frames->top();
+    Slots *frame;
+    JValue *locals;
+    JValue *sp;
+    Instruction *code;
+    const int32_t *switchTables;
+    const FieldCache *fieldCaches;
+    const StaticFieldCache *staticFieldCaches;
+    InlineCache *inlineCaches;
+    Instruction *pc;
+    const Instruction *branch;
+
+    // Method invocation, method return and exception unwinding
+    CallSite csite;
+    bool isObjectMethod;
+    CompiledMethod *compiled;
+    JValue returnValue;
+    JObject *throwobj;
+    u4 handlerPC;
+
+    // Loop traces
+    unique_ptr<TraceRecorder> recorder;
+    CompiledTrace *trace;
+    bool recordTrace;
+
+    entryFrame->jc = jc;
+    entryFrame->method = m;
+    entryFrame->decoded = decoded;
+    LOAD_FRAME();
+
+#ifdef YVM_THREADED_DISPATCH
+    static const void *dispatchTable[256] = {DISPATCH_TABLE};
+    static const void *recordTable[256] = {RECORD_TABLE};
+    const void *const *handlers = dispatchTable;
+#endif
 
-            if (handleException(jc, exceptLen, exceptTab, throwobj, op)) {
-                while (!frames->top()->emptyStack()) {
-                    frames->top()->pop<JType>();
-                }
-                frames->top()->push(throwobj);
-                exception.sweepException();
+    DISPATCH();
+
+    INTERPRETER_LOOP {
+        HANDLE(op_nop) {
+            // DO NOTHING :-)
+            NEXT();
+        }
+        HANDLE(op_aconst_null) {
+            pushOperand<JRef>(sp, nullptr);
+            NEXT();
+        }
+        HANDLE(op_iconst_m1) {
+            pushOperand<JInt>(sp, -1);
+            NEXT();
+        }
+        HANDLE(op_iconst_0) {
+            pushOperand<JInt>(sp, 0);
+            NEXT();
+        }
+        HANDLE(op_iconst_1) {
+            pushOperand<JInt>(sp, 1);
+            NEXT();
+        }
+        HANDLE(op_iconst_2) {
+            pushOperand<JInt>(sp, 2);
+            NEXT();
+        }
+        HANDLE(op_iconst_3) {
+            pushOperand<JInt>(sp, 3);
+            NEXT();
+        }
+        HANDLE(op_iconst_4) {
+            pushOperand<JInt>(sp, 4);
+            NEXT();
+        }
+        HANDLE(op_iconst_5) {
+            pushOperand<JInt>(sp, 5);
+            NEXT();
+        }
+        HANDLE(op_lconst_0) {
+            pushOperand<JLong>(sp, 0);
+            NEXT();
+        }
+        HANDLE(op_lconst_1) {
+            pushOperand<JLong>(sp, 1);
+            NEXT();
+        }
+        HANDLE(op_fconst_0) {
+            pushOperand<JFloat>(sp, 0.0f);
+            NEXT();
+        }
+        HANDLE(op_fconst_1) {
+            pushOperand<JFloat>(sp, 1.0f);
+            NEXT();
+        }
+        HANDLE(op_fconst_2) {
+            pushOperand<JFloat>(sp, 2.0f);
+            NEXT();
+        }
+        HANDLE(op_dconst_0) {
+            pushOperand<JDouble>(sp, 0.0);
+            NEXT();
+        }
+        HANDLE(op_dconst_1) {
+            pushOperand<JDouble>(sp, 1.0);
+            NEXT();
+        }
+        HANDLE(op_sipush)
+        HANDLE(op_bipush) {
+            pushOperand<JInt>(sp, pc->operand);
+            NEXT();
+        }
+        HANDLE(op_ldc_w)
+        HANDLE(op_ldc) {
+            loadConstantPoolItem2Stack(jc, pc->index, sp);
+            NEXT();
+        }
+        HANDLE(op_ldc2_w) {
+            const u2 index = pc->index;
+            const ConstantPool &cp = jc->raw.constPool;
+            if (cp.is(index, TAG_Double)) {
+                pushOperand<JDouble>(sp, cp.doubleValue(index));
+            } else if (cp.is(index, TAG_Long)) {
+                pushOperand<JLong>(sp, cp.longValue(index));
             } else {
-                return throwobj;
+                throw runtime_error(
+                    "invalid symbolic reference index on "
+                    "constant pool");
             }
+            NEXT();
         }
-#ifdef YVM_DEBUG_SHOW_BYTECODE
-        for (int i = 0; i < frames.size(); i++) {
-            cout << "-";
+        HANDLE(op_iload) {
+            loadLocal<JInt>(sp, locals, pc->index);
+            NEXT();
         }
-        Inspector::printOpcode(code, op);
-#endif
-        // Interpreting through big switching
-        switch (code[op]) {
-            case op_nop: {
-                // DO NOTHING :-)
-            } break;
-            case op_aconst_null: {
-                frames->top()->push(nullptr);
-            } break;
-            case op_iconst_m1: {
-                frames->top()->push(new JInt(-1));
-            } break;
-            case op_iconst_0: {
-                frames->top()->push(new JInt(0));
-            } break;
-            case op_iconst_1: {
-                frames->top()->push(new JInt(1));
-            } break;
-            case op_iconst_2: {
-                frames->top()->push(new JInt(2));
-            } break;
-            case op_iconst_3: {
-                frames->top()->push(new JInt(3));
-            } break;
-            case op_iconst_4: {
-                frames->top()->push(new JInt(4));
-            } break;
-            case op_iconst_5: {
-                frames->top()->push(new JInt(5));
-            } break;
-            case op_lconst_0: {
-                frames->top()->push(new JLong(0));
-            } break;
-            case op_lconst_1: {
-                frames->top()->push(new JLong(1));
-            } break;
-            case op_fconst_0: {
-                frames->top()->push(new JFloat(0.0f));
-            } break;
-            case op_fconst_1: {
-                frames->top()->push(new JFloat(1.0f));
-            } break;
-            case op_fconst_2: {
-                frames->top()->push(new JFloat(2.0f));
-            } break;
-            case op_dconst_0: {
-                frames->top()->push(new JDouble(0.0));
-            } break;
-            case op_dconst_1: {
-                frames->top()->push(new JDouble(1.0));
-            } break;
-            case op_bipush: {
-                const u1 byte = consumeU1(code, op);
-                frames->top()->push(new JInt(byte));
-            } break;
-            case op_sipush: {
-                const u2 byte = consumeU2(code, op);
-                frames->top()->push(new JInt(byte));
-            } break;
-            case op_ldc: {
-                const u1 index = consumeU1(code, op);
-                loadConstantPoolItem2Stack(jc, static_cast<u2>(index));
-            } break;
-            case op_ldc_w: {
-                const u2 index = consumeU2(code, op);
-                loadConstantPoolItem2Stack(jc, index);
-            } break;
-            case op_ldc2_w: {
-                const u2 index = consumeU2(code, op);
-                if (typeid(*jc->raw.constPoolInfo[index]) ==
-                    typeid(CONSTANT_Double)) {
-                    auto val = dynamic_cast<CONSTANT_Double *>(
-                                   jc->raw.constPoolInfo[index])
-                                   ->val;
-                    JDouble *dval = new JDouble;
-                    dval->val = val;
-                    frames->top()->push(dval);
-                } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-                           typeid(CONSTANT_Long)) {
-                    auto val = dynamic_cast<CONSTANT_Long *>(
-                                   jc->raw.constPoolInfo[index])
-                                   ->val;
-                    JLong *lval = new JLong;
-                    lval->val = val;
-                    frames->top()->push(lval);
-                } else {
-                    throw runtime_error(
-                        "invalid symbolic reference index on "
-                        "constant pool");
-                }
-            } break;
-            case op_iload: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->load<JInt>(index);
-            } break;
-            case op_lload: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->load<JLong>(index);
-            } break;
-            case op_fload: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->load<JFloat>(index);
-            } break;
-            case op_dload: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->load<JDouble>(index);
-            } break;
-            case op_aload: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->load<JRef>(index);
-            } break;
-            case op_iload_0: {
-                frames->top()->load<JInt>(0);
-            } break;
-            case op_iload_1: {
-                frames->top()->load<JInt>(1);
-            } break;
-            case op_iload_2: {
-                frames->top()->load<JInt>(2);
-            } break;
-            case op_iload_3: {
-                frames->top()->load<JInt>(3);
-            } break;
-            case op_lload_0: {
-                frames->top()->load<JLong>(0);
-            } break;
-            case op_lload_1: {
-                frames->top()->load<JLong>(1);
-            } break;
-            case op_lload_2: {
-                frames->top()->load<JLong>(2);
-            } break;
-            case op_lload_3: {
-                frames->top()->load<JLong>(3);
-            } break;
-            case op_fload_0: {
-                frames->top()->load<JFloat>(0);
-            } break;
-            case op_fload_1: {
-                frames->top()->load<JFloat>(1);
-            } break;
-            case op_fload_2: {
-                frames->top()->load<JFloat>(2);
-            } break;
-            case op_fload_3: {
-                frames->top()->load<JFloat>(3);
-            } break;
-            case op_dload_0: {
-                frames->top()->load<JDouble>(0);
-            } break;
-            case op_dload_1: {
-                frames->top()->load<JDouble>(1);
-            } break;
-            case op_dload_2: {
-                frames->top()->load<JDouble>(2);
-            } break;
-            case op_dload_3: {
-                frames->top()->load<JDouble>(3);
-            } break;
-            case op_aload_0: {
-                frames->top()->load<JRef>(0);
-            } break;
-            case op_aload_1: {
-                frames->top()->load<JRef>(1);
-            } break;
-            case op_aload_2: {
-                frames->top()->load<JRef>(2);
-            } break;
-            case op_aload_3: {
-                frames->top()->load<JRef>(3);
-            } break;
-            case op_saload:
-            case op_caload:
-            case op_baload:
-            case op_iaload: {
-                auto *index = frames->top()->pop<JInt>();
-                const auto *arrref = frames->top()->pop<JArray>();
-                if (!arrref) {
-                    throw runtime_error("nullpointerexception");
-                }
-                auto *elem = dynamic_cast<JInt *>(
-                    yrt.jheap->getElement(*arrref, index->val));
-                frames->top()->push(elem);
-            } break;
-            case op_laload: {
-                auto *index = frames->top()->pop<JInt>();
-                const auto *arrref = frames->top()->pop<JArray>();
-                if (!arrref) {
-                    throw runtime_error("nullpointerexception");
-                }
-                auto *elem = dynamic_cast<JLong *>(
-                    yrt.jheap->getElement(*arrref, index->val));
-                frames->top()->push(elem);
-            } break;
-            case op_faload: {
-                auto *index = frames->top()->pop<JInt>();
-                const auto *arrref = frames->top()->pop<JArray>();
-                if (!arrref) {
-                    throw runtime_error("nullpointerexception");
-                }
-                auto *elem = dynamic_cast<JFloat *>(
-                    yrt.jheap->getElement(*arrref, index->val));
-                frames->top()->push(elem);
-            } break;
-            case op_daload: {
-                auto *index = frames->top()->pop<JInt>();
-                const auto *arrref = frames->top()->pop<JArray>();
-                if (!arrref) {
-                    throw runtime_error("nullpointerexception");
-                }
-                auto *elem = dynamic_cast<JDouble *>(
-                    yrt.jheap->getElement(*arrref, index->val));
-                frames->top()->push(elem);
-            } break;
-            case op_aaload: {
-                auto *index = frames->top()->pop<JInt>();
-                const auto *arrref = frames->top()->pop<JArray>();
-                if (!arrref) {
-                    throw runtime_error("nullpointerexception");
-                }
-                auto *elem = dynamic_cast<JRef *>(
-                    yrt.jheap->getElement(*arrref, index->val));
-                frames->top()->push(elem);
-            } break;
-            case op_istore: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->store<JInt>(index);
-            } break;
-            case op_lstore: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->store<JLong>(index);
-            } break;
-            case op_fstore: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->store<JFloat>(index);
-            } break;
-            case op_dstore: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->store<JDouble>(index);
-            } break;
-            case op_astore: {
-                const u1 index = consumeU1(code, op);
-                frames->top()->store<JRef>(index);
-            } break;
-            case op_istore_0: {
-                frames->top()->store<JInt>(0);
-            } break;
-            case op_istore_1: {
-                frames->top()->store<JInt>(1);
-            } break;
-            case op_istore_2: {
-                frames->top()->store<JInt>(2);
-            } break;
-            case op_istore_3: {
-                frames->top()->store<JInt>(3);
-            } break;
-            case op_lstore_0: {
-                frames->top()->store<JLong>(0);
-            } break;
-            case op_lstore_1: {
-                frames->top()->store<JLong>(1);
-            } break;
-            case op_lstore_2: {
-                frames->top()->store<JLong>(2);
-            } break;
-            case op_lstore_3: {
-                frames->top()->store<JLong>(3);
-            } break;
-            case op_fstore_0: {
-                frames->top()->store<JFloat>(0);
-            } break;
-            case op_fstore_1: {
-                frames->top()->store<JFloat>(1);
-            } break;
-            case op_fstore_2: {
-                frames->top()->store<JFloat>(2);
-            } break;
-            case op_fstore_3: {
-                frames->top()->store<JFloat>(3);
-            } break;
-            case op_dstore_0: {
-                frames->top()->store<JDouble>(0);
-            } break;
-            case op_dstore_1: {
-                frames->top()->store<JDouble>(1);
-            } break;
-            case op_dstore_2: {
-                frames->top()->store<JDouble>(2);
-            } break;
-            case op_dstore_3: {
-                frames->top()->store<JDouble>(3);
-            } break;
-            case op_astore_0: {
-                frames->top()->store<JRef>(0);
-            } break;
-            case op_astore_1: {
-                frames->top()->store<JRef>(1);
-            } break;
-            case op_astore_2: {
-                frames->top()->store<JRef>(2);
-            } break;
-            case op_astore_3: {
-                frames->top()->store<JRef>(3);
-            } break;
-            case op_iastore: {
-                auto *value = frames->top()->pop<JInt>();
-                auto *index = frames->top()->pop<JInt>();
-                auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                yrt.jheap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_lastore: {
-                auto *value = frames->top()->pop<JLong>();
-                auto *index = frames->top()->pop<JInt>();
-                auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                yrt.jheap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_fastore: {
-                auto *value = frames->top()->pop<JFloat>();
-                auto *index = frames->top()->pop<JInt>();
-                auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                yrt.jheap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_dastore: {
-                auto *value = frames->top()->pop<JDouble>();
-                auto *index = frames->top()->pop<JInt>();
-                auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                yrt.jheap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_aastore: {
-                auto *value = frames->top()->pop<JType>();
-                auto *index = frames->top()->pop<JInt>();
-                auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                yrt.jheap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_bastore: {
-                auto *value = frames->top()->pop<JInt>();
-                value->val = static_cast<int8_t>(value->val);
-                auto *index = frames->top()->pop<JInt>();
-                auto *arrref = frames->top()->pop<JArray>();
-
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                yrt.jheap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_sastore:
-            case op_castore: {
-                auto *value = frames->top()->pop<JInt>();
-                value->val = static_cast<int16_t>(value->val);
-
-                auto *index = frames->top()->pop<JInt>();
-                auto *arrref = frames->top()->pop<JArray>();
-                if (arrref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (index->val > arrref->length || index->val < 0) {
-                    throw runtime_error("array index out of bounds");
-                }
-                yrt.jheap->putElement(*arrref, index->val, value);
-
-            } break;
-            case op_pop: {
-                frames->top()->pop<JType>();
-            } break;
-            case op_pop2: {
-                frames->top()->pop<JType>();
-                frames->top()->pop<JType>();
-            } break;
-            case op_dup: {
-                JType *value = frames->top()->pop<JType>();
-
-                assert(typeid(*value) != typeid(JLong) &&
-                       typeid(*value) != typeid(JDouble));
-                frames->top()->push(value);
-                frames->top()->push(cloneValue(value));
-            } break;
-            case op_dup_x1: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
-
-                assert(IS_COMPUTATIONAL_TYPE_1(value1));
-                assert(IS_COMPUTATIONAL_TYPE_1(value2));
-
-                frames->top()->push(cloneValue(value1));
-                frames->top()->push(value2);
-                frames->top()->push(value1);
-            } break;
-            case op_dup_x2: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
-                JType *value3 = frames->top()->pop<JType>();
-
-                if (IS_COMPUTATIONAL_TYPE_1(value1) &&
-                    IS_COMPUTATIONAL_TYPE_1(value2) &&
-                    IS_COMPUTATIONAL_TYPE_1(value3)) {
-                    // use structure 1
-                    frames->top()->push(cloneValue(value1));
-                    frames->top()->push(value3);
-                    frames->top()->push(value2);
-                    frames->top()->push(value1);
-                } else if (IS_COMPUTATIONAL_TYPE_1(value1) &&
-                           IS_COMPUTATIONAL_TYPE_2(value2)) {
-                    // use structure 2
-                    frames->top()->push(value3);
-
-                    frames->top()->push(cloneValue(value1));
-                    frames->top()->push(value2);
-                    frames->top()->push(value1);
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
-            } break;
-            case op_dup2: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
-
-                if (IS_COMPUTATIONAL_TYPE_1(value1) &&
-                    IS_COMPUTATIONAL_TYPE_1(value2)) {
-                    // use structure 1
-                    frames->top()->push(cloneValue(value2));
-                    frames->top()->push(cloneValue(value1));
-                    frames->top()->push(value2);
-                    frames->top()->push(value1);
-                } else if (IS_COMPUTATIONAL_TYPE_2(value1)) {
-                    // use structure 2
-                    frames->top()->push(value2);
-
-                    frames->top()->push(cloneValue(value1));
-                    frames->top()->push(value1);
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
-            } break;
-            case op_dup2_x1: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
-                JType *value3 = frames->top()->pop<JType>();
-
-                if (IS_COMPUTATIONAL_TYPE_1(value1) &&
-                    IS_COMPUTATIONAL_TYPE_1(value2) &&
-                    IS_COMPUTATIONAL_TYPE_1(value3)) {
-                    // use structure 1
-                    frames->top()->push(cloneValue(value2));
-                    frames->top()->push(cloneValue(value1));
-                    frames->top()->push(value3);
-                    frames->top()->push(value2);
-                    frames->top()->push(value1);
-                } else if (IS_COMPUTATIONAL_TYPE_2(value1) &&
-                           IS_COMPUTATIONAL_TYPE_1(value2)) {
-                    // use structure 2
-                    frames->top()->push(value3);
-
-                    frames->top()->push(cloneValue(value1));
-                    frames->top()->push(value2);
-                    frames->top()->push(value1);
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
-            } break;
-            case op_dup2_x2: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
-                JType *value3 = frames->top()->pop<JType>();
-                JType *value4 = frames->top()->pop<JType>();
-                if (IS_COMPUTATIONAL_TYPE_1(value1) &&
-                    IS_COMPUTATIONAL_TYPE_1(value2) &&
-                    IS_COMPUTATIONAL_TYPE_1(value3) &&
-                    IS_COMPUTATIONAL_TYPE_1(value4)) {
-                    // use structure 1
-                    frames->top()->push(cloneValue(value2));
-                    frames->top()->push(cloneValue(value1));
-                    frames->top()->push(value4);
-                    frames->top()->push(value3);
-                    frames->top()->push(value2);
-                    frames->top()->push(value1);
-                } else if (IS_COMPUTATIONAL_TYPE_2(value1) &&
-                           IS_COMPUTATIONAL_TYPE_1(value2) &&
-                           IS_COMPUTATIONAL_TYPE_1(value3)) {
-                    // use structure 2
-                    frames->top()->push(value4);
-
-                    frames->top()->push(cloneValue(value1));
-                    frames->top()->push(value4);
-                    frames->top()->push(value2);
-                    frames->top()->push(value1);
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
-            } break;
-            case op_swap: {
-                JType *value1 = frames->top()->pop<JType>();
-                JType *value2 = frames->top()->pop<JType>();
-
-                assert(IS_COMPUTATIONAL_TYPE_1(value1));
-                assert(IS_COMPUTATIONAL_TYPE_1(value2));
-                if (typeid(*value1) == typeid(JInt) &&
-                    typeid(*value2) == typeid(JInt)) {
-                    swap(value1, value2);
-                } else if (typeid(*value1) == typeid(JInt) &&
-                           typeid(*value2) == typeid(JFloat)) {
-                    const int32_t temp = dynamic_cast<JInt *>(value1)->val;
-                    dynamic_cast<JInt *>(value1)->val = static_cast<int32_t>(
-                        dynamic_cast<JFloat *>(value2)->val);
-                    dynamic_cast<JFloat *>(value2)->val =
-                        static_cast<float>(temp);
-                } else if (typeid(*value1) == typeid(JFloat) &&
-                           typeid(*value2) == typeid(JInt)) {
-                    const float temp = dynamic_cast<JFloat *>(value1)->val;
-                    dynamic_cast<JFloat *>(value1)->val =
-                        static_cast<int32_t>(dynamic_cast<JInt *>(value2)->val);
-                    dynamic_cast<JInt *>(value2)->val =
-                        static_cast<int32_t>(temp);
-                } else if (typeid(*value1) == typeid(JFloat) &&
-                           typeid(*value2) == typeid(JFloat)) {
-                    swap(value1, value2);
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
-            } break;
-            case op_iadd: {
-                binaryArithmetic<JInt>(plus<>());
-            } break;
-            case op_ladd: {
-                binaryArithmetic<JLong>(plus<>());
-            } break;
-            case op_fadd: {
-                binaryArithmetic<JFloat>(plus<>());
-            } break;
-            case op_dadd: {
-                binaryArithmetic<JDouble>(plus<>());
-            } break;
-            case op_isub: {
-                binaryArithmetic<JInt>(minus<>());
-            } break;
-            case op_lsub: {
-                binaryArithmetic<JLong>(minus<>());
-            } break;
-            case op_fsub: {
-                binaryArithmetic<JFloat>(minus<>());
-            } break;
-            case op_dsub: {
-                binaryArithmetic<JDouble>(minus<>());
-            } break;
-            case op_imul: {
-                binaryArithmetic<JInt>(multiplies<>());
-            } break;
-            case op_lmul: {
-                binaryArithmetic<JLong>(multiplies<>());
-            } break;
-            case op_fmul: {
-                binaryArithmetic<JFloat>(multiplies<>());
-            } break;
-            case op_dmul: {
-                binaryArithmetic<JDouble>(multiplies<>());
-            } break;
-            case op_idiv: {
-                binaryArithmetic<JInt>(divides<>());
-            } break;
-            case op_ldiv: {
-                binaryArithmetic<JLong>(divides<>());
-            } break;
-            case op_fdiv: {
-                binaryArithmetic<JFloat>(divides<>());
-            } break;
-            case op_ddiv: {
-                binaryArithmetic<JDouble>(divides<>());
-
-            } break;
-            case op_irem: {
-                binaryArithmetic<JInt>(modulus<>());
-            } break;
-            case op_lrem: {
-                binaryArithmetic<JLong>(modulus<>());
-            } break;
-            case op_frem: {
-                binaryArithmetic<JFloat>(std::fmod<float, float>);
-            } break;
-            case op_drem: {
-                binaryArithmetic<JFloat>(std::fmod<double, double>);
-            } break;
-            case op_ineg: {
-                unaryArithmetic<JInt>(negate<>());
-            } break;
-            case op_lneg: {
-                unaryArithmetic<JLong>(negate<>());
-            } break;
-            case op_fneg: {
-                unaryArithmetic<JFloat>(negate<>());
-            } break;
-            case op_dneg: {
-                unaryArithmetic<JDouble>(negate<>());
-            } break;
-            case op_ishl: {
-                binaryArithmetic<JInt>([](int32_t a, int32_t b) -> int32_t {
-                    return a * pow(2, b & 0x1f);
-                });
-            } break;
-            case op_lshl: {
-                binaryArithmetic<JLong>([](int64_t a, int64_t b) -> int64_t {
-                    return a * pow(2, b & 0x3f);
-                });
-            } break;
-            case op_ishr: {
-                binaryArithmetic<JInt>([](int32_t a, int32_t b) -> int32_t {
-                    return floor(a / pow(2, b & 0x1f));
-                });
-            } break;
-            case op_lshr: {
-                binaryArithmetic<JLong>([](int64_t a, int64_t b) -> int64_t {
-                    return floor(a / pow(2, b & 0x3f));
-                });
-            } break;
-            case op_iushr: {
-                binaryArithmetic<JInt>([](int32_t a, int32_t b) -> int32_t {
-                    if (a > 0) {
-                        return a >> (b & 0x1f);
-                    } else if (a < 0) {
-                        return (a >> (b & 0x1f)) + (2 << ~(b & 0x1f));
-                    } else {
-                        throw runtime_error("0 is not handled");
-                    }
-                });
-            } break;
-            case op_lushr: {
-                binaryArithmetic<JLong>([](int64_t a, int64_t b) -> int64_t {
-                    if (a > 0) {
-                        return a >> (b & 0x3f);
-                    } else if (a < 0) {
-                        return (a >> (b & 0x1f)) + (2L << ~(b & 0x3f));
-                    } else {
-                        throw runtime_error("0 is not handled");
-                    }
-                });
-            } break;
-            case op_iand: {
-                binaryArithmetic<JInt>(bit_and<>());
-            } break;
-            case op_land: {
-                binaryArithmetic<JLong>(bit_and<>());
-            } break;
-            case op_ior: {
-                binaryArithmetic<JInt>(bit_or<>());
-            } break;
-            case op_lor: {
-                binaryArithmetic<JLong>(bit_or<>());
-            } break;
-            case op_ixor: {
-                binaryArithmetic<JInt>(bit_xor<>());
-            } break;
-            case op_lxor: {
-                binaryArithmetic<JLong>(bit_xor<>());
-            } break;
-            case op_iinc: {
-                const u1 index = code[++op];
-                const int8_t count = code[++op];
-                const int32_t extendedCount = count;
-                if (IS_JINT(frames->top()->getLocalVariable(index))) {
-                    dynamic_cast<JInt *>(frames->top()->getLocalVariable(index))
-                        ->val += extendedCount;
-                } else if (IS_JLong(frames->top()->getLocalVariable(index))) {
-                    dynamic_cast<JLong *>(
-                        frames->top()->getLocalVariable(index))
-                        ->val += extendedCount;
-                } else if (IS_JFloat(frames->top()->getLocalVariable(index))) {
-                    dynamic_cast<JFloat *>(
-                        frames->top()->getLocalVariable(index))
-                        ->val += extendedCount;
-                } else if (IS_JDouble(frames->top()->getLocalVariable(index))) {
-                    dynamic_cast<JDouble *>(
-                        frames->top()->getLocalVariable(index))
-                        ->val += extendedCount;
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
-            } break;
-            case op_i2l: {
-                typeCast<JInt, JLong>();
-            } break;
-            case op_i2f: {
-                typeCast<JInt, JFloat>();
-            } break;
-            case op_i2d: {
-                typeCast<JInt, JDouble>();
-            } break;
-            case op_l2i: {
-                typeCast<JLong, JInt>();
-            } break;
-            case op_l2f: {
-                typeCast<JLong, JFloat>();
-            } break;
-            case op_l2d: {
-                typeCast<JLong, JDouble>();
-            } break;
-            case op_f2i: {
-                typeCast<JFloat, JInt>();
-            } break;
-            case op_f2l: {
-                typeCast<JFloat, JLong>();
-            } break;
-            case op_f2d: {
-                typeCast<JFloat, JDouble>();
-            } break;
-            case op_d2i: {
-                typeCast<JDouble, JInt>();
-            } break;
-            case op_d2l: {
-                typeCast<JDouble, JLong>();
-            } break;
-            case op_d2f: {
-                typeCast<JDouble, JFloat>();
-            } break;
-            case op_i2c:
-            case op_i2b: {
-                auto *value = frames->top()->pop<JInt>();
-                auto *result = new JInt;
-                result->val = (int8_t)(value->val);
-                frames->top()->push(result);
-
-            } break;
-            case op_i2s: {
-                auto *value = frames->top()->pop<JInt>();
-                auto *result = new JInt;
-                result->val = (int16_t)(value->val);
-                frames->top()->push(result);
-
-            } break;
-            case op_lcmp: {
-                auto *value2 = frames->top()->pop<JLong>();
-                auto *value1 = frames->top()->pop<JLong>();
-                if (value1->val > value2->val) {
-                    auto *result = new JInt(1);
-                    frames->top()->push(result);
-                } else if (value1->val == value2->val) {
-                    auto *result = new JInt(0);
-                    frames->top()->push(result);
-                } else {
-                    auto *result = new JInt(-1);
-                    frames->top()->push(result);
-                }
-
-            } break;
-            case op_fcmpg:
-            case op_fcmpl: {
-                auto *value2 = frames->top()->pop<JFloat>();
-                auto *value1 = frames->top()->pop<JFloat>();
-                if (value1->val > value2->val) {
-                    auto *result = new JInt(1);
-                    frames->top()->push(result);
-                } else if (abs(value1->val - value2->val) < 0.000001) {
-                    auto *result = new JInt(0);
-                    frames->top()->push(result);
-                } else {
-                    auto *result = new JInt(-1);
-                    frames->top()->push(result);
-                }
-
-            } break;
-            case op_dcmpl:
-            case op_dcmpg: {
-                auto *value2 = frames->top()->pop<JDouble>();
-                auto *value1 = frames->top()->pop<JDouble>();
-                if (value1->val > value2->val) {
-                    auto *result = new JInt(1);
-                    frames->top()->push(result);
-                } else if (abs(value1->val - value2->val) < 0.000000000001) {
-                    auto *result = new JInt(0);
-                    frames->top()->push(result);
-                } else {
-                    auto *result = new JInt(-1);
-                    frames->top()->push(result);
-                }
-
-            } break;
-            case op_ifeq: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val == 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_ifne: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val != 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_iflt: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val < 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_ifge: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val >= 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_ifgt: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val > 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_ifle: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value = frames->top()->pop<JInt>();
-                if (value->val <= 0) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmpeq: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val == value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmpne: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val != value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmplt: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val < value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmpge: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val >= value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmpgt: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val > value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_icmple: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JInt>();
-                auto *value1 = frames->top()->pop<JInt>();
-                if (value1->val <= value2->val) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_acmpeq: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JObject>();
-                auto *value1 = frames->top()->pop<JObject>();
-                if (value1->offset == value2->offset &&
-                    value1->jc == value2->jc) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_if_acmpne: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                auto *value2 = frames->top()->pop<JObject>();
-                auto *value1 = frames->top()->pop<JObject>();
-                if (value1->offset != value2->offset ||
-                    value1->jc != value2->jc) {
-                    op = currentOffset + branchindex;
-                }
-
-            } break;
-            case op_goto: {
-                u4 currentOffset = op - 1;
-                int16_t branchindex = consumeU2(code, op);
-                op = currentOffset + branchindex;
-            } break;
-            case op_jsr: {
-                throw runtime_error("unsupported opcode [jsr]");
-            } break;
-            case op_ret: {
-                throw runtime_error("unsupported opcode [ret]");
-            } break;
-            case op_tableswitch: {
-                u4 currentOffset = op - 1;
-                op++;
-                op++;
-                op++;  // 3 bytes padding
-                int32_t defaultIndex = consumeU4(code, op);
-                int32_t low = consumeU4(code, op);
-                int32_t high = consumeU4(code, op);
-                vector<int32_t> jumpOffset;
-                FOR_EACH(i, high - low + 1) {
-                    jumpOffset.push_back(consumeU4(code, op));
-                }
-
-                auto *index = frames->top()->pop<JInt>();
-                if (index->val < low || index->val > high) {
-                    op = currentOffset + defaultIndex;
-                } else {
-                    op = currentOffset + jumpOffset[index->val - low];
-                }
+        HANDLE(op_lload) {
+            loadLocal<JLong>(sp, locals, pc->index);
+            NEXT();
+        }
+        HANDLE(op_fload) {
+            loadLocal<JFloat>(sp, locals, pc->index);
+            NEXT();
+        }
+        HANDLE(op_dload) {
+            loadLocal<JDouble>(sp, locals, pc->index);
+            NEXT();
+        }
+        HANDLE(op_aload) {
+            loadLocal<JRef>(sp, locals, pc->index);
+            NEXT();
+        }
+        HANDLE(op_iload_0) {
+            loadLocal<JInt>(sp, locals, 0);
+            NEXT();
+        }
+        HANDLE(op_iload_1) {
+            loadLocal<JInt>(sp, locals, 1);
+            NEXT();
+        }
+        HANDLE(op_iload_2) {
+            loadLocal<JInt>(sp, locals, 2);
+            NEXT();
+        }
+        HANDLE(op_iload_3) {
+            loadLocal<JInt>(sp, locals, 3);
+            NEXT();
+        }
+        HANDLE(op_lload_0) {
+            loadLocal<JLong>(sp, locals, 0);
+            NEXT();
+        }
+        HANDLE(op_lload_1) {
+            loadLocal<JLong>(sp, locals, 1);
+            NEXT();
+        }
+        HANDLE(op_lload_2) {
+            loadLocal<JLong>(sp, locals, 2);
+            NEXT();
+        }
+        HANDLE(op_lload_3) {
+            loadLocal<JLong>(sp, locals, 3);
+            NEXT();
+        }
+        HANDLE(op_fload_0) {
+            loadLocal<JFloat>(sp, locals, 0);
+            NEXT();
+        }
+        HANDLE(op_fload_1) {
+            loadLocal<JFloat>(sp, locals, 1);
+            NEXT();
+        }
+        HANDLE(op_fload_2) {
+            loadLocal<JFloat>(sp, locals, 2);
+            NEXT();
+        }
+        HANDLE(op_fload_3) {
+            loadLocal<JFloat>(sp, locals, 3);
+            NEXT();
+        }
+        HANDLE(op_dload_0) {
+            loadLocal<JDouble>(sp, locals, 0);
+            NEXT();
+        }
+        HANDLE(op_dload_1) {
+            loadLocal<JDouble>(sp, locals, 1);
+            NEXT();
+        }
+        HANDLE(op_dload_2) {
+            loadLocal<JDouble>(sp, locals, 2);
+            NEXT();
+        }
+        HANDLE(op_dload_3) {
+            loadLocal<JDouble>(sp, locals, 3);
+            NEXT();
+        }
+        HANDLE(op_aload_0) {
+            loadLocal<JRef>(sp, locals, 0);
+            NEXT();
+        }
+        HANDLE(op_aload_1) {
+            loadLocal<JRef>(sp, locals, 1);
+            NEXT();
+        }
+        HANDLE(op_aload_2) {
+            loadLocal<JRef>(sp, locals, 2);
+            NEXT();
+        }
+        HANDLE(op_aload_3) {
+            loadLocal<JRef>(sp, locals, 3);
+            NEXT();
+        }
+        HANDLE(op_saload)
+        HANDLE(op_caload)
+        HANDLE(op_baload)
+        HANDLE(op_iaload) {
+            arrayLoad<JInt>(sp);
+            NEXT();
+        }
+        HANDLE(op_laload) {
+            arrayLoad<JLong>(sp);
+            NEXT();
+        }
+        HANDLE(op_faload) {
+            arrayLoad<JFloat>(sp);
+            NEXT();
+        }
+        HANDLE(op_daload) {
+            arrayLoad<JDouble>(sp);
+            NEXT();
+        }
+        HANDLE(op_aaload) {
+            arrayLoad<JRef>(sp);
+            NEXT();
+        }
+        HANDLE(op_istore) {
+            storeLocal<JInt>(sp, locals, pc->index);
+            NEXT();
+        }
+        HANDLE(op_lstore) {
+            storeLocal<JLong>(sp, locals, pc->index);
+            NEXT();
+        }
+        HANDLE(op_fstore) {
+            storeLocal<JFloat>(sp, locals, pc->index);
+            NEXT();
+        }
+        HANDLE(op_dstore) {
+            storeLocal<JDouble>(sp, locals, pc->index);
+            NEXT();
+        }
+        HANDLE(op_astore) {
+            storeLocal<JRef>(sp, locals, pc->index);
+            NEXT();
+        }
+        HANDLE(op_istore_0) {
+            storeLocal<JInt>(sp, locals, 0);
+            NEXT();
+        }
+        HANDLE(op_istore_1) {
+            storeLocal<JInt>(sp, locals, 1);
+            NEXT();
+        }
+        HANDLE(op_istore_2) {
+            storeLocal<JInt>(sp, locals, 2);
+            NEXT();
+        }
+        HANDLE(op_istore_3) {
+            storeLocal<JInt>(sp, locals, 3);
+            NEXT();
+        }
+        HANDLE(op_lstore_0) {
+            storeLocal<JLong>(sp, locals, 0);
+            NEXT();
+        }
+        HANDLE(op_lstore_1) {
+            storeLocal<JLong>(sp, locals, 1);
+            NEXT();
+        }
+        HANDLE(op_lstore_2) {
+            storeLocal<JLong>(sp, locals, 2);
+            NEXT();
+        }
+        HANDLE(op_lstore_3) {
+            storeLocal<JLong>(sp, locals, 3);
+            NEXT();
+        }
+        HANDLE(op_fstore_0) {
+            storeLocal<JFloat>(sp, locals, 0);
+            NEXT();
+        }
+        HANDLE(op_fstore_1) {
+            storeLocal<JFloat>(sp, locals, 1);
+            NEXT();
+        }
+        HANDLE(op_fstore_2) {
+            storeLocal<JFloat>(sp, locals, 2);
+            NEXT();
+        }
+        HANDLE(op_fstore_3) {
+            storeLocal<JFloat>(sp, locals, 3);
+            NEXT();
+        }
+        HANDLE(op_dstore_0) {
+            storeLocal<JDouble>(sp, locals, 0);
+            NEXT();
+        }
+        HANDLE(op_dstore_1) {
+            storeLocal<JDouble>(sp, locals, 1);
+            NEXT();
+        }
+        HANDLE(op_dstore_2) {
+            storeLocal<JDouble>(sp, locals, 2);
+            NEXT();
+        }
+        HANDLE(op_dstore_3) {
+            storeLocal<JDouble>(sp, locals, 3);
+            NEXT();
+        }
+        HANDLE(op_astore_0) {
+            storeLocal<JRef>(sp, locals, 0);
+            NEXT();
+        }
+        HANDLE(op_astore_1) {
+            storeLocal<JRef>(sp, locals, 1);
+            NEXT();
+        }
+        HANDLE(op_astore_2) {
+            storeLocal<JRef>(sp, locals, 2);
+            NEXT();
+        }
+        HANDLE(op_astore_3) {
+            storeLocal<JRef>(sp, locals, 3);
+            NEXT();
+        }
+        HANDLE(op_iastore) {
+            arrayStore<JInt>(sp);
+            NEXT();
+        }
+        HANDLE(op_lastore) {
+            arrayStore<JLong>(sp);
+            NEXT();
+        }
+        HANDLE(op_fastore) {
+            arrayStore<JFloat>(sp);
+            NEXT();
+        }
+        HANDLE(op_dastore) {
+            arrayStore<JDouble>(sp);
+            NEXT();
+        }
+        HANDLE(op_aastore) {
+            arrayStore<JRef>(sp);
+            NEXT();
+        }
+        HANDLE(op_bastore) {
+            arrayStore<JInt>(sp, [](int32_t value) {
+                return static_cast<int8_t>(value);
+            });
+            NEXT();
+        }
+        HANDLE(op_sastore) {
+            arrayStore<JInt>(sp, [](int32_t value) {
+                return static_cast<int16_t>(value);
+            });
+            NEXT();
+        }
+        HANDLE(op_castore) {
+            arrayStore<JInt>(sp, [](int32_t value) {
+                return static_cast<uint16_t>(value);
+            });
+            NEXT();
+        }
+        HANDLE(op_pop) {
+            --sp;
+            NEXT();
+        }
+        HANDLE(op_pop2) {
+            sp -= 2;
+            NEXT();
+        }
+        // Since long and double take up two slots, all stack manipulating
+        // instructions only need to shuffle raw slots as jvm specification
+        // form 1 described, no matter what kind of values they hold
+        HANDLE(op_dup) {
+            const JValue value1 = *--sp;
+
+            *sp++ = value1;
+            *sp++ = value1;
+            NEXT();
+        }
+        HANDLE(op_dup_x1) {
+            const JValue value1 = *--sp;
+            const JValue value2 = *--sp;
+
+            *sp++ = value1;
+            *sp++ = value2;
+            *sp++ = value1;
+            NEXT();
+        }
+        HANDLE(op_dup_x2) {
+            const JValue value1 = *--sp;
+            const JValue value2 = *--sp;
+            const JValue value3 = *--sp;
+
+            *sp++ = value1;
+            *sp++ = value3;
+            *sp++ = value2;
+            *sp++ = value1;
+            NEXT();
+        }
+        HANDLE(op_dup2) {
+            const JValue value1 = *--sp;
+            const JValue value2 = *--sp;
+
+            *sp++ = value2;
+            *sp++ = value1;
+            *sp++ = value2;
+            *sp++ = value1;
+            NEXT();
+        }
+        HANDLE(op_dup2_x1) {
+            const JValue value1 = *--sp;
+            const JValue value2 = *--sp;
+            const JValue value3 = *--sp;
+
+            *sp++ = value2;
+            *sp++ = value1;
+            *sp++ = value3;
+            *sp++ = value2;
+            *sp++ = value1;
+            NEXT();
+        }
+        HANDLE(op_dup2_x2) {
+            const JValue value1 = *--sp;
+            const JValue value2 = *--sp;
+            const JValue value3 = *--sp;
+            const JValue value4 = *--sp;
+
+            *sp++ = value2;
+            *sp++ = value1;
+            *sp++ = value4;
+            *sp++ = value3;
+            *sp++ = value2;
+            *sp++ = value1;
+            NEXT();
+        }
+        HANDLE(op_swap) {
+            const JValue value1 = *--sp;
+            const JValue value2 = *--sp;
 
-            } break;
-            case op_lookupswitch: {
-                u4 currentOffset = op - 1;
-                op++;
-                op++;
-                op++;  // 3 bytes padding
-                int32_t defaultIndex = consumeU4(code, op);
-                int32_t npair = consumeU4(code, op);
-                map<int32_t, int32_t> matchOffset;
-                FOR_EACH(i, npair) {
-                    matchOffset.insert(
-                        make_pair(consumeU4(code, op), consumeU4(code, op)));
-                }
-                auto *key = frames->top()->pop<JInt>();
-                auto res = matchOffset.find(key->val);
-                if (res != matchOffset.end()) {
-                    op = currentOffset + (*res).second;
-                } else {
-                    op = currentOffset + defaultIndex;
-                }
-            } break;
-            case op_ireturn: {
-                return cloneValue(frames->top()->pop<JInt>());
-            } break;
-            case op_lreturn: {
-                return cloneValue(frames->top()->pop<JLong>());
-            } break;
-            case op_freturn: {
-                return cloneValue(frames->top()->pop<JFloat>());
-            } break;
-            case op_dreturn: {
-                return cloneValue(frames->top()->pop<JDouble>());
-            } break;
-            case op_areturn: {
-                return cloneValue(frames->top()->pop<JType>());
-            } break;
-            case op_return: {
-                return nullptr;
-            } break;
-            case op_getstatic: {
-                const u2 index = consumeU2(code, op);
-                auto symbolicRef = parseFieldSymbolicReference(jc, index);
-                yrt.ma->linkClassIfAbsent(symbolicRef.jc->getClassName());
-                yrt.ma->initClassIfAbsent(*this,
-                                          symbolicRef.jc->getClassName());
-                JType *field = symbolicRef.jc->getStaticVar(
-                    symbolicRef.name, symbolicRef.descriptor);
-                frames->top()->push(field);
-            } break;
-            case op_putstatic: {
-                u2 index = consumeU2(code, op);
-                JType *value = frames->top()->pop<JType>();
-                auto symbolicRef = parseFieldSymbolicReference(jc, index);
-
-                yrt.ma->linkClassIfAbsent(symbolicRef.jc->getClassName());
-                yrt.ma->initClassIfAbsent(*this,
-                                          symbolicRef.jc->getClassName());
-                symbolicRef.jc->setStaticVar(symbolicRef.name,
-                                             symbolicRef.descriptor, value);
-            } break;
-            case op_getfield: {
-                u2 index = consumeU2(code, op);
-                JObject *objectref = frames->top()->pop<JObject>();
-                auto symbolicRef = parseFieldSymbolicReference(jc, index);
-                JType *field = cloneValue(yrt.jheap->getFieldByName(
-                    symbolicRef.jc, symbolicRef.name, symbolicRef.descriptor,
-                    objectref));
-                frames->top()->push(field);
-
-            } break;
-            case op_putfield: {
-                const u2 index = consumeU2(code, op);
-                JType *value = frames->top()->pop<JType>();
-                JObject *objectref = frames->top()->pop<JObject>();
-                auto symbolicRef = parseFieldSymbolicReference(jc, index);
-                yrt.jheap->putFieldByName(symbolicRef.jc, symbolicRef.name,
-                                          symbolicRef.descriptor, objectref,
-                                          value);
-
-            } break;
-            case op_invokevirtual: {
-                const u2 index = consumeU2(code, op);
-                assert(typeid(*jc->raw.constPoolInfo[index]) ==
-                       typeid(CONSTANT_Methodref));
-
-                auto symbolicRef = parseMethodSymbolicReference(jc, index);
-
-                if (symbolicRef.name == "<init>") {
-                    runtime_error(
-                        "invoking method should not be instance "
-                        "initialization method\n");
-                }
-                if (!IS_SIGNATURE_POLYMORPHIC_METHOD(
-                        symbolicRef.jc->getClassName(), symbolicRef.name)) {
-                    invokeVirtual(symbolicRef.name, symbolicRef.descriptor);
+            *sp++ = value1;
+            *sp++ = value2;
+            NEXT();
+        }
+        HANDLE(op_iadd) {
+            binaryArithmetic<JInt>(sp, [](int32_t a, int32_t b) -> int32_t {
+                return static_cast<uint32_t>(a) + static_cast<uint32_t>(b);
+            });
+            NEXT();
+        }
+        HANDLE(op_ladd) {
+            binaryArithmetic<JLong>(sp, [](int64_t a, int64_t b) -> int64_t {
+                return static_cast<uint64_t>(a) + static_cast<uint64_t>(b);
+            });
+            NEXT();
+        }
+        HANDLE(op_fadd) {
+            binaryArithmetic<JFloat>(sp, plus<>());
+            NEXT();
+        }
+        HANDLE(op_dadd) {
+            binaryArithmetic<JDouble>(sp, plus<>());
+            NEXT();
+        }
+        HANDLE(op_isub) {
+            binaryArithmetic<JInt>(sp, [](int32_t a, int32_t b) -> int32_t {
+                return static_cast<uint32_t>(a) - static_cast<uint32_t>(b);
+            });
+            NEXT();
+        }
+        HANDLE(op_lsub) {
+            binaryArithmetic<JLong>(sp, [](int64_t a, int64_t b) -> int64_t {
+                return static_cast<uint64_t>(a) - static_cast<uint64_t>(b);
+            });
+            NEXT();
+        }
+        HANDLE(op_fsub) {
+            binaryArithmetic<JFloat>(sp, minus<>());
+            NEXT();
+        }
+        HANDLE(op_dsub) {
+            binaryArithmetic<JDouble>(sp, minus<>());
+            NEXT();
+        }
+        HANDLE(op_imul) {
+            binaryArithmetic<JInt>(sp, [](int32_t a, int32_t b) -> int32_t {
+                return static_cast<uint32_t>(a) * static_cast<uint32_t>(b);
+            });
+            NEXT();
+        }
+        HANDLE(op_lmul) {
+            binaryArithmetic<JLong>(sp, [](int64_t a, int64_t b) -> int64_t {
+                return static_cast<uint64_t>(a) * static_cast<uint64_t>(b);
+            });
+            NEXT();
+        }
+        HANDLE(op_fmul) {
+            binaryArithmetic<JFloat>(sp, multiplies<>());
+            NEXT();
+        }
+        HANDLE(op_dmul) {
+            binaryArithmetic<JDouble>(sp, multiplies<>());
+            NEXT();
+        }
+        HANDLE(op_idiv) {
+            binaryArithmetic<JInt>(sp, IntegerDivides<int32_t>());
+            NEXT();
+        }
+        HANDLE(op_ldiv) {
+            binaryArithmetic<JLong>(sp, IntegerDivides<int64_t>());
+            NEXT();
+        }
+        HANDLE(op_fdiv) {
+            binaryArithmetic<JFloat>(sp, divides<>());
+            NEXT();
+        }
+        HANDLE(op_ddiv) {
+            binaryArithmetic<JDouble>(sp, divides<>());
+            NEXT();
+        }
+        HANDLE(op_irem) {
+            binaryArithmetic<JInt>(sp, IntegerModulus<int32_t>());
+            NEXT();
+        }
+        HANDLE(op_lrem) {
+            binaryArithmetic<JLong>(sp, IntegerModulus<int64_t>());
+            NEXT();
+        }
+        HANDLE(op_frem) {
+            binaryArithmetic<JFloat>(sp, [](float a, float b) -> float {
+                return std::fmod(a, b);
+            });
+            NEXT();
+        }
+        HANDLE(op_drem) {
+            binaryArithmetic<JDouble>(sp, [](double a, double b) -> double {
+                return std::fmod(a, b);
+            });
+            NEXT();
+        }
+        HANDLE(op_ineg) {
+            unaryArithmetic<JInt>(sp, [](int32_t a) -> int32_t {
+                return -static_cast<uint32_t>(a);
+            });
+            NEXT();
+        }
+        HANDLE(op_lneg) {
+            unaryArithmetic<JLong>(sp, [](int64_t a) -> int64_t {
+                return -static_cast<uint64_t>(a);
+            });
+            NEXT();
+        }
+        HANDLE(op_fneg) {
+            unaryArithmetic<JFloat>(sp, negate<>());
+            NEXT();
+        }
+        HANDLE(op_dneg) {
+            unaryArithmetic<JDouble>(sp, negate<>());
+            NEXT();
+        }
+        HANDLE(op_ishl) {
+            shiftArithmetic<JInt>(sp, [](int32_t a, int32_t b) -> int32_t {
+                return static_cast<uint32_t>(a) << (b & 0x1f);
+            });
+            NEXT();
+        }
+        HANDLE(op_lshl) {
+            shiftArithmetic<JLong>(sp, [](int64_t a, int32_t b) -> int64_t {
+                return static_cast<uint64_t>(a) << (b & 0x3f);
+            });
+            NEXT();
+        }
+        HANDLE(op_ishr) {
+            shiftArithmetic<JInt>(sp, [](int32_t a, int32_t b) -> int32_t {
+                return a >> (b & 0x1f);
+            });
+            NEXT();
+        }
+        HANDLE(op_lshr) {
+            shiftArithmetic<JLong>(sp, [](int64_t a, int32_t b) -> int64_t {
+                return a >> (b & 0x3f);
+            });
+            NEXT();
+        }
+        HANDLE(op_iushr) {
+            shiftArithmetic<JInt>(sp, [](int32_t a, int32_t b) -> int32_t {
+                return static_cast<uint32_t>(a) >> (b & 0x1f);
+            });
+            NEXT();
+        }
+        HANDLE(op_lushr) {
+            shiftArithmetic<JLong>(sp, [](int64_t a, int32_t b) -> int64_t {
+                return static_cast<uint64_t>(a) >> (b & 0x3f);
+            });
+            NEXT();
+        }
+        HANDLE(op_iand) {
+            binaryArithmetic<JInt>(sp, bit_and<>());
+            NEXT();
+        }
+        HANDLE(op_land) {
+            binaryArithmetic<JLong>(sp, bit_and<>());
+            NEXT();
+        }
+        HANDLE(op_ior) {
+            binaryArithmetic<JInt>(sp, bit_or<>());
+            NEXT();
+        }
+        HANDLE(op_lor) {
+            binaryArithmetic<JLong>(sp, bit_or<>());
+            NEXT();
+        }
+        HANDLE(op_ixor) {
+            binaryArithmetic<JInt>(sp, bit_xor<>());
+            NEXT();
+        }
+        HANDLE(op_lxor) {
+            binaryArithmetic<JLong>(sp, bit_xor<>());
+            NEXT();
+        }
+        HANDLE(op_iinc) {
+            locals[pc->index].i = static_cast<uint32_t>(locals[pc->index].i) +
+                                  static_cast<uint32_t>(pc->operand);
+            NEXT();
+        }
+        HANDLE(op_i2l) {
+            typeCast<JInt, JLong>(sp);
+            NEXT();
+        }
+        HANDLE(op_i2f) {
+            typeCast<JInt, JFloat>(sp);
+            NEXT();
+        }
+        HANDLE(op_i2d) {
+            typeCast<JInt, JDouble>(sp);
+            NEXT();
+        }
+        HANDLE(op_l2i) {
+            typeCast<JLong, JInt>(sp);
+            NEXT();
+        }
+        HANDLE(op_l2f) {
+            typeCast<JLong, JFloat>(sp);
+            NEXT();
+        }
+        HANDLE(op_l2d) {
+            typeCast<JLong, JDouble>(sp);
+            NEXT();
+        }
+        HANDLE(op_f2i) {
+            typeCast<JFloat, JInt>(sp);
+            NEXT();
+        }
+        HANDLE(op_f2l) {
+            typeCast<JFloat, JLong>(sp);
+            NEXT();
+        }
+        HANDLE(op_f2d) {
+            typeCast<JFloat, JDouble>(sp);
+            NEXT();
+        }
+        HANDLE(op_d2i) {
+            typeCast<JDouble, JInt>(sp);
+            NEXT();
+        }
+        HANDLE(op_d2l) {
+            typeCast<JDouble, JLong>(sp);
+            NEXT();
+        }
+        HANDLE(op_d2f) {
+            typeCast<JDouble, JFloat>(sp);
+            NEXT();
+        }
+        HANDLE(op_i2b) {
+            unaryArithmetic<JInt>(sp, [](int32_t value) {
+                return static_cast<int8_t>(value);
+            });
+            NEXT();
+        }
+        HANDLE(op_i2c) {
+            unaryArithmetic<JInt>(sp, [](int32_t value) {
+                return static_cast<uint16_t>(value);
+            });
+            NEXT();
+        }
+        HANDLE(op_i2s) {
+            unaryArithmetic<JInt>(sp, [](int32_t value) {
+                return static_cast<int16_t>(value);
+            });
+            NEXT();
+        }
+        HANDLE(op_lcmp) {
+            const int64_t value2 = popOperand<JLong>(sp);
+            const int64_t value1 = popOperand<JLong>(sp);
+            if (value1 > value2) {
+                pushOperand<JInt>(sp, 1);
+            } else if (value1 == value2) {
+                pushOperand<JInt>(sp, 0);
+            } else {
+                pushOperand<JInt>(sp, -1);
+            }
+            NEXT();
+        }
+        HANDLE(op_fcmpg)
+        HANDLE(op_fcmpl) {
+            compareFloating<JFloat>(sp, pc->opcode == op_fcmpg ? 1 : -1);
+            NEXT();
+        }
+        HANDLE(op_dcmpl)
+        HANDLE(op_dcmpg) {
+            compareFloating<JDouble>(sp, pc->opcode == op_dcmpg ? 1 : -1);
+            NEXT();
+        }
+        HANDLE(op_ifeq) {
+            if (popOperand<JInt>(sp) == 0) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_ifne) {
+            if (popOperand<JInt>(sp) != 0) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_iflt) {
+            if (popOperand<JInt>(sp) < 0) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_ifge) {
+            if (popOperand<JInt>(sp) >= 0) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_ifgt) {
+            if (popOperand<JInt>(sp) > 0) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_ifle) {
+            if (popOperand<JInt>(sp) <= 0) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_if_icmpeq) {
+            const int32_t value2 = popOperand<JInt>(sp);
+            const int32_t value1 = popOperand<JInt>(sp);
+            if (value1 == value2) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_if_icmpne) {
+            const int32_t value2 = popOperand<JInt>(sp);
+            const int32_t value1 = popOperand<JInt>(sp);
+            if (value1 != value2) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_if_icmplt) {
+            const int32_t value2 = popOperand<JInt>(sp);
+            const int32_t value1 = popOperand<JInt>(sp);
+            if (value1 < value2) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_if_icmpge) {
+            const int32_t value2 = popOperand<JInt>(sp);
+            const int32_t value1 = popOperand<JInt>(sp);
+            if (value1 >= value2) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_if_icmpgt) {
+            const int32_t value2 = popOperand<JInt>(sp);
+            const int32_t value1 = popOperand<JInt>(sp);
+            if (value1 > value2) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_if_icmple) {
+            const int32_t value2 = popOperand<JInt>(sp);
+            const int32_t value1 = popOperand<JInt>(sp);
+            if (value1 <= value2) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_if_acmpeq) {
+            auto *value2 = popOperand<JRef>(sp);
+            auto *value1 = popOperand<JRef>(sp);
+            if (isSameReference(value1, value2)) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_if_acmpne) {
+            auto *value2 = popOperand<JRef>(sp);
+            auto *value1 = popOperand<JRef>(sp);
+            if (!isSameReference(value1, value2)) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_goto_w)
+        HANDLE(op_goto) {
+            BRANCH(pc);
+        }
+        HANDLE(op_jsr) {
+            throw runtime_error("unsupported opcode [jsr]");
+        }
+        HANDLE(op_ret) {
+            throw runtime_error("unsupported opcode [ret]");
+        }
+        HANDLE(op_tableswitch) {
+            // [default, low, high, target...]
+            const int32_t *table = switchTables + pc->operand;
+            const int32_t index = popOperand<JInt>(sp);
+            if (index < table[1] || index > table[2]) {
+                JUMP(table[0]);
+            }
+            JUMP(table[3 + (static_cast<int64_t>(index) - table[1])]);
+        }
+        HANDLE(op_lookupswitch) {
+            // [default, npairs, match, target...], pairs are sorted by
+            // match value so we can use binary search
+            const int32_t *table = switchTables + pc->operand;
+            const int32_t key = popOperand<JInt>(sp);
+            int32_t low = 0;
+            int32_t high = table[1] - 1;
+            while (low <= high) {
+                const int32_t mid = low + (high - low) / 2;
+                const int32_t match = table[2 + mid * 2];
+                if (match == key) {
+                    JUMP(table[3 + mid * 2]);
+                } else if (match < key) {
+                    low = mid + 1;
                 } else {
-                    // TODO:TO BE IMPLEMENTED
+                    high = mid - 1;
                 }
+            }
+            JUMP(table[0]);
+        }
+        HANDLE(op_ireturn) {
+            returnValue = popOperandValue<JInt>(sp);
+            goto methodReturn;
+        }
+        HANDLE(op_lreturn) {
+            returnValue = popOperandValue<JLong>(sp);
+            goto methodReturn;
+        }
+        HANDLE(op_freturn) {
+            returnValue = popOperandValue<JFloat>(sp);
+            goto methodReturn;
+        }
+        HANDLE(op_dreturn) {
+            returnValue = popOperandValue<JDouble>(sp);
+            goto methodReturn;
+        }
+        HANDLE(op_areturn) {
+            returnValue = popOperandValue<JRef>(sp);
+            goto methodReturn;
+        }
+        HANDLE(op_return) {
+            returnValue = JValue{};
+            goto methodReturn;
+        }
+        HANDLE(op_putstatic)
+        HANDLE(op_getstatic) {
+            FLUSH_SP();
+            FLUSH_PC();
+            const StaticFieldCache field = resolveStaticField(jc, decoded, pc);
+            const u1 opcode = loadOpcode(pc);
+            if (opcode == op_getstatic) {
+                pushOperandValue(sp, unboxValue(*field.slot, field.type));
+            } else if (opcode == op_putstatic) {
+                putStaticValue(field, popFieldValue(sp, field.type));
+            } else {
+                // Current instruction has been quickened
+                DISPATCH();
+            }
+            NEXT();
+        }
+        HANDLE(op_fast_getstatic) {
+            const StaticFieldCache &field = staticFieldCaches[pc->operand];
+            pushOperandValue(sp, unboxValue(*field.slot, field.type));
+            NEXT();
+        }
+        HANDLE(op_fast_putstatic) {
+            const StaticFieldCache &field = staticFieldCaches[pc->operand];
+            putStaticValue(field, popFieldValue(sp, field.type));
+            NEXT();
+        }
+        HANDLE(op_putfield)
+        HANDLE(op_getfield) {
+            // Resolve field reference and re-execute current instruction as
+            // its quickened form
+            quickenFieldAccess(jc, decoded, pc, sp);
+            DISPATCH();
+        }
+        HANDLE(op_fast_getfield) {
+            JObject *objectref = popOperand<JObject>(sp);
+            pushOperandValue(sp,
+                             getFieldValue(fieldCaches[pc->operand],
+                                           objectref));
+            NEXT();
+        }
+        HANDLE(op_fast_putfield) {
+            const FieldCache &cache = fieldCaches[pc->operand];
+            const JValue value = popFieldValue(sp, cache.type);
+            putFieldValue(cache, popOperand<JObject>(sp), value);
+            NEXT();
+        }
+        HANDLE(op_iinc_goto) {
+            locals[pc->index].i = static_cast<uint32_t>(locals[pc->index].i) +
+                                  static_cast<uint32_t>(pc->operand);
+            BRANCH(pc + 1);
+        }
+        HANDLE(op_aload_getfield) {
+            if (loadOpcode(pc + 1) != op_fast_getfield) {
+                // Field has not been resolved, getfield quickens itself
+                loadLocal<JRef>(sp, locals, pc->index);
+                NEXT();
+            }
+            JObject *objectref = static_cast<JObject *>(locals[pc->index].ref);
+            pushOperandValue(
+                sp, getFieldValue(fieldCaches[pc[1].operand], objectref));
+            pc += 2;
+            DISPATCH();
+        }
+        HANDLE(op_aload_iload_iaload) {
+            loadLocal<JRef>(sp, locals, pc->index);
+            loadLocal<JInt>(sp, locals, pc[1].index);
+            arrayLoad<JInt>(sp);
+            pc += 3;
+            DISPATCH();
+        }
+        HANDLE(op_iload_iconst_iadd_istore) {
+            SlotTraits<JInt>::set(locals[pc[3].index],
+                                  static_cast<uint32_t>(locals[pc->index].i) +
+                                      static_cast<uint32_t>(pc[1].operand));
+            pc += 4;
+            DISPATCH();
+        }
+        HANDLE(op_iload_iload_if_icmpeq) {
+            if (locals[pc->index].i == locals[pc[1].index].i) {
+                BRANCH(pc + 2);
+            }
+            pc += 3;
+            DISPATCH();
+        }
+        HANDLE(op_iload_iload_if_icmpne) {
+            if (locals[pc->index].i != locals[pc[1].index].i) {
+                BRANCH(pc + 2);
+            }
+            pc += 3;
+            DISPATCH();
+        }
+        HANDLE(op_iload_iload_if_icmplt) {
+            if (locals[pc->index].i < locals[pc[1].index].i) {
+                BRANCH(pc + 2);
+            }
+            pc += 3;
+            DISPATCH();
+        }
+        HANDLE(op_iload_iload_if_icmpge) {
+            if (locals[pc->index].i >= locals[pc[1].index].i) {
+                BRANCH(pc + 2);
+            }
+            pc += 3;
+            DISPATCH();
+        }
+        HANDLE(op_iload_iload_if_icmpgt) {
+            if (locals[pc->index].i > locals[pc[1].index].i) {
+                BRANCH(pc + 2);
+            }
+            pc += 3;
+            DISPATCH();
+        }
+        HANDLE(op_iload_iload_if_icmple) {
+            if (locals[pc->index].i <= locals[pc[1].index].i) {
+                BRANCH(pc + 2);
+            }
+            pc += 3;
+            DISPATCH();
+        }
+        HANDLE(op_invokevirtual)
+        HANDLE(op_invokespecial)
+        HANDLE(op_invokestatic)
+        HANDLE(op_invokeinterface) {
+            FLUSH_SP();
+            FLUSH_PC();
+            csite = resolveInvocation(jc, inlineCaches, pc, isObjectMethod);
+            if (!csite.isCallable()) {
+                // TODO:TO BE IMPLEMENTED
+                NEXT();
+            }
+            goto callMethod;
+        }
+        HANDLE(op_invokedynamic) {
+            throw runtime_error("unsupported opcode [invokedynamic]");
+        }
+        HANDLE(op_new) {
+            const u2 index = pc->index;
+            FLUSH_SP();
+            FLUSH_PC();
+            JObject *objectref = execNew(jc, index);
+            pushOperand<JObject>(sp, objectref);
+            NEXT();
+        }
+        HANDLE(op_newarray) {
+            const int32_t count = popOperand<JInt>(sp);
+            pushOperand<JArray>(sp, execNewArray(pc->index, count));
+            NEXT();
+        }
+        HANDLE(op_anewarray) {
+            const int32_t count = popOperand<JInt>(sp);
+            pushOperand<JArray>(sp, execANewArray(jc, pc->index, count));
+            NEXT();
+        }
+        HANDLE(op_arraylength) {
+            JArray *arrayref = popOperand<JArray>(sp);
 
-            } break;
-            case op_invokespecial: {
-                const u2 index = consumeU2(code, op);
-                SymbolicRef symbolicRef;
-
-                if (typeid(*jc->raw.constPoolInfo[index]) ==
-                    typeid(CONSTANT_InterfaceMethodref)) {
-                    symbolicRef =
-                        parseInterfaceMethodSymbolicReference(jc, index);
-                } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-                           typeid(CONSTANT_Methodref)) {
-                    symbolicRef = parseMethodSymbolicReference(jc, index);
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
+            if (arrayref == nullptr) {
+                throw runtime_error("null pointer\n");
+            }
+            pushOperand<JInt>(sp, arrayref->length);
+            NEXT();
+        }
+        HANDLE(op_athrow) {
+            throwobj = popOperand<JObject>(sp);
+            goto throwException;
+        }
+        HANDLE(op_checkcast) {
+            throw runtime_error("unsupported opcode [checkcast]");
+        }
+        HANDLE(op_instanceof) {
+            const u2 index = pc->index;
+            auto *objectref = popOperand<JObject>(sp);
+            if (objectref == nullptr) {
+                pushOperand<JInt>(sp, 0);
+            } else if (checkInstanceof(jc, index, objectref)) {
+                pushOperand<JInt>(sp, 1);
+            } else {
+                pushOperand<JInt>(sp, 0);
+            }
+            NEXT();
+        }
+        HANDLE(op_monitorenter) {
+            JType *ref = popOperand<JRef>(sp);
 
-                // If all of the following are true, let C be the direct
-                // superclass of the current class :
-                JavaClass *symbolicRefClass = symbolicRef.jc;
-                if ("<init>" != symbolicRef.name) {
-                    if (!IS_CLASS_INTERFACE(
-                            symbolicRefClass->raw.accessFlags)) {
-                        if (symbolicRefClass->getClassName() ==
-                            jc->getSuperClassName()) {
-                            if (IS_CLASS_SUPER(jc->raw.accessFlags)) {
-                                invokeSpecial(yrt.ma->findJavaClass(
-                                                  jc->getSuperClassName()),
-                                              symbolicRef.name,
-                                              symbolicRef.descriptor);
-                                break;
-                            }
-                        }
-                    }
-                }
-                // Otherwise let C be the symbolic reference class
-                invokeSpecial(symbolicRef.jc, symbolicRef.name,
-                              symbolicRef.descriptor);
-            } break;
-            case op_invokestatic: {
-                // Invoke a class (static) method
-                const u2 index = consumeU2(code, op);
-
-                if (typeid(*jc->raw.constPoolInfo[index]) ==
-                    typeid(CONSTANT_InterfaceMethodref)) {
-                    auto symbolicRef =
-                        parseInterfaceMethodSymbolicReference(jc, index);
-                    invokeStatic(symbolicRef.jc, symbolicRef.name,
-                                 symbolicRef.descriptor);
-                } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-                           typeid(CONSTANT_Methodref)) {
-                    auto symbolicRef = parseMethodSymbolicReference(jc, index);
-                    invokeStatic(symbolicRef.jc, symbolicRef.name,
-                                 symbolicRef.descriptor);
-                } else {
-                    SHOULD_NOT_REACH_HERE
-                }
-            } break;
-            case op_invokeinterface: {
-                const u2 index = consumeU2(code, op);
-                ++op;  // read count and discard
-                ++op;  // opcode padding 0;
-
-                if (typeid(*jc->raw.constPoolInfo[index]) ==
-                    typeid(CONSTANT_InterfaceMethodref)) {
-                    auto symbolicRef =
-                        parseInterfaceMethodSymbolicReference(jc, index);
-                    invokeInterface(symbolicRef.jc, symbolicRef.name,
-                                    symbolicRef.descriptor);
-                }
-            } break;
-            case op_invokedynamic: {
-                throw runtime_error("unsupported opcode [invokedynamic]");
-            } break;
-            case op_new: {
-                const u2 index = consumeU2(code, op);
-                JObject *objectref = execNew(jc, index);
-                frames->top()->push(objectref);
-            } break;
-            case op_newarray: {
-                const u1 atype = code[++op];
-                JInt *count = frames->top()->pop<JInt>();
-
-                if (count->val < 0) {
-                    throw runtime_error("negative array size");
-                }
-                JArray *arrayref = yrt.jheap->createPODArray(atype, count->val);
+            if (ref == nullptr) {
+                throw runtime_error("null pointer");
+            }
 
-                frames->top()->push(arrayref);
+            if (!yrt.jheap->hasMonitor(ref)) {
+                yrt.jheap->createMonitor(ref);
+            }
+            yrt.jheap->findMonitor(ref)->enter(this_thread::get_id());
+            NEXT();
+        }
+        HANDLE(op_monitorexit) {
+            JType *ref = popOperand<JRef>(sp);
 
-            } break;
-            case op_anewarray: {
-                const u2 index = consumeU2(code, op);
-                auto symbolicRef = parseClassSymbolicReference(jc, index);
-                JInt *count = frames->top()->pop<JInt>();
+            if (ref == nullptr) {
+                throw runtime_error("null pointer");
+            }
+            if (!yrt.jheap->hasMonitor(ref)) {
+                yrt.jheap->createMonitor(ref);
+            }
+            yrt.jheap->findMonitor(ref)->exit();
+            NEXT();
+        }
+        HANDLE(op_wide) {
+            throw runtime_error("unsupported opcode [wide]");
+        }
+        HANDLE(op_multianewarray) {
+            throw runtime_error("unsupported opcode [multianewarray]");
+        }
+        HANDLE(op_ifnull) {
+            JType *value = popOperand<JRef>(sp);
+            if (value == nullptr) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_ifnonnull) {
+            JType *value = popOperand<JRef>(sp);
+            if (value != nullptr) {
+                BRANCH(pc);
+            }
+            NEXT();
+        }
+        HANDLE(op_jsr_w) {
+            throw runtime_error("unsupported opcode [jsr_w]");
+        }
+        HANDLE(op_breakpoint)
+        HANDLE(op_impdep1)
+        HANDLE(op_impdep2) {
+            // Reserved opcodde
+            cerr << "Are you a dot.class hacker? Or you were entered a "
+                    "strange region.";
+            exit(EXIT_FAILURE);
+        }
+        DEFAULT_HANDLER {
+            cerr << "The YVM can not recognize this opcode. Bytecode file "
+                    "was be corrupted.";
+            exit(EXIT_FAILURE);
+        }
+    }
 
-                if (count->val < 0) {
-                    throw runtime_error("negative array size");
-                }
-                JArray *arrayref =
-                    yrt.jheap->createObjectArray(*symbolicRef.jc, count->val);
+callMethod:
+    // Native methods are executed by invokeMethod() since they may reenter
+    // interpreter, so are compiled methods which run on native stack. Other
+    // bytecode methods get a new frame and are executed here
+    FLUSH_PC();
+    compiled = csite.decoded != nullptr ? TemplateJIT::enter(csite) : nullptr;
+    if (csite.decoded == nullptr || compiled != nullptr) {
+        invokeMethod(csite, isObjectMethod, compiled);
+        RELOAD_SP();
+        CHECK_PENDING_EXCEPTION();
+        NEXT();
+    }
+    if (!frames->pushFrame(csite.exec->maxLocal, csite.exec->maxStack,
+                           getArgumentSlots(csite, isObjectMethod))) {
+        // Arguments are left on operand stack of caller, they are discarded
+        // along with its operand stack when the error was handled
+        throwobj = raiseStackOverflowError(
+            csite.jc->getString(csite.method->nameIndex));
+        goto throwException;
+    }
+    frames->top()->jc = csite.jc;
+    frames->top()->method = csite.method;
+    frames->top()->decoded = csite.decoded;
+    LOAD_FRAME();
+    DISPATCH();
+
+loopBackedge:
+    // A loop that keeps running either runs its trace or moves the rest of
+    // current activation into compiled code, both continue from the beginning
+    // of next iteration
+    pc = code + branch->operand;
+    if (yrt.trace) {
+        // Traces are not entered while recording, it must see every
+        // instruction
+        if (recorder == nullptr) {
+            recordTrace = false;
+            trace = TraceJIT::backedge(decoded, branch->index, recordTrace);
+            if (trace != nullptr) {
+                FLUSH_SP();
+                if (TraceJIT::run(*this, trace)) {
+                    LOAD_FRAME();
+                    CHECK_PENDING_EXCEPTION();
+                }
+            } else if (recordTrace) {
+                recorder.reset(
+                    new TraceRecorder(frame, branch->index, branch->operand));
+                SELECT_HANDLERS();
+            }
+        }
+        DISPATCH();
+    }
+    compiled = TemplateJIT::backedge(jc, frame->method, decoded, branch->index);
+    if (compiled != nullptr &&
+        frames->hasRoom(frame->stackSlots + frame->maxStack +
+                            compiled->extraStack,
+                        0)) {
+        FLUSH_SP();
+        returnValue = TemplateJIT::runOsr(*this, compiled, pc - code);
+        if (exception.hasUnhandledException()) {
+            throwobj = static_cast<JObject *>(returnValue.ref);
+            goto throwException;
+        }
+        goto methodReturn;
+    }
+    DISPATCH();
 
-                frames->top()->push(arrayref);
-            } break;
-            case op_arraylength: {
-                JArray *arrayref = frames->top()->pop<JArray>();
+recordInstruction:
+    // The recorder sees each instruction before it's executed
+    if (!recorder->record(frame, pc, sp)) {
+        STOP_RECORDING();
+    }
+    EXECUTE();
 
-                if (arrayref == nullptr) {
-                    throw runtime_error("null pointer\n");
-                }
-                JInt *length = new JInt;
-                length->val = arrayref->length;
-                frames->top()->push(length);
-
-            } break;
-            case op_athrow: {
-                auto *throwobj = frames->top()->pop<JObject>();
-                if (throwobj == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (!hasInheritanceRelationship(
-                        throwobj->jc,
-                        yrt.ma->loadClassIfAbsent("java/lang/Throwable"))) {
-                    throw runtime_error("it's not a throwable object");
-                }
+methodReturn:
+    if (frame == entryFrame) {
+        return returnValue;
+    }
+    {
+        // Caller resumes after its invoking instruction with return value on
+        // top of operand stack
+        const bool hasResult =
+            frame->method->shape.returnType != T_EXTRA_VOID;
+        frames->popFrame();
+        LOAD_FRAME();
+        if (hasResult) {
+            pushOperandValue(sp, returnValue);
+        }
+    }
 
-                if (handleException(jc, exceptLen, exceptTab, throwobj, op)) {
-                    while (!frames->top()->emptyStack()) {
-                        frames->top()->pop<JType>();
-                    }
-                    frames->top()->push(throwobj);
-                } else /* Exception can not handled within method handlers */ {
-                    exception.markException();
-                    exception.setThrowExceptionInfo(throwobj);
-                    return throwobj;
-                }
-            } break;
-            case op_checkcast: {
-                throw runtime_error("unsupported opcode [checkcast]");
-            } break;
-            case op_instanceof: {
-                const u2 index = consumeU2(code, op);
-                auto *objectref = frames->top()->pop<JObject>();
-                if (objectref == nullptr) {
-                    frames->top()->push(new JInt(0));
-                }
-                if (checkInstanceof(jc, index, objectref)) {
-                    frames->top()->push(new JInt(1));
-                } else {
-                    frames->top()->push(new JInt(0));
-                }
-            } break;
-            case op_monitorenter: {
-                JType *ref = frames->top()->pop<JType>();
+    GC_SAFE_POINT
+    if (yrt.gc->shallGC()) {
+        FLUSH_SP();
+        yrt.gc->stopTheWorld();
+        yrt.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);
+    }
+    NEXT();
 
-                if (ref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
+pendingException:
+    // If callee propagates a unhandled exception, it was pushed onto our
+    // operand stack
+    throwobj = popOperand<JObject>(sp);
 
-                if (!yrt.jheap->hasMonitor(ref)) {
-                    dynamic_cast<JObject *>(ref)->offset =
-                        yrt.jheap->createMonitor();
-                }
-                yrt.jheap->findMonitor(ref)->enter(this_thread::get_id());
-            } break;
-            case op_monitorexit: {
-                JType *ref = frames->top()->pop<JType>();
+throwException:
+    // Recorded path ends at an exception
+    if (recorder != nullptr) {
+        STOP_RECORDING();
+    }
+    if (throwobj == nullptr) {
+        throw runtime_error("null pointer");
+    }
+    if (!hasInheritanceRelationship(
+            throwobj->jc, yrt.ma->loadClassIfAbsent("java/lang/Throwable"))) {
+        throw runtime_error("it's not a throwable object");
+    }
 
-                if (ref == nullptr) {
-                    throw runtime_error("null pointer");
-                }
-                if (!yrt.jheap->hasMonitor(ref)) {
-                    dynamic_cast<JObject *>(ref)->offset =
-                        yrt.jheap->createMonitor();
-                }
-                yrt.jheap->findMonitor(ref)->exit();
-
-            } break;
-            case op_wide: {
-                throw runtime_error("unsupported opcode [wide]");
-            } break;
-            case op_multianewarray: {
-                throw runtime_error("unsupported opcode [multianewarray]");
-            } break;
-            case op_ifnull: {
-                u4 currentOffset = op - 1;
-                int16_t branchIndex = consumeU2(code, op);
-                JObject *value = frames->top()->pop<JObject>();
-                if (value == nullptr) {
-                    op = currentOffset + branchIndex;
-                }
-            } break;
-            case op_ifnonnull: {
-                u4 currentOffset = op - 1;
-                int16_t branchIndex = consumeU2(code, op);
-                JObject *value = frames->top()->pop<JObject>();
-                if (value != nullptr) {
-                    op = currentOffset + branchIndex;
-                }
-            } break;
-            case op_goto_w: {
-                u4 currentOffset = op - 1;
-                int32_t branchIndex = consumeU4(code, op);
-                op = currentOffset + branchIndex;
-            } break;
-            case op_jsr_w: {
-                throw runtime_error("unsupported opcode [jsr_w]");
-            } break;
-            case op_breakpoint:
-            case op_impdep1:
-            case op_impdep2: {
-                // Reserved opcodde
-                cerr << "Are you a dot.class hacker? Or you were entered a "
-                        "strange region.";
-                exit(EXIT_FAILURE);
-            } break;
-            default:
-                cerr << "The YVM can not recognize this opcode. Bytecode file "
-                        "was be corrupted.";
-                exit(EXIT_FAILURE);
-        }
+    handlerPC = pc - code;
+    if (handleException(jc, decoded, throwobj, handlerPC)) {
+        sp = frame->stackSlots;
+        pushOperand<JObject>(sp, throwobj);
+        exception.sweepException();
+        JUMP(handlerPC);
+    }
+    // Exception can not handled within method handlers
+    if (!exception.hasUnhandledException()) {
+        exception.markException();
+        exception.setThrowExceptionInfo(throwobj);
+    }
+    if (frame == entryFrame) {
+        return makeValue<JObject>(throwobj);
     }
-    return nullptr;
+    // Unwind to the caller and try to handle it there
+    exception.extendExceptionStackTrace(
+        frame->jc->getString(frame->method->nameIndex));
+    frames->popFrame();
+    LOAD_FRAME();
+    goto throwException;
 }
 //--------------------------------------------------------------------------------
 //  This function does "ldc" opcode jc type of JavaClass, which indicate where
 //  to resolve
 //--------------------------------------------------------------------------------
-void Interpreter::loadConstantPoolItem2Stack(const JavaClass *jc, u2 index) {
-    if (typeid(*jc->raw.constPoolInfo[index]) == typeid(CONSTANT_Integer)) {
-        auto val =
-            dynamic_cast<CONSTANT_Integer *>(jc->raw.constPoolInfo[index])->val;
-        JInt *ival = new JInt;
-        ival->val = val;
-        frames->top()->push(ival);
-    } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-               typeid(CONSTANT_Float)) {
-        auto val =
-            dynamic_cast<CONSTANT_Float *>(jc->raw.constPoolInfo[index])->val;
-        JFloat *fval = new JFloat;
-        fval->val = val;
-        frames->top()->push(fval);
-    } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-               typeid(CONSTANT_String)) {
-        auto val = jc->getString(
-            dynamic_cast<CONSTANT_String *>(jc->raw.constPoolInfo[index])
-                ->stringIndex);
-        JObject *str = yrt.jheap->createObject(
-            *yrt.ma->loadClassIfAbsent("java/lang/String"));
-        JArray *value = yrt.jheap->createCharArray(val, val.length());
-        // Put string  into str's field; according the source file of
-        // java.lang.Object, we know that its first field was used to store
-        // chars
-        yrt.jheap->putFieldByOffset(*str, 0, value);
-        frames->top()->push(str);
-    } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-               typeid(CONSTANT_Class)) {
-        throw runtime_error("nonsupport region");
-    } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-               typeid(CONSTANT_MethodType)) {
-        throw runtime_error("nonsupport region");
-    } else if (typeid(*jc->raw.constPoolInfo[index]) ==
-               typeid(CONSTANT_MethodHandle)) {
-        throw runtime_error("nonsupport region");
-    } else {
-        throw runtime_error(
-            "invalid symbolic reference index on constant "
-            "pool");
+void Interpreter::loadConstantPoolItem2Stack(const JavaClass *jc, u2 index,
+                                             JValue *&sp) {
+    const ConstantPool &cp = jc->raw.constPool;
+    switch (cp.tag(index)) {
+        case TAG_Integer:
+            pushOperand<JInt>(sp, cp.intValue(index));
+            break;
+        case TAG_Float:
+            pushOperand<JFloat>(sp, cp.floatValue(index));
+            break;
+        case TAG_String: {
+            const string &val = jc->getString(cp.nameIndex(index));
+            JObject *str = yrt.jheap->createObject(
+                *yrt.ma->loadClassIfAbsent("java/lang/String"));
+            JArray *value = yrt.jheap->createCharArray(val, val.length());
+            // Put string  into str's field; according the source file of
+            // java.lang.Object, we know that its first field was used to store
+            // chars
+            yrt.jheap->putFieldByOffset(*str, 0, value);
+            pushOperand<JObject>(sp, str);
+            break;
+        }
+        case TAG_Class:
+        case TAG_MethodType:
+        case TAG_MethodHandle:
+            throw runtime_error("nonsupport region");
+        default:
+            throw runtime_error(
+                "invalid symbolic reference index on constant "
+                "pool");
     }
 }
 
-bool Interpreter::handleException(const JavaClass *jc, u2 exceptLen,
-                                  ExceptionTable *exceptTab,
+bool Interpreter::handleException(const JavaClass *jc,
+                                  const DecodedCode *decoded,
                                   const JObject *objectref, u4 &op) {
-    FOR_EACH(i, exceptLen) {
-        const string &catchTypeName =
-            jc->getString(dynamic_cast<CONSTANT_Class *>(
-                              jc->raw.constPoolInfo[exceptTab[i].catchType])
-                              ->nameIndex);
-
-        if (hasInheritanceRelationship(
-                yrt.ma->findJavaClass(objectref->jc->getClassName()),
-                yrt.ma->findJavaClass(catchTypeName)) &&
-            exceptTab[i].startPC <= op && op < exceptTab[i].endPC) {
-            // start<=op<end
-            // If we found a proper exception handler, set current pc as
-            // handlerPC of this exception table item;
-            op = exceptTab[i].handlerPC - 1;
-            return true;
-        }
-        if (exceptTab[i].catchType == 0) {
-            op = exceptTab[i].handlerPC - 1;
-            return true;
+    for (const auto &handler : decoded->exceptionTable) {
+        // start<=op<end
+        if (op < handler.startPC || op >= handler.endPC) {
+            continue;
         }
+        // A catch type of zero indicates this handler catches any exceptions
+        if (handler.catchType != 0) {
+            const string &catchTypeName =
+                jc->getString(jc->raw.constPool.nameIndex(handler.catchType));
+            if (!hasInheritanceRelationship(
+                    yrt.ma->findJavaClass(objectref->jc->getClassName()),
+                    yrt.ma->findJavaClass(catchTypeName))) {
+                continue;
+            }
+        }
+        // If we found a proper exception handler, set current pc as
+        // handlerPC of this exception table item;
+        op = handler.handlerPC;
+        return true;
     }
 
     return false;
 }
 
-JObject *Interpreter::execNew(const JavaClass *jc, u2 index) {
-    yrt.ma->linkClassIfAbsent(const_cast<JavaClass *>(jc)->getClassName());
-    yrt.ma->initClassIfAbsent(*this,
-                              const_cast<JavaClass *>(jc)->getClassName());
+JValue Interpreter::popFieldValue(JValue *&sp, char type) {
+    switch (type) {
+        case 'J':
+            return popOperandValue<JLong>(sp);
+        case 'D':
+            return popOperandValue<JDouble>(sp);
+        case 'F':
+            return popOperandValue<JFloat>(sp);
+        case 'L':
+        case '[':
+            return popOperandValue<JRef>(sp);
+        default:
+            return popOperandValue<JInt>(sp);
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Resolve the field referred by getfield/putfield and rewrite the instruction
+// to its fast form, which accesses the resolved field slot directly
+//--------------------------------------------------------------------------------
+void Interpreter::quickenFieldAccess(const JavaClass *jc, DecodedCode *decoded,
+                                     Instruction *pc, const JValue *sp) {
+    const SymbolicRef &symbolicRef =
+        parseFieldSymbolicReference(jc, pc->index);
+    u4 ordinal = 0;
+    const JavaClass *declaringClass = symbolicRef.jc->findInstanceField(
+        symbolicRef.name, symbolicRef.descriptor, ordinal);
+    if (declaringClass == nullptr) {
+        throw runtime_error("can not find field " + symbolicRef.name->str() +
+                            " " + symbolicRef.descriptor->str());
+    }
+
+    // Object reference lies beneath the value to be put
+    const char type = symbolicRef.descriptor->str()[0];
+    int objectDepth = 1;
+    const u1 opcode = loadOpcode(pc);
+    if (opcode == op_putfield || opcode == op_fast_putfield) {
+        objectDepth += (type == 'J' || type == 'D') ? 2 : 1;
+    }
+    const auto *objectref = static_cast<JObject *>(sp[-objectDepth].ref);
+    if (objectref == nullptr) {
+        throw runtime_error("null pointer");
+    }
+
+    lock_guard<mutex> lock(quickeningMutex);
+    if ((opcode != op_getfield && opcode != op_putfield) ||
+        loadOpcode(pc) != opcode) {
+        // Someone else has quickened this instruction
+        return;
+    }
+    FieldCache &cache = decoded->fieldCaches[pc->operand];
+    cache.type = type;
+    cache.slotFromEnd = declaringClass->getInstanceFieldCount() - ordinal;
+    cache.receiverClass = objectref->jc;
+    cache.slot = objectref->jc->getInstanceFieldCount() - cache.slotFromEnd;
+    // Cache must be visible to other threads before the fast instruction
+    publishOpcode(pc, opcode == op_getfield ? op_fast_getfield
+                                            : op_fast_putfield);
+}
+
+//--------------------------------------------------------------------------------
+// Resolve the static field referred by getstatic/putstatic and initialize its
+// class. Once <clinit> has finished, nobody needs to check initialization of
+// the class again, so the instruction is rewritten to its fast form which
+// accesses the static variable directly
+//--------------------------------------------------------------------------------
+StaticFieldCache Interpreter::resolveStaticField(const JavaClass *jc,
+                                                 DecodedCode *decoded,
+                                                 Instruction *pc) {
+    const SymbolicRef &symbolicRef =
+        parseFieldSymbolicReference(jc, pc->index);
+    yrt.ma->initClassIfAbsent(*this, symbolicRef.jc->getClassName());
+
+    u2 fieldIndex = 0;
+    JavaClass *declaringClass = symbolicRef.jc->findStaticField(
+        symbolicRef.name, symbolicRef.descriptor, fieldIndex);
+    if (declaringClass == nullptr) {
+        throw runtime_error("can not find field " + symbolicRef.name->str() +
+                            " " + symbolicRef.descriptor->str());
+    }
+    yrt.ma->linkClassIfAbsent(declaringClass->getClassName());
+
+    StaticFieldCache field{};
+    field.slot = &declaringClass->staticVars.find(fieldIndex)->second;
+    field.type = symbolicRef.descriptor->str()[0];
+
+    // The class may still be initializing by <clinit> of current thread
+    if (symbolicRef.jc->isInitialized()) {
+        lock_guard<mutex> lock(quickeningMutex);
+        const u1 opcode = loadOpcode(pc);
+        if (opcode == op_getstatic || opcode == op_putstatic) {
+            decoded->staticFieldCaches[pc->operand] = field;
+            publishOpcode(pc, opcode == op_getstatic ? op_fast_getstatic
+                                                     : op_fast_putstatic);
+        }
+    }
+    return field;
+}
 
-    if (typeid(*jc->raw.constPoolInfo[index]) != typeid(CONSTANT_Class)) {
+bool Interpreter::isSameReference(const JType *value1, const JType *value2) {
+    if (value1 == value2) {
+        return true;
+    }
+    if (value1 == nullptr || value2 == nullptr) {
+        return false;
+    }
+    // Different handles may refer to the same object on java heap
+    const auto *object1 = dynamic_cast<const JObject *>(value1);
+    const auto *object2 = dynamic_cast<const JObject *>(value2);
+    if (object1 != nullptr && object2 != nullptr) {
+        return object1->offset == object2->offset;
+    }
+    const auto *array1 = dynamic_cast<const JArray *>(value1);
+    const auto *array2 = dynamic_cast<const JArray *>(value2);
+    if (array1 != nullptr && array2 != nullptr) {
+        return array1->offset == array2->offset;
+    }
+    return false;
+}
+
+JObject *Interpreter::execNew(const JavaClass *jc, u2 index) {
+    if (!jc->raw.constPool.is(index, TAG_Class)) {
         throw runtime_error(
             "operand index of new is not a class or "
             "interface\n");
     }
-    string className = jc->getString(
-        dynamic_cast<CONSTANT_Class *>(jc->raw.constPoolInfo[index])
-            ->nameIndex);
-    JavaClass *newClass = yrt.ma->loadClassIfAbsent(className);
+    JavaClass *newClass = parseClassSymbolicReference(jc, index).jc;
+    if (!newClass->isInitialized()) {
+        yrt.ma->initClassIfAbsent(*this, newClass->getClassName());
+    }
     return yrt.jheap->createObject(*newClass);
 }
 
+JArray *Interpreter::execNewArray(u1 atype, int32_t count) {
+    if (count < 0) {
+        throw runtime_error("negative array size");
+    }
+    return yrt.jheap->createPODArray(atype, count);
+}
+
+JArray *Interpreter::execANewArray(const JavaClass *jc, u2 index,
+                                   int32_t count) {
+    const SymbolicRef &symbolicRef = parseClassSymbolicReference(jc, index);
+    if (count < 0) {
+        throw runtime_error("negative array size");
+    }
+    return yrt.jheap->createObjectArray(*symbolicRef.jc, count);
+}
+
 bool Interpreter::checkInstanceof(const JavaClass *jc, u2 index,
                                   JType *objectref) {
-    string TclassName =
-        (char *)dynamic_cast<CONSTANT_Utf8 *>(
-            jc->raw.constPoolInfo[dynamic_cast<CONSTANT_Class *>(
-                                      jc->raw.constPoolInfo[index])
-                                      ->nameIndex])
-            ->bytes;
+    const string &TclassName =
+        jc->getString(jc->raw.constPool.nameIndex(index));
     constexpr short TYPE_ARRAY = 1;
     constexpr short TYPE_CLASS = 2;
     constexpr short TYPE_INTERFACE = 3;
@@ -1488,37 +1784,41 @@ bool Interpreter::checkInstanceof(const JavaClass *jc, u2 index,
     if (TclassName.find('[') != string::npos) {
         tType = TYPE_ARRAY;
     } else {
-        if (IS_CLASS_INTERFACE(
-                yrt.ma->findJavaClass(TclassName)->raw.accessFlags)) {
+        const JavaClass *target = yrt.ma->findJavaClass(TclassName);
+        if (target == nullptr) {
+            // No object can be an instance of a class that was never loaded
+            return false;
+        }
+        if (IS_CLASS_INTERFACE(target->raw.accessFlags)) {
             tType = TYPE_INTERFACE;
         } else {
             tType = TYPE_CLASS;
         }
     }
 
-    if (typeid(objectref) == typeid(JObject)) {
+    if (typeid(*objectref) == typeid(JObject)) {
         if (!IS_CLASS_INTERFACE(
                 dynamic_cast<JObject *>(objectref)->jc->raw.accessFlags)) {
             // If it's an ordinary class
             if (tType == TYPE_CLASS) {
-                if (yrt.ma->findJavaClass(dynamic_cast<JObject *>(objectref)
-                                              ->jc->getClassName())
-                            ->getClassName() == TclassName ||
-                    yrt.ma->findJavaClass(dynamic_cast<JObject *>(objectref)
-                                              ->jc->getSuperClassName())
-                            ->getClassName() == TclassName) {
-                    return true;
+                // Walk up the whole superclass chain of the dynamic type
+                const JavaClass *c = dynamic_cast<JObject *>(objectref)->jc;
+                while (c != nullptr) {
+                    if (c->getClassName() == TclassName) {
+                        return true;
+                    }
+                    c = c->hasSuperClass()
+                            ? yrt.ma->findJavaClass(c->getSuperClassSymbol())
+                            : nullptr;
                 }
             } else if (tType == TYPE_INTERFACE) {
                 auto &&interfaceIdxs = dynamic_cast<JObject *>(objectref)
                                            ->jc->getInterfacesIndex();
                 FOR_EACH(i, interfaceIdxs.size()) {
-                    string interfaceName =
+                    // Interface indexes refer to names of interfaces
+                    const string &interfaceName =
                         dynamic_cast<JObject *>(objectref)->jc->getString(
-                            dynamic_cast<CONSTANT_Class *>(
-                                dynamic_cast<JObject *>(objectref)
-                                    ->jc->raw.constPoolInfo[interfaceIdxs[i]])
-                                ->nameIndex);
+                            interfaceIdxs[i]);
                     if (interfaceName == TclassName) {
                         return true;
                     }
@@ -1543,7 +1843,7 @@ bool Interpreter::checkInstanceof(const JavaClass *jc, u2 index,
                 SHOULD_NOT_REACH_HERE
             }
         }
-    } else if (typeid(objectref) == typeid(JArray)) {
+    } else if (typeid(*objectref) == typeid(JArray)) {
         if (tType == TYPE_CLASS) {
             if (TclassName == "java/lang/Object") {
                 return true;
@@ -1553,11 +1853,8 @@ bool Interpreter::checkInstanceof(const JavaClass *jc, u2 index,
                 yrt.jheap->getElement(*dynamic_cast<JArray *>(objectref), 0));
             auto &&interfaceIdxs = firstComponent->jc->getInterfacesIndex();
             FOR_EACH(i, interfaceIdxs.size()) {
-                if (firstComponent->jc->getString(
-                        dynamic_cast<CONSTANT_Class *>(
-                            firstComponent->jc->raw
-                                .constPoolInfo[interfaceIdxs[i]])
-                            ->nameIndex) == TclassName) {
+                if (firstComponent->jc->getString(interfaceIdxs[i]) ==
+                    TclassName) {
                     return true;
                 }
             }
@@ -1569,68 +1866,141 @@ bool Interpreter::checkInstanceof(const JavaClass *jc, u2 index,
     } else {
         SHOULD_NOT_REACH_HERE
     }
+    return false;
 }
 
-void Interpreter::pushMethodArguments(vector<int> &parameter,
-                                      bool isObjectMethod) {
-    if (parameter.size() > 0) {
-        for (int localIndex = parameter.size() - (isObjectMethod ? 0 : 1),
-                 paramIndex = parameter.size() - 1;
-             paramIndex >= 0; localIndex--, paramIndex--) {
-            if (parameter[paramIndex] == T_INT ||
-                parameter[paramIndex] == T_BOOLEAN ||
-                parameter[paramIndex] == T_CHAR ||
-                parameter[paramIndex] == T_BYTE ||
-                parameter[paramIndex] == T_SHORT) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JInt>());
-            } else if (parameter[paramIndex] == T_FLOAT) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JFloat>());
-            } else if (parameter[paramIndex] == T_DOUBLE) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JDouble>());
-            } else if (parameter[paramIndex] == T_LONG) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JLong>());
-            } else if (parameter[paramIndex] == T_EXTRA_ARRAY) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JArray>());
-            } else if (parameter[paramIndex] == T_EXTRA_OBJECT) {
-                frames->top()->setLocalVariable(
-                    localIndex, frames->nextFrame()->pop<JObject>());
-            } else {
-                SHOULD_NOT_REACH_HERE;
-            }
+//--------------------------------------------------------------------------------
+// Create a StackOverflowError when there is no room for frame of callee, and
+// mark it as a pending exception which is thrown by given method
+//--------------------------------------------------------------------------------
+JObject *Interpreter::raiseStackOverflowError(const string &name) {
+    JavaClass *errorClass =
+        yrt.ma->loadClassIfAbsent("java/lang/StackOverflowError");
+    if (errorClass == nullptr) {
+        throw runtime_error("stack overflow");
+    }
+    yrt.ma->linkClassIfAbsent("java/lang/StackOverflowError");
+    JObject *error = yrt.jheap->createObject(*errorClass);
+    exception.markException();
+    exception.setThrowExceptionInfo(error);
+    exception.extendExceptionStackTrace(name);
+    return error;
+}
+
+//--------------------------------------------------------------------------------
+// Method referenced by invokevirtual/invokeinterface as entry index of vtable
+// of jc, and its shape by which we locate the receiver before selecting the
+// method to be invoked. They are cached in inline cache of the call site
+//--------------------------------------------------------------------------------
+static const MethodShape &resolveReferencedMethod(InlineCache *cache,
+                                                  const JavaClass *&jc,
+                                                  int &index,
+                                                  const Symbol *name,
+                                                  const Symbol *descriptor) {
+    if (cache != nullptr) {
+        const MethodShape *shape = cache->shape.load(memory_order_acquire);
+        if (shape != nullptr) {
+            jc = cache->methodClass;
+            index = cache->methodIndex;
+            return *shape;
+        }
+    }
+    index = jc->findVirtualMethod(name, descriptor);
+    if (index < 0) {
+        // Public methods of java/lang/Object may be invoked on an interface
+        jc = yrt.ma->findJavaClass("java/lang/Object");
+        index = jc->findVirtualMethod(name, descriptor);
+        if (index < 0) {
+            throw runtime_error("can not find method " + name->str() + " " +
+                                descriptor->str());
+        }
+    }
+    const MethodShape *shape = &jc->getVirtualMethod(index).method->shape;
+    if (cache != nullptr) {
+        lock_guard<mutex> lock(quickeningMutex);
+        if (cache->shape.load(memory_order_relaxed) == nullptr) {
+            cache->methodClass = jc;
+            cache->methodIndex = index;
+            cache->shape.store(shape, memory_order_release);
+        }
+    }
+    return *shape;
+}
+
+//--------------------------------------------------------------------------------
+// Look up the method selected for receiver class in inline cache of current
+// call site. On a miss the method is selected by select() and cached if there
+// is a free entry, call sites without inline cache always call select()
+//--------------------------------------------------------------------------------
+template <typename Selector>
+static CallSite lookupInlineCache(InlineCache *cache,
+                                  const JavaClass *receiverClass,
+                                  Selector select) {
+    if (cache == nullptr) {
+        return select();
+    }
+    for (auto &entry : cache->entries) {
+        const JavaClass *cached =
+            entry.receiverClass.load(memory_order_acquire);
+        if (cached == receiverClass) {
+            return CallSite::makeCallSite(entry.jc, entry.method);
+        }
+        if (cached == nullptr) {
+            break;
         }
     }
-    if (isObjectMethod) {
-        frames->top()->setLocalVariable(0, frames->nextFrame()->pop<JObject>());
+
+    CallSite csite = select();
+    if (csite.isCallable()) {
+        lock_guard<mutex> lock(quickeningMutex);
+        for (auto &entry : cache->entries) {
+            const JavaClass *cached =
+                entry.receiverClass.load(memory_order_relaxed);
+            if (cached == receiverClass) {
+                break;
+            }
+            if (cached == nullptr) {
+                entry.jc = csite.jc;
+                entry.method = csite.method;
+                entry.receiverClass.store(receiverClass, memory_order_release);
+                break;
+            }
+        }
     }
+    return csite;
 }
+
 //--------------------------------------------------------------------------------
 // Invoke by given name, this method was be used internally
 //--------------------------------------------------------------------------------
 void Interpreter::invokeByName(JavaClass *jc, const string &name,
                                const string &descriptor) {
-    const int returnType = get<0>(peelMethodParameterAndType(descriptor));
-
     MethodInfo *m = jc->findMethod(name, descriptor);
     CallSite csite = CallSite::makeCallSite(jc, m);
     if (!csite.isCallable()) {
         return;
     }
 
-    frames->pushFrame(csite.maxLocal, csite.maxStack);
+    // Like any other invocation, <clinit> and main run as compiled code once
+    // it's present, code compiled ahead of time is always present
+    CompiledMethod *compiled =
+        csite.decoded != nullptr ? TemplateJIT::enter(csite) : nullptr;
+    const int maxStack =
+        csite.exec->maxStack +
+        (compiled != nullptr ? static_cast<int>(compiled->extraStack) : 0);
+    if (!frames->pushFrame(csite.exec->maxLocal, maxStack)) {
+        raiseStackOverflowError(name);
+        exception.printStackTrace();
+        return;
+    }
 
-    JType *returnValue{};
+    JValue returnValue{};
     if (IS_METHOD_NATIVE(m->accessFlags)) {
-        returnValue =
-            cloneValue(execNativeMethod(jc->getClassName(), name, descriptor));
+        returnValue = execNativeMethod(m);
+    } else if (compiled != nullptr) {
+        returnValue = TemplateJIT::run(*this, csite, compiled);
     } else {
-        returnValue =
-            cloneValue(execByteCode(jc, csite.code, csite.codeLength,
-                                    csite.exceptionLen, csite.exception));
+        returnValue = execByteCode(jc, m, csite.decoded);
     }
     frames->popFrame();
 
@@ -1639,9 +2009,6 @@ void Interpreter::invokeByName(JavaClass *jc, const string &name,
     // need to push its value into upper frame  again (In fact there is no more
     // frame), we just print stack trace inforamtion to notice user and
     // return directly
-    if (returnType != T_EXTRA_VOID) {
-        frames->top()->push(returnValue);
-    }
     if (exception.hasUnhandledException()) {
         exception.extendExceptionStackTrace(name);
         exception.printStackTrace();
@@ -1653,134 +2020,120 @@ void Interpreter::invokeByName(JavaClass *jc, const string &name,
         yrt.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);
     }
 }
+
 //--------------------------------------------------------------------------------
-// Invoke interface method
+// Method names given as strings are looked up in symbol table, a name that was
+// never interned can not be the name of any loaded method
 //--------------------------------------------------------------------------------
-void Interpreter::invokeInterface(const JavaClass *jc, const string &name,
-                                  const string &descriptor) {
-    auto parameterAndReturnType = peelMethodParameterAndType(descriptor);
-    const int returnType = get<0>(parameterAndReturnType);
-    auto parameter = get<1>(parameterAndReturnType);
-
-    auto csite = findInstanceMethod(jc, name, descriptor);
-    if (!csite.isCallable()) {
-        csite = findInstanceMethodOnSupers(jc, name, descriptor);
-        if (!csite.isCallable()) {
-            csite = findMaximallySpecifiedMethod(jc, name, descriptor);
-            if (!csite.isCallable()) {
-                throw runtime_error("can not find method " + name + " " +
-                                    descriptor);
-            }
-        }
+static const Symbol *lookupMethodSymbol(const string &name,
+                                        const string &descriptor,
+                                        const Symbol *&descriptorSymbol) {
+    const Symbol *nameSymbol = yrt.symbols->lookup(name);
+    descriptorSymbol = yrt.symbols->lookup(descriptor);
+    if (nameSymbol == nullptr || descriptorSymbol == nullptr) {
+        throw runtime_error("can not find method " + name + " " + descriptor);
     }
+    return nameSymbol;
+}
 
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        csite.maxLocal = csite.maxStack = parameter.size() + 1;
-    }
-    frames->pushFrame(csite.maxLocal, csite.maxStack);
-    pushMethodArguments(parameter, true);
+void Interpreter::invokeInterface(const JavaClass *jc, const string &name,
+                                  const string &descriptor,
+                                  InlineCache *cache) {
+    const Symbol *descriptorSymbol = nullptr;
+    const Symbol *nameSymbol =
+        lookupMethodSymbol(name, descriptor, descriptorSymbol);
+    invokeMethod(
+        resolveInterfaceCall(jc, nameSymbol, descriptorSymbol, cache), true);
+}
 
-    JType *returnValue{};
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        returnValue = cloneValue(
-            execNativeMethod(csite.jc->getClassName(), name, descriptor));
-    } else {
-        returnValue =
-            cloneValue(execByteCode(csite.jc, csite.code, csite.codeLength,
-                                    csite.exceptionLen, csite.exception));
-    }
-    frames->popFrame();
+void Interpreter::invokeVirtual(const JavaClass *jc, const string &name,
+                                const string &descriptor, InlineCache *cache) {
+    const Symbol *descriptorSymbol = nullptr;
+    const Symbol *nameSymbol =
+        lookupMethodSymbol(name, descriptor, descriptorSymbol);
+    invokeMethod(resolveVirtualCall(jc, nameSymbol, descriptorSymbol, cache),
+                 true);
+}
 
-    if (returnType != T_EXTRA_VOID) {
-        frames->top()->push(returnValue);
-    }
-    if (exception.hasUnhandledException()) {
-        frames->top()->grow(1);
-        frames->top()->push(returnValue);
-        if (exception.hasUnhandledException()) {
-            exception.extendExceptionStackTrace(name);
-        }
-    }
+void Interpreter::invokeSpecial(const JavaClass *jc, const string &name,
+                                const string &descriptor) {
+    const Symbol *descriptorSymbol = nullptr;
+    const Symbol *nameSymbol =
+        lookupMethodSymbol(name, descriptor, descriptorSymbol);
+    invokeMethod(resolveSpecialCall(jc, nameSymbol, descriptorSymbol), true);
+}
 
-    GC_SAFE_POINT
-    if (yrt.gc->shallGC()) {
-        yrt.gc->stopTheWorld();
-        yrt.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);
-    }
+void Interpreter::invokeStatic(const JavaClass *jc, const string &name,
+                               const string &descriptor) {
+    const Symbol *descriptorSymbol = nullptr;
+    const Symbol *nameSymbol =
+        lookupMethodSymbol(name, descriptor, descriptorSymbol);
+    invokeMethod(resolveStaticCall(jc, nameSymbol, descriptorSymbol), false);
 }
 
 //--------------------------------------------------------------------------------
-// Invoke instance method; dispatch based on class
+// Select interface method; dispatch based on class of receiver
 //--------------------------------------------------------------------------------
-void Interpreter::invokeVirtual(const string &name, const string &descriptor) {
-    auto parameterAndReturnType = peelMethodParameterAndType(descriptor);
-    const int returnType = get<0>(parameterAndReturnType);
-    auto parameter = get<1>(parameterAndReturnType);
-
-    auto *thisRef =
-        (JObject *)frames->top()
-            ->stackSlots[frames->top()->stackTop - parameter.size() - 1];
-
-    auto csite = findInstanceMethod(thisRef->jc, name, descriptor);
-    if (!csite.isCallable()) {
-        csite = findInstanceMethodOnSupers(thisRef->jc, name, descriptor);
-        if (!csite.isCallable()) {
-            csite = findMaximallySpecifiedMethod(thisRef->jc, name, descriptor);
-            if (!csite.isCallable()) {
-                throw runtime_error("can not find method " + name + " " +
-                                    descriptor);
-            }
-        }
-    }
-
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        csite.maxLocal = csite.maxStack = parameter.size() + 1;
+CallSite Interpreter::resolveInterfaceCall(const JavaClass *jc,
+                                           const Symbol *name,
+                                           const Symbol *descriptor,
+                                           InlineCache *cache) {
+    const JavaClass *methodClass = jc;
+    int index;
+    const MethodShape &referenced =
+        resolveReferencedMethod(cache, methodClass, index, name, descriptor);
+    const int argSlots = referenced.parameterSlots;
+    auto *thisRef = static_cast<JObject *>(
+        frames->top()->stackSlots[frames->top()->stackTop - argSlots - 1].ref);
+    if (thisRef == nullptr) {
+        throw runtime_error("null pointer");
     }
 
-    frames->pushFrame(csite.maxLocal, csite.maxStack);
-    pushMethodArguments(parameter, true);
-    JType *returnValue{};
-    if (csite.isCallable()) {
-        if (IS_METHOD_NATIVE(csite.accessFlags)) {
-            returnValue = cloneValue(
-                execNativeMethod(csite.jc->getClassName(), name, descriptor));
-        } else {
-            returnValue =
-                cloneValue(execByteCode(csite.jc, csite.code, csite.codeLength,
-                                        csite.exceptionLen, csite.exception));
-        }
-    } else {
-        throw runtime_error("can not find method to call");
+    auto csite = lookupInlineCache(cache, thisRef->jc, [&]() {
+        return selectInterfaceMethod(thisRef->jc, methodClass, index);
+    });
+    if (!csite.isCallable()) {
+        throw runtime_error("can not find method " + name->str() + " " +
+                            descriptor->str());
     }
-    frames->popFrame();
+    return csite;
+}
 
-    if (returnType != T_EXTRA_VOID) {
-        frames->top()->push(returnValue);
-    }
-    if (exception.hasUnhandledException()) {
-        frames->top()->grow(1);
-        frames->top()->push(returnValue);
-        if (exception.hasUnhandledException()) {
-            exception.extendExceptionStackTrace(name);
-        }
+//--------------------------------------------------------------------------------
+// Select instance method; dispatch based on class of receiver
+//--------------------------------------------------------------------------------
+CallSite Interpreter::resolveVirtualCall(const JavaClass *jc,
+                                         const Symbol *name,
+                                         const Symbol *descriptor,
+                                         InlineCache *cache) {
+    const JavaClass *methodClass = jc;
+    int index;
+    const MethodShape &referenced =
+        resolveReferencedMethod(cache, methodClass, index, name, descriptor);
+    const int argSlots = referenced.parameterSlots;
+    auto *thisRef = static_cast<JObject *>(
+        frames->top()->stackSlots[frames->top()->stackTop - argSlots - 1].ref);
+    if (thisRef == nullptr) {
+        throw runtime_error("null pointer");
     }
 
-    GC_SAFE_POINT
-    if (yrt.gc->shallGC()) {
-        yrt.gc->stopTheWorld();
-        yrt.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);
+    auto csite = lookupInlineCache(cache, thisRef->jc, [&]() {
+        return selectVirtualMethod(thisRef->jc, index);
+    });
+    if (!csite.isCallable()) {
+        throw runtime_error("can not find method " + name->str() + " " +
+                            descriptor->str());
     }
+    return csite;
 }
+
 //--------------------------------------------------------------------------------
-//  Invoke instance method; special handling for superclass, private,
+//  Select instance method; special handling for superclass, private,
 //  and instance initialization method invocations
 //--------------------------------------------------------------------------------
-void Interpreter::invokeSpecial(const JavaClass *jc, const string &name,
-                                const string &descriptor) {
-    auto parameterAndReturnType = peelMethodParameterAndType(descriptor);
-    const int returnType = get<0>(parameterAndReturnType);
-    auto parameter = get<1>(parameterAndReturnType);
-
+CallSite Interpreter::resolveSpecialCall(const JavaClass *jc,
+                                         const Symbol *name,
+                                         const Symbol *descriptor) {
     auto csite = findInstanceMethod(jc, name, descriptor);
     if (!csite.isCallable()) {
         csite = findInstanceMethodOnSupers(jc, name, descriptor);
@@ -1789,92 +2142,199 @@ void Interpreter::invokeSpecial(const JavaClass *jc, const string &name,
             if (!csite.isCallable()) {
                 csite = findMaximallySpecifiedMethod(jc, name, descriptor);
                 if (!csite.isCallable()) {
-                    throw runtime_error("can not find method " + name + " " +
-                                        descriptor);
+                    throw runtime_error("can not find method " +
+                                        name->str() + " " + descriptor->str());
                 }
             }
         }
     }
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        csite.maxLocal = csite.maxStack = parameter.size() + 1;
-    }
-    frames->pushFrame(csite.maxLocal, csite.maxStack);
-    pushMethodArguments(parameter, true);
-    JType *returnValue{};
-
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        returnValue = cloneValue(
-            execNativeMethod(csite.jc->getClassName(), name, descriptor));
-    } else {
-        returnValue =
-            cloneValue(execByteCode(csite.jc, csite.code, csite.codeLength,
-                                    csite.exceptionLen, csite.exception));
-    }
-    frames->popFrame();
-    if (returnType != T_EXTRA_VOID) {
-        frames->top()->push(returnValue);
-    }
-    if (exception.hasUnhandledException()) {
-        frames->top()->grow(1);
-        frames->top()->push(returnValue);
-        if (exception.hasUnhandledException()) {
-            exception.extendExceptionStackTrace(name);
-        }
-    }
-
-    GC_SAFE_POINT
-    if (yrt.gc->shallGC()) {
-        yrt.gc->stopTheWorld();
-        yrt.gc->gc(frames, GCPolicy::GC_MARK_AND_SWEEP);
-    }
+    return csite;
 }
 
-void Interpreter::invokeStatic(const JavaClass *jc, const string &name,
-                               const string &descriptor) {
+CallSite Interpreter::resolveStaticCall(const JavaClass *jc,
+                                        const Symbol *name,
+                                        const Symbol *descriptor) {
     // Get instance method name and descriptor from CONSTANT_Methodref
     // locating by index and get interface method parameter and return value
     // descriptor
-    yrt.ma->linkClassIfAbsent(const_cast<JavaClass *>(jc)->getClassName());
-    yrt.ma->initClassIfAbsent(*this,
-                              const_cast<JavaClass *>(jc)->getClassName());
-
-    auto parameterAndReturnType = peelMethodParameterAndType(descriptor);
-    const int returnType = get<0>(parameterAndReturnType);
-    auto parameter = get<1>(parameterAndReturnType);
+    if (!jc->isInitialized()) {
+        yrt.ma->linkClassIfAbsent(jc->getClassName());
+        yrt.ma->initClassIfAbsent(*this, jc->getClassName());
+    }
 
     auto csite = CallSite::makeCallSite(jc, jc->findMethod(name, descriptor));
     if (!csite.isCallable()) {
-        throw runtime_error("can not find method " + name + " " + descriptor);
+        throw runtime_error("can not find method " + name->str() + " " +
+                            descriptor->str());
+    }
+    assert(IS_METHOD_STATIC(csite.method->accessFlags) == true);
+    assert(IS_METHOD_ABSTRACT(csite.method->accessFlags) == false);
+    assert(name != yrt.symbols->initName);
+    return csite;
+}
+
+// MethodHandle.invoke and invokeExtract accept any arguments
+static bool isSignaturePolymorphic(const JavaClass *jc, const Symbol *name) {
+    return (name == yrt.symbols->invokeName ||
+            name == yrt.symbols->invokeExtractName) &&
+           jc->getClassSymbol() == yrt.symbols->methodHandleName;
+}
+
+//--------------------------------------------------------------------------------
+// Resolve the method invoked by an invoke instruction of given class. Operand
+// stack of current frame must have been written back since the receiver is
+// located there. Returns an uncallable call site if the invocation is not
+// supported yet
+//--------------------------------------------------------------------------------
+CallSite Interpreter::resolveInvocation(const JavaClass *jc,
+                                        InlineCache *inlineCaches,
+                                        const Instruction *pc,
+                                        bool &isObjectMethod) {
+    const u2 index = pc->index;
+    switch (pc->opcode) {
+        case op_invokevirtual: {
+            assert(jc->raw.constPool.is(index, TAG_Methodref));
+
+            const SymbolicRef &symbolicRef =
+                parseMethodSymbolicReference(jc, index);
+
+            if (symbolicRef.name == yrt.symbols->initName) {
+                throw runtime_error(
+                    "invoking method should not be instance "
+                    "initialization method\n");
+            }
+            if (isSignaturePolymorphic(symbolicRef.jc, symbolicRef.name)) {
+                return CallSite();
+            }
+            isObjectMethod = true;
+            return resolveVirtualCall(symbolicRef.jc, symbolicRef.name,
+                                      symbolicRef.descriptor,
+                                      inlineCaches + pc->operand);
+        }
+        case op_invokespecial: {
+            const SymbolicRef *symbolicRef = nullptr;
+
+            if (jc->raw.constPool.is(index, TAG_InterfaceMethodref)) {
+                symbolicRef =
+                    &parseInterfaceMethodSymbolicReference(jc, index);
+            } else if (jc->raw.constPool.is(index, TAG_Methodref)) {
+                symbolicRef = &parseMethodSymbolicReference(jc, index);
+            } else {
+                SHOULD_NOT_REACH_HERE
+            }
+            isObjectMethod = true;
+            if (const CallSite *target =
+                    symbolicRef->target.load(memory_order_acquire)) {
+                return *target;
+            }
+
+            // If all of the following are true, let C be the direct
+            // superclass of the current class, otherwise let C be the
+            // symbolic reference class
+            const JavaClass *targetClass = symbolicRef->jc;
+            if (symbolicRef->name != yrt.symbols->initName) {
+                if (!IS_CLASS_INTERFACE(targetClass->raw.accessFlags)) {
+                    if (targetClass->getClassSymbol() ==
+                        jc->getSuperClassSymbol()) {
+                        if (IS_CLASS_SUPER(jc->raw.accessFlags)) {
+                            targetClass = yrt.ma->findJavaClass(
+                                jc->getSuperClassSymbol());
+                        }
+                    }
+                }
+            }
+            return publishCallTarget(
+                *symbolicRef, resolveSpecialCall(targetClass, symbolicRef->name,
+                                                 symbolicRef->descriptor));
+        }
+        case op_invokestatic: {
+            // Invoke a class (static) method
+            const SymbolicRef *symbolicRef = nullptr;
+            if (jc->raw.constPool.is(index, TAG_InterfaceMethodref)) {
+                symbolicRef =
+                    &parseInterfaceMethodSymbolicReference(jc, index);
+            } else if (jc->raw.constPool.is(index, TAG_Methodref)) {
+                symbolicRef = &parseMethodSymbolicReference(jc, index);
+            } else {
+                SHOULD_NOT_REACH_HERE
+            }
+            isObjectMethod = false;
+            if (const CallSite *target =
+                    symbolicRef->target.load(memory_order_acquire)) {
+                return *target;
+            }
+            const CallSite csite = resolveStaticCall(
+                symbolicRef->jc, symbolicRef->name, symbolicRef->descriptor);
+            // Until its class is initialized every invocation must check it
+            if (!symbolicRef->jc->isInitialized()) {
+                return csite;
+            }
+            return publishCallTarget(*symbolicRef, csite);
+        }
+        case op_invokeinterface: {
+            if (!jc->raw.constPool.is(index, TAG_InterfaceMethodref)) {
+                return CallSite();
+            }
+            const SymbolicRef &symbolicRef =
+                parseInterfaceMethodSymbolicReference(jc, index);
+            isObjectMethod = true;
+            return resolveInterfaceCall(symbolicRef.jc, symbolicRef.name,
+                                        symbolicRef.descriptor,
+                                        inlineCaches + pc->operand);
+        }
+        default:
+            throw runtime_error("not an invoke instruction");
     }
-    assert(IS_METHOD_STATIC(csite.accessFlags) == true);
-    assert(IS_METHOD_ABSTRACT(csite.accessFlags) == false);
-    assert("<init>" != name);
+}
+
+void Interpreter::invokeMethod(const CallSite &csite, bool isObjectMethod) {
+    invokeMethod(csite, isObjectMethod,
+                 csite.decoded != nullptr ? TemplateJIT::enter(csite)
+                                          : nullptr);
+}
 
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        csite.maxLocal = csite.maxStack = parameter.size();
+//--------------------------------------------------------------------------------
+// Invoke a resolved method on a new native stack frame of interpreter, a
+// bytecode method runs as given compiled code if it's present. Return value or
+// unhandled exception of callee is pushed onto operand stack of caller.
+// Interpreted bytecode methods called by bytecode never come here,
+// execByteCode() runs them within its own dispatch loop
+//--------------------------------------------------------------------------------
+void Interpreter::invokeMethod(const CallSite &csite, bool isObjectMethod,
+                               CompiledMethod *compiled) {
+    // Compiled code keeps frames of inlined methods above its operand stack
+    const int maxStack =
+        csite.exec->maxStack +
+        (compiled != nullptr ? static_cast<int>(compiled->extraStack) : 0);
+    if (!frames->pushFrame(csite.exec->maxLocal, maxStack,
+                           getArgumentSlots(csite, isObjectMethod))) {
+        // Arguments are left on operand stack of caller, they are discarded
+        // along with its operand stack when the error was handled. The error
+        // takes the slot every frame keeps above its operand stack
+        frames->top()->push<JObject>(raiseStackOverflowError(
+            csite.jc->getString(csite.method->nameIndex)));
+        return;
     }
-    frames->pushFrame(csite.maxLocal, csite.maxStack);
-    pushMethodArguments(parameter, false);
-    JType *returnValue{};
-    if (IS_METHOD_NATIVE(csite.accessFlags)) {
-        returnValue = cloneValue(
-            execNativeMethod(csite.jc->getClassName(), name, descriptor));
+
+    JValue returnValue{};
+    if (IS_METHOD_NATIVE(csite.method->accessFlags)) {
+        returnValue = execNativeMethod(csite.method);
+    } else if (compiled != nullptr) {
+        returnValue = TemplateJIT::run(*this, csite, compiled);
     } else {
-        returnValue =
-            cloneValue(execByteCode(csite.jc, csite.code, csite.codeLength,
-                                    csite.exceptionLen, csite.exception));
+        returnValue = execByteCode(csite.jc, csite.method, csite.decoded);
     }
     frames->popFrame();
 
-    if (returnType != T_EXTRA_VOID) {
-        frames->top()->push(returnValue);
-    }
     if (exception.hasUnhandledException()) {
-        frames->top()->grow(1);
-        frames->top()->push(returnValue);
-        if (exception.hasUnhandledException()) {
-            exception.extendExceptionStackTrace(name);
-        }
+        // Propagate the thrown object to caller, it would be handled at the
+        // beginning of next execution loop of caller. Operand stack of caller
+        // may be full, the thrown object takes the slot above it then
+        frames->top()->pushValue(returnValue);
+        exception.extendExceptionStackTrace(
+            csite.jc->getString(csite.method->nameIndex));
+    } else if (csite.method->shape.returnType != T_EXTRA_VOID) {
+        frames->top()->pushValue(returnValue);
     }
 
     GC_SAFE_POINT
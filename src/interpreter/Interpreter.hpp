@@ -1,8 +1,12 @@
 #ifndef YVM_INTERPRETER_H
 #define YVM_INTERPRETER_H
 
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 #include <typeinfo>
 #include "../classfile/ClassFile.h"
+#include "Instruction.h"
 #include "../runtime/JavaException.h"
 #include "../runtime/JavaFrame.hpp"
 #include "../runtime/JavaHeap.hpp"
@@ -11,11 +15,17 @@
 
 #pragma warning(disable : 4244)
 
+struct CallSite;
+struct CompiledMethod;
 struct MethodInfo;
 struct RuntimeEnv;
+class Symbol;
 extern RuntimeEnv yrt;
 using std::string;
 class Interpreter {
+    friend class TemplateJIT;
+    friend class TraceJIT;
+
 public:
     explicit Interpreter() : frames(new JavaFrame) {}
 
@@ -26,67 +36,262 @@ public:
     void invokeByName(JavaClass* jc, const string& name,
                       const string& descriptor);
     void invokeInterface(const JavaClass* jc, const string& name,
-                         const string& descriptor);
+                         const string& descriptor,
+                         InlineCache* cache = nullptr);
     void invokeSpecial(const JavaClass* jc, const string& name,
                        const string& descriptor);
     void invokeStatic(const JavaClass* jc, const string& name,
                       const string& descriptor);
-    void invokeVirtual(const string& name, const string& descriptor);
+    void invokeVirtual(const JavaClass* jc, const string& name,
+                       const string& descriptor, InlineCache* cache);
 
 private:
     bool checkInstanceof(const JavaClass* jc, u2 index, JType* objectref);
 
     JObject* execNew(const JavaClass* jc, u2 index);
-    JType* execByteCode(const JavaClass* jc, u1* code, u4 codeLength,
-                        u2 exceptLen, ExceptionTable* exceptTab);
-    JType* execNativeMethod(const string& className, const string& methodName,
-                            const string& methodDescriptor);
+    static JArray* execNewArray(u1 atype, int32_t count);
+    static JArray* execANewArray(const JavaClass* jc, u2 index,
+                                 int32_t count);
+    JValue execByteCode(const JavaClass* jc, const MethodInfo* m,
+                        DecodedCode* decoded);
+    JValue execNativeMethod(const MethodInfo* m);
+
+    void loadConstantPoolItem2Stack(const JavaClass* jc, u2 index,
+                                    JValue*& sp);
+
+    bool handleException(const JavaClass* jc, const DecodedCode* decoded,
+                         const JObject* objectref, u4& op);
+
+    CallSite resolveInterfaceCall(const JavaClass* jc, const Symbol* name,
+                                  const Symbol* descriptor,
+                                  InlineCache* cache);
+    CallSite resolveSpecialCall(const JavaClass* jc, const Symbol* name,
+                                const Symbol* descriptor);
+    CallSite resolveStaticCall(const JavaClass* jc, const Symbol* name,
+                               const Symbol* descriptor);
+    CallSite resolveVirtualCall(const JavaClass* jc, const Symbol* name,
+                                const Symbol* descriptor, InlineCache* cache);
+
+    CallSite resolveInvocation(const JavaClass* jc, InlineCache* inlineCaches,
+                               const Instruction* pc, bool& isObjectMethod);
 
-    void loadConstantPoolItem2Stack(const JavaClass* jc, u2 index);
+    void invokeMethod(const CallSite& csite, bool isObjectMethod);
+    void invokeMethod(const CallSite& csite, bool isObjectMethod,
+                      CompiledMethod* compiled);
 
-    bool handleException(const JavaClass* jc, u2 exceptLen,
-                         ExceptionTable* exceptTab, const JObject* objectref,
-                         u4& op);
+    JObject* raiseStackOverflowError(const string& name);
 
-    void pushMethodArguments(std::vector<int>& parameter, bool isObjectMethod);
+    StaticFieldCache resolveStaticField(const JavaClass* jc,
+                                        DecodedCode* decoded, Instruction* pc);
 
 private:
     template <typename ResultType, typename CallableObjectType>
-    void binaryArithmetic(CallableObjectType op);
+    static void binaryArithmetic(JValue*& sp, CallableObjectType op);
 
     template <typename ResultType, typename CallableObjectType>
-    void unaryArithmetic(CallableObjectType op);
+    static void unaryArithmetic(JValue*& sp, CallableObjectType op);
+
+    template <typename ResultType, typename CallableObjectType>
+    static void shiftArithmetic(JValue*& sp, CallableObjectType op);
 
     template <typename Type1, typename Type2>
-    void typeCast() const;
+    static void typeCast(JValue*& sp);
+
+    template <typename Type>
+    static void arrayLoad(JValue*& sp);
+
+    template <typename Type, typename CallableObjectType>
+    static void arrayStore(JValue*& sp, CallableObjectType op);
+
+    template <typename Type>
+    static void arrayStore(JValue*& sp);
+
+    template <typename Type>
+    static void compareFloating(JValue*& sp, int32_t nanResult);
+
+    static JValue popFieldValue(JValue*& sp, char type);
+
+    static void quickenFieldAccess(const JavaClass* jc, DecodedCode* decoded,
+                                   Instruction* pc, const JValue* sp);
+
+    static bool isSameReference(const JType* value1, const JType* value2);
 
 private:
     JavaFrame* frames;
     JavaException exception;
 };
 
+//--------------------------------------------------------------------------------
+// Integer division and remainder of jvm throw an ArithmeticException when the
+// divisor is zero, and silently overflow when dividing MIN_VALUE by -1 which
+// is an undefined behavior in C++
+//--------------------------------------------------------------------------------
+template <typename IntegerType>
+struct IntegerDivides {
+    IntegerType operator()(IntegerType a, IntegerType b) const {
+        if (b == 0) {
+            throw std::runtime_error("divide by zero");
+        }
+        if (b == -1) {
+            return static_cast<IntegerType>(
+                -static_cast<typename std::make_unsigned<IntegerType>::type>(
+                    a));
+        }
+        return a / b;
+    }
+};
+
+template <typename IntegerType>
+struct IntegerModulus {
+    IntegerType operator()(IntegerType a, IntegerType b) const {
+        if (b == 0) {
+            throw std::runtime_error("divide by zero");
+        }
+        if (b == -1) {
+            return 0;
+        }
+        return a % b;
+    }
+};
+
+//--------------------------------------------------------------------------------
+// Narrowing a floating-point value to an integer rounds toward zero and
+// saturates at the bounds of target type, NaN is converted to 0
+//--------------------------------------------------------------------------------
+template <typename To, typename From>
+inline typename std::enable_if<std::is_floating_point<From>::value &&
+                                   std::is_integral<To>::value,
+                               To>::type
+convertValue(From value) {
+    if (value != value) {
+        return 0;
+    }
+    if (value <= static_cast<From>(std::numeric_limits<To>::min())) {
+        return std::numeric_limits<To>::min();
+    }
+    if (value >= static_cast<From>(std::numeric_limits<To>::max())) {
+        return std::numeric_limits<To>::max();
+    }
+    return static_cast<To>(value);
+}
+
+template <typename To, typename From>
+inline typename std::enable_if<!(std::is_floating_point<From>::value &&
+                                 std::is_integral<To>::value),
+                               To>::type
+convertValue(From value) {
+    return static_cast<To>(value);
+}
+
 template <typename ResultType, typename CallableObjectType>
-void Interpreter::binaryArithmetic(CallableObjectType op) {
-    auto* value2 = frames->top()->pop<ResultType>();
-    auto* value1 = frames->top()->pop<ResultType>();
-    auto* result = new ResultType;
-    result->val = op(value1->val, value2->val);
-    frames->top()->push(result);
+void Interpreter::binaryArithmetic(JValue*& sp, CallableObjectType op) {
+    const auto value2 = popOperand<ResultType>(sp);
+    const auto value1 = popOperand<ResultType>(sp);
+    pushOperand<ResultType>(sp, op(value1, value2));
 }
 
 template <typename ResultType, typename CallableObjectType>
-void Interpreter::unaryArithmetic(CallableObjectType op) {
-    auto* ival = frames->top()->pop<ResultType>();
-    ival->val = op(ival->val);
-    frames->top()->push(ival);
+void Interpreter::unaryArithmetic(JValue*& sp, CallableObjectType op) {
+    const auto value = popOperand<ResultType>(sp);
+    pushOperand<ResultType>(sp, op(value));
+}
+
+template <typename ResultType, typename CallableObjectType>
+void Interpreter::shiftArithmetic(JValue*& sp, CallableObjectType op) {
+    // The shift distance is always an int no matter what type of the shifted
+    // value is
+    const int32_t value2 = popOperand<JInt>(sp);
+    const auto value1 = popOperand<ResultType>(sp);
+    pushOperand<ResultType>(sp, op(value1, value2));
 }
 
 template <typename Type1, typename Type2>
-void Interpreter::typeCast() const {
-    auto* value = frames->top()->pop<Type1>();
-    auto* result = new Type2;
-    result->val = value->val;
-    frames->top()->push(result);
+void Interpreter::typeCast(JValue*& sp) {
+    const auto value = popOperand<Type1>(sp);
+    pushOperand<Type2>(sp,
+        convertValue<typename SlotTraits<Type2>::ValueType>(value));
+}
+
+template <typename Type>
+void Interpreter::arrayLoad(JValue*& sp) {
+    const int32_t index = popOperand<JInt>(sp);
+    const auto* arrref = popOperand<JArray>(sp);
+    if (arrref == nullptr) {
+        throw std::runtime_error("null pointer");
+    }
+    if (index >= arrref->length || index < 0) {
+        throw std::runtime_error("array index out of bounds");
+    }
+    // Elements of primitive array are boxed, we read them in place
+    pushOperand<Type>(sp,
+        static_cast<Type*>(yrt.jheap->getElement(*arrref, index))->val);
+}
+
+template <typename Type, typename CallableObjectType>
+void Interpreter::arrayStore(JValue*& sp, CallableObjectType op) {
+    const auto value = popOperand<Type>(sp);
+    const int32_t index = popOperand<JInt>(sp);
+    auto* arrref = popOperand<JArray>(sp);
+    if (arrref == nullptr) {
+        throw std::runtime_error("null pointer");
+    }
+    if (index >= arrref->length || index < 0) {
+        throw std::runtime_error("array index out of bounds");
+    }
+    static_cast<Type*>(yrt.jheap->getElement(*arrref, index))->val = op(value);
+}
+
+template <typename Type>
+void Interpreter::arrayStore(JValue*& sp) {
+    arrayStore<Type>(sp, [](typename SlotTraits<Type>::ValueType value) {
+        return value;
+    });
+}
+
+//--------------------------------------------------------------------------------
+// Elements of reference array are references themselves rather than boxes
+//--------------------------------------------------------------------------------
+template <>
+inline void Interpreter::arrayLoad<JRef>(JValue*& sp) {
+    const int32_t index = popOperand<JInt>(sp);
+    const auto* arrref = popOperand<JArray>(sp);
+    if (arrref == nullptr) {
+        throw std::runtime_error("null pointer");
+    }
+    if (index >= arrref->length || index < 0) {
+        throw std::runtime_error("array index out of bounds");
+    }
+    pushOperand<JRef>(sp, yrt.jheap->getElement(*arrref, index));
+}
+
+template <>
+inline void Interpreter::arrayStore<JRef>(JValue*& sp) {
+    auto* value = popOperand<JRef>(sp);
+    const int32_t index = popOperand<JInt>(sp);
+    auto* arrref = popOperand<JArray>(sp);
+    if (arrref == nullptr) {
+        throw std::runtime_error("null pointer");
+    }
+    if (index >= arrref->length || index < 0) {
+        throw std::runtime_error("array index out of bounds");
+    }
+    yrt.jheap->putElement(*arrref, index, value);
+}
+
+template <typename Type>
+void Interpreter::compareFloating(JValue*& sp, int32_t nanResult) {
+    const auto value2 = popOperand<Type>(sp);
+    const auto value1 = popOperand<Type>(sp);
+    if (value1 > value2) {
+        pushOperand<JInt>(sp, 1);
+    } else if (value1 == value2) {
+        pushOperand<JInt>(sp, 0);
+    } else if (value1 < value2) {
+        pushOperand<JInt>(sp, -1);
+    } else {
+        // At least one of value1 or value2 is NaN
+        pushOperand<JInt>(sp, nanResult);
+    }
 }
 
 #endif  // YVM_INTERPRETER_H
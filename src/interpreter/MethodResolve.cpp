@@ -5,8 +5,8 @@
 // If C contains a declaration for an instance method m that overrides the
 // resolved method, then m is the method to be invoked.
 //--------------------------------------------------------------------------------
-CallSite findInstanceMethod(const JavaClass *jc, const std::string &methodName,
-                            const std::string &methodDescriptor) {
+CallSite findInstanceMethod(const JavaClass *jc, const Symbol *methodName,
+                            const Symbol *methodDescriptor) {
     auto *methodInfo = jc->findMethod(methodName, methodDescriptor);
     if (methodInfo && !IS_METHOD_STATIC(methodInfo->accessFlags)) {
         return CallSite::makeCallSite(jc, methodInfo);
@@ -23,13 +23,13 @@ CallSite findInstanceMethod(const JavaClass *jc, const std::string &methodName,
 // invoked.
 //--------------------------------------------------------------------------------
 CallSite findInstanceMethodOnSupers(const JavaClass *jc,
-                                    const std::string &methodName,
-                                    const std::string &methodDescriptor) {
+                                    const Symbol *methodName,
+                                    const Symbol *methodDescriptor) {
     if (!jc->hasSuperClass()) {
         return CallSite{};
     }
 
-    JavaClass *superClass = yrt.ma->loadClassIfAbsent(jc->getSuperClassName());
+    JavaClass *superClass = yrt.ma->loadClassIfAbsent(jc->getSuperClassSymbol());
     auto methodInfo = superClass->findMethod(methodName, methodDescriptor);
     if (methodInfo && !IS_METHOD_STATIC(methodInfo->accessFlags)) {
         return CallSite::makeCallSite(superClass, methodInfo);
@@ -43,8 +43,8 @@ CallSite findInstanceMethodOnSupers(const JavaClass *jc,
 // then it is the method to be invoked.
 //--------------------------------------------------------------------------------
 CallSite findJavaLangObjectMethod(const JavaClass *jc,
-                                  const std::string &methodName,
-                                  const std::string &methodDescriptor) {
+                                  const Symbol *methodName,
+                                  const Symbol *methodDescriptor) {
     if (IS_CLASS_INTERFACE(jc->getAccessFlag())) {
         JavaClass *jloc = yrt.ma->findJavaClass("java/lang/Object");
         auto *jlom = jloc->findMethod(methodName, methodDescriptor);
@@ -61,12 +61,12 @@ CallSite findJavaLangObjectMethod(const JavaClass *jc,
 // and is not abstract, then it is the method to be invoked.
 //--------------------------------------------------------------------------------
 CallSite findMaximallySpecifiedMethod(const JavaClass *jc,
-                                      const std::string &methodName,
-                                      const std::string &methodDescriptor) {
+                                      const Symbol *methodName,
+                                      const Symbol *methodDescriptor) {
     if (!jc->hasSuperClass()) {
         return CallSite{};
     }
-    JavaClass *superClass = yrt.ma->loadClassIfAbsent(jc->getSuperClassName());
+    JavaClass *superClass = yrt.ma->loadClassIfAbsent(jc->getSuperClassSymbol());
 
     if (superClass->getInterfaceCount()) {
         FOR_EACH(eachInterface, jc->getInterfaceCount()) {
@@ -92,3 +92,41 @@ CallSite findMaximallySpecifiedMethod(const JavaClass *jc,
     return findMaximallySpecifiedMethod(superClass, methodName,
                                         methodDescriptor);
 }
+
+static CallSite makeVirtualCallSite(const JavaClass *receiverClass,
+                                    int vtableIndex) {
+    if (vtableIndex < 0 ||
+        static_cast<size_t>(vtableIndex) >=
+            receiverClass->getVirtualMethodCount()) {
+        return CallSite{};
+    }
+    const VirtualMethod &vm = receiverClass->getVirtualMethod(vtableIndex);
+    if (IS_METHOD_ABSTRACT(vm.method->accessFlags)) {
+        return CallSite{};
+    }
+    return CallSite::makeCallSite(vm.jc, vm.method);
+}
+
+static void linkReceiverClass(const JavaClass *receiverClass) {
+    // Objects such as strings created by native methods may belong to
+    // classes that were never linked
+    if (!receiverClass->isLinked()) {
+        yrt.ma->linkClassIfAbsent(receiverClass->getClassName());
+    }
+}
+
+CallSite selectVirtualMethod(const JavaClass *receiverClass, int vtableIndex) {
+    linkReceiverClass(receiverClass);
+    return makeVirtualCallSite(receiverClass, vtableIndex);
+}
+
+CallSite selectInterfaceMethod(const JavaClass *receiverClass,
+                               const JavaClass *jc, int index) {
+    linkReceiverClass(receiverClass);
+    if (!IS_CLASS_INTERFACE(jc->getAccessFlag())) {
+        return makeVirtualCallSite(receiverClass, index);
+    }
+    return makeVirtualCallSite(
+        receiverClass,
+        receiverClass->findInterfaceMethod(jc, static_cast<u2>(index)));
+}
@@ -9,8 +9,8 @@
 // If C contains a declaration for an instance method m that overrides the
 // resolved method, then m is the method to be invoked.
 //--------------------------------------------------------------------------------
-CallSite findInstanceMethod(const JavaClass* jc, const std::string& methodName,
-                            const std::string& methodDescriptor);
+CallSite findInstanceMethod(const JavaClass* jc, const Symbol* methodName,
+                            const Symbol* methodDescriptor);
 
 //--------------------------------------------------------------------------------
 // If C has a superclass, a search for a declaration of an instance
@@ -21,8 +21,8 @@ CallSite findInstanceMethod(const JavaClass* jc, const std::string& methodName,
 // invoked.
 //--------------------------------------------------------------------------------
 CallSite findInstanceMethodOnSupers(const JavaClass* jc,
-                                    const std::string& methodName,
-                                    const std::string& methodDescriptor);
+                                    const Symbol* methodName,
+                                    const Symbol* methodDescriptor);
 
 //--------------------------------------------------------------------------------
 // If C is an interface and the class Object contains a declaration of a public
@@ -30,8 +30,8 @@ CallSite findInstanceMethodOnSupers(const JavaClass* jc,
 // then it is the method to be invoked.
 //--------------------------------------------------------------------------------
 CallSite findMaximallySpecifiedMethod(const JavaClass* jc,
-                                      const std::string& methodName,
-                                      const std::string& methodDescriptor);
+                                      const Symbol* methodName,
+                                      const Symbol* methodDescriptor);
 
 //--------------------------------------------------------------------------------
 // If there is exactly one maximally - specific method(5.4.3.3) in the
@@ -39,7 +39,23 @@ CallSite findMaximallySpecifiedMethod(const JavaClass* jc,
 // and is not abstract, then it is the method to be invoked.
 //--------------------------------------------------------------------------------
 CallSite findJavaLangObjectMethod(const JavaClass* jc,
-                                  const std::string& methodName,
-                                  const std::string& methodDescriptor);
+                                  const Symbol* methodName,
+                                  const Symbol* methodDescriptor);
+
+//--------------------------------------------------------------------------------
+// Select the method to be invoked by invokevirtual. The resolved method is
+// entry vtableIndex of vtable of referenced class, the method which overrides
+// it takes the same index in vtable of receiver class
+//--------------------------------------------------------------------------------
+CallSite selectVirtualMethod(const JavaClass* receiverClass, int vtableIndex);
+
+//--------------------------------------------------------------------------------
+// Select the method to be invoked by invokeinterface, the resolved method is
+// entry index of vtable of jc. Methods of an interface are found through
+// itable of receiver class, methods of java/lang/Object invoked on an
+// interface are dispatched by vtable of receiver class
+//--------------------------------------------------------------------------------
+CallSite selectInterfaceMethod(const JavaClass* receiverClass,
+                               const JavaClass* jc, int index);
 
 #endif  // !_METHODRESOLVE_H
@@ -1,58 +1,83 @@
 #include "SymbolicRef.h"
 
-SymbolicRef parseFieldSymbolicReference(const JavaClass *jc, u2 index) {
-    auto *fr = (CONSTANT_Fieldref *)jc->getConstPoolItem(index);
-    auto *nat =
-        (CONSTANT_NameAndType *)jc->getConstPoolItem(fr->nameAndTypeIndex);
-    auto *cl = (CONSTANT_Class *)jc->getConstPoolItem(fr->classIndex);
-
-    auto fieldName = jc->getString(nat->nameIndex);
-    auto fieldDesc = jc->getString(nat->descriptorIndex);
-    auto fieldClass = yrt.ma->loadClassIfAbsent(jc->getString(cl->nameIndex));
-    yrt.ma->linkClassIfAbsent(jc->getString(cl->nameIndex));
-
-    return SymbolicRef{fieldClass, fieldName, fieldDesc};
+const SymbolicRef &parseFieldSymbolicReference(const JavaClass *jc, u2 index) {
+    if (const SymbolicRef *resolved = jc->getResolvedRef(index)) {
+        return *resolved;
+    }
+    const ConstantPool &cp = jc->getConstPool();
+    const u2 nat = cp.nameAndTypeIndex(index);
+    const u2 className = cp.nameIndex(cp.classIndex(index));
+
+    auto fieldName = jc->getSymbol(cp.natNameIndex(nat));
+    auto fieldDesc = jc->getSymbol(cp.natDescriptorIndex(nat));
+    auto fieldClass = yrt.ma->loadClassIfAbsent(jc->getSymbol(className));
+    yrt.ma->linkClassIfAbsent(jc->getString(className));
+
+    return *jc->publishResolvedRef(
+        index, new SymbolicRef{fieldClass, fieldName, fieldDesc});
 }
 
-SymbolicRef parseInterfaceMethodSymbolicReference(const JavaClass *jc,
-                                                  u2 index) {
-    auto *imr = (CONSTANT_InterfaceMethodref *)jc->getConstPoolItem(index);
-    auto *nat =
-        (CONSTANT_NameAndType *)jc->getConstPoolItem(imr->nameAndTypeIndex);
-    auto *cl = (CONSTANT_Class *)jc->getConstPoolItem(imr->classIndex);
+const SymbolicRef &parseInterfaceMethodSymbolicReference(const JavaClass *jc,
+                                                         u2 index) {
+    if (const SymbolicRef *resolved = jc->getResolvedRef(index)) {
+        return *resolved;
+    }
+    const ConstantPool &cp = jc->getConstPool();
+    const u2 nat = cp.nameAndTypeIndex(index);
+    const u2 className = cp.nameIndex(cp.classIndex(index));
 
-    auto interfaceMethodName = jc->getString(nat->nameIndex);
-    auto interfaceMethodDesc = jc->getString(nat->descriptorIndex);
+    auto interfaceMethodName = jc->getSymbol(cp.natNameIndex(nat));
+    auto interfaceMethodDesc = jc->getSymbol(cp.natDescriptorIndex(nat));
     auto interfaceMethodClass =
-        yrt.ma->loadClassIfAbsent(jc->getString(cl->nameIndex));
-    yrt.ma->linkClassIfAbsent(jc->getString(cl->nameIndex));
+        yrt.ma->loadClassIfAbsent(jc->getSymbol(className));
+    yrt.ma->linkClassIfAbsent(jc->getString(className));
 
-    return SymbolicRef{interfaceMethodClass, interfaceMethodName,
-                       interfaceMethodDesc};
+    return *jc->publishResolvedRef(
+        index, new SymbolicRef{interfaceMethodClass, interfaceMethodName,
+                               interfaceMethodDesc});
 }
 
-SymbolicRef parseMethodSymbolicReference(const JavaClass *jc, u2 index) {
-    auto *mr = (CONSTANT_Methodref *)jc->getConstPoolItem(index);
-    auto *nat =
-        (CONSTANT_NameAndType *)jc->getConstPoolItem(mr->nameAndTypeIndex);
-    auto *cl = (CONSTANT_Class *)jc->getConstPoolItem(mr->classIndex);
+const SymbolicRef &parseMethodSymbolicReference(const JavaClass *jc,
+                                                u2 index) {
+    if (const SymbolicRef *resolved = jc->getResolvedRef(index)) {
+        return *resolved;
+    }
+    const ConstantPool &cp = jc->getConstPool();
+    const u2 nat = cp.nameAndTypeIndex(index);
+    const u2 className = cp.nameIndex(cp.classIndex(index));
 
-    auto methodName = jc->getString(nat->nameIndex);
-    auto methodDesc = jc->getString(nat->descriptorIndex);
-    auto methodClass = yrt.ma->loadClassIfAbsent(jc->getString(cl->nameIndex));
-    yrt.ma->linkClassIfAbsent(jc->getString(cl->nameIndex));
+    auto methodName = jc->getSymbol(cp.natNameIndex(nat));
+    auto methodDesc = jc->getSymbol(cp.natDescriptorIndex(nat));
+    auto methodClass = yrt.ma->loadClassIfAbsent(jc->getSymbol(className));
+    yrt.ma->linkClassIfAbsent(jc->getString(className));
 
-    return SymbolicRef{methodClass, methodName, methodDesc};
+    return *jc->publishResolvedRef(
+        index, new SymbolicRef{methodClass, methodName, methodDesc});
 }
 
-SymbolicRef parseClassSymbolicReference(const JavaClass *jc, u2 index) {
-    auto *cl = (CONSTANT_Class *)jc->getConstPoolItem(index);
-    auto className = jc->getString(cl->nameIndex);
+const SymbolicRef &parseClassSymbolicReference(const JavaClass *jc, u2 index) {
+    if (const SymbolicRef *resolved = jc->getResolvedRef(index)) {
+        return *resolved;
+    }
+    string className = jc->getString(jc->getConstPool().nameIndex(index));
     if (className[0] == '[') {
         className = peelArrayComponentTypeFrom(className);
     }
 
     auto c = yrt.ma->loadClassIfAbsent(className);
     yrt.ma->linkClassIfAbsent(className);
-    return SymbolicRef{c};
+    return *jc->publishResolvedRef(index, new SymbolicRef{c});
+}
+
+const CallSite &publishCallTarget(const SymbolicRef &ref,
+                                  const CallSite &csite) {
+    const CallSite *fresh = new CallSite(csite);
+    const CallSite *expected = nullptr;
+    if (ref.target.compare_exchange_strong(expected, fresh,
+                                           memory_order_acq_rel,
+                                           memory_order_acquire)) {
+        return *fresh;
+    }
+    delete fresh;
+    return *expected;
 }
@@ -1,28 +1,48 @@
 #ifndef _SYMBOLIC_REFERENCE_H
 #define _SYMBOLIC_REFERENCE_H
 
+#include <atomic>
 #include <string>
 #include "../runtime/JavaClass.h"
+#include "CallSite.h"
 
 struct SymbolicRef {
-    explicit SymbolicRef() : jc(nullptr) {}
-    explicit SymbolicRef(JavaClass* jc) : jc(jc) {}
-    explicit SymbolicRef(JavaClass* jc, std::string name,
-                         std::string descriptor)
+    explicit SymbolicRef() : jc(nullptr), name(nullptr), descriptor(nullptr) {}
+    explicit SymbolicRef(JavaClass* jc)
+        : jc(jc), name(nullptr), descriptor(nullptr) {}
+    explicit SymbolicRef(JavaClass* jc, const Symbol* name,
+                         const Symbol* descriptor)
         : jc(jc), name(name), descriptor(descriptor) {}
+    ~SymbolicRef() { delete target.load(std::memory_order_relaxed); }
 
     JavaClass* jc;
-    std::string name;
-    std::string descriptor;
+    const Symbol* name;
+    const Symbol* descriptor;
+    // Method invokespecial or invokestatic of a method reference calls, null
+    // until it was selected. A method reference names either a static or an
+    // instance method, so the two never share an entry
+    mutable std::atomic<const CallSite*> target{nullptr};
 };
 
-SymbolicRef parseFieldSymbolicReference(const JavaClass* jc, u2 index);
+//--------------------------------------------------------------------------------
+// Resolve symbolic references of constant pool entries. An entry is resolved
+// at most once per class, referenced class is loaded and linked at that time,
+// and the result is kept in resolved constant pool cache of jc
+//--------------------------------------------------------------------------------
+const SymbolicRef& parseFieldSymbolicReference(const JavaClass* jc, u2 index);
 
-SymbolicRef parseInterfaceMethodSymbolicReference(const JavaClass* jc,
-                                                  u2 index);
+const SymbolicRef& parseInterfaceMethodSymbolicReference(const JavaClass* jc,
+                                                         u2 index);
 
-SymbolicRef parseMethodSymbolicReference(const JavaClass* jc, u2 index);
+const SymbolicRef& parseMethodSymbolicReference(const JavaClass* jc, u2 index);
 
-SymbolicRef parseClassSymbolicReference(const JavaClass* jc, u2 index);
+const SymbolicRef& parseClassSymbolicReference(const JavaClass* jc, u2 index);
+
+//--------------------------------------------------------------------------------
+// Publish the method invokespecial or invokestatic of ref calls, returns the
+// call site every later invocation of ref reuses
+//--------------------------------------------------------------------------------
+const CallSite& publishCallTarget(const SymbolicRef& ref,
+                                  const CallSite& csite);
 
 #endif
@@ -0,0 +1,854 @@
+#include <algorithm>
+#include <cstring>
+#include <typeinfo>
+#include "../classfile/AccessFlag.h"
+#include "../runtime/JavaClass.h"
+#include "Decoder.h"
+#include "TypeInference.h"
+
+using namespace std;
+
+namespace {
+
+// Type of a field descriptor, or of a stack effect character where 'L' stands
+// for any reference
+SlotTag tagOfDescriptor(char c) {
+    switch (c) {
+        case 'J':
+            return SlotTag::Long;
+        case 'D':
+            return SlotTag::Double;
+        case 'F':
+            return SlotTag::Float;
+        case 'L':
+        case '[':
+            return SlotTag::Ref;
+        default:
+            // boolean, byte, char, short and int are all int on stack
+            return SlotTag::Int;
+    }
+}
+
+SlotTag tagOfVerificationType(const VerificationTypeInfo* type) {
+    if (typeid(*type) == typeid(VariableInfo_Top)) {
+        return SlotTag::Top;
+    } else if (typeid(*type) == typeid(VariableInfo_Integer)) {
+        return SlotTag::Int;
+    } else if (typeid(*type) == typeid(VariableInfo_Float)) {
+        return SlotTag::Float;
+    } else if (typeid(*type) == typeid(VariableInfo_Long)) {
+        return SlotTag::Long;
+    } else if (typeid(*type) == typeid(VariableInfo_Double)) {
+        return SlotTag::Double;
+    }
+    // Null, UninitializedThis, Object and Uninitialized
+    return SlotTag::Ref;
+}
+
+inline bool isWide(SlotTag tag) {
+    return tag == SlotTag::Long || tag == SlotTag::Double;
+}
+
+size_t countSlots(const vector<SlotTag>& items) {
+    size_t slots = 0;
+    for (SlotTag tag : items) {
+        slots += isWide(tag) ? 2 : 1;
+    }
+    return slots;
+}
+
+// Split a method descriptor into types of parameters and return type, the
+// latter is Top for void
+void parseMethodDescriptor(const string& descriptor, vector<SlotTag>& params,
+                           SlotTag& returnType) {
+    size_t i = 1;
+    while (i < descriptor.size() && descriptor[i] != ')') {
+        params.push_back(tagOfDescriptor(descriptor[i]));
+        while (descriptor[i] == '[') {
+            i++;
+        }
+        if (descriptor[i] == 'L') {
+            i = descriptor.find(';', i);
+        }
+        i++;
+    }
+    returnType = descriptor[i + 1] == 'V' ? SlotTag::Top
+                                          : tagOfDescriptor(descriptor[i + 1]);
+}
+
+//--------------------------------------------------------------------------------
+// Stack effect of instructions that neither touch local variables nor refer to
+// constant pool, written as "popped>pushed" in descriptor characters. Returns
+// nullptr for other instructions
+//--------------------------------------------------------------------------------
+const char* simpleStackEffect(u1 opcode) {
+    switch (opcode) {
+        case op_nop:
+        case op_iinc:
+        case op_goto:
+        case op_return:
+            return ">";
+        case op_aconst_null:
+        case op_new:
+            return ">L";
+        case op_iconst_m1:
+        case op_iconst_0:
+        case op_iconst_1:
+        case op_iconst_2:
+        case op_iconst_3:
+        case op_iconst_4:
+        case op_iconst_5:
+        case op_bipush:
+        case op_sipush:
+            return ">I";
+        case op_lconst_0:
+        case op_lconst_1:
+            return ">J";
+        case op_fconst_0:
+        case op_fconst_1:
+        case op_fconst_2:
+            return ">F";
+        case op_dconst_0:
+        case op_dconst_1:
+            return ">D";
+        case op_iaload:
+        case op_baload:
+        case op_caload:
+        case op_saload:
+            return "LI>I";
+        case op_laload:
+            return "LI>J";
+        case op_faload:
+            return "LI>F";
+        case op_daload:
+            return "LI>D";
+        case op_aaload:
+            return "LI>L";
+        case op_iastore:
+        case op_bastore:
+        case op_castore:
+        case op_sastore:
+            return "LII>";
+        case op_lastore:
+            return "LIJ>";
+        case op_fastore:
+            return "LIF>";
+        case op_dastore:
+            return "LID>";
+        case op_aastore:
+            return "LIL>";
+        case op_iadd:
+        case op_isub:
+        case op_imul:
+        case op_idiv:
+        case op_irem:
+        case op_ishl:
+        case op_ishr:
+        case op_iushr:
+        case op_iand:
+        case op_ior:
+        case op_ixor:
+            return "II>I";
+        case op_ladd:
+        case op_lsub:
+        case op_lmul:
+        case op_ldiv:
+        case op_lrem:
+        case op_land:
+        case op_lor:
+        case op_lxor:
+            return "JJ>J";
+        case op_lshl:
+        case op_lshr:
+        case op_lushr:
+            return "JI>J";
+        case op_fadd:
+        case op_fsub:
+        case op_fmul:
+        case op_fdiv:
+        case op_frem:
+            return "FF>F";
+        case op_dadd:
+        case op_dsub:
+        case op_dmul:
+        case op_ddiv:
+        case op_drem:
+            return "DD>D";
+        case op_ineg:
+        case op_i2b:
+        case op_i2c:
+        case op_i2s:
+            return "I>I";
+        case op_lneg:
+            return "J>J";
+        case op_fneg:
+            return "F>F";
+        case op_dneg:
+            return "D>D";
+        case op_i2l:
+            return "I>J";
+        case op_i2f:
+            return "I>F";
+        case op_i2d:
+            return "I>D";
+        case op_l2i:
+            return "J>I";
+        case op_l2f:
+            return "J>F";
+        case op_l2d:
+            return "J>D";
+        case op_f2i:
+            return "F>I";
+        case op_f2l:
+            return "F>J";
+        case op_f2d:
+            return "F>D";
+        case op_d2i:
+            return "D>I";
+        case op_d2l:
+            return "D>J";
+        case op_d2f:
+            return "D>F";
+        case op_lcmp:
+            return "JJ>I";
+        case op_fcmpl:
+        case op_fcmpg:
+            return "FF>I";
+        case op_dcmpl:
+        case op_dcmpg:
+            return "DD>I";
+        case op_ifeq:
+        case op_ifne:
+        case op_iflt:
+        case op_ifge:
+        case op_ifgt:
+        case op_ifle:
+        case op_tableswitch:
+        case op_lookupswitch:
+        case op_ireturn:
+            return "I>";
+        case op_if_icmpeq:
+        case op_if_icmpne:
+        case op_if_icmplt:
+        case op_if_icmpge:
+        case op_if_icmpgt:
+        case op_if_icmple:
+            return "II>";
+        case op_if_acmpeq:
+        case op_if_acmpne:
+            return "LL>";
+        case op_ifnull:
+        case op_ifnonnull:
+        case op_areturn:
+        case op_athrow:
+        case op_monitorenter:
+        case op_monitorexit:
+            return "L>";
+        case op_lreturn:
+            return "J>";
+        case op_freturn:
+            return "F>";
+        case op_dreturn:
+            return "D>";
+        case op_newarray:
+        case op_anewarray:
+            return "I>L";
+        case op_arraylength:
+            return "L>I";
+        case op_checkcast:
+            return "L>L";
+        case op_instanceof:
+            return "L>I";
+        default:
+            return nullptr;
+    }
+}
+
+class TypeAnalyzer {
+public:
+    TypeAnalyzer(const JavaClass* jc, const MethodInfo* m,
+                 const DecodedCode* decoded, vector<TypeState>& states)
+        : jc(jc),
+          m(m),
+          decoded(decoded),
+          maxLocals(m->exec.maxLocal),
+          maxStack(m->exec.maxStack),
+          states(states) {}
+
+    bool run();
+
+private:
+    bool initEntryState(vector<SlotTag>& entryItems);
+    bool loadStackMapTable(const vector<SlotTag>& entryItems);
+    bool expandItems(const vector<SlotTag>& items, size_t limit,
+                     vector<SlotTag>& slots) const;
+    bool execute(u4 i, TypeState& state) const;
+    bool flowSuccessors(u4 i, const TypeState& state);
+    bool flowTo(u4 target, const TypeState& state);
+
+    bool push(TypeState& state, SlotTag tag) const;
+    static bool pop(TypeState& state, size_t slots);
+    bool load(TypeState& state, u2 index, SlotTag tag) const;
+    bool store(TypeState& state, u2 index, SlotTag tag) const;
+
+    const JavaClass* jc;
+    const MethodInfo* m;
+    const DecodedCode* decoded;
+    const size_t maxLocals;
+    const size_t maxStack;
+    vector<TypeState>& states;
+    // Frames of StackMapTable, indexed by instruction
+    vector<TypeState> declared;
+    vector<u4> worklist;
+    vector<bool> queued;
+};
+
+bool TypeAnalyzer::run() {
+    const size_t n = decoded->code.size();
+    states.assign(n, TypeState{});
+    declared.assign(n, TypeState{});
+    queued.assign(n, false);
+    if (n == 0) {
+        return false;
+    }
+
+    vector<SlotTag> entryItems;
+    if (!initEntryState(entryItems) || !loadStackMapTable(entryItems)) {
+        return false;
+    }
+    worklist.push_back(0);
+    queued[0] = true;
+
+    while (!worklist.empty()) {
+        const u4 i = worklist.back();
+        worklist.pop_back();
+        queued[i] = false;
+
+        TypeState state = states[i];
+        if (!execute(i, state) || !flowSuccessors(i, state)) {
+            return false;
+        }
+        // An exception may be thrown before or after current instruction
+        // changed local variables, handlers see both of them
+        for (const ExceptionHandler& handler : decoded->exceptionTable) {
+            if (i < handler.startPC || i >= handler.endPC) {
+                continue;
+            }
+            TypeState thrown;
+            thrown.stack.push_back(SlotTag::Ref);
+            thrown.locals = states[i].locals;
+            if (!flowTo(handler.handlerPC, thrown)) {
+                return false;
+            }
+            thrown.locals = state.locals;
+            if (!flowTo(handler.handlerPC, thrown)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool TypeAnalyzer::initEntryState(vector<SlotTag>& entryItems) {
+    if (!IS_METHOD_STATIC(m->accessFlags)) {
+        entryItems.push_back(SlotTag::Ref);
+    }
+    SlotTag returnType;
+    parseMethodDescriptor(jc->getString(m->descriptorIndex), entryItems,
+                          returnType);
+
+    TypeState& entry = states[0];
+    entry.reached = true;
+    return expandItems(entryItems, maxLocals, entry.locals);
+}
+
+bool TypeAnalyzer::loadStackMapTable(const vector<SlotTag>& entryItems) {
+    const ATTR_StackMapTable* table = nullptr;
+    FOR_EACH(i, m->exec.code->attributeCount) {
+        if (typeid(*m->exec.code->attributes[i]) ==
+            typeid(ATTR_StackMapTable)) {
+            table = static_cast<const ATTR_StackMapTable*>(
+                m->exec.code->attributes[i]);
+            break;
+        }
+    }
+    if (table == nullptr) {
+        return true;
+    }
+
+    // Frames are delta encoded, each of them is derived from the previous
+    // one. Long and double are a single item here
+    vector<SlotTag> locals = entryItems;
+    vector<SlotTag> stack;
+    int64_t offset = -1;
+    FOR_EACH(k, table->numberOfEntries) {
+        const StackMapFrame* entry = table->entries[k];
+        u2 offsetDelta = 0;
+        stack.clear();
+        if (typeid(*entry) == typeid(Frame_Same)) {
+            offsetDelta = static_cast<const Frame_Same*>(entry)->frameType;
+        } else if (typeid(*entry) == typeid(Frame_Same_locals_1_stack_item)) {
+            auto* frame =
+                static_cast<const Frame_Same_locals_1_stack_item*>(entry);
+            offsetDelta = frame->frameType - 64;
+            stack.push_back(tagOfVerificationType(frame->stack[0]));
+        } else if (typeid(*entry) ==
+                   typeid(Frame_Same_locals_1_stack_item_extended)) {
+            auto* frame =
+                static_cast<const Frame_Same_locals_1_stack_item_extended*>(
+                    entry);
+            offsetDelta = frame->offsetDelta;
+            stack.push_back(tagOfVerificationType(frame->stack[0]));
+        } else if (typeid(*entry) == typeid(Frame_Chop)) {
+            auto* frame = static_cast<const Frame_Chop*>(entry);
+            offsetDelta = frame->offsetDelta;
+            const size_t chopped = 251 - frame->frameType;
+            if (chopped > locals.size()) {
+                return false;
+            }
+            locals.resize(locals.size() - chopped);
+        } else if (typeid(*entry) == typeid(Frame_Same_frame_extended)) {
+            offsetDelta =
+                static_cast<const Frame_Same_frame_extended*>(entry)
+                    ->offsetDelta;
+        } else if (typeid(*entry) == typeid(Frame_Append)) {
+            auto* frame = static_cast<const Frame_Append*>(entry);
+            offsetDelta = frame->offsetDelta;
+            FOR_EACH(i, frame->frameType - 251) {
+                locals.push_back(tagOfVerificationType(frame->stack[i]));
+            }
+        } else if (typeid(*entry) == typeid(Frame_Full)) {
+            auto* frame = static_cast<const Frame_Full*>(entry);
+            offsetDelta = frame->offsetDelta;
+            locals.clear();
+            FOR_EACH(i, frame->numberOfLocals) {
+                locals.push_back(tagOfVerificationType(frame->locals[i]));
+            }
+            FOR_EACH(i, frame->numberOfStackItems) {
+                stack.push_back(tagOfVerificationType(frame->stack[i]));
+            }
+        } else {
+            return false;
+        }
+        offset += offsetDelta + 1;
+
+        auto pos = lower_bound(decoded->bytecodePC.cbegin(),
+                               decoded->bytecodePC.cend(), offset);
+        if (pos == decoded->bytecodePC.cend() || *pos != offset) {
+            return false;
+        }
+        TypeState& frame = declared[pos - decoded->bytecodePC.cbegin()];
+        frame.reached = true;
+        if (!expandItems(locals, maxLocals, frame.locals) ||
+            !expandItems(stack, maxStack, frame.stack)) {
+            return false;
+        }
+        // Unlike local variables, operand stack has no trailing Top slots
+        frame.stack.resize(countSlots(stack));
+    }
+    return true;
+}
+
+bool TypeAnalyzer::expandItems(const vector<SlotTag>& items, size_t limit,
+                               vector<SlotTag>& slots) const {
+    slots.assign(limit, SlotTag::Top);
+    size_t k = 0;
+    for (SlotTag tag : items) {
+        const size_t size = isWide(tag) ? 2 : 1;
+        if (k + size > limit) {
+            return false;
+        }
+        slots[k] = tag;
+        k += size;
+    }
+    return true;
+}
+
+bool TypeAnalyzer::push(TypeState& state, SlotTag tag) const {
+    const size_t size = isWide(tag) ? 2 : 1;
+    if (state.stack.size() + size > maxStack) {
+        return false;
+    }
+    state.stack.push_back(tag);
+    if (size == 2) {
+        state.stack.push_back(SlotTag::Top);
+    }
+    return true;
+}
+
+bool TypeAnalyzer::pop(TypeState& state, size_t slots) {
+    if (state.stack.size() < slots) {
+        return false;
+    }
+    state.stack.resize(state.stack.size() - slots);
+    return true;
+}
+
+bool TypeAnalyzer::load(TypeState& state, u2 index, SlotTag tag) const {
+    if (index + (isWide(tag) ? 2u : 1u) > maxLocals) {
+        return false;
+    }
+    return push(state, tag);
+}
+
+bool TypeAnalyzer::store(TypeState& state, u2 index, SlotTag tag) const {
+    const size_t size = isWide(tag) ? 2 : 1;
+    if (index + size > maxLocals || !pop(state, size)) {
+        return false;
+    }
+    // Overwriting either half of a long or double kills the whole value
+    if (index > 0 && isWide(state.locals[index - 1])) {
+        state.locals[index - 1] = SlotTag::Top;
+    }
+    state.locals[index] = tag;
+    if (size == 2) {
+        state.locals[index + 1] = SlotTag::Top;
+    }
+    return true;
+}
+
+bool TypeAnalyzer::execute(u4 i, TypeState& state) const {
+    static const SlotTag kindTags[] = {SlotTag::Int, SlotTag::Long,
+                                       SlotTag::Float, SlotTag::Double,
+                                       SlotTag::Ref};
+    const Instruction& insn = decoded->code[i];
+    // Methods may have been quickened and fused when they are compiled
+    const u1 opcode = originalOpcode(loadOpcode(&insn));
+    const ConstantPool& cp = jc->getConstPool();
+
+    if (const char* effect = simpleStackEffect(opcode)) {
+        const char* pushed = strchr(effect, '>');
+        size_t slots = 0;
+        for (const char* p = effect; p != pushed; p++) {
+            slots += isWide(tagOfDescriptor(*p)) ? 2 : 1;
+        }
+        if (!pop(state, slots)) {
+            return false;
+        }
+        for (const char* p = pushed + 1; *p != '\0'; p++) {
+            if (!push(state, tagOfDescriptor(*p))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Loads and stores are ordered by kind of value
+    if (opcode >= op_iload && opcode <= op_aload) {
+        return load(state, insn.index, kindTags[opcode - op_iload]);
+    } else if (opcode >= op_istore && opcode <= op_astore) {
+        return store(state, insn.index, kindTags[opcode - op_istore]);
+    }
+
+    vector<SlotTag>& stack = state.stack;
+    switch (opcode) {
+        case op_ldc: {
+            SlotTag tag = SlotTag::Ref;
+            if (cp.is(insn.index, TAG_Integer)) {
+                tag = SlotTag::Int;
+            } else if (cp.is(insn.index, TAG_Float)) {
+                tag = SlotTag::Float;
+            }
+            return push(state, tag);
+        }
+        case op_ldc2_w:
+            return push(state, cp.is(insn.index, TAG_Long) ? SlotTag::Long
+                                                           : SlotTag::Double);
+        // Stack manipulations copy raw slots regardless of their types
+        case op_pop:
+            return pop(state, 1);
+        case op_pop2:
+            return pop(state, 2);
+        case op_dup:
+            if (stack.size() < 1 || stack.size() + 1 > maxStack) {
+                return false;
+            }
+            stack.push_back(stack.back());
+            return true;
+        case op_dup_x1:
+        case op_dup_x2: {
+            const size_t depth = opcode == op_dup_x1 ? 2 : 3;
+            if (stack.size() < depth || stack.size() + 1 > maxStack) {
+                return false;
+            }
+            stack.insert(stack.end() - depth, stack.back());
+            return true;
+        }
+        case op_dup2:
+        case op_dup2_x1:
+        case op_dup2_x2: {
+            const size_t depth =
+                opcode == op_dup2 ? 2 : (opcode == op_dup2_x1 ? 3 : 4);
+            if (stack.size() < depth || stack.size() + 2 > maxStack) {
+                return false;
+            }
+            const SlotTag value[] = {stack[stack.size() - 2], stack.back()};
+            stack.insert(stack.end() - depth, value, value + 2);
+            return true;
+        }
+        case op_swap:
+            if (stack.size() < 2) {
+                return false;
+            }
+            swap(stack[stack.size() - 1], stack[stack.size() - 2]);
+            return true;
+        case op_getstatic:
+        case op_putstatic:
+        case op_getfield:
+        case op_putfield: {
+            const SlotTag field = tagOfDescriptor(
+                jc->getString(cp.natDescriptorIndex(
+                                  cp.nameAndTypeIndex(insn.index)))[0]);
+            const size_t size = isWide(field) ? 2 : 1;
+            switch (opcode) {
+                case op_getstatic:
+                    return push(state, field);
+                case op_putstatic:
+                    return pop(state, size);
+                case op_getfield:
+                    return pop(state, 1) && push(state, field);
+                default:
+                    return pop(state, size + 1);
+            }
+        }
+        case op_invokevirtual:
+        case op_invokespecial:
+        case op_invokestatic:
+        case op_invokeinterface: {
+            vector<SlotTag> params;
+            SlotTag returnType;
+            parseMethodDescriptor(
+                jc->getString(
+                    cp.natDescriptorIndex(cp.nameAndTypeIndex(insn.index))),
+                params, returnType);
+            const size_t slots =
+                countSlots(params) + (opcode == op_invokestatic ? 0 : 1);
+            if (!pop(state, slots)) {
+                return false;
+            }
+            return returnType == SlotTag::Top || push(state, returnType);
+        }
+        case op_multianewarray:
+            return pop(state, static_cast<size_t>(insn.operand)) &&
+                   push(state, SlotTag::Ref);
+        default:
+            // jsr/ret, invokedynamic and reserved opcodes
+            return false;
+    }
+}
+
+bool TypeAnalyzer::flowSuccessors(u4 i, const TypeState& state) {
+    const Instruction& insn = decoded->code[i];
+    switch (originalOpcode(loadOpcode(&insn))) {
+        case op_goto:
+            return flowTo(insn.operand, state);
+        case op_tableswitch: {
+            const int32_t* table = &decoded->switchTables[insn.operand];
+            if (!flowTo(table[0], state)) {
+                return false;
+            }
+            for (int64_t k = 0; k <= int64_t(table[2]) - table[1]; k++) {
+                if (!flowTo(table[3 + k], state)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case op_lookupswitch: {
+            const int32_t* table = &decoded->switchTables[insn.operand];
+            if (!flowTo(table[0], state)) {
+                return false;
+            }
+            for (int32_t k = 0; k < table[1]; k++) {
+                if (!flowTo(table[3 + 2 * k], state)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case op_ireturn:
+        case op_lreturn:
+        case op_freturn:
+        case op_dreturn:
+        case op_areturn:
+        case op_return:
+        case op_athrow:
+            return true;
+        case op_ifeq:
+        case op_ifne:
+        case op_iflt:
+        case op_ifge:
+        case op_ifgt:
+        case op_ifle:
+        case op_if_icmpeq:
+        case op_if_icmpne:
+        case op_if_icmplt:
+        case op_if_icmpge:
+        case op_if_icmpgt:
+        case op_if_icmple:
+        case op_if_acmpeq:
+        case op_if_acmpne:
+        case op_ifnull:
+        case op_ifnonnull:
+            if (!flowTo(insn.operand, state)) {
+                return false;
+            }
+            break;
+        default:
+            break;
+    }
+    // Falling off the end of code is not allowed
+    return flowTo(i + 1, state);
+}
+
+bool TypeAnalyzer::flowTo(u4 target, const TypeState& state) {
+    if (target >= states.size()) {
+        return false;
+    }
+    TypeState& current = states[target];
+    bool changed = false;
+    if (declared[target].reached) {
+        // Types recorded by compiler are authoritative
+        if (declared[target].stack.size() != state.stack.size()) {
+            return false;
+        }
+        if (!current.reached) {
+            current = declared[target];
+            changed = true;
+        }
+    } else if (!current.reached) {
+        current = state;
+        current.reached = true;
+        changed = true;
+    } else {
+        if (current.stack.size() != state.stack.size()) {
+            return false;
+        }
+        auto merge = [&changed](vector<SlotTag>& into,
+                                const vector<SlotTag>& from) {
+            for (size_t k = 0; k < into.size(); k++) {
+                if (into[k] != SlotTag::Top && into[k] != from[k]) {
+                    into[k] = SlotTag::Top;
+                    changed = true;
+                }
+            }
+        };
+        merge(current.locals, state.locals);
+        merge(current.stack, state.stack);
+    }
+    if (changed && !queued[target]) {
+        queued[target] = true;
+        worklist.push_back(target);
+    }
+    return true;
+}
+
+}  // namespace
+
+bool inferTypes(const JavaClass* jc, const MethodInfo* m,
+                const DecodedCode* decoded, vector<TypeState>& states) {
+    return TypeAnalyzer(jc, m, decoded, states).run();
+}
+
+size_t poppedSlots(const JavaClass* jc, const Instruction& insn) {
+    const u1 opcode = originalOpcode(loadOpcode(&insn));
+    const ConstantPool& cp = jc->getConstPool();
+    if (const char* effect = simpleStackEffect(opcode)) {
+        size_t slots = 0;
+        for (const char* p = effect; *p != '>'; p++) {
+            slots += isWide(tagOfDescriptor(*p)) ? 2 : 1;
+        }
+        return slots;
+    }
+    if (opcode >= op_istore && opcode <= op_astore) {
+        return opcode == op_lstore || opcode == op_dstore ? 2 : 1;
+    }
+    switch (opcode) {
+        case op_pop:
+        case op_dup:
+            return 1;
+        case op_pop2:
+        case op_dup_x1:
+        case op_dup2:
+        case op_swap:
+            return 2;
+        case op_dup_x2:
+        case op_dup2_x1:
+            return 3;
+        case op_dup2_x2:
+            return 4;
+        case op_putstatic:
+        case op_getfield:
+        case op_putfield: {
+            const SlotTag field = tagOfDescriptor(
+                jc->getString(cp.natDescriptorIndex(
+                                  cp.nameAndTypeIndex(insn.index)))[0]);
+            const size_t size = isWide(field) ? 2 : 1;
+            return opcode == op_putstatic
+                       ? size
+                       : (opcode == op_getfield ? 1 : size + 1);
+        }
+        case op_invokevirtual:
+        case op_invokespecial:
+        case op_invokestatic:
+        case op_invokeinterface: {
+            vector<SlotTag> params;
+            SlotTag returnType;
+            parseMethodDescriptor(
+                jc->getString(
+                    cp.natDescriptorIndex(cp.nameAndTypeIndex(insn.index))),
+                params, returnType);
+            return countSlots(params) + (opcode == op_invokestatic ? 0 : 1);
+        }
+        case op_multianewarray:
+            return static_cast<size_t>(insn.operand);
+        default:
+            return 0;
+    }
+}
+
+void buildReferenceMaps(const JavaClass* jc, const MethodInfo* m,
+                        DecodedCode* decoded) {
+    const u4 words = (m->exec.maxLocal + 31) / 32;
+    vector<TypeState> states;
+    if (words == 0 || !inferTypes(jc, m, decoded, states)) {
+        return;
+    }
+
+    decoded->refMapWords = words;
+    FOR_EACH(i, decoded->code.size()) {
+        switch (decoded->code[i].opcode) {
+            case op_invokevirtual:
+            case op_invokespecial:
+            case op_invokestatic:
+            case op_invokeinterface:
+            case op_new:
+            case op_getstatic:
+            case op_putstatic:
+                break;
+            default:
+                continue;
+        }
+        if (!states[i].reached) {
+            continue;
+        }
+        decoded->refMapPCs.push_back(static_cast<u4>(i));
+        decoded->refMaps.resize(decoded->refMaps.size() + words, 0);
+        uint32_t* map = &decoded->refMaps[decoded->refMaps.size() - words];
+        FOR_EACH(k, states[i].locals.size()) {
+            if (states[i].locals[k] == SlotTag::Ref) {
+                map[k / 32] |= 1u << (k % 32);
+            }
+        }
+    }
+}
+
+const uint32_t* findReferenceMap(const DecodedCode* decoded, u4 pc) {
+    auto pos = lower_bound(decoded->refMapPCs.cbegin(),
+                           decoded->refMapPCs.cend(), pc);
+    if (pos == decoded->refMapPCs.cend() || *pos != pc) {
+        return nullptr;
+    }
+    return &decoded->refMaps[(pos - decoded->refMapPCs.cbegin()) *
+                             decoded->refMapWords];
+}
@@ -0,0 +1,55 @@
+#ifndef YVM_TYPEINFERENCE_H
+#define YVM_TYPEINFERENCE_H
+
+#include <vector>
+#include "../classfile/ClassFile.h"
+#include "../runtime/JavaType.h"
+#include "Instruction.h"
+
+class JavaClass;
+
+//--------------------------------------------------------------------------------
+// Types of local variables and operand stack slots before an instruction was
+// executed. A long or double value takes up two slots as it does at runtime,
+// the second one is Top. References of any class, null and uninitialized
+// objects are all Ref
+//--------------------------------------------------------------------------------
+struct TypeState {
+    bool reached = false;
+    std::vector<SlotTag> locals;
+    std::vector<SlotTag> stack;
+};
+
+//--------------------------------------------------------------------------------
+// Infer types of every instruction of a decoded method by data flow analysis.
+// Frames recorded in StackMapTable are taken as they are at their
+// instructions, types flowing into any other instruction are merged and a slot
+// that disagrees becomes Top. Returns false if the method can not be analyzed,
+// e.g. it uses jsr/ret or its operand stack goes out of bounds
+//--------------------------------------------------------------------------------
+bool inferTypes(const JavaClass* jc, const MethodInfo* m,
+                const DecodedCode* decoded, std::vector<TypeState>& states);
+
+//--------------------------------------------------------------------------------
+// Number of operand stack slots instruction insn of a method of jc pops. Loads
+// of local variables pop nothing, stack manipulations pop the slots they
+// rearrange
+//--------------------------------------------------------------------------------
+size_t poppedSlots(const JavaClass* jc, const Instruction& insn);
+
+//--------------------------------------------------------------------------------
+// Build reference maps of local variables at instructions where current frame
+// may be suspended while GC runs, i.e. method invocations and instructions
+// that may initialize a class. Nothing is built if types of the method can not
+// be inferred, GC falls back to slot tags then
+//--------------------------------------------------------------------------------
+void buildReferenceMaps(const JavaClass* jc, const MethodInfo* m,
+                        DecodedCode* decoded);
+
+//--------------------------------------------------------------------------------
+// Find reference map of local variables at given instruction, bit i of the map
+// is set if local variable i holds a live reference. Returns nullptr if absent
+//--------------------------------------------------------------------------------
+const uint32_t* findReferenceMap(const DecodedCode* decoded, u4 pc);
+
+#endif  // YVM_TYPEINFERENCE_H
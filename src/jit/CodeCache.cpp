@@ -0,0 +1,39 @@
+#include <cstring>
+#include "CodeCache.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define YVM_HAS_MMAP
+#endif
+
+using namespace std;
+
+uint8_t* CodeCache::install(const uint8_t* code, size_t size) {
+    lock_guard<mutex> lock(installMutex);
+#ifdef YVM_HAS_MMAP
+    if (!reserved) {
+        reserved = true;
+        pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        void* region = mmap(nullptr, capacity, PROT_NONE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        base = region != MAP_FAILED ? static_cast<uint8_t*>(region) : nullptr;
+    }
+    // Pages of former code may be running on other threads, so they are
+    // never made writable again
+    const size_t start = (used + pageSize - 1) & ~(pageSize - 1);
+    const size_t end = (start + size + pageSize - 1) & ~(pageSize - 1);
+    if (base == nullptr || end > capacity ||
+        mprotect(base + start, end - start, PROT_READ | PROT_WRITE) != 0) {
+        return nullptr;
+    }
+    memcpy(base + start, code, size);
+    if (mprotect(base + start, end - start, PROT_READ | PROT_EXEC) != 0) {
+        return nullptr;
+    }
+    used = end;
+    return base + start;
+#else
+    return nullptr;
+#endif
+}
@@ -0,0 +1,37 @@
+#ifndef YVM_CODECACHE_H
+#define YVM_CODECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+//--------------------------------------------------------------------------------
+// Executable memory holding machine code of compiled methods. The region is
+// reserved on the first allocation and carved out by bumping a pointer,
+// compiled code is never freed since methods are never unloaded. The region
+// is not unmapped at exit either, detached threads may still be running
+// compiled code while static objects are destroyed. Each installed code
+// starts on a page of its own, its pages are writable while it's copied and
+// executable afterwards, never both at once
+//--------------------------------------------------------------------------------
+class CodeCache {
+public:
+    explicit CodeCache(size_t capacity) : capacity(capacity) {}
+
+    CodeCache(const CodeCache&) = delete;
+    CodeCache& operator=(const CodeCache&) = delete;
+
+    // Copy given code into the cache, returns nullptr if the cache was
+    // exhausted or executable memory is not available
+    uint8_t* install(const uint8_t* code, size_t size);
+
+private:
+    std::mutex installMutex;
+    uint8_t* base = nullptr;
+    size_t capacity;
+    size_t pageSize = 4096;
+    size_t used = 0;
+    bool reserved = false;
+};
+
+#endif  // YVM_CODECACHE_H
@@ -0,0 +1,400 @@
+#include <cstddef>
+#include "../interpreter/Decoder.h"
+#include "OptimizingJIT.h"
+
+using namespace std;
+
+static const int32_t TAG_OFFSET = offsetof(JValue, tag);
+
+// Registers whose tag in memory is not known
+static const uint8_t UNKNOWN_TAG = 0xff;
+
+static bool isWide(SlotTag tag) {
+    return tag == SlotTag::Long || tag == SlotTag::Double;
+}
+
+bool OptimizingJIT::compile(const JavaClass* jc, const MethodInfo* m,
+                            DecodedCode* decoded,
+                            const vector<TypeState>* states,
+                            CompiledMethod* compiled) {
+    IrMethod ir;
+    if (!buildIR(jc, m, decoded, *states, ir)) {
+        return false;
+    }
+    optimizeIR(ir, jc, decoded, *states);
+    OptimizingJIT compiler(jc, decoded, states, compiled, &ir);
+    if (!compiler.assemble()) {
+        return false;
+    }
+    for (const IrInlined& inlined : ir.inlined) {
+        // The outermost inlined method of a body was inlined at site 0
+        const IrInlined* outer = &inlined;
+        while (outer->caller != 0) {
+            outer = &ir.inlined[outer->caller - 1];
+        }
+        compiled->inlined.push_back(
+            InlinedMethod{inlined.jc, inlined.method, inlined.decoded,
+                          static_cast<int>(inlined.caller) - 1,
+                          outer->invokeIndex});
+        if (inlined.bound != nullptr) {
+            compiled->dependencies.emplace_back(inlined.bound,
+                                                inlined.method);
+        }
+    }
+    compiled->extraStack = ir.extraStack;
+    return true;
+}
+
+OptimizingJIT::OptimizingJIT(const JavaClass* jc, DecodedCode* decoded,
+                             const vector<TypeState>* states,
+                             CompiledMethod* compiled, const IrMethod* ir)
+    : TemplateJIT(jc, decoded, states, compiled), ir(ir) {}
+
+bool OptimizingJIT::emitBody() {
+    offsets.resize(decoded->code.size());
+    tags.resize(ir->registerCount());
+    for (const IrBlock& block : ir->blocks) {
+        // Only the beginning of a block is ever entered
+        for (u4 i = block.start; i < block.end; i++) {
+            offsets[i] = as.size();
+        }
+        if (!block.reached) {
+            as.int3();
+            continue;
+        }
+
+        // Registers carry their inferred tags into a block, Top may be
+        // either the second half of a value or a slot nobody agrees on
+        const TypeState& entry = (*states)[block.start];
+        FOR_EACH(r, tags.size()) {
+            SlotTag tag = SlotTag::Top;
+            if (r < ir->maxLocal) {
+                tag = entry.locals[r];
+            } else if (r - ir->maxLocal < entry.stack.size()) {
+                tag = entry.stack[r - ir->maxLocal];
+            }
+            tags[r] = tag == SlotTag::Top ? UNKNOWN_TAG
+                                          : static_cast<uint8_t>(tag);
+        }
+        for (const IrInsn& insn : block.code) {
+            if (!emitInsn(insn)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void OptimizingJIT::emitOperand(Reg dst, const IrOperand& operand,
+                                SlotTag type) {
+    if (operand.isImm()) {
+        as.movImm(dst, operand.imm);
+    } else {
+        as.load(dst, slot(operand.reg),
+                type != SlotTag::Int && type != SlotTag::Float);
+    }
+}
+
+void OptimizingJIT::emitStore(int32_t reg, Reg src, SlotTag type) {
+    as.store(slot(reg), src, type != SlotTag::Int && type != SlotTag::Float);
+    emitTags(reg, type);
+}
+
+void OptimizingJIT::emitTags(int32_t reg, SlotTag type) {
+    auto store = [&](int32_t r, SlotTag tag) {
+        if (tags[r] != static_cast<uint8_t>(tag)) {
+            as.storeImm8(localSlot(r, TAG_OFFSET), static_cast<uint8_t>(tag));
+            tags[r] = static_cast<uint8_t>(tag);
+        }
+    };
+    store(reg, type);
+    if (isWide(type)) {
+        store(reg + 1, SlotTag::Top);
+    }
+}
+
+void OptimizingJIT::emitCall(const IrInsn& insn) {
+    if (insn.site == 0) {
+        emitSlowPath(insn.index, insn.depth);
+    } else {
+        emitHelperCall(addressOf(&TemplateJIT::inlinedPath),
+                       (insn.site - 1) << 16 | insn.index, insn.depth);
+    }
+    // Helpers write operand stack with whatever tags they push
+    for (size_t r = ir->maxLocal; r < tags.size(); r++) {
+        tags[r] = UNKNOWN_TAG;
+    }
+}
+
+void OptimizingJIT::emitCompare(const IrInsn& insn) {
+    // An immediate operand is always the second one
+    const bool wide = insn.type != SlotTag::Int;
+    emitOperand(RAX, insn.a, insn.type);
+    if (!insn.b.isImm()) {
+        as.alu(AluCmp, RAX, slot(insn.b.reg), wide);
+    } else if (insn.b.imm == 0) {
+        as.test(RAX, RAX, wide);
+    } else {
+        as.movImm(RDX, insn.b.imm);
+        as.alu(AluCmp, RAX, RDX, wide);
+    }
+}
+
+bool OptimizingJIT::emitInsn(const IrInsn& insn) {
+    static const Cond conditions[] = {CondE,  CondNE, CondL,
+                                      CondGE, CondG,  CondLE};
+
+    const SlotTag type = insn.type;
+    const bool wide = type == SlotTag::Long || type == SlotTag::Double;
+    const SsePrefix prefix = type == SlotTag::Double ? SseDouble : SseSingle;
+    switch (insn.op) {
+        case IrOp::Nop:
+            break;
+        case IrOp::Const:
+            if (wide) {
+                as.movImm(RAX, insn.a.imm);
+                as.store(slot(insn.dst), RAX, true);
+            } else {
+                as.storeImm32(slot(insn.dst),
+                              static_cast<int32_t>(insn.a.imm),
+                              type == SlotTag::Ref);
+            }
+            emitTags(insn.dst, type);
+            break;
+        case IrOp::Move:
+            emitOperand(RAX, insn.a, type);
+            emitStore(insn.dst, RAX, type);
+            break;
+
+        case IrOp::Add:
+        case IrOp::Sub:
+        case IrOp::Mul:
+        case IrOp::Div:
+        case IrOp::And:
+        case IrOp::Or:
+        case IrOp::Xor:
+            if (type == SlotTag::Float || type == SlotTag::Double) {
+                static const SseOp floatOps[] = {SseAdd, SseSub, SseMul,
+                                                 SseDiv};
+                if (insn.a.isImm() || insn.b.isImm()) {
+                    return false;
+                }
+                as.sse(prefix, SseLoad, 0, slot(insn.a.reg));
+                as.sse(prefix,
+                       floatOps[static_cast<int>(insn.op) -
+                                static_cast<int>(IrOp::Add)],
+                       0, slot(insn.b.reg));
+                as.sse(prefix, SseStore, 0, slot(insn.dst));
+                emitTags(insn.dst, type);
+                break;
+            }
+            emitOperand(RAX, insn.a, type);
+            if (insn.b.isImm()) {
+                as.movImm(RCX, insn.b.imm);
+            }
+            if (insn.op == IrOp::Mul) {
+                if (insn.b.isImm()) {
+                    as.imul(RAX, RCX, wide);
+                } else {
+                    as.imul(RAX, slot(insn.b.reg), wide);
+                }
+            } else {
+                AluOp op = AluXor;
+                if (insn.op == IrOp::Add) {
+                    op = AluAdd;
+                } else if (insn.op == IrOp::Sub) {
+                    op = AluSub;
+                } else if (insn.op == IrOp::And) {
+                    op = AluAnd;
+                } else if (insn.op == IrOp::Or) {
+                    op = AluOr;
+                } else if (insn.op == IrOp::Div) {
+                    // Integer division is always called
+                    return false;
+                }
+                if (insn.b.isImm()) {
+                    as.alu(op, RAX, RCX, wide);
+                } else {
+                    as.alu(op, RAX, slot(insn.b.reg), wide);
+                }
+            }
+            emitStore(insn.dst, RAX, type);
+            break;
+        case IrOp::Shl:
+        case IrOp::Shr:
+        case IrOp::UShr: {
+            static const ShiftOp shiftOps[] = {ShiftLeft, ShiftRight,
+                                               ShiftRightLogical};
+            emitOperand(RCX, insn.b, SlotTag::Int);
+            emitOperand(RAX, insn.a, type);
+            as.shift(shiftOps[static_cast<int>(insn.op) -
+                              static_cast<int>(IrOp::Shl)],
+                     RAX, wide);
+            emitStore(insn.dst, RAX, type);
+            break;
+        }
+        case IrOp::Neg:
+            emitOperand(RAX, insn.a, type);
+            if (type == SlotTag::Float || type == SlotTag::Double) {
+                // Flip the sign bit, which is what fneg and dneg do
+                as.movImm(RCX, wide ? uint64_t(1) << 63 : 0x80000000u);
+                as.alu(AluXor, RAX, RCX, wide);
+            } else {
+                as.neg(RAX, wide);
+            }
+            emitStore(insn.dst, RAX, type);
+            break;
+        case IrOp::Convert: {
+            const Mem src = slot(insn.a.reg);
+            switch (insn.extra) {
+                case op_i2l:
+                    as.loadSignExtend32(RAX, src);
+                    emitStore(insn.dst, RAX, type);
+                    break;
+                case op_l2i:
+                    as.load(RAX, src, false);
+                    emitStore(insn.dst, RAX, type);
+                    break;
+                case op_i2b:
+                    as.loadSignExtend8(RAX, src);
+                    emitStore(insn.dst, RAX, type);
+                    break;
+                case op_i2c:
+                    as.loadZeroExtend16(RAX, src);
+                    emitStore(insn.dst, RAX, type);
+                    break;
+                case op_i2s:
+                    as.loadSignExtend16(RAX, src);
+                    emitStore(insn.dst, RAX, type);
+                    break;
+                case op_i2f:
+                case op_l2f:
+                case op_i2d:
+                case op_l2d:
+                    as.sse(prefix, SseConvertInt, 0, src,
+                           insn.extra == op_l2f || insn.extra == op_l2d);
+                    as.sse(prefix, SseStore, 0, slot(insn.dst));
+                    emitTags(insn.dst, type);
+                    break;
+                case op_f2d:
+                    as.sse(SseSingle, SseConvertFloat, 0, src);
+                    as.sse(SseDouble, SseStore, 0, slot(insn.dst));
+                    emitTags(insn.dst, type);
+                    break;
+                case op_d2f:
+                    as.sse(SseDouble, SseConvertFloat, 0, src);
+                    as.sse(SseSingle, SseStore, 0, slot(insn.dst));
+                    emitTags(insn.dst, type);
+                    break;
+                default:
+                    return false;
+            }
+            break;
+        }
+        case IrOp::Compare:
+            emitCompare(insn);
+            as.setcc(CondG, RAX);
+            as.setcc(CondL, RCX);
+            as.zeroExtend8(RAX, RAX);
+            as.zeroExtend8(RCX, RCX);
+            as.alu(AluSub, RAX, RCX, false);
+            emitStore(insn.dst, RAX, SlotTag::Int);
+            break;
+
+        case IrOp::Shuffle: {
+            size_t popped;
+            const char* pattern = shufflePattern(insn.extra, popped);
+            const vector<SlotTag>& stack = (*states)[insn.index].stack;
+            emitShuffle(stack.data(), insn.depth, popped, pattern);
+            const size_t base = insn.depth - popped;
+            for (size_t k = 0; pattern[k] != '\0'; k++) {
+                tags[ir->maxLocal + base + k] =
+                    static_cast<uint8_t>(stack[base + pattern[k] - '0']);
+            }
+            break;
+        }
+
+        case IrOp::Branch: {
+            const auto cond = static_cast<IrCond>(insn.extra);
+            if (type == SlotTag::Ref && !insn.b.isImm()) {
+                as.load(RDI, slot(insn.a.reg), true);
+                as.load(RSI, slot(insn.b.reg), true);
+                as.movImm(RAX, addressOf(&TemplateJIT::sameReference));
+                as.call(RAX);
+                as.zeroExtend8(RAX, RAX);
+                as.test(RAX, RAX, false);
+                emitBranch(cond == IrCond::Eq ? CondNE : CondE, insn.target);
+                break;
+            }
+            // A reference is only ever compared to null
+            emitCompare(insn);
+            emitBranch(conditions[insn.extra], insn.target);
+            break;
+        }
+        case IrOp::Goto:
+            branches.emplace_back(as.jmp(), insn.target);
+            break;
+        case IrOp::Switch:
+            as.movImm(RDI, addressOf(decoded->switchTables.data() +
+                                     insn.target));
+            as.load(RSI, slot(insn.a.reg), false);
+            as.movImm(RAX, insn.extra == op_tableswitch
+                               ? addressOf(&TemplateJIT::tableSwitchTarget)
+                               : addressOf(&TemplateJIT::lookupSwitchTarget));
+            as.call(RAX);
+            as.mov(RAX, RAX, false);
+            as.movImm(RCX, addressOf(compiled->entries.data()));
+            as.jmpIndexed(RCX, RAX);
+            break;
+        case IrOp::Return:
+            // Return value is left in its slot and copied by caller
+            as.lea(RAX, insn.a.isImm() ? stackSlot(0) : slot(insn.a.reg));
+            returnExits.push_back(as.jmp());
+            break;
+
+        case IrOp::Call:
+            emitCall(insn);
+            break;
+        case IrOp::Inline: {
+            if (insn.extra != 0) {
+                guards.emplace_back();
+            }
+            if ((insn.extra & GuardReceiver) != 0) {
+                emitClassGuard(
+                    slot(insn.a.reg),
+                    reinterpret_cast<const JavaClass*>(insn.b.imm),
+                    guards.back());
+            }
+            // Once a loaded class overrides a method bound by class
+            // hierarchy, the code is invalidated and activations still
+            // running it leave the bodies to the invocations they replace
+            if ((insn.extra & GuardHierarchy) != 0) {
+                as.movImm(RCX, reinterpret_cast<uint64_t>(
+                                   &compiled->invalidated));
+                as.loadSignExtend8(RCX, Mem{RCX, 0});
+                as.test(RCX, RCX, false);
+                guards.back().push_back(as.jcc(CondNE));
+            }
+            // Local variables after arguments are cleared the same way
+            // JavaFrame::pushFrame() does, GC scans them while the body
+            // calls runtime helpers
+            const IrInlined& callee = ir->inlined[insn.target - 1];
+            for (u4 k = callee.argSlots; k < callee.maxLocal; k++) {
+                emitTags(static_cast<int32_t>(callee.base + k), SlotTag::Top);
+            }
+            break;
+        }
+        case IrOp::Merge:
+            if (insn.extra != 0) {
+                const size_t join = as.jmp();
+                for (size_t miss : guards.back()) {
+                    as.bind(miss, as.size());
+                }
+                guards.pop_back();
+                emitCall(insn);
+                as.bind(join, as.size());
+            }
+            break;
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef YVM_OPTIMIZINGJIT_H
+#define YVM_OPTIMIZINGJIT_H
+
+#include <vector>
+#include "RegisterIR.h"
+#include "TemplateJIT.h"
+
+//--------------------------------------------------------------------------------
+// Optimizing compiler. A hot method is translated into register IR, each
+// basic block is optimized and every IR instruction is lowered into machine
+// code working on frame slots directly, so the copies through operand stack
+// that stack code is made of are gone along with folded constants, common
+// subexpressions and repeated loads, and so are the frames of inlined
+// methods. The code runs on the same frame as baseline code does and shares
+// its entries, exits and runtime helpers, and a slot tag is only stored when
+// it differs from the tag already in memory
+//--------------------------------------------------------------------------------
+class OptimizingJIT : public TemplateJIT {
+public:
+    // Compile a method whose types were inferred into compiled, returns false
+    // if it can not be translated into IR
+    static bool compile(const JavaClass* jc, const MethodInfo* m,
+                        DecodedCode* decoded,
+                        const std::vector<TypeState>* states,
+                        CompiledMethod* compiled);
+
+private:
+    OptimizingJIT(const JavaClass* jc, DecodedCode* decoded,
+                  const std::vector<TypeState>* states,
+                  CompiledMethod* compiled, const IrMethod* ir);
+
+    bool emitBody() override;
+    bool emitInsn(const IrInsn& insn);
+    void emitOperand(Reg dst, const IrOperand& operand, SlotTag type);
+    void emitStore(int32_t reg, Reg src, SlotTag type);
+    void emitTags(int32_t reg, SlotTag type);
+    void emitCompare(const IrInsn& insn);
+    void emitCall(const IrInsn& insn);
+
+    static Mem slot(int32_t reg) { return localSlot(reg); }
+
+    const IrMethod* ir;
+    // Tag of each register in memory, UNKNOWN_TAG if it's not known
+    std::vector<uint8_t> tags;
+    // Guards of the inlined bodies being emitted, which jump to the
+    // invocation each body replaces
+    std::vector<std::vector<size_t>> guards;
+};
+
+#endif  // YVM_OPTIMIZINGJIT_H
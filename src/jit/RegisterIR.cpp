@@ -0,0 +1,2206 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <set>
+#include <tuple>
+#include "../classfile/AccessFlag.h"
+#include "../interpreter/Decoder.h"
+#include "../interpreter/MethodResolve.h"
+#include "../interpreter/SymbolicRef.h"
+#include "../misc/Option.h"
+#include "../runtime/JavaClass.h"
+#include "../runtime/MethodArea.h"
+#include "RegisterIR.h"
+
+using namespace std;
+
+static bool isWide(SlotTag tag) {
+    return tag == SlotTag::Long || tag == SlotTag::Double;
+}
+
+static uint64_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static uint64_t doubleBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float toFloat(uint64_t bits) {
+    const auto low = static_cast<uint32_t>(bits);
+    float value;
+    memcpy(&value, &low, sizeof(value));
+    return value;
+}
+
+static double toDouble(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static IrInsn makeInsn(IrOp op, SlotTag type, int32_t dst, u4 index,
+                       u4 depth, u4 site) {
+    IrInsn insn;
+    insn.op = op;
+    insn.type = type;
+    insn.extra = 0;
+    insn.dst = dst;
+    insn.a = IrOperand::immOf(0);
+    insn.b = IrOperand::immOf(0);
+    insn.index = index;
+    insn.depth = depth;
+    insn.target = -1;
+    insn.site = site;
+    return insn;
+}
+
+// Type of the value an instruction defines, lcmp compares longs into an int
+static SlotTag resultType(const IrInsn& insn) {
+    return insn.op == IrOp::Compare ? SlotTag::Int : insn.type;
+}
+
+// Instructions that compute dst from their operands and nothing else
+static bool isPure(IrOp op) {
+    return op >= IrOp::Const && op <= IrOp::Compare;
+}
+
+static bool hasSecondOperand(IrOp op) {
+    return (op >= IrOp::Add && op <= IrOp::UShr) || op == IrOp::Compare ||
+           op == IrOp::Branch;
+}
+
+const char* shufflePattern(u1 opcode, size_t& popped) {
+    switch (opcode) {
+        case op_dup_x1:
+            popped = 2;
+            return "101";
+        case op_dup_x2:
+            popped = 3;
+            return "2012";
+        case op_dup2_x1:
+            popped = 3;
+            return "12012";
+        case op_dup2_x2:
+            popped = 4;
+            return "230123";
+        case op_swap:
+            popped = 2;
+            return "10";
+        default:
+            popped = 0;
+            return "";
+    }
+}
+
+//--------------------------------------------------------------------------------
+// A method being translated into IR, either the compiled method or a method
+// inlined into it by caller. Its local variable k is register base + k and
+// its operand stack slot k is register base + maxLocal + k
+//--------------------------------------------------------------------------------
+struct Translation {
+    const JavaClass* jc;
+    const MethodInfo* method;
+    const DecodedCode* decoded;
+    const vector<TypeState>* states;
+    const Translation* caller;
+    u4 site;
+    u4 base;
+    u4 maxLocal;
+    u4 level;
+};
+
+static bool inlineCall(const Translation& t, u4 i, IrMethod& ir,
+                       vector<IrInsn>& code);
+
+//--------------------------------------------------------------------------------
+// Translate instruction i of t into IR. Every instruction reads and writes the
+// registers its stack code would, so copies are left for the optimizer to
+// remove
+//--------------------------------------------------------------------------------
+static bool translate(const Translation& t, u4 i, IrMethod& ir,
+                      vector<IrInsn>& code) {
+    static const IrOp floatOps[] = {IrOp::Add, IrOp::Sub, IrOp::Mul,
+                                    IrOp::Div};
+    static const IrOp shiftOps[] = {IrOp::Shl, IrOp::Shr, IrOp::UShr};
+
+    const TypeState& state = (*t.states)[i];
+    const Instruction& insn = t.decoded->code[i];
+    const ConstantPool& cp = t.jc->getConstPool();
+    const auto d = static_cast<u4>(state.stack.size());
+    const u4 depth = t.base + t.maxLocal + d - ir.maxLocal;
+    const u1 opcode = originalOpcode(loadOpcode(&insn));
+
+    auto S = [&](u4 slot) {
+        return static_cast<int32_t>(t.base + t.maxLocal + slot);
+    };
+    auto L = [&](u4 local) { return static_cast<int32_t>(t.base + local); };
+    auto emit = [&](IrOp op, SlotTag type, int32_t dst) -> IrInsn& {
+        code.push_back(makeInsn(op, type, dst, i, depth, t.site));
+        return code.back();
+    };
+    auto constant = [&](uint64_t bits, SlotTag type) {
+        emit(IrOp::Const, type, S(d)).a = IrOperand::immOf(bits);
+    };
+    auto move = [&](int32_t dst, int32_t src, SlotTag type) {
+        emit(IrOp::Move, type, dst).a = IrOperand::regOf(src);
+    };
+    auto binary = [&](IrOp op, SlotTag type, int32_t dst, int32_t src) {
+        IrInsn& x = emit(op, type, dst);
+        x.a = IrOperand::regOf(dst);
+        x.b = IrOperand::regOf(src);
+    };
+    auto unary = [&](IrOp op, SlotTag type, int32_t dst, int32_t src) {
+        emit(op, type, dst).a = IrOperand::regOf(src);
+    };
+    auto branch = [&](IrCond cond, SlotTag type, IrOperand a, IrOperand b) {
+        IrInsn& x = emit(IrOp::Branch, type, -1);
+        x.extra = static_cast<u1>(cond);
+        x.a = a;
+        x.b = b;
+        x.target = insn.operand;
+    };
+
+    switch (opcode) {
+        case op_nop:
+        case op_pop:
+        case op_pop2:
+            break;
+        case op_aconst_null:
+            constant(0, SlotTag::Ref);
+            break;
+        case op_bipush:
+        case op_sipush:
+            constant(static_cast<uint32_t>(insn.operand), SlotTag::Int);
+            break;
+        case op_lconst_0:
+        case op_lconst_1:
+            constant(opcode - op_lconst_0, SlotTag::Long);
+            break;
+        case op_fconst_0:
+        case op_fconst_1:
+        case op_fconst_2:
+            constant(floatBits(static_cast<float>(opcode - op_fconst_0)),
+                     SlotTag::Float);
+            break;
+        case op_dconst_0:
+        case op_dconst_1:
+            constant(doubleBits(static_cast<double>(opcode - op_dconst_0)),
+                     SlotTag::Double);
+            break;
+        case op_ldc:
+            if (cp.is(insn.index, TAG_Integer)) {
+                constant(static_cast<uint32_t>(cp.intValue(insn.index)),
+                         SlotTag::Int);
+            } else if (cp.is(insn.index, TAG_Float)) {
+                constant(floatBits(cp.floatValue(insn.index)), SlotTag::Float);
+            } else {
+                emit(IrOp::Call, SlotTag::Top, -1);
+            }
+            break;
+        case op_ldc2_w:
+            if (cp.is(insn.index, TAG_Long)) {
+                constant(static_cast<uint64_t>(cp.longValue(insn.index)),
+                         SlotTag::Long);
+            } else if (cp.is(insn.index, TAG_Double)) {
+                constant(doubleBits(cp.doubleValue(insn.index)),
+                         SlotTag::Double);
+            } else {
+                return false;
+            }
+            break;
+
+        // A long or double is copied as one value
+        case op_iload:
+        case op_fload:
+        case op_aload:
+        case op_lload:
+        case op_dload: {
+            const bool wide = opcode == op_lload || opcode == op_dload;
+            const SlotTag tag = state.locals[insn.index];
+            if (tag == SlotTag::Top || isWide(tag) != wide) {
+                return false;
+            }
+            move(S(d), L(insn.index), tag);
+            break;
+        }
+        case op_istore:
+        case op_fstore:
+        case op_astore:
+        case op_lstore:
+        case op_dstore: {
+            const bool wide = opcode == op_lstore || opcode == op_dstore;
+            const u4 slot = d - (wide ? 2 : 1);
+            const SlotTag tag = state.stack[slot];
+            if (tag == SlotTag::Top || isWide(tag) != wide) {
+                return false;
+            }
+            move(L(insn.index), S(slot), tag);
+            break;
+        }
+        case op_iinc: {
+            IrInsn& x = emit(IrOp::Add, SlotTag::Int, L(insn.index));
+            x.a = IrOperand::regOf(L(insn.index));
+            x.b = IrOperand::immOf(static_cast<uint32_t>(insn.operand));
+            break;
+        }
+
+        case op_dup:
+            if (state.stack[d - 1] == SlotTag::Top) {
+                return false;
+            }
+            move(S(d), S(d - 1), state.stack[d - 1]);
+            break;
+        case op_dup2:
+            if (isWide(state.stack[d - 2])) {
+                move(S(d), S(d - 2), state.stack[d - 2]);
+            } else if (state.stack[d - 2] != SlotTag::Top &&
+                       state.stack[d - 1] != SlotTag::Top) {
+                move(S(d), S(d - 2), state.stack[d - 2]);
+                move(S(d + 1), S(d - 1), state.stack[d - 1]);
+            } else {
+                return false;
+            }
+            break;
+        case op_dup_x1:
+        case op_dup_x2:
+        case op_dup2_x1:
+        case op_dup2_x2:
+        case op_swap:
+            // Backend shuffles operand stack of the compiled method only
+            if (t.site != 0) {
+                return false;
+            }
+            emit(IrOp::Shuffle, SlotTag::Top, -1).extra = opcode;
+            break;
+
+        // Arithmetic overwrites its first operand as stack code does
+        case op_iadd:
+        case op_ladd:
+        case op_isub:
+        case op_lsub:
+        case op_imul:
+        case op_lmul:
+        case op_iand:
+        case op_land:
+        case op_ior:
+        case op_lor:
+        case op_ixor:
+        case op_lxor: {
+            IrOp op = IrOp::Xor;
+            if (opcode == op_iadd || opcode == op_ladd) {
+                op = IrOp::Add;
+            } else if (opcode == op_isub || opcode == op_lsub) {
+                op = IrOp::Sub;
+            } else if (opcode == op_imul || opcode == op_lmul) {
+                op = IrOp::Mul;
+            } else if (opcode == op_iand || opcode == op_land) {
+                op = IrOp::And;
+            } else if (opcode == op_ior || opcode == op_lor) {
+                op = IrOp::Or;
+            }
+            // Long variant of each operation follows its int variant
+            const bool wide = (opcode & 1) != 0;
+            const u4 size = wide ? 2 : 1;
+            binary(op, wide ? SlotTag::Long : SlotTag::Int, S(d - 2 * size),
+                   S(d - size));
+            break;
+        }
+        case op_ineg:
+            unary(IrOp::Neg, SlotTag::Int, S(d - 1), S(d - 1));
+            break;
+        case op_lneg:
+            unary(IrOp::Neg, SlotTag::Long, S(d - 2), S(d - 2));
+            break;
+        case op_ishl:
+        case op_ishr:
+        case op_iushr:
+        case op_lshl:
+        case op_lshr:
+        case op_lushr: {
+            const bool wide = (opcode - op_ishl) % 2 != 0;
+            binary(shiftOps[(opcode - op_ishl) / 2],
+                   wide ? SlotTag::Long : SlotTag::Int,
+                   S(d - 1 - (wide ? 2 : 1)), S(d - 1));
+            break;
+        }
+        case op_lcmp:
+            binary(IrOp::Compare, SlotTag::Long, S(d - 4), S(d - 2));
+            break;
+        case op_fadd:
+        case op_fsub:
+        case op_fmul:
+        case op_fdiv:
+            binary(floatOps[(opcode - op_fadd) / 4], SlotTag::Float, S(d - 2),
+                   S(d - 1));
+            break;
+        case op_dadd:
+        case op_dsub:
+        case op_dmul:
+        case op_ddiv:
+            binary(floatOps[(opcode - op_dadd) / 4], SlotTag::Double,
+                   S(d - 4), S(d - 2));
+            break;
+        case op_fneg:
+            unary(IrOp::Neg, SlotTag::Float, S(d - 1), S(d - 1));
+            break;
+        case op_dneg:
+            unary(IrOp::Neg, SlotTag::Double, S(d - 2), S(d - 2));
+            break;
+
+        // Conversions that can not throw nor saturate
+        case op_i2l:
+        case op_l2i:
+        case op_i2b:
+        case op_i2c:
+        case op_i2s:
+        case op_i2f:
+        case op_l2f:
+        case op_i2d:
+        case op_l2d:
+        case op_f2d:
+        case op_d2f: {
+            const bool wide =
+                opcode == op_l2i || opcode == op_l2f || opcode == op_l2d ||
+                opcode == op_d2f;
+            SlotTag type = SlotTag::Int;
+            if (opcode == op_i2l) {
+                type = SlotTag::Long;
+            } else if (opcode == op_i2f || opcode == op_l2f ||
+                       opcode == op_d2f) {
+                type = SlotTag::Float;
+            } else if (opcode == op_i2d || opcode == op_l2d ||
+                       opcode == op_f2d) {
+                type = SlotTag::Double;
+            }
+            const int32_t slot = S(d - (wide ? 2 : 1));
+            unary(IrOp::Convert, type, slot, slot);
+            code.back().extra = opcode;
+            break;
+        }
+
+        case op_ifeq:
+        case op_ifne:
+        case op_iflt:
+        case op_ifge:
+        case op_ifgt:
+        case op_ifle:
+            branch(static_cast<IrCond>(opcode - op_ifeq), SlotTag::Int,
+                   IrOperand::regOf(S(d - 1)), IrOperand::immOf(0));
+            break;
+        case op_if_icmpeq:
+        case op_if_icmpne:
+        case op_if_icmplt:
+        case op_if_icmpge:
+        case op_if_icmpgt:
+        case op_if_icmple:
+            branch(static_cast<IrCond>(opcode - op_if_icmpeq), SlotTag::Int,
+                   IrOperand::regOf(S(d - 2)), IrOperand::regOf(S(d - 1)));
+            break;
+        case op_ifnull:
+        case op_ifnonnull:
+            branch(opcode == op_ifnull ? IrCond::Eq : IrCond::Ne, SlotTag::Ref,
+                   IrOperand::regOf(S(d - 1)), IrOperand::immOf(0));
+            break;
+        case op_if_acmpeq:
+        case op_if_acmpne:
+            branch(opcode == op_if_acmpeq ? IrCond::Eq : IrCond::Ne,
+                   SlotTag::Ref, IrOperand::regOf(S(d - 2)),
+                   IrOperand::regOf(S(d - 1)));
+            break;
+        case op_goto:
+            emit(IrOp::Goto, SlotTag::Top, -1).target = insn.operand;
+            break;
+        case op_tableswitch:
+        case op_lookupswitch: {
+            IrInsn& x = emit(IrOp::Switch, SlotTag::Int, -1);
+            x.extra = opcode;
+            x.a = IrOperand::regOf(S(d - 1));
+            x.target = insn.operand;
+            break;
+        }
+
+        case op_ireturn:
+        case op_freturn:
+        case op_areturn:
+            emit(IrOp::Return, state.stack[d - 1], -1).a =
+                IrOperand::regOf(S(d - 1));
+            break;
+        case op_lreturn:
+        case op_dreturn:
+            emit(IrOp::Return, state.stack[d - 2], -1).a =
+                IrOperand::regOf(S(d - 2));
+            break;
+        case op_return:
+            emit(IrOp::Return, SlotTag::Top, -1);
+            break;
+
+        // Instructions calling back into runtime
+        case op_idiv:
+        case op_ldiv:
+        case op_irem:
+        case op_lrem:
+        case op_frem:
+        case op_drem:
+        case op_f2i:
+        case op_f2l:
+        case op_d2i:
+        case op_d2l:
+        case op_fcmpl:
+        case op_fcmpg:
+        case op_dcmpl:
+        case op_dcmpg:
+        case op_iaload:
+        case op_laload:
+        case op_faload:
+        case op_daload:
+        case op_aaload:
+        case op_baload:
+        case op_caload:
+        case op_saload:
+        case op_iastore:
+        case op_lastore:
+        case op_fastore:
+        case op_dastore:
+        case op_aastore:
+        case op_bastore:
+        case op_castore:
+        case op_sastore:
+        case op_getstatic:
+        case op_putstatic:
+        case op_getfield:
+        case op_putfield:
+        case op_new:
+        case op_newarray:
+        case op_anewarray:
+        case op_arraylength:
+        case op_athrow:
+        case op_instanceof:
+            emit(IrOp::Call, SlotTag::Top, -1);
+            break;
+        case op_invokevirtual:
+        case op_invokespecial:
+        case op_invokestatic:
+        case op_invokeinterface:
+            if (!inlineCall(t, i, ir, code)) {
+                emit(IrOp::Call, SlotTag::Top, -1);
+            }
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+static bool endsBlock(u1 opcode) {
+    return (opcode >= op_ifeq && opcode <= op_lookupswitch) ||
+           (opcode >= op_ireturn && opcode <= op_return) ||
+           opcode == op_athrow || opcode == op_ifnull ||
+           opcode == op_ifnonnull;
+}
+
+//--------------------------------------------------------------------------------
+// Bind invokevirtual ref statically. A final method is reached whatever the
+// receiver is, and so is a method no loaded subclass of the referenced class
+// overrides, bound is set to the class then since the binding only holds
+// until a class overriding it is loaded, see MethodArea::isEffectivelyFinal()
+//--------------------------------------------------------------------------------
+static CallSite bindVirtual(const SymbolicRef* ref, const JavaClass*& bound) {
+    const int index = ref->jc->findVirtualMethod(ref->name, ref->descriptor);
+    if (!ref->jc->isLinked() || index < 0 ||
+        static_cast<size_t>(index) >= ref->jc->getVirtualMethodCount()) {
+        return CallSite{};
+    }
+    const VirtualMethod& vm = ref->jc->getVirtualMethod(index);
+    if (IS_METHOD_FINAL(vm.method->accessFlags) ||
+        IS_CLASS_FINAL(ref->jc->getAccessFlag())) {
+        return CallSite::makeCallSite(vm.jc, vm.method);
+    }
+    if (!IS_METHOD_ABSTRACT(vm.method->accessFlags) &&
+        yrt.ma->isEffectivelyFinal(ref->jc, vm.method)) {
+        bound = ref->jc;
+        return CallSite::makeCallSite(vm.jc, vm.method);
+    }
+    return CallSite{};
+}
+
+//--------------------------------------------------------------------------------
+// Select the method invocation i of t always reaches. A virtual call reaches
+// the method class hierarchy binds it to, otherwise a virtual or interface
+// call reaches the method selected for the only receiver class its inline
+// cache has seen, as long as receivers keep being of receiverClass. Only
+// invocations that were already resolved are considered, and a static method
+// only once its class was initialized, so compiling never loads or
+// initializes classes
+//--------------------------------------------------------------------------------
+static CallSite selectCallee(const Translation& t, u4 i,
+                             const JavaClass*& receiverClass,
+                             const JavaClass*& bound) {
+    const Instruction& insn = t.decoded->code[i];
+    const u1 opcode = originalOpcode(loadOpcode(&insn));
+    const SymbolicRef* ref = t.jc->getResolvedRef(insn.index);
+    receiverClass = nullptr;
+    bound = nullptr;
+    if (opcode == op_invokevirtual && ref != nullptr && ref->name != nullptr) {
+        const CallSite csite = bindVirtual(ref, bound);
+        if (csite.isCallable()) {
+            return csite;
+        }
+    }
+    if (opcode == op_invokevirtual || opcode == op_invokeinterface) {
+        const InlineCache& cache = t.decoded->inlineCaches[insn.operand];
+        const JavaClass* seen =
+            cache.entries[0].receiverClass.load(memory_order_acquire);
+        if (seen != nullptr &&
+            (YVM_INLINE_CACHE_SIZE == 1 ||
+             cache.entries[1].receiverClass.load(memory_order_acquire) ==
+                 nullptr)) {
+            receiverClass = seen;
+            return CallSite::makeCallSite(cache.entries[0].jc,
+                                          cache.entries[0].method);
+        }
+    }
+
+    if (ref == nullptr || ref->name == nullptr) {
+        return CallSite{};
+    }
+    switch (opcode) {
+        case op_invokespecial: {
+            // Superclass method as Interpreter::resolveInvocation() selects
+            // it, methods of interfaces are left to runtime
+            const JavaClass* target = ref->jc;
+            if (ref->name != yrt.symbols->initName &&
+                !IS_CLASS_INTERFACE(target->getAccessFlag()) &&
+                target->getClassSymbol() == t.jc->getSuperClassSymbol() &&
+                IS_CLASS_SUPER(t.jc->getAccessFlag())) {
+                target = yrt.ma->findJavaClass(t.jc->getSuperClassSymbol());
+            }
+            CallSite csite =
+                findInstanceMethod(target, ref->name, ref->descriptor);
+            if (!csite.isCallable()) {
+                csite = findInstanceMethodOnSupers(target, ref->name,
+                                                   ref->descriptor);
+            }
+            return csite;
+        }
+        case op_invokestatic:
+            if (ref->jc->isInitialized()) {
+                MethodInfo* m = ref->jc->findMethod(ref->name, ref->descriptor);
+                if (m != nullptr && IS_METHOD_STATIC(m->accessFlags)) {
+                    return CallSite::makeCallSite(ref->jc, m);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    return CallSite{};
+}
+
+// A method runs straight through if it's one basic block ending in a return
+static bool isStraightLine(const DecodedCode* decoded,
+                           const vector<TypeState>& states) {
+    const size_t n = decoded->code.size();
+    for (size_t k = 0; k < n; k++) {
+        const u1 opcode = originalOpcode(loadOpcode(&decoded->code[k]));
+        if (!states[k].reached || (k + 1 < n && endsBlock(opcode))) {
+            return false;
+        }
+    }
+    const u1 last = originalOpcode(loadOpcode(&decoded->code[n - 1]));
+    return last >= op_ireturn && last <= op_return;
+}
+
+//--------------------------------------------------------------------------------
+// Inline the method invocation i of t reaches. Its body is translated in place
+// of the invocation between Inline and Merge, and its return becomes a copy
+// of return value where the invocation would leave it. Calls of an inlined
+// body are inlined the same way up to YVM_OPT_MAX_INLINE_DEPTH levels, unless
+// a method would be inlined into itself
+//--------------------------------------------------------------------------------
+static bool inlineCall(const Translation& t, u4 i, IrMethod& ir,
+                       vector<IrInsn>& code) {
+    if (t.level >= YVM_OPT_MAX_INLINE_DEPTH) {
+        return false;
+    }
+    const JavaClass* receiverClass;
+    const JavaClass* bound;
+    const CallSite csite = selectCallee(t, i, receiverClass, bound);
+    if (!csite.isCallable() || csite.decoded == nullptr) {
+        return false;
+    }
+    const MethodInfo* m = csite.method;
+    if (IS_METHOD_SYNCHRONIZED(m->accessFlags) ||
+        m->exec.code->codeLength > YVM_OPT_INLINE_SIZE ||
+        !csite.decoded->exceptionTable.empty()) {
+        return false;
+    }
+    for (const Translation* outer = &t; outer != nullptr;
+         outer = outer->caller) {
+        if (outer->method == m) {
+            return false;
+        }
+    }
+
+    IrInlined callee;
+    if (!inferTypes(csite.jc, m, csite.decoded, callee.states) ||
+        !isStraightLine(csite.decoded, callee.states)) {
+        return false;
+    }
+    const u1 opcode = originalOpcode(loadOpcode(&t.decoded->code[i]));
+    const TypeState& state = (*t.states)[i];
+    const auto d = static_cast<u4>(state.stack.size());
+    callee.jc = csite.jc;
+    callee.method = m;
+    callee.decoded = csite.decoded;
+    callee.caller = t.site;
+    callee.invokeIndex = i;
+    callee.argSlots =
+        m->shape.parameterSlots + (opcode == op_invokestatic ? 0 : 1);
+    callee.base = t.base + t.maxLocal + d - callee.argSlots;
+    callee.maxLocal = m->exec.maxLocal;
+    callee.bound = bound;
+    const u4 top = callee.base + callee.maxLocal + m->exec.maxStack;
+    const size_t mark = ir.inlined.size();
+    ir.inlined.push_back(move(callee));
+
+    // Methods inlined into the body are appended after it, which leaves it
+    // where it is
+    const IrInlined& added = ir.inlined.back();
+    const auto site = static_cast<u4>(ir.inlined.size());
+    const Translation body{added.jc,   m,    added.decoded, &added.states,
+                           &t,         site, added.base,    added.maxLocal,
+                           t.level + 1};
+    const u4 depth = t.base + t.maxLocal + d - ir.maxLocal;
+    IrInsn enter = makeInsn(IrOp::Inline, SlotTag::Top, -1, i, depth, t.site);
+    // Any receiver is checked against null, whose invocation throws
+    if (opcode != op_invokestatic) {
+        enter.extra = GuardReceiver | (bound != nullptr ? GuardHierarchy : 0);
+        enter.a = IrOperand::regOf(added.base);
+        enter.b = IrOperand::immOf(reinterpret_cast<uint64_t>(receiverClass));
+    }
+    enter.target = static_cast<int32_t>(site);
+    vector<IrInsn> spliced{enter};
+    FOR_EACH(k, added.decoded->code.size()) {
+        if (!translate(body, static_cast<u4>(k), ir, spliced)) {
+            // Along with methods inlined into it so far
+            ir.inlined.resize(mark);
+            return false;
+        }
+    }
+    IrInsn& last = spliced.back();
+    if (last.op == IrOp::Return) {
+        if (last.a.isImm()) {
+            spliced.pop_back();
+        } else {
+            last.op = IrOp::Move;
+            last.dst = static_cast<int32_t>(added.base);
+        }
+    }
+    IrInsn merge = enter;
+    merge.op = IrOp::Merge;
+    merge.a = IrOperand::immOf(0);
+    spliced.push_back(merge);
+    code.insert(code.end(), spliced.begin(), spliced.end());
+
+    const u4 limit = ir.maxLocal + ir.maxStack;
+    if (top > limit) {
+        ir.extraStack = max(ir.extraStack, top - limit);
+    }
+    return true;
+}
+
+bool buildIR(const JavaClass* jc, const MethodInfo* m,
+             const DecodedCode* decoded, const vector<TypeState>& states,
+             IrMethod& ir) {
+    if (!decoded->exceptionTable.empty()) {
+        return false;
+    }
+    const auto n = static_cast<u4>(decoded->code.size());
+    ir.maxLocal = m->exec.maxLocal;
+    ir.maxStack = m->exec.maxStack;
+    ir.extraStack = 0;
+    const Translation root{jc, m, decoded,     &states, nullptr,
+                           0,  0, ir.maxLocal, 0};
+
+    // Blocks begin at branch targets and after instructions that leave
+    // the straight line
+    vector<bool> leaders(n + 1, false);
+    leaders[0] = true;
+    for (u4 i = 0; i < n; i++) {
+        const Instruction& insn = decoded->code[i];
+        const u1 opcode = originalOpcode(loadOpcode(&insn));
+        if (!states[i].reached || !endsBlock(opcode)) {
+            continue;
+        }
+        leaders[i + 1] = true;
+        if (opcode == op_tableswitch || opcode == op_lookupswitch) {
+            const int32_t* table = decoded->switchTables.data() + insn.operand;
+            leaders[table[0]] = true;
+            if (opcode == op_tableswitch) {
+                for (int32_t k = 0; k <= table[2] - table[1]; k++) {
+                    leaders[table[3 + k]] = true;
+                }
+            } else {
+                for (int32_t k = 0; k < table[1]; k++) {
+                    leaders[table[3 + 2 * k]] = true;
+                }
+            }
+        } else if ((opcode >= op_ifeq && opcode <= op_goto) ||
+                   opcode == op_ifnull || opcode == op_ifnonnull) {
+            leaders[insn.operand] = true;
+        }
+    }
+
+    u4 start = 0;
+    for (u4 i = 1; i <= n; i++) {
+        if (!leaders[i] && i < n) {
+            continue;
+        }
+        IrBlock block;
+        block.start = start;
+        block.end = i;
+        block.reached = states[start].reached;
+        block.exitDepth = 0;
+        if (block.reached) {
+            for (u4 k = start; k < i; k++) {
+                if (!translate(root, k, ir, block.code)) {
+                    return false;
+                }
+            }
+            // Control leaves the block with the operand stack its
+            // successors begin with, returns and athrow leave nothing live
+            const Instruction& last = decoded->code[i - 1];
+            const u1 opcode = originalOpcode(loadOpcode(&last));
+            if (opcode == op_goto) {
+                block.exitDepth =
+                    static_cast<u4>(states[last.operand].stack.size());
+            } else if (opcode == op_tableswitch ||
+                       opcode == op_lookupswitch) {
+                const int32_t target = decoded->switchTables[last.operand];
+                block.exitDepth = static_cast<u4>(states[target].stack.size());
+            } else if (i < n && opcode != op_athrow &&
+                       !(opcode >= op_ireturn && opcode <= op_return)) {
+                block.exitDepth = static_cast<u4>(states[i].stack.size());
+            }
+        }
+        ir.blocks.push_back(move(block));
+        start = i;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------
+// Fold an operation on constant operands, returns false if it must be left
+// to runtime
+//--------------------------------------------------------------------------------
+static bool foldBinary(IrOp op, SlotTag type, uint64_t a, uint64_t b,
+                       uint64_t& result) {
+    if (type == SlotTag::Int) {
+        const auto x = static_cast<uint32_t>(a);
+        const auto y = static_cast<uint32_t>(b);
+        uint32_t value;
+        switch (op) {
+            case IrOp::Add:
+                value = x + y;
+                break;
+            case IrOp::Sub:
+                value = x - y;
+                break;
+            case IrOp::Mul:
+                value = x * y;
+                break;
+            case IrOp::And:
+                value = x & y;
+                break;
+            case IrOp::Or:
+                value = x | y;
+                break;
+            case IrOp::Xor:
+                value = x ^ y;
+                break;
+            case IrOp::Shl:
+                value = x << (y & 31);
+                break;
+            case IrOp::Shr:
+                value = static_cast<uint32_t>(static_cast<int32_t>(x) >>
+                                              (y & 31));
+                break;
+            case IrOp::UShr:
+                value = x >> (y & 31);
+                break;
+            default:
+                return false;
+        }
+        result = value;
+        return true;
+    }
+    if (type == SlotTag::Long) {
+        const auto y = static_cast<uint32_t>(b);
+        switch (op) {
+            case IrOp::Add:
+                result = a + b;
+                break;
+            case IrOp::Sub:
+                result = a - b;
+                break;
+            case IrOp::Mul:
+                result = a * b;
+                break;
+            case IrOp::And:
+                result = a & b;
+                break;
+            case IrOp::Or:
+                result = a | b;
+                break;
+            case IrOp::Xor:
+                result = a ^ b;
+                break;
+            case IrOp::Shl:
+                result = a << (y & 63);
+                break;
+            case IrOp::Shr:
+                result = static_cast<uint64_t>(static_cast<int64_t>(a) >>
+                                               (y & 63));
+                break;
+            case IrOp::UShr:
+                result = a >> (y & 63);
+                break;
+            case IrOp::Compare: {
+                const auto x = static_cast<int64_t>(a);
+                const auto z = static_cast<int64_t>(b);
+                result = static_cast<uint32_t>(x > z ? 1 : (x < z ? -1 : 0));
+                break;
+            }
+            default:
+                return false;
+        }
+        return true;
+    }
+    if (type == SlotTag::Float) {
+        const float x = toFloat(a);
+        const float y = toFloat(b);
+        switch (op) {
+            case IrOp::Add:
+                result = floatBits(x + y);
+                return true;
+            case IrOp::Sub:
+                result = floatBits(x - y);
+                return true;
+            case IrOp::Mul:
+                result = floatBits(x * y);
+                return true;
+            case IrOp::Div:
+                result = floatBits(x / y);
+                return true;
+            default:
+                return false;
+        }
+    }
+    if (type == SlotTag::Double) {
+        const double x = toDouble(a);
+        const double y = toDouble(b);
+        switch (op) {
+            case IrOp::Add:
+                result = doubleBits(x + y);
+                return true;
+            case IrOp::Sub:
+                result = doubleBits(x - y);
+                return true;
+            case IrOp::Mul:
+                result = doubleBits(x * y);
+                return true;
+            case IrOp::Div:
+                result = doubleBits(x / y);
+                return true;
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+static uint64_t foldNeg(SlotTag type, uint64_t a) {
+    switch (type) {
+        case SlotTag::Int:
+            return static_cast<uint32_t>(0u - static_cast<uint32_t>(a));
+        case SlotTag::Float:
+            return a ^ 0x80000000u;
+        case SlotTag::Double:
+            return a ^ (uint64_t(1) << 63);
+        default:
+            return 0 - a;
+    }
+}
+
+static uint64_t foldConvert(u1 opcode, uint64_t a) {
+    const auto i = static_cast<int32_t>(a);
+    const auto l = static_cast<int64_t>(a);
+    switch (opcode) {
+        case op_i2l:
+            return static_cast<uint64_t>(static_cast<int64_t>(i));
+        case op_l2i:
+            return static_cast<uint32_t>(a);
+        case op_i2b:
+            return static_cast<uint32_t>(static_cast<int32_t>(
+                static_cast<int8_t>(i)));
+        case op_i2c:
+            return static_cast<uint16_t>(a);
+        case op_i2s:
+            return static_cast<uint32_t>(static_cast<int32_t>(
+                static_cast<int16_t>(i)));
+        case op_i2f:
+            return floatBits(static_cast<float>(i));
+        case op_l2f:
+            return floatBits(static_cast<float>(l));
+        case op_i2d:
+            return doubleBits(static_cast<double>(i));
+        case op_l2d:
+            return doubleBits(static_cast<double>(l));
+        case op_f2d:
+            return doubleBits(static_cast<double>(toFloat(a)));
+        default:
+            return floatBits(static_cast<float>(toDouble(a)));
+    }
+}
+
+static bool compareInts(IrCond cond, int32_t a, int32_t b) {
+    switch (cond) {
+        case IrCond::Eq:
+            return a == b;
+        case IrCond::Ne:
+            return a != b;
+        case IrCond::Lt:
+            return a < b;
+        case IrCond::Ge:
+            return a >= b;
+        case IrCond::Gt:
+            return a > b;
+        default:
+            return a <= b;
+    }
+}
+
+// Condition holding after operands of a comparison were swapped
+static IrCond mirror(IrCond cond) {
+    switch (cond) {
+        case IrCond::Lt:
+            return IrCond::Gt;
+        case IrCond::Ge:
+            return IrCond::Le;
+        case IrCond::Gt:
+            return IrCond::Lt;
+        case IrCond::Le:
+            return IrCond::Ge;
+        default:
+            return cond;
+    }
+}
+
+static int32_t switchTarget(const int32_t* table, u1 opcode, int32_t key) {
+    if (opcode == op_tableswitch) {
+        if (key < table[1] || key > table[2]) {
+            return table[0];
+        }
+        return table[3 + key - table[1]];
+    }
+    for (int32_t k = 0; k < table[1]; k++) {
+        if (table[2 + 2 * k] == key) {
+            return table[3 + 2 * k];
+        }
+    }
+    return table[0];
+}
+
+//--------------------------------------------------------------------------------
+// Local value numbering of a basic block. Each register is mapped to the
+// number of the value it holds, registers mapped to the same number hold the
+// same bits, so an instruction reads its operands from whichever register
+// holds them and a copy into a register already holding the value is
+// dropped. Stack shuffles become copies of the values they move
+//--------------------------------------------------------------------------------
+class ValueNumbering {
+public:
+    ValueNumbering(const IrMethod& ir, const DecodedCode* decoded,
+                   const vector<TypeState>& states)
+        : ir(ir), decoded(decoded), states(states) {}
+
+    void run(IrBlock& block);
+
+private:
+    // The second half of a long or double, no instruction reads it
+    static const u4 HIGH_HALF = 0;
+
+    struct Value {
+        bool constant;
+        uint64_t bits;
+    };
+
+    u4 fresh();
+    u4 constant(SlotTag type, uint64_t bits);
+    u4 valueOf(const IrOperand& operand, SlotTag type);
+    bool isConstant(u4 value) const { return values[value].constant; }
+    int32_t holder(const vector<u4>& regs, u4 value) const;
+    IrOperand operandOf(u4 value, SlotTag type) const;
+    void define(int32_t reg, SlotTag type, u4 value);
+    void assign(IrInsn& insn, SlotTag type, u4 value);
+    void forgetStack();
+
+    void number(IrInsn& insn);
+    void numberCall(IrInsn& insn);
+    void numberShuffle(const IrInsn& insn, vector<IrInsn>& code);
+
+    const IrMethod& ir;
+    const DecodedCode* decoded;
+    const vector<TypeState>& states;
+
+    vector<u4> regs;
+    vector<Value> values;
+    map<pair<SlotTag, uint64_t>, u4> constants;
+    // Pure operations by opcode, type, extra and operand values
+    map<tuple<IrOp, SlotTag, u1, u4, u4>, u4> expressions;
+    // Values of fields, static variables, array elements and array lengths
+    // by the method whose constant pool is indexed, opcode, constant pool
+    // index and operand values
+    map<tuple<const DecodedCode*, u1, u2, u4, u4>, u4> loads;
+    // Values known to be non-null references, and inlined methods whose
+    // receivers are known to be non-null
+    set<u4> nonNull;
+    set<int32_t> unguarded;
+};
+
+u4 ValueNumbering::fresh() {
+    values.push_back(Value{false, 0});
+    return static_cast<u4>(values.size() - 1);
+}
+
+u4 ValueNumbering::constant(SlotTag type, uint64_t bits) {
+    auto iter = constants.find(make_pair(type, bits));
+    if (iter != constants.end()) {
+        return iter->second;
+    }
+    values.push_back(Value{true, bits});
+    const auto value = static_cast<u4>(values.size() - 1);
+    constants.emplace(make_pair(type, bits), value);
+    return value;
+}
+
+u4 ValueNumbering::valueOf(const IrOperand& operand, SlotTag type) {
+    return operand.isImm() ? constant(type, operand.imm) : regs[operand.reg];
+}
+
+int32_t ValueNumbering::holder(const vector<u4>& regs, u4 value) const {
+    // Local variables come first, so copies on operand stack die
+    FOR_EACH(r, regs.size()) {
+        if (regs[r] == value) {
+            return static_cast<int32_t>(r);
+        }
+    }
+    return -1;
+}
+
+IrOperand ValueNumbering::operandOf(u4 value, SlotTag type) const {
+    // Floating-point operands are read from memory by backend
+    if (isConstant(value) && (type == SlotTag::Int || type == SlotTag::Long ||
+                              type == SlotTag::Ref)) {
+        return IrOperand::immOf(values[value].bits);
+    }
+    return IrOperand::regOf(holder(regs, value));
+}
+
+void ValueNumbering::define(int32_t reg, SlotTag type, u4 value) {
+    regs[reg] = value;
+    if (isWide(type)) {
+        regs[reg + 1] = HIGH_HALF;
+    }
+}
+
+// Turn insn into a copy of value into its dst, or drop it if dst holds it
+void ValueNumbering::assign(IrInsn& insn, SlotTag type, u4 value) {
+    const int32_t dst = insn.dst;
+    if (regs[dst] == value &&
+        (!isWide(type) || regs[dst + 1] == HIGH_HALF)) {
+        insn.op = IrOp::Nop;
+        return;
+    }
+    if (isConstant(value)) {
+        insn.op = IrOp::Const;
+        insn.a = IrOperand::immOf(values[value].bits);
+    } else {
+        insn.op = IrOp::Move;
+        insn.a = IrOperand::regOf(holder(regs, value));
+    }
+    insn.b = IrOperand::immOf(0);
+    insn.type = type;
+    define(dst, type, value);
+}
+
+void ValueNumbering::forgetStack() {
+    for (size_t r = ir.maxLocal; r < regs.size(); r++) {
+        regs[r] = fresh();
+    }
+}
+
+void ValueNumbering::run(IrBlock& block) {
+    values.clear();
+    constants.clear();
+    expressions.clear();
+    loads.clear();
+    nonNull.clear();
+    unguarded.clear();
+    values.push_back(Value{false, 0});
+
+    // Nothing is known about registers at the beginning of a block except
+    // the halves of long and double values
+    const TypeState& entry = states[block.start];
+    auto tagOf = [&](size_t r) {
+        if (r < ir.maxLocal) {
+            return entry.locals[r];
+        }
+        r -= ir.maxLocal;
+        return r < entry.stack.size() ? entry.stack[r] : SlotTag::Top;
+    };
+    regs.resize(ir.registerCount());
+    FOR_EACH(r, regs.size()) {
+        const bool high =
+            r > 0 && tagOf(r) == SlotTag::Top && isWide(tagOf(r - 1));
+        regs[r] = high ? HIGH_HALF : fresh();
+    }
+
+    vector<IrInsn> code;
+    code.reserve(block.code.size());
+    for (IrInsn& insn : block.code) {
+        if (insn.op == IrOp::Shuffle) {
+            numberShuffle(insn, code);
+            continue;
+        }
+        number(insn);
+        if (insn.op != IrOp::Nop) {
+            code.push_back(insn);
+        }
+    }
+    block.code.swap(code);
+}
+
+void ValueNumbering::number(IrInsn& insn) {
+    switch (insn.op) {
+        case IrOp::Const:
+            assign(insn, insn.type, constant(insn.type, insn.a.imm));
+            break;
+        case IrOp::Move:
+            assign(insn, insn.type, regs[insn.a.reg]);
+            break;
+        case IrOp::Add:
+        case IrOp::Sub:
+        case IrOp::Mul:
+        case IrOp::Div:
+        case IrOp::And:
+        case IrOp::Or:
+        case IrOp::Xor:
+        case IrOp::Shl:
+        case IrOp::Shr:
+        case IrOp::UShr:
+        case IrOp::Compare: {
+            const SlotTag type = insn.type;
+            const SlotTag result = resultType(insn);
+            const bool shift = insn.op >= IrOp::Shl && insn.op <= IrOp::UShr;
+            const SlotTag typeB = shift ? SlotTag::Int : type;
+            u4 va = valueOf(insn.a, type);
+            u4 vb = valueOf(insn.b, typeB);
+            uint64_t bits;
+            if (isConstant(va) && isConstant(vb) &&
+                foldBinary(insn.op, type, values[va].bits, values[vb].bits,
+                           bits)) {
+                assign(insn, result, constant(result, bits));
+                break;
+            }
+
+            // Algebraic identities of integers, floating-point ones do not
+            // hold for NaN and signed zero
+            if (type == SlotTag::Int || type == SlotTag::Long) {
+                const uint64_t ones =
+                    type == SlotTag::Int ? 0xffffffffu : ~0ull;
+                const uint64_t mask = shift ? (type == SlotTag::Int ? 31 : 63)
+                                            : ones;
+                const bool zeroB =
+                    isConstant(vb) && (values[vb].bits & mask) == 0;
+                const bool zeroA = isConstant(va) && values[va].bits == 0;
+                const bool oneA = isConstant(va) && values[va].bits == 1;
+                const bool oneB = isConstant(vb) && values[vb].bits == 1;
+                switch (insn.op) {
+                    case IrOp::Add:
+                    case IrOp::Or:
+                    case IrOp::Xor:
+                        if (zeroA || zeroB) {
+                            assign(insn, type, zeroA ? vb : va);
+                            return;
+                        }
+                        if (insn.op == IrOp::Xor && va == vb) {
+                            assign(insn, type, constant(type, 0));
+                            return;
+                        }
+                        break;
+                    case IrOp::Sub:
+                        if (zeroB) {
+                            assign(insn, type, va);
+                            return;
+                        }
+                        if (va == vb) {
+                            assign(insn, type, constant(type, 0));
+                            return;
+                        }
+                        break;
+                    case IrOp::Shl:
+                    case IrOp::Shr:
+                    case IrOp::UShr:
+                        if (zeroB) {
+                            assign(insn, type, va);
+                            return;
+                        }
+                        break;
+                    case IrOp::Mul:
+                        if (oneA || oneB) {
+                            assign(insn, type, oneA ? vb : va);
+                            return;
+                        }
+                        if (zeroA || zeroB) {
+                            assign(insn, type, constant(type, 0));
+                            return;
+                        }
+                        break;
+                    case IrOp::And:
+                        if ((isConstant(va) && values[va].bits == ones) ||
+                            (isConstant(vb) && values[vb].bits == ones)) {
+                            assign(insn, type,
+                                   isConstant(va) && values[va].bits == ones
+                                       ? vb
+                                       : va);
+                            return;
+                        }
+                        if (zeroA || zeroB || va == vb) {
+                            assign(insn, type,
+                                   va == vb ? va : constant(type, 0));
+                            return;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            const bool commutative =
+                insn.op == IrOp::Add || insn.op == IrOp::Mul ||
+                insn.op == IrOp::And || insn.op == IrOp::Or ||
+                insn.op == IrOp::Xor;
+            if (commutative && va > vb) {
+                swap(va, vb);
+            }
+            const auto key = make_tuple(insn.op, type, u1(0), va, vb);
+            auto iter = expressions.find(key);
+            if (iter != expressions.end() &&
+                holder(regs, iter->second) >= 0) {
+                assign(insn, result, iter->second);
+                break;
+            }
+            const u4 value = fresh();
+            expressions[key] = value;
+            insn.a = operandOf(va, type);
+            insn.b = operandOf(vb, typeB);
+            define(insn.dst, result, value);
+            break;
+        }
+        case IrOp::Neg:
+        case IrOp::Convert: {
+            const u4 va = regs[insn.a.reg];
+            if (isConstant(va)) {
+                const uint64_t bits =
+                    insn.op == IrOp::Neg ? foldNeg(insn.type, values[va].bits)
+                                         : foldConvert(insn.extra,
+                                                       values[va].bits);
+                assign(insn, insn.type, constant(insn.type, bits));
+                break;
+            }
+            const auto key = make_tuple(insn.op, insn.type, insn.extra, va,
+                                        u4(0));
+            auto iter = expressions.find(key);
+            if (iter != expressions.end() &&
+                holder(regs, iter->second) >= 0) {
+                assign(insn, insn.type, iter->second);
+                break;
+            }
+            const u4 value = fresh();
+            expressions[key] = value;
+            insn.a = IrOperand::regOf(holder(regs, va));
+            define(insn.dst, insn.type, value);
+            break;
+        }
+        case IrOp::Branch: {
+            u4 va = valueOf(insn.a, insn.type);
+            u4 vb = valueOf(insn.b, insn.type);
+            auto cond = static_cast<IrCond>(insn.extra);
+            if (va == vb || (isConstant(va) && isConstant(vb))) {
+                // Distinct values compare unequal only as references, whose
+                // only constant is null
+                bool taken;
+                if (insn.type == SlotTag::Ref) {
+                    taken = (cond == IrCond::Eq) == (va == vb);
+                } else if (va == vb) {
+                    taken = cond == IrCond::Eq || cond == IrCond::Ge ||
+                            cond == IrCond::Le;
+                } else {
+                    taken = compareInts(cond,
+                                        static_cast<int32_t>(values[va].bits),
+                                        static_cast<int32_t>(values[vb].bits));
+                }
+                insn.op = taken ? IrOp::Goto : IrOp::Nop;
+                break;
+            }
+            // An immediate is always the second operand
+            if (isConstant(va)) {
+                swap(va, vb);
+                cond = mirror(cond);
+            }
+            insn.extra = static_cast<u1>(cond);
+            insn.a = IrOperand::regOf(holder(regs, va));
+            insn.b = operandOf(vb, insn.type);
+            break;
+        }
+        case IrOp::Switch: {
+            const u4 va = regs[insn.a.reg];
+            if (isConstant(va)) {
+                insn.op = IrOp::Goto;
+                insn.target = switchTarget(
+                    decoded->switchTables.data() + insn.target, insn.extra,
+                    static_cast<int32_t>(values[va].bits));
+                break;
+            }
+            insn.a = IrOperand::regOf(holder(regs, va));
+            break;
+        }
+        case IrOp::Return:
+            if (!insn.a.isImm()) {
+                insn.a = IrOperand::regOf(holder(regs, regs[insn.a.reg]));
+            }
+            break;
+        case IrOp::Call:
+            numberCall(insn);
+            break;
+        case IrOp::Inline:
+            // Only a receiver that may be null is checked without class
+            if ((insn.extra & GuardReceiver) != 0 && insn.b.imm == 0 &&
+                nonNull.count(regs[insn.a.reg]) != 0) {
+                insn.extra &= ~GuardReceiver;
+            } else if ((insn.extra & GuardReceiver) != 0) {
+                nonNull.insert(regs[insn.a.reg]);
+            }
+            if (insn.extra == 0) {
+                unguarded.insert(insn.target);
+            }
+            break;
+        case IrOp::Merge:
+            if (unguarded.count(insn.target) != 0) {
+                insn.extra = 0;
+            }
+            // Registers hold what either the body or the invocation left
+            if (insn.extra != 0) {
+                loads.clear();
+                forgetStack();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+//--------------------------------------------------------------------------------
+// A load from heap or static variable is replaced by a copy of the value the
+// same load produced earlier in the block, as long as no other call ran in
+// between. Calls are the only instructions writing heap, static variables
+// or other threads' visible state, and they also end the validity of
+// operand stack slots above their operands
+//--------------------------------------------------------------------------------
+void ValueNumbering::numberCall(IrInsn& insn) {
+    // Instruction of an inlined method is typed by its own states, and its
+    // operand stack starts at stackBase of operand stack of compiled method
+    const DecodedCode* owner = decoded;
+    const vector<TypeState>* types = &states;
+    u4 stackBase = 0;
+    if (insn.site != 0) {
+        const IrInlined& inlined = ir.inlined[insn.site - 1];
+        owner = inlined.decoded;
+        types = &inlined.states;
+        stackBase = inlined.base + inlined.maxLocal - ir.maxLocal;
+    }
+    const Instruction& code = owner->code[insn.index];
+    const u1 opcode = originalOpcode(loadOpcode(&code));
+    const u4 d = insn.depth;
+    const u4 base = ir.maxLocal;
+
+    u4 result = 0;
+    tuple<const DecodedCode*, u1, u2, u4, u4> key;
+    switch (opcode) {
+        case op_getfield:
+            result = d - 1;
+            key = make_tuple(owner, opcode, code.index, regs[base + d - 1],
+                             u4(0));
+            break;
+        case op_getstatic:
+            // It may initialize the class, which runs arbitrary code
+            loads.clear();
+            result = d;
+            key = make_tuple(owner, opcode, code.index, u4(0), u4(0));
+            break;
+        case op_arraylength:
+            result = d - 1;
+            key = make_tuple(nullptr, opcode, u2(0), regs[base + d - 1],
+                             u4(0));
+            break;
+        case op_iaload:
+        case op_laload:
+        case op_faload:
+        case op_daload:
+        case op_aaload:
+        case op_baload:
+        case op_caload:
+        case op_saload:
+            result = d - 2;
+            key = make_tuple(nullptr, opcode, u2(0), regs[base + d - 2],
+                             regs[base + d - 1]);
+            break;
+        default:
+            loads.clear();
+            forgetStack();
+            // An object just created is never null
+            if (opcode == op_new) {
+                nonNull.insert(regs[base + d]);
+            }
+            return;
+    }
+
+    const TypeState& after = (*types)[insn.index + 1];
+    const SlotTag type = after.stack[result - stackBase];
+    auto iter = loads.find(key);
+    if (iter != loads.end() && holder(regs, iter->second) >= 0) {
+        insn.dst = static_cast<int32_t>(base + result);
+        assign(insn, type, iter->second);
+        return;
+    }
+    FOR_EACH(r, regs.size() - base - result) {
+        regs[base + result + r] = fresh();
+    }
+    const u4 value = regs[base + result];
+    define(static_cast<int32_t>(base + result), type, value);
+    loads[key] = value;
+}
+
+void ValueNumbering::numberShuffle(const IrInsn& insn, vector<IrInsn>& code) {
+    size_t popped;
+    const char* pattern = shufflePattern(insn.extra, popped);
+    const vector<SlotTag>& tags = states[insn.index].stack;
+    const u4 base = insn.depth - static_cast<u4>(popped);
+    u4 sources[4];
+    FOR_EACH(k, popped) {
+        sources[k] = regs[ir.maxLocal + base + k];
+    }
+
+    // Slots are written from the top, each one from any register holding
+    // its value. If a value would lose its last holder before it was copied
+    // the shuffle is kept as it is
+    vector<u4> after(regs);
+    vector<IrInsn> moves;
+    bool copied = true;
+    for (size_t pos = strlen(pattern); pos-- > 0;) {
+        const int from = pattern[pos] - '0';
+        const SlotTag tag = tags[base + from];
+        if (tag == SlotTag::Top) {
+            continue;
+        }
+        const auto dst = static_cast<int32_t>(ir.maxLocal + base + pos);
+        const u4 value = sources[from];
+        if (after[dst] == value &&
+            (!isWide(tag) || after[dst + 1] == HIGH_HALF)) {
+            continue;
+        }
+        IrInsn move = makeInsn(IrOp::Move, tag, dst, insn.index, insn.depth,
+                               insn.site);
+        if (isConstant(value)) {
+            move.op = IrOp::Const;
+            move.a = IrOperand::immOf(values[value].bits);
+        } else {
+            const int32_t src = holder(after, value);
+            if (src < 0) {
+                copied = false;
+                break;
+            }
+            move.a = IrOperand::regOf(src);
+        }
+        moves.push_back(move);
+        after[dst] = value;
+        if (isWide(tag)) {
+            after[dst + 1] = HIGH_HALF;
+        }
+    }
+
+    if (copied) {
+        code.insert(code.end(), moves.begin(), moves.end());
+        regs.swap(after);
+        return;
+    }
+    code.push_back(insn);
+    for (size_t pos = 0; pattern[pos] != '\0'; pos++) {
+        const int from = pattern[pos] - '0';
+        regs[ir.maxLocal + base + pos] =
+            tags[base + from] == SlotTag::Top ? HIGH_HALF : sources[from];
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Registers read and written by IR instructions. Calls read every local
+// variable, since a frame may be inspected by GC or exceptions while they
+// run, and the whole operand stack below them
+//--------------------------------------------------------------------------------
+static void markUses(const IrMethod& ir, const IrInsn& insn,
+                     vector<bool>& live) {
+    switch (insn.op) {
+        case IrOp::Shuffle: {
+            size_t popped;
+            shufflePattern(insn.extra, popped);
+            FOR_EACH(k, popped) {
+                live[ir.maxLocal + insn.depth - popped + k] = true;
+            }
+            break;
+        }
+        case IrOp::Call:
+            FOR_EACH(r, ir.maxLocal + insn.depth) {
+                live[r] = true;
+            }
+            break;
+        case IrOp::Inline:
+            // A guard may leave the body to the invocation it replaces
+            if (insn.extra != 0) {
+                FOR_EACH(r, ir.maxLocal + insn.depth) {
+                    live[r] = true;
+                }
+            }
+            break;
+        case IrOp::Merge:
+            break;
+        default:
+            if (insn.op != IrOp::Const && !insn.a.isImm()) {
+                live[insn.a.reg] = true;
+            }
+            if (hasSecondOperand(insn.op) && !insn.b.isImm()) {
+                live[insn.b.reg] = true;
+            }
+            break;
+    }
+}
+
+static void markDefs(const IrMethod& ir, const IrInsn& insn,
+                     vector<bool>& live) {
+    if (isPure(insn.op)) {
+        live[insn.dst] = false;
+        if (isWide(resultType(insn))) {
+            live[insn.dst + 1] = false;
+        }
+    } else if (insn.op == IrOp::Shuffle) {
+        size_t popped;
+        const char* pattern = shufflePattern(insn.extra, popped);
+        for (size_t pos = 0; pattern[pos] != '\0'; pos++) {
+            live[ir.maxLocal + insn.depth - popped + pos] = false;
+        }
+    }
+}
+
+static bool uses(const IrInsn& insn, int32_t reg) {
+    if (insn.op == IrOp::Const) {
+        return false;
+    }
+    return (!insn.a.isImm() && insn.a.reg == reg) ||
+           (hasSecondOperand(insn.op) && !insn.b.isImm() && insn.b.reg == reg);
+}
+
+static bool defines(const IrInsn& insn, int32_t reg) {
+    return insn.dst == reg ||
+           (isWide(resultType(insn)) && insn.dst + 1 == reg);
+}
+
+// Registers live when control leaves a block
+static vector<bool> liveOut(const IrMethod& ir, const IrBlock& block) {
+    vector<bool> live(ir.registerCount(), false);
+    if (block.code.empty() || block.code.back().op != IrOp::Return) {
+        FOR_EACH(r, ir.maxLocal + block.exitDepth) {
+            live[r] = true;
+        }
+    }
+    return live;
+}
+
+static void eliminateDeadStores(const IrMethod& ir, IrBlock& block) {
+    vector<bool> live = liveOut(ir, block);
+    for (size_t k = block.code.size(); k-- > 0;) {
+        IrInsn& insn = block.code[k];
+        if (isPure(insn.op) && !live[insn.dst] &&
+            !(isWide(resultType(insn)) && live[insn.dst + 1])) {
+            insn.op = IrOp::Nop;
+            continue;
+        }
+        markDefs(ir, insn, live);
+        markUses(ir, insn, live);
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Compute the value of a copy right into its destination, "t = a + b; r = t"
+// becomes "r = a + b" if t is dead after the copy and nothing in between
+// touches r or t
+//--------------------------------------------------------------------------------
+static void coalesceCopies(const IrMethod& ir, IrBlock& block) {
+    vector<IrInsn>& code = block.code;
+    vector<vector<bool>> liveAfter(code.size());
+    vector<bool> live = liveOut(ir, block);
+    for (size_t k = code.size(); k-- > 0;) {
+        liveAfter[k] = live;
+        markDefs(ir, code[k], live);
+        markUses(ir, code[k], live);
+    }
+
+    FOR_EACH(j, code.size()) {
+        IrInsn& copy = code[j];
+        if (copy.op != IrOp::Move) {
+            continue;
+        }
+        const int32_t r = copy.dst;
+        const int32_t t = copy.a.reg;
+        const bool wide = isWide(copy.type);
+        if (liveAfter[j][t] || (wide && liveAfter[j][t + 1])) {
+            continue;
+        }
+        for (size_t k = j; k-- > 0;) {
+            IrInsn& def = code[k];
+            if (def.op == IrOp::Nop) {
+                continue;
+            }
+            if (!isPure(def.op)) {
+                break;
+            }
+            if (def.dst == t) {
+                if (resultType(def) == copy.type) {
+                    def.dst = r;
+                    copy.op = IrOp::Nop;
+                }
+                break;
+            }
+            if (defines(def, t) || defines(def, r) || uses(def, t) ||
+                uses(def, r) ||
+                (wide && (defines(def, r + 1) || uses(def, r + 1)))) {
+                break;
+            }
+        }
+    }
+}
+
+// Successors of instruction i of a method, exception handlers aside
+static void successorsOf(const DecodedCode* decoded, u4 i, vector<u4>& next) {
+    const Instruction& insn = decoded->code[i];
+    const u1 opcode = originalOpcode(loadOpcode(&insn));
+    next.clear();
+    if (opcode == op_tableswitch || opcode == op_lookupswitch) {
+        const int32_t* table = decoded->switchTables.data() + insn.operand;
+        next.push_back(static_cast<u4>(table[0]));
+        if (opcode == op_tableswitch) {
+            for (int32_t k = 0; k <= table[2] - table[1]; k++) {
+                next.push_back(static_cast<u4>(table[3 + k]));
+            }
+        } else {
+            for (int32_t k = 0; k < table[1]; k++) {
+                next.push_back(static_cast<u4>(table[3 + 2 * k]));
+            }
+        }
+        return;
+    }
+    if ((opcode >= op_ifeq && opcode <= op_goto) || opcode == op_ifnull ||
+        opcode == op_ifnonnull) {
+        next.push_back(insn.operand);
+    }
+    if (opcode != op_goto && opcode != op_athrow &&
+        !(opcode >= op_ireturn && opcode <= op_return) &&
+        i + 1 < decoded->code.size()) {
+        next.push_back(i + 1);
+    }
+}
+
+//--------------------------------------------------------------------------------
+// Local variables of a method that may be read before they are written again,
+// at the beginning of each instruction
+//--------------------------------------------------------------------------------
+static vector<vector<bool>> liveLocals(const DecodedCode* decoded,
+                                       const vector<TypeState>& states,
+                                       u4 maxLocal) {
+    const size_t n = decoded->code.size();
+    vector<vector<bool>> live(n, vector<bool>(maxLocal, false));
+    vector<u4> next;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = n; i-- > 0;) {
+            if (!states[i].reached) {
+                continue;
+            }
+            vector<bool> in(maxLocal, false);
+            successorsOf(decoded, static_cast<u4>(i), next);
+            for (u4 succ : next) {
+                FOR_EACH(r, maxLocal) {
+                    if (live[succ][r]) {
+                        in[r] = true;
+                    }
+                }
+            }
+            const Instruction& insn = decoded->code[i];
+            const u1 opcode = originalOpcode(loadOpcode(&insn));
+            if (opcode >= op_istore && opcode <= op_astore) {
+                in[insn.index] = false;
+                if (opcode == op_lstore || opcode == op_dstore) {
+                    in[insn.index + 1] = false;
+                }
+            } else if (opcode >= op_iload && opcode <= op_aload) {
+                in[insn.index] = true;
+                if (opcode == op_lload || opcode == op_dload) {
+                    in[insn.index + 1] = true;
+                }
+            } else if (opcode == op_iinc) {
+                in[insn.index] = true;
+            }
+            if (in != live[i]) {
+                live[i].swap(in);
+                changed = true;
+            }
+        }
+    }
+    return live;
+}
+
+static SlotTag fieldTag(char type) {
+    switch (type) {
+        case 'J':
+            return SlotTag::Long;
+        case 'D':
+            return SlotTag::Double;
+        case 'F':
+            return SlotTag::Float;
+        case 'L':
+        case '[':
+            return SlotTag::Ref;
+        default:
+            return SlotTag::Int;
+    }
+}
+
+// Instructions runtime helpers execute without running any Java code, so
+// they never reach a GC safepoint or push a frame unless they throw
+static bool staysInFrame(u1 opcode) {
+    switch (opcode) {
+        case op_idiv:
+        case op_ldiv:
+        case op_irem:
+        case op_lrem:
+        case op_frem:
+        case op_drem:
+        case op_f2i:
+        case op_f2l:
+        case op_d2i:
+        case op_d2l:
+        case op_fcmpl:
+        case op_fcmpg:
+        case op_dcmpl:
+        case op_dcmpg:
+        case op_getfield:
+        case op_putfield:
+        case op_newarray:
+        case op_arraylength:
+            return true;
+        default:
+            return (opcode >= op_iaload && opcode <= op_saload) ||
+                   (opcode >= op_iastore && opcode <= op_sastore);
+    }
+}
+
+// Whether an invocation of the method inlined as callee on an object of class
+// object reaches it
+static bool selects(const JavaClass* object, const IrInlined& callee) {
+    const int index = object->findVirtualMethod(
+        callee.jc->getSymbol(callee.method->nameIndex),
+        callee.jc->getSymbol(callee.method->descriptorIndex));
+    return index >= 0 &&
+           object->getVirtualMethod(static_cast<u2>(index)).method ==
+               callee.method;
+}
+
+//--------------------------------------------------------------------------------
+// Escape analysis and scalar replacement of a basic block. An object created
+// in the block does not escape if its reference is only copied between
+// registers, its fields are read and written, it's the receiver of inlined
+// methods whose guards it passes anyway, and nothing holds it when control
+// leaves the block. Such an object is never created, its fields are kept
+// in registers above the frames of inlined methods instead. GC does not scan
+// those registers and a method invocation would overwrite them, so nothing
+// but instructions that never run Java code may run while they are in use
+//--------------------------------------------------------------------------------
+class ScalarReplacement {
+public:
+    ScalarReplacement(IrMethod& ir, const JavaClass* jc,
+                      const DecodedCode* decoded,
+                      const vector<TypeState>& states)
+        : ir(ir),
+          jc(jc),
+          decoded(decoded),
+          states(states),
+          fieldBase(ir.registerCount()) {}
+
+    // Returns true if any object created in block was replaced
+    bool run(IrBlock& block);
+
+private:
+    struct Field {
+        u4 slot;
+        SlotTag type;
+        int32_t reg;
+    };
+    // getfield or putfield of the object at instruction pos
+    struct Access {
+        size_t pos;
+        u4 slot;
+        SlotTag type;
+        bool put;
+    };
+
+    const JavaClass* ownerClass(u4 site) const {
+        return site == 0 ? jc : ir.inlined[site - 1].jc;
+    }
+    const DecodedCode* ownerCode(u4 site) const {
+        return site == 0 ? decoded : ir.inlined[site - 1].decoded;
+    }
+    bool fieldOf(const JavaClass* object, const IrInsn& insn, u4& slot,
+                 SlotTag& type) const;
+    bool leavesBlock(const IrBlock& block, const vector<bool>& holders);
+    bool replace(vector<IrInsn>& code, size_t pos, const IrBlock& block,
+                 u4& top);
+
+    IrMethod& ir;
+    const JavaClass* jc;
+    const DecodedCode* decoded;
+    const vector<TypeState>& states;
+    // Fields of each block are kept from this register on
+    const u4 fieldBase;
+    // Local variables live at each instruction, computed once needed
+    vector<vector<bool>> live;
+};
+
+bool ScalarReplacement::run(IrBlock& block) {
+    bool replaced = false;
+    u4 top = fieldBase;
+    for (size_t k = 0; k < block.code.size(); k++) {
+        const IrInsn& insn = block.code[k];
+        if (insn.op != IrOp::Call) {
+            continue;
+        }
+        const Instruction& bc = ownerCode(insn.site)->code[insn.index];
+        if (originalOpcode(loadOpcode(&bc)) == op_new &&
+            replace(block.code, k, block, top)) {
+            replaced = true;
+        }
+    }
+    const u4 frame = ir.maxLocal + ir.maxStack;
+    if (top > frame) {
+        ir.extraStack = max(ir.extraStack, top - frame);
+    }
+    return replaced;
+}
+
+// Slot of the field quickened getfield or putfield insn accesses in objects of
+// class object
+bool ScalarReplacement::fieldOf(const JavaClass* object, const IrInsn& insn,
+                                u4& slot, SlotTag& type) const {
+    const DecodedCode* owner = ownerCode(insn.site);
+    const Instruction& code = owner->code[insn.index];
+    // Field cache was published before the instruction was quickened
+    const u1 opcode = loadOpcode(&code);
+    if (opcode != op_fast_getfield && opcode != op_fast_putfield) {
+        return false;
+    }
+    const FieldCache& cache = owner->fieldCaches[code.operand];
+    slot = cache.receiverClass == object
+               ? cache.slot
+               : object->getInstanceFieldCount() - cache.slotFromEnd;
+    type = fieldTag(cache.type);
+    return true;
+}
+
+bool ScalarReplacement::leavesBlock(const IrBlock& block,
+                                    const vector<bool>& holders) {
+    if (!block.code.empty() && block.code.back().op == IrOp::Return) {
+        return false;
+    }
+    for (u4 r = ir.maxLocal; r < ir.maxLocal + block.exitDepth; r++) {
+        if (holders[r]) {
+            return true;
+        }
+    }
+    // A local variable holding it is fine if no successor reads it
+    vector<u4> next;
+    successorsOf(decoded, block.end - 1, next);
+    FOR_EACH(r, ir.maxLocal) {
+        if (!holders[r]) {
+            continue;
+        }
+        if (live.empty()) {
+            live = liveLocals(decoded, states, ir.maxLocal);
+        }
+        for (u4 succ : next) {
+            if (live[succ][r]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ScalarReplacement::replace(vector<IrInsn>& code, size_t pos,
+                                const IrBlock& block, u4& top) {
+    // Creating an object of a class that was not initialized yet runs its
+    // <clinit>, and an abstract class can not be instantiated at all
+    const IrInsn& created = code[pos];
+    const SymbolicRef* ref = ownerClass(created.site)
+                                 ->getResolvedRef(ownerCode(created.site)
+                                                      ->code[created.index]
+                                                      .index);
+    if (ref == nullptr || ref->jc == nullptr || !ref->jc->isInitialized() ||
+        IS_CLASS_INTERFACE(ref->jc->getAccessFlag()) ||
+        IS_CLASS_ABSTRACT(ref->jc->getAccessFlag())) {
+        return false;
+    }
+    const JavaClass* object = ref->jc;
+
+    // Registers holding the reference
+    vector<bool> holders(top, false);
+    holders[ir.maxLocal + created.depth] = true;
+    auto holds = [&](const IrOperand& operand) {
+        return !operand.isImm() && holders[operand.reg];
+    };
+    auto define = [&](int32_t reg, SlotTag type) {
+        holders[reg] = false;
+        if (isWide(type)) {
+            holders[reg + 1] = false;
+        }
+    };
+
+    vector<Access> accesses;
+    vector<size_t> unguarded;
+    size_t lastUse = pos;
+    // The first instruction that may run Java code
+    size_t firstRun = code.size();
+    for (size_t k = pos + 1; k < code.size(); k++) {
+        const IrInsn& insn = code[k];
+        switch (insn.op) {
+            case IrOp::Nop:
+            case IrOp::Goto:
+                break;
+            case IrOp::Move:
+                if (holds(insn.a)) {
+                    holders[insn.dst] = true;
+                } else {
+                    define(insn.dst, insn.type);
+                }
+                break;
+            case IrOp::Shuffle: {
+                size_t popped;
+                const char* pattern = shufflePattern(insn.extra, popped);
+                const u4 base =
+                    ir.maxLocal + insn.depth - static_cast<u4>(popped);
+                vector<bool> sources(holders.begin() + base,
+                                     holders.begin() + base + popped);
+                for (size_t p = 0; pattern[p] != '\0'; p++) {
+                    holders[base + p] = sources[pattern[p] - '0'];
+                }
+                break;
+            }
+            case IrOp::Call: {
+                const Instruction& bc = ownerCode(insn.site)->code[insn.index];
+                const u1 opcode = originalOpcode(loadOpcode(&bc));
+                const u4 end = ir.maxLocal + insn.depth;
+                const auto begin = static_cast<u4>(
+                    end - poppedSlots(ownerClass(insn.site), bc));
+                u4 slot;
+                SlotTag type;
+                if (opcode == op_getfield && holders[end - 1]) {
+                    if (!fieldOf(object, insn, slot, type)) {
+                        return false;
+                    }
+                    accesses.push_back(Access{k, slot, type, false});
+                    lastUse = k;
+                } else if (opcode == op_putfield && holders[begin]) {
+                    // Storing it into itself
+                    if (!fieldOf(object, insn, slot, type) ||
+                        holders[begin + 1]) {
+                        return false;
+                    }
+                    accesses.push_back(Access{k, slot, type, true});
+                    lastUse = k;
+                } else {
+                    for (u4 r = begin; r < end; r++) {
+                        if (holders[r]) {
+                            return false;
+                        }
+                    }
+                    if (!staysInFrame(opcode)) {
+                        firstRun = min(firstRun, k);
+                    }
+                }
+                // Results are left right where operands were
+                for (u4 r = begin; r < holders.size(); r++) {
+                    holders[r] = false;
+                }
+                break;
+            }
+            case IrOp::Inline: {
+                if (insn.extra == 0) {
+                    break;
+                }
+                const IrInlined& callee = ir.inlined[insn.target - 1];
+                if (holds(insn.a)) {
+                    // The class of the object is known exactly
+                    u1 guards = insn.extra;
+                    if (insn.b.imm == 0 ||
+                        insn.b.imm == reinterpret_cast<uint64_t>(object)) {
+                        guards &= ~GuardReceiver;
+                    }
+                    if (selects(object, callee)) {
+                        guards &= ~GuardHierarchy;
+                    }
+                    if (guards != 0) {
+                        return false;
+                    }
+                    unguarded.push_back(k);
+                    lastUse = k;
+                    break;
+                }
+                // A guard that fails invokes the method with its arguments
+                for (u4 r = callee.base; r < callee.base + callee.argSlots;
+                     r++) {
+                    if (holders[r]) {
+                        return false;
+                    }
+                }
+                firstRun = min(firstRun, k);
+                break;
+            }
+            case IrOp::Merge: {
+                bool guarded = insn.extra != 0;
+                for (size_t inlined : unguarded) {
+                    if (code[inlined].target == insn.target) {
+                        guarded = false;
+                    }
+                }
+                if (guarded) {
+                    firstRun = min(firstRun, k);
+                }
+                break;
+            }
+            default:
+                // Comparing or returning it, or anything else
+                if ((insn.op != IrOp::Const && holds(insn.a)) ||
+                    (hasSecondOperand(insn.op) && holds(insn.b))) {
+                    return false;
+                }
+                if (isPure(insn.op)) {
+                    define(insn.dst, resultType(insn));
+                }
+                break;
+        }
+    }
+    if (firstRun < lastUse || leavesBlock(block, holders)) {
+        return false;
+    }
+
+    // Each field gets registers of its own, getfield and putfield become
+    // copies from and into them
+    vector<Field> fields;
+    for (const Access& access : accesses) {
+        auto field =
+            find_if(fields.begin(), fields.end(),
+                    [&](const Field& f) { return f.slot == access.slot; });
+        if (field == fields.end()) {
+            fields.push_back(
+                Field{access.slot, access.type, static_cast<int32_t>(top)});
+            field = fields.end() - 1;
+            top += isWide(access.type) ? 2 : 1;
+        }
+        IrInsn& insn = code[access.pos];
+        const auto end = static_cast<int32_t>(ir.maxLocal + insn.depth);
+        insn.op = IrOp::Move;
+        insn.type = field->type;
+        if (access.put) {
+            insn.dst = field->reg;
+            insn.a = IrOperand::regOf(end - (isWide(field->type) ? 2 : 1));
+        } else {
+            insn.dst = end - 1;
+            insn.a = IrOperand::regOf(field->reg);
+        }
+    }
+    for (size_t inlined : unguarded) {
+        code[inlined].extra = 0;
+        for (size_t k = inlined + 1; k < code.size(); k++) {
+            if (code[k].op == IrOp::Merge &&
+                code[k].target == code[inlined].target) {
+                code[k].extra = 0;
+                break;
+            }
+        }
+    }
+
+    // The reference is null and fields begin with their default values
+    IrInsn& replaced = code[pos];
+    replaced.op = IrOp::Const;
+    replaced.type = SlotTag::Ref;
+    replaced.dst = static_cast<int32_t>(ir.maxLocal + replaced.depth);
+    replaced.a = IrOperand::immOf(0);
+    vector<IrInsn> defaults;
+    for (const Field& field : fields) {
+        IrInsn zero = makeInsn(IrOp::Const, field.type, field.reg,
+                               replaced.index, replaced.depth, replaced.site);
+        defaults.push_back(zero);
+    }
+    code.insert(code.begin() + pos + 1, defaults.begin(), defaults.end());
+    return true;
+}
+
+void optimizeIR(IrMethod& ir, const JavaClass* jc, const DecodedCode* decoded,
+                const vector<TypeState>& states) {
+    ValueNumbering numbering(ir, decoded, states);
+    ScalarReplacement replacement(ir, jc, decoded, states);
+    for (IrBlock& block : ir.blocks) {
+        if (!block.reached) {
+            continue;
+        }
+        numbering.run(block);
+        // Values of fields are propagated once they are in registers
+        if (replacement.run(block)) {
+            numbering.run(block);
+        }
+        eliminateDeadStores(ir, block);
+        coalesceCopies(ir, block);
+
+        vector<IrInsn> code;
+        for (const IrInsn& insn : block.code) {
+            if (insn.op != IrOp::Nop) {
+                code.push_back(insn);
+            }
+        }
+        block.code.swap(code);
+    }
+}
@@ -0,0 +1,178 @@
+#ifndef YVM_REGISTERIR_H
+#define YVM_REGISTERIR_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "../interpreter/Instruction.h"
+#include "../interpreter/TypeInference.h"
+
+class JavaClass;
+
+//--------------------------------------------------------------------------------
+// Register-based intermediate representation of optimizing compiler. Registers
+// are the slots of the frame, local variables first and operand stack above
+// them, so a method in IR runs on the same frame as it does in interpreter and
+// baseline compiler, and at the beginning of each basic block every register
+// holds exactly what interpreter would hold there. Within a block the stack
+// code is translated as it is, one instruction into at most a few IR
+// instructions, and the optimizer then removes the copies between operand
+// stack and local variables that stack code is made of
+//--------------------------------------------------------------------------------
+enum class IrOp : u1 {
+    Nop,
+    // dst = imm, dst = a
+    Const,
+    Move,
+    // dst = a op b, for shifts b is an int in any case
+    Add,
+    Sub,
+    Mul,
+    Div,
+    And,
+    Or,
+    Xor,
+    Shl,
+    Shr,
+    UShr,
+    // dst = -a
+    Neg,
+    // dst = a converted by the conversion instruction extra
+    Convert,
+    // dst = lcmp(a, b)
+    Compare,
+    // Stack manipulation instruction extra, see shufflePattern()
+    Shuffle,
+    // if (a cond b) goto target, cond is extra
+    Branch,
+    Goto,
+    // goto switch table at target, which is of instruction extra
+    Switch,
+    // Return the register a, or nothing if it's an immediate
+    Return,
+    // Execute instruction index by runtime helper, operand stack is depth
+    // slots deep before it
+    Call,
+    // Beginning and end of the body of inlined method target, which replaces
+    // invocation index at operand stack depth. extra holds the guards of the
+    // body, see IrGuard, if any of them fails Merge executes the invocation
+    // by runtime helper instead
+    Inline,
+    Merge
+};
+
+// Guards of an inlined body. Register a of Inline must hold an object, whose
+// class must be b unless b is 0, and a method bound by class hierarchy must
+// still not be overridden by any loaded class
+enum IrGuard : u1 { GuardReceiver = 1, GuardHierarchy = 2 };
+
+// Conditions in the order of ifeq...ifle
+enum class IrCond : u1 { Eq, Ne, Lt, Ge, Gt, Le };
+
+// An operand is either a register or an immediate of the type of instruction
+struct IrOperand {
+    int32_t reg;
+    uint64_t imm;
+
+    bool isImm() const { return reg < 0; }
+    static IrOperand regOf(u4 reg) {
+        return IrOperand{static_cast<int32_t>(reg), 0};
+    }
+    static IrOperand immOf(uint64_t imm) { return IrOperand{-1, imm}; }
+};
+
+//--------------------------------------------------------------------------------
+// An IR instruction. type is the type of result, or of compared operands for
+// Branch and Compare, a long or double result takes register dst and dst + 1
+// as it does in a frame. index is the instruction it was translated from,
+// it's also what a Call executes, and site is the method it belongs to, 0 for
+// the compiled method or k for inlined method k - 1. depth always counts the
+// operand stack of the compiled method, where inlined frames are laid out
+//--------------------------------------------------------------------------------
+struct IrInsn {
+    IrOp op;
+    SlotTag type;
+    u1 extra;
+    int32_t dst;
+    IrOperand a;
+    IrOperand b;
+    u4 index;
+    u4 depth;
+    int32_t target;
+    u4 site;
+};
+
+// Instructions [start, end) of a method, and the depth of operand stack when
+// control leaves the block
+struct IrBlock {
+    u4 start;
+    u4 end;
+    u4 exitDepth;
+    bool reached;
+    std::vector<IrInsn> code;
+};
+
+//--------------------------------------------------------------------------------
+// A method inlined at invocation invokeIndex of site caller. Its frame is
+// never pushed, local variable k is register base + k and operand stack
+// follows local variables, right where interpreter would push the frame in
+// place of the argSlots slots of arguments. If class hierarchy analysis bound
+// the invocation to it for receivers of class bound, it's not nullptr
+//--------------------------------------------------------------------------------
+struct IrInlined {
+    const JavaClass* jc;
+    const MethodInfo* method;
+    DecodedCode* decoded;
+    std::vector<TypeState> states;
+    u4 caller;
+    u4 invokeIndex;
+    u4 base;
+    u4 maxLocal;
+    u4 argSlots;
+    const JavaClass* bound;
+};
+
+// Registers above operand stack are taken by frames of inlined methods, and
+// above them by fields of objects scalar replacement never creates
+struct IrMethod {
+    u4 maxLocal;
+    u4 maxStack;
+    u4 extraStack;
+    std::vector<IrBlock> blocks;
+    std::deque<IrInlined> inlined;
+
+    u4 registerCount() const { return maxLocal + maxStack + extraStack; }
+};
+
+//--------------------------------------------------------------------------------
+// Operand stack slots a dup_x1, dup_x2, dup2_x1, dup2_x2 or swap pops, and the
+// slots it pushes, each digit of pattern names a popped slot from the deepest
+// one
+//--------------------------------------------------------------------------------
+const char* shufflePattern(u1 opcode, size_t& popped);
+
+//--------------------------------------------------------------------------------
+// Translate a decoded method whose types were inferred into IR. Returns false
+// if it has exception handlers or instructions IR can not express, jsr/ret,
+// monitors, checkcast, multianewarray and invokedynamic. Invoked methods that
+// are small and run straight through are inlined if the invocation always
+// reaches them, if no loaded class overrides them, or if their receiver class
+// is the only one it has seen so far
+//--------------------------------------------------------------------------------
+bool buildIR(const JavaClass* jc, const MethodInfo* m,
+             const DecodedCode* decoded, const std::vector<TypeState>& states,
+             IrMethod& ir);
+
+//--------------------------------------------------------------------------------
+// Optimize each basic block of IR on its own. Local value numbering folds
+// constants, propagates copies, reuses common subexpressions and removes
+// loads of fields, static variables and array elements that were already
+// loaded since the last store or call. Objects that never escape the block
+// are replaced by their fields in registers. Then stores of dead registers are
+// removed and results are computed right into the registers they are copied
+// to
+//--------------------------------------------------------------------------------
+void optimizeIR(IrMethod& ir, const JavaClass* jc, const DecodedCode* decoded,
+                const std::vector<TypeState>& states);
+
+#endif  // YVM_REGISTERIR_H
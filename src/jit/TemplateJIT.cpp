@@ -0,0 +1,1102 @@
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include "../classfile/AccessFlag.h"
+#include "../interpreter/Decoder.h"
+#include "../interpreter/FieldAccess.h"
+#include "../interpreter/Interpreter.hpp"
+#include "../interpreter/SymbolicRef.h"
+#include "../misc/Option.h"
+#include "../runtime/JavaClass.h"
+#include "../runtime/JavaHeap.hpp"
+#include "../runtime/MethodArea.h"
+#include "CodeCache.h"
+#include "OptimizingJIT.h"
+#include "TemplateJIT.h"
+
+// Templates follow System V AMD64 calling convention
+#if defined(__x86_64__) && !defined(_WIN32)
+#define YVM_JIT_SUPPORTED
+#endif
+
+using namespace std;
+
+//--------------------------------------------------------------------------------
+// State of a running compiled method shared with runtime helpers. Machine
+// code never looks into it, it only passes it to helpers
+//--------------------------------------------------------------------------------
+struct JitContext {
+    Interpreter* interp;
+    Slots* frame;
+    const JavaClass* jc;
+    DecodedCode* decoded;
+    const CompiledMethod* compiled;
+    // The thrown object if compiled code returned nullptr
+    JValue thrown;
+    // C++ exceptions can not unwind through machine code, a helper catches
+    // them and they are rethrown after compiled code returned
+    exception_ptr error;
+};
+
+static_assert(sizeof(JValue) == 16, "templates assume 16-byte slots");
+
+static const int32_t TAG_OFFSET = offsetof(JValue, tag);
+
+// Receiver guards compare the vtable pointer and the class of an object
+static const JObject objectLayout{};
+static const int32_t CLASS_OFFSET = static_cast<int32_t>(
+    reinterpret_cast<const char*>(&objectLayout.jc) -
+    reinterpret_cast<const char*>(&objectLayout));
+
+static uint64_t objectVtable() {
+    uint64_t vptr;
+    memcpy(&vptr, &objectLayout, sizeof(vptr));
+    return vptr;
+}
+
+static CodeCache codeCache(YVM_JIT_CODE_CACHE_SIZE);
+
+// Depth of compiled methods on native stack of current thread
+static thread_local int nativeDepth = 0;
+
+// Slots taken by the value a load or store of local variable copies
+static size_t slotCount(u1 opcode) {
+    switch (opcode) {
+        case op_lload:
+        case op_dload:
+        case op_lstore:
+        case op_dstore:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+static uint64_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static uint64_t doubleBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+CompiledMethod* TemplateJIT::prepare(const CallSite& csite) {
+    DecodedCode* decoded = csite.decoded;
+    CompiledMethod* compiled = decoded->compiled.load(memory_order_acquire);
+    if (compiled == nullptr) {
+        if (!yrt.jit) {
+            return nullptr;
+        }
+        // Counters are bumped without atomic read-modify-write, losing a few
+        // counts to racing threads is cheaper than locked instructions
+        const u4 count = decoded->invocationCount.load(memory_order_relaxed);
+        if (count < yrt.jitThreshold) {
+            decoded->invocationCount.store(count + 1, memory_order_relaxed);
+            return nullptr;
+        }
+        compiled = compiledCode(csite.jc, csite.method, decoded);
+        if (compiled == nullptr) {
+            return nullptr;
+        }
+    }
+    return nativeDepth < YVM_JIT_MAX_NATIVE_DEPTH ? compiled : nullptr;
+}
+
+CompiledMethod* TemplateJIT::countBackedge(const JavaClass* jc,
+                                           const MethodInfo* m,
+                                           DecodedCode* decoded, u2 loop) {
+    atomic<u4>& counter = decoded->loops[loop - 1].backedges;
+    const u4 count = counter.load(memory_order_relaxed);
+    if (count < yrt.osrThreshold) {
+        counter.store(count + 1, memory_order_relaxed);
+        return nullptr;
+    }
+    // Counting starts over, so a loop that failed to transfer, e.g. since
+    // native stack was too deep, tries again after another round
+    counter.store(0, memory_order_relaxed);
+    // Code compiled ahead of time can only be entered at the beginning
+    CompiledMethod* compiled = compiledCode(jc, m, decoded);
+    return compiled != nullptr && compiled->osrEntry != nullptr &&
+                   nativeDepth < YVM_JIT_MAX_NATIVE_DEPTH
+               ? compiled
+               : nullptr;
+}
+
+CompiledMethod* TemplateJIT::compiledCode(const JavaClass* jc,
+                                          const MethodInfo* m,
+                                          DecodedCode* decoded) {
+    // Only the first thread getting here compiles the method, others keep
+    // interpreting meanwhile. It's never compiled again if it failed
+    CompiledMethod* compiled = decoded->compiled.load(memory_order_acquire);
+    if (compiled == nullptr &&
+        !decoded->compileAttempted.load(memory_order_relaxed) &&
+        !decoded->compileAttempted.exchange(true)) {
+        compiled = compile(jc, m, decoded);
+        // Classes may have been loaded since the code was compiled, code
+        // relying on a method they override is dropped and the method is
+        // compiled again once it gets hot again
+        if (compiled != nullptr &&
+            !yrt.ma->publishDependent(decoded, compiled)) {
+            compiled->invalidated.store(true, memory_order_relaxed);
+            compiled = nullptr;
+            decoded->invocationCount.store(0, memory_order_relaxed);
+            decoded->compileAttempted.store(false, memory_order_release);
+        }
+    }
+    return compiled;
+}
+
+void TemplateJIT::invalidate(DecodedCode* decoded, CompiledMethod* compiled) {
+    compiled->invalidated.store(true, memory_order_release);
+    CompiledMethod* expected = compiled;
+    if (decoded->compiled.compare_exchange_strong(expected, nullptr)) {
+        decoded->invocationCount.store(0, memory_order_relaxed);
+        decoded->compileAttempted.store(false, memory_order_release);
+    }
+}
+
+JValue TemplateJIT::run(Interpreter& interp, const CallSite& csite,
+                        CompiledMethod* compiled) {
+    Slots* frame = interp.frames->top();
+    frame->jc = csite.jc;
+    frame->method = csite.method;
+    frame->decoded = csite.decoded;
+
+    JitContext ctx{&interp,  frame,    csite.jc, csite.decoded,
+                   compiled, JValue{}, nullptr};
+    nativeDepth++;
+    const JValue* result =
+        compiled->entry(&ctx, frame->localSlots, frame->stackSlots);
+    nativeDepth--;
+    return complete(ctx, result, csite.method);
+}
+
+JValue TemplateJIT::runOsr(Interpreter& interp, CompiledMethod* compiled,
+                           u4 start) {
+    Slots* frame = interp.frames->top();
+    // Frames of inlined methods lie above operand stack, interpreter checked
+    // there is room for them
+    if (compiled->extraStack > 0) {
+        interp.frames->grow(static_cast<int>(compiled->extraStack));
+    }
+    JitContext ctx{&interp, frame,    frame->jc, frame->decoded,
+                   compiled, JValue{}, nullptr};
+    nativeDepth++;
+    const JValue* result =
+        compiled->osrEntry(&ctx, frame->localSlots, frame->stackSlots,
+                           compiled->entries[start]);
+    nativeDepth--;
+    return complete(ctx, result, frame->method);
+}
+
+JValue TemplateJIT::complete(const JitContext& ctx, const JValue* result,
+                             const MethodInfo* m) {
+    if (ctx.error) {
+        rethrow_exception(ctx.error);
+    }
+    if (result == nullptr) {
+        return ctx.thrown;
+    }
+    return m->shape.returnType != T_EXTRA_VOID ? *result : JValue{};
+}
+
+CompiledMethod* TemplateJIT::compile(const JavaClass* jc, const MethodInfo* m,
+                                     DecodedCode* decoded) {
+#ifdef YVM_JIT_SUPPORTED
+    vector<TypeState> states;
+    if (!decoded->exceptionTable.empty() ||
+        !inferTypes(jc, m, decoded, states)) {
+        return nullptr;
+    }
+
+    auto* compiled = new CompiledMethod;
+    compiled->entries.resize(decoded->code.size());
+    // Methods the optimizing tier can not translate get templates
+    if (yrt.opt && OptimizingJIT::compile(jc, m, decoded, &states, compiled)) {
+        return compiled;
+    }
+    TemplateJIT compiler(jc, decoded, &states, compiled);
+    if (compiler.assemble()) {
+        return compiled;
+    }
+    delete compiled;
+#endif
+    return nullptr;
+}
+
+Mem TemplateJIT::stackSlot(size_t slot, int32_t offset) {
+    return Mem{R12, static_cast<int32_t>(slot * sizeof(JValue)) + offset};
+}
+
+Mem TemplateJIT::localSlot(size_t slot, int32_t offset) {
+    return Mem{RBX, static_cast<int32_t>(slot * sizeof(JValue)) + offset};
+}
+
+bool TemplateJIT::assemble() {
+    if (!emitMethod()) {
+        return false;
+    }
+    const uint8_t* base = install(as);
+    if (base == nullptr) {
+        return false;
+    }
+    compiled->entry = reinterpret_cast<CompiledEntry>(base);
+    compiled->osrEntry = reinterpret_cast<OsrEntry>(base + osrOffset);
+    FOR_EACH(i, compiled->entries.size()) {
+        compiled->entries[i] = base + offsets[i];
+    }
+    return true;
+}
+
+const uint8_t* TemplateJIT::install(const X86Assembler& as) {
+    return codeCache.install(as.code().data(), as.size());
+}
+
+TemplateJIT::TemplateJIT(const JavaClass* jc, DecodedCode* decoded,
+                         const vector<TypeState>* states,
+                         CompiledMethod* compiled)
+    : jc(jc), decoded(decoded), states(states), compiled(compiled) {}
+
+bool TemplateJIT::emitMethod() {
+    emitPrologue();
+    if (!emitBody()) {
+        return false;
+    }
+
+    const size_t exceptionPath = as.size();
+    as.movImm(RAX, 0);
+    const size_t epilogue = as.size();
+    as.pop(R14);
+    as.pop(R13);
+    as.pop(R12);
+    as.pop(RBX);
+    as.pop(RBP);
+    as.ret();
+
+    // Entry of on-stack replacement jumps to the instruction it was given
+    osrOffset = as.size();
+    emitPrologue();
+    as.jmp(RCX);
+
+    for (const auto& branch : branches) {
+        as.bind(branch.first, offsets[branch.second]);
+    }
+    for (size_t exit : returnExits) {
+        as.bind(exit, epilogue);
+    }
+    for (size_t exit : exceptionExits) {
+        as.bind(exit, exceptionPath);
+    }
+    return true;
+}
+
+bool TemplateJIT::emitBody() {
+    const size_t n = decoded->code.size();
+    offsets.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        offsets[i] = as.size();
+        if (!(*states)[i].reached) {
+            as.int3();
+            continue;
+        }
+        if (!emitInstruction(static_cast<u4>(i),
+                             (*states)[i].stack.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TemplateJIT::emitPrologue() {
+    // Five pushes keep native stack aligned to 16 bytes at calls
+    as.push(RBP);
+    as.mov(RBP, RSP, true);
+    as.push(RBX);
+    as.push(R12);
+    as.push(R13);
+    as.push(R14);
+    as.mov(R13, RDI, true);
+    as.mov(RBX, RSI, true);
+    as.mov(R12, RDX, true);
+}
+
+void TemplateJIT::emitSlowPath(u4 i, size_t depth) {
+    emitHelperCall(addressOf(&TemplateJIT::slowPath), i, depth);
+}
+
+void TemplateJIT::emitHelperCall(uint64_t helper, u4 argument, size_t depth) {
+    // helper(ctx, sp, argument) returns false if the instruction threw
+    as.mov(RDI, R13, true);
+    as.lea(RSI, stackSlot(depth));
+    as.movImm(RDX, argument);
+    as.movImm(RAX, helper);
+    as.call(RAX);
+    as.zeroExtend8(RAX, RAX);
+    as.test(RAX, RAX, false);
+    exceptionExits.push_back(as.jcc(CondE));
+}
+
+void TemplateJIT::emitBranch(Cond cond, int32_t target) {
+    branches.emplace_back(as.jcc(cond), target);
+}
+
+void TemplateJIT::emitClassGuard(Mem receiver, const JavaClass* receiverClass,
+                                 vector<size_t>& misses) {
+    as.load(RAX, receiver, true);
+    as.test(RAX, RAX, true);
+    misses.push_back(as.jcc(CondE));
+    if (receiverClass == nullptr) {
+        return;
+    }
+    // Arrays have a class of their own
+    as.load(RCX, Mem{RAX, 0}, true);
+    as.movImm(RDX, objectVtable());
+    as.alu(AluCmp, RCX, RDX, true);
+    misses.push_back(as.jcc(CondNE));
+    as.load(RCX, Mem{RAX, CLASS_OFFSET}, true);
+    as.movImm(RDX, addressOf(receiverClass));
+    as.alu(AluCmp, RCX, RDX, true);
+    misses.push_back(as.jcc(CondNE));
+}
+
+void TemplateJIT::emitReturn(size_t slot) {
+    as.lea(RAX, stackSlot(slot));
+    returnExits.push_back(as.jmp());
+}
+
+void TemplateJIT::emitShuffle(const SlotTag* tags, size_t depth,
+                              size_t popped, const char* pushed) {
+    // Popped slots are loaded into rax, rcx, rdx and rsi from the deepest one,
+    // each digit of pushed names the slot to be pushed
+    static const Reg regs[] = {RAX, RCX, RDX, RSI};
+    const size_t base = depth - popped;
+    FOR_EACH(k, popped) {
+        emitLoadSlot(regs[k], stackSlot(base + k), tags[base + k]);
+    }
+    for (size_t k = 0; pushed[k] != '\0'; k++) {
+        const int from = pushed[k] - '0';
+        emitStoreSlot(stackSlot(base + k), regs[from], tags[base + from]);
+    }
+}
+
+void TemplateJIT::emitLoadSlot(Reg dst, Mem src, SlotTag tag) {
+    // A slot is accessed by the width its value was written with, reading
+    // value and tag at once would stall store forwarding. The second half of
+    // a long or double holds nothing but its tag
+    if (tag != SlotTag::Top) {
+        as.load(dst, src, tag == SlotTag::Long || tag == SlotTag::Double ||
+                              tag == SlotTag::Ref);
+    }
+}
+
+void TemplateJIT::emitStoreSlot(Mem dst, Reg src, SlotTag tag) {
+    if (tag != SlotTag::Top) {
+        as.store(dst, src, tag == SlotTag::Long || tag == SlotTag::Double ||
+                               tag == SlotTag::Ref);
+    }
+    as.storeImm8(Mem{dst.base, dst.disp + TAG_OFFSET},
+                 static_cast<uint8_t>(tag));
+}
+
+void TemplateJIT::emitTag(size_t slot, SlotTag tag) {
+    as.storeImm8(stackSlot(slot, TAG_OFFSET), static_cast<uint8_t>(tag));
+}
+
+void TemplateJIT::emitConstant(size_t slot, uint64_t bits, SlotTag tag) {
+    if (tag == SlotTag::Long || tag == SlotTag::Double) {
+        as.movImm(RAX, bits);
+        as.store(stackSlot(slot), RAX, true);
+        emitTag(slot + 1, SlotTag::Top);
+    } else {
+        as.storeImm32(stackSlot(slot), static_cast<int32_t>(bits),
+                      tag == SlotTag::Ref);
+    }
+    emitTag(slot, tag);
+}
+
+bool TemplateJIT::emitInstruction(u4 i, size_t depth) {
+    static const SseOp floatOps[] = {SseAdd, SseSub, SseMul, SseDiv};
+    static const ShiftOp shiftOps[] = {ShiftLeft, ShiftRight,
+                                       ShiftRightLogical};
+    static const Cond conditions[] = {CondE,  CondNE, CondL,
+                                      CondGE, CondG,  CondLE};
+
+    const Instruction& insn = decoded->code[i];
+    const TypeState& state = (*states)[i];
+    const ConstantPool& cp = jc->getConstPool();
+    const size_t d = depth;
+    const u1 opcode = originalOpcode(loadOpcode(&insn));
+
+    switch (opcode) {
+        case op_nop:
+        case op_pop:
+        case op_pop2:
+            break;
+        case op_aconst_null:
+            emitConstant(d, 0, SlotTag::Ref);
+            break;
+        case op_bipush:
+        case op_sipush:
+            emitConstant(d, static_cast<uint32_t>(insn.operand), SlotTag::Int);
+            break;
+        case op_lconst_0:
+        case op_lconst_1:
+            emitConstant(d, opcode - op_lconst_0, SlotTag::Long);
+            break;
+        case op_fconst_0:
+        case op_fconst_1:
+        case op_fconst_2:
+            emitConstant(d, floatBits(static_cast<float>(opcode - op_fconst_0)),
+                         SlotTag::Float);
+            break;
+        case op_dconst_0:
+        case op_dconst_1:
+            emitConstant(d,
+                         doubleBits(static_cast<double>(opcode - op_dconst_0)),
+                         SlotTag::Double);
+            break;
+        case op_ldc:
+            // Strings are created at runtime
+            if (cp.is(insn.index, TAG_Integer)) {
+                emitConstant(d, static_cast<uint32_t>(cp.intValue(insn.index)),
+                             SlotTag::Int);
+            } else if (cp.is(insn.index, TAG_Float)) {
+                emitConstant(d, floatBits(cp.floatValue(insn.index)),
+                             SlotTag::Float);
+            } else {
+                emitSlowPath(i, d);
+            }
+            break;
+        case op_ldc2_w:
+            if (cp.is(insn.index, TAG_Long)) {
+                emitConstant(d, static_cast<uint64_t>(cp.longValue(insn.index)),
+                             SlotTag::Long);
+            } else if (cp.is(insn.index, TAG_Double)) {
+                emitConstant(d, doubleBits(cp.doubleValue(insn.index)),
+                             SlotTag::Double);
+            } else {
+                return false;
+            }
+            break;
+
+        // Local variables are copied with their inferred tags
+        case op_iload:
+        case op_fload:
+        case op_aload:
+        case op_lload:
+        case op_dload:
+            FOR_EACH(k, slotCount(opcode)) {
+                const SlotTag tag = state.locals[insn.index + k];
+                emitLoadSlot(RAX, localSlot(insn.index + k), tag);
+                emitStoreSlot(stackSlot(d + k), RAX, tag);
+            }
+            break;
+        case op_istore:
+        case op_fstore:
+        case op_astore:
+        case op_lstore:
+        case op_dstore: {
+            const size_t n = slotCount(opcode);
+            for (size_t k = 0; k < n; k++) {
+                const SlotTag tag = state.stack[d - n + k];
+                emitLoadSlot(RAX, stackSlot(d - n + k), tag);
+                emitStoreSlot(localSlot(insn.index + k), RAX, tag);
+            }
+            break;
+        }
+        case op_iinc:
+            as.addImm32(localSlot(insn.index), insn.operand);
+            break;
+
+        // Stack manipulations shuffle slots with their inferred tags
+        case op_dup:
+            emitShuffle(state.stack.data(), d, 1, "00");
+            break;
+        case op_dup_x1:
+            emitShuffle(state.stack.data(), d, 2, "101");
+            break;
+        case op_dup_x2:
+            emitShuffle(state.stack.data(), d, 3, "2012");
+            break;
+        case op_dup2:
+            emitShuffle(state.stack.data(), d, 2, "0101");
+            break;
+        case op_dup2_x1:
+            emitShuffle(state.stack.data(), d, 3, "12012");
+            break;
+        case op_dup2_x2:
+            emitShuffle(state.stack.data(), d, 4, "230123");
+            break;
+        case op_swap:
+            emitShuffle(state.stack.data(), d, 2, "10");
+            break;
+
+        // Integer arithmetic, results overwrite the first operand in place
+        case op_iadd:
+        case op_isub:
+        case op_iand:
+        case op_ior:
+        case op_ixor:
+        case op_ladd:
+        case op_lsub:
+        case op_land:
+        case op_lor:
+        case op_lxor: {
+            AluOp op = AluXor;
+            if (opcode == op_iadd || opcode == op_ladd) {
+                op = AluAdd;
+            } else if (opcode == op_isub || opcode == op_lsub) {
+                op = AluSub;
+            } else if (opcode == op_iand || opcode == op_land) {
+                op = AluAnd;
+            } else if (opcode == op_ior || opcode == op_lor) {
+                op = AluOr;
+            }
+            // Long variant of each operation follows its int variant
+            const bool wide = (opcode & 1) != 0;
+            const size_t size = wide ? 2 : 1;
+            as.load(RAX, stackSlot(d - 2 * size), wide);
+            as.alu(op, RAX, stackSlot(d - size), wide);
+            as.store(stackSlot(d - 2 * size), RAX, wide);
+            break;
+        }
+        case op_imul:
+        case op_lmul: {
+            const bool wide = opcode == op_lmul;
+            const size_t size = wide ? 2 : 1;
+            as.load(RAX, stackSlot(d - 2 * size), wide);
+            as.imul(RAX, stackSlot(d - size), wide);
+            as.store(stackSlot(d - 2 * size), RAX, wide);
+            break;
+        }
+        case op_ineg:
+        case op_lneg: {
+            const bool wide = opcode == op_lneg;
+            const size_t size = wide ? 2 : 1;
+            as.load(RAX, stackSlot(d - size), wide);
+            as.neg(RAX, wide);
+            as.store(stackSlot(d - size), RAX, wide);
+            break;
+        }
+        case op_ishl:
+        case op_ishr:
+        case op_iushr:
+        case op_lshl:
+        case op_lshr:
+        case op_lushr: {
+            const bool wide = (opcode - op_ishl) % 2 != 0;
+            const size_t value = d - 1 - (wide ? 2 : 1);
+            as.load(RCX, stackSlot(d - 1), false);
+            as.load(RAX, stackSlot(value), wide);
+            as.shift(shiftOps[(opcode - op_ishl) / 2], RAX, wide);
+            as.store(stackSlot(value), RAX, wide);
+            break;
+        }
+        case op_lcmp:
+            as.load(RAX, stackSlot(d - 4), true);
+            as.alu(AluCmp, RAX, stackSlot(d - 2), true);
+            as.setcc(CondG, RAX);
+            as.setcc(CondL, RCX);
+            as.zeroExtend8(RAX, RAX);
+            as.zeroExtend8(RCX, RCX);
+            as.alu(AluSub, RAX, RCX, false);
+            as.store(stackSlot(d - 4), RAX, false);
+            emitTag(d - 4, SlotTag::Int);
+            break;
+
+        // Floating-point arithmetic except remainders
+        case op_fadd:
+        case op_fsub:
+        case op_fmul:
+        case op_fdiv:
+            as.sse(SseSingle, SseLoad, 0, stackSlot(d - 2));
+            as.sse(SseSingle, floatOps[(opcode - op_fadd) / 4], 0,
+                   stackSlot(d - 1));
+            as.sse(SseSingle, SseStore, 0, stackSlot(d - 2));
+            break;
+        case op_dadd:
+        case op_dsub:
+        case op_dmul:
+        case op_ddiv:
+            as.sse(SseDouble, SseLoad, 0, stackSlot(d - 4));
+            as.sse(SseDouble, floatOps[(opcode - op_dadd) / 4], 0,
+                   stackSlot(d - 2));
+            as.sse(SseDouble, SseStore, 0, stackSlot(d - 4));
+            break;
+        case op_fneg:
+            as.xorImm32(stackSlot(d - 1), INT32_MIN);
+            break;
+        case op_dneg:
+            as.xorImm32(stackSlot(d - 2, 4), INT32_MIN);
+            break;
+
+        // Conversions, narrowing floating-point values saturates and is
+        // done by runtime helper
+        case op_i2l:
+            as.loadSignExtend32(RAX, stackSlot(d - 1));
+            as.store(stackSlot(d - 1), RAX, true);
+            emitTag(d - 1, SlotTag::Long);
+            emitTag(d, SlotTag::Top);
+            break;
+        case op_l2i:
+            emitTag(d - 2, SlotTag::Int);
+            break;
+        case op_i2b:
+            as.loadSignExtend8(RAX, stackSlot(d - 1));
+            as.store(stackSlot(d - 1), RAX, false);
+            break;
+        case op_i2c:
+            as.loadZeroExtend16(RAX, stackSlot(d - 1));
+            as.store(stackSlot(d - 1), RAX, false);
+            break;
+        case op_i2s:
+            as.loadSignExtend16(RAX, stackSlot(d - 1));
+            as.store(stackSlot(d - 1), RAX, false);
+            break;
+        case op_i2f:
+        case op_l2f:
+        case op_i2d:
+        case op_l2d: {
+            const bool wide = opcode == op_l2f || opcode == op_l2d;
+            const bool toDouble = opcode == op_i2d || opcode == op_l2d;
+            const size_t slot = d - (wide ? 2 : 1);
+            const SsePrefix prefix = toDouble ? SseDouble : SseSingle;
+            as.sse(prefix, SseConvertInt, 0, stackSlot(slot), wide);
+            as.sse(prefix, SseStore, 0, stackSlot(slot));
+            emitTag(slot, toDouble ? SlotTag::Double : SlotTag::Float);
+            if (toDouble && !wide) {
+                emitTag(slot + 1, SlotTag::Top);
+            }
+            break;
+        }
+        case op_f2d:
+            as.sse(SseSingle, SseConvertFloat, 0, stackSlot(d - 1));
+            as.sse(SseDouble, SseStore, 0, stackSlot(d - 1));
+            emitTag(d - 1, SlotTag::Double);
+            emitTag(d, SlotTag::Top);
+            break;
+        case op_d2f:
+            as.sse(SseDouble, SseConvertFloat, 0, stackSlot(d - 2));
+            as.sse(SseSingle, SseStore, 0, stackSlot(d - 2));
+            emitTag(d - 2, SlotTag::Float);
+            break;
+
+        // Branches
+        case op_ifeq:
+        case op_ifne:
+        case op_iflt:
+        case op_ifge:
+        case op_ifgt:
+        case op_ifle:
+            as.load(RAX, stackSlot(d - 1), false);
+            as.test(RAX, RAX, false);
+            emitBranch(conditions[opcode - op_ifeq], insn.operand);
+            break;
+        case op_if_icmpeq:
+        case op_if_icmpne:
+        case op_if_icmplt:
+        case op_if_icmpge:
+        case op_if_icmpgt:
+        case op_if_icmple:
+            as.load(RAX, stackSlot(d - 2), false);
+            as.alu(AluCmp, RAX, stackSlot(d - 1), false);
+            emitBranch(conditions[opcode - op_if_icmpeq], insn.operand);
+            break;
+        case op_ifnull:
+        case op_ifnonnull:
+            as.load(RAX, stackSlot(d - 1), true);
+            as.test(RAX, RAX, true);
+            emitBranch(opcode == op_ifnull ? CondE : CondNE, insn.operand);
+            break;
+        case op_if_acmpeq:
+        case op_if_acmpne:
+            as.load(RDI, stackSlot(d - 2), true);
+            as.load(RSI, stackSlot(d - 1), true);
+            as.movImm(RAX, addressOf(&TemplateJIT::sameReference));
+            as.call(RAX);
+            as.zeroExtend8(RAX, RAX);
+            as.test(RAX, RAX, false);
+            emitBranch(opcode == op_if_acmpeq ? CondNE : CondE, insn.operand);
+            break;
+        case op_goto:
+            branches.emplace_back(as.jmp(), insn.operand);
+            break;
+        case op_tableswitch:
+        case op_lookupswitch:
+            as.movImm(RDI, addressOf(decoded->switchTables.data() +
+                                     insn.operand));
+            as.load(RSI, stackSlot(d - 1), false);
+            as.movImm(RAX, opcode == op_tableswitch
+                               ? addressOf(&TemplateJIT::tableSwitchTarget)
+                               : addressOf(&TemplateJIT::lookupSwitchTarget));
+            as.call(RAX);
+            as.mov(RAX, RAX, false);
+            as.movImm(RCX, addressOf(compiled->entries.data()));
+            as.jmpIndexed(RCX, RAX);
+            break;
+
+        // Return value is left in its slot and copied by caller
+        case op_ireturn:
+        case op_freturn:
+        case op_areturn:
+            emitReturn(d - 1);
+            break;
+        case op_lreturn:
+        case op_dreturn:
+            emitReturn(d - 2);
+            break;
+        case op_return:
+            emitReturn(0);
+            break;
+
+        // Instructions calling back into runtime
+        case op_idiv:
+        case op_ldiv:
+        case op_irem:
+        case op_lrem:
+        case op_frem:
+        case op_drem:
+        case op_f2i:
+        case op_f2l:
+        case op_d2i:
+        case op_d2l:
+        case op_fcmpl:
+        case op_fcmpg:
+        case op_dcmpl:
+        case op_dcmpg:
+        case op_iaload:
+        case op_laload:
+        case op_faload:
+        case op_daload:
+        case op_aaload:
+        case op_baload:
+        case op_caload:
+        case op_saload:
+        case op_iastore:
+        case op_lastore:
+        case op_fastore:
+        case op_dastore:
+        case op_aastore:
+        case op_bastore:
+        case op_castore:
+        case op_sastore:
+        case op_getstatic:
+        case op_putstatic:
+        case op_getfield:
+        case op_putfield:
+        case op_invokevirtual:
+        case op_invokespecial:
+        case op_invokestatic:
+        case op_invokeinterface:
+        case op_new:
+        case op_newarray:
+        case op_anewarray:
+        case op_arraylength:
+        case op_athrow:
+        case op_instanceof:
+            emitSlowPath(i, d);
+            break;
+        default:
+            // jsr/ret, monitors, checkcast, multianewarray, invokedynamic
+            // and reserved opcodes are left to interpreter
+            return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------
+// Execute an instruction that has no machine code template. sp points to the
+// operand stack of current frame before the instruction, the instruction
+// leaves its results on operand stack exactly as type inference assumed.
+// Returns false if it throws an exception
+//--------------------------------------------------------------------------------
+bool TemplateJIT::slowPath(JitContext* ctx, JValue* sp, u4 index) {
+    // Current frame is inspected by method invocation and GC
+    Slots* frame = ctx->frame;
+    frame->stackTop = static_cast<int>(sp - frame->stackSlots);
+    frame->pc = ctx->decoded->code.data() + index;
+    return execute(*ctx->interp, frame, ctx->jc, ctx->decoded, frame->pc, sp,
+                   ctx->thrown, ctx->error);
+}
+
+//--------------------------------------------------------------------------------
+// Execute an instruction of an inlined method. The frame stays suspended at
+// the invocation of compiled method the code was inlined at, whose reference
+// map describes its local variables, and operand stack reaches up to the
+// registers of inlined frames. An exception leaves inlined methods as if each
+// of them had a frame, so they all show up in its stack trace
+//--------------------------------------------------------------------------------
+bool TemplateJIT::inlinedPath(JitContext* ctx, JValue* sp, u4 argument) {
+    const vector<InlinedMethod>& inlined = ctx->compiled->inlined;
+    const InlinedMethod* method = &inlined[argument >> 16];
+    Slots* frame = ctx->frame;
+    frame->stackTop = static_cast<int>(sp - frame->stackSlots);
+    frame->pc = ctx->decoded->code.data() + method->invokeIndex;
+    if (execute(*ctx->interp, frame, method->jc, method->decoded,
+                method->decoded->code.data() + (argument & 0xffff), sp,
+                ctx->thrown, ctx->error)) {
+        return true;
+    }
+    if (!ctx->error) {
+        while (method != nullptr) {
+            ctx->interp->exception.extendExceptionStackTrace(
+                method->jc->getString(method->method->nameIndex));
+            method = method->caller >= 0 ? &inlined[method->caller] : nullptr;
+        }
+    }
+    return false;
+}
+
+bool TemplateJIT::execute(Interpreter& interp, Slots* frame,
+                          const JavaClass* jc, DecodedCode* decoded,
+                          Instruction* pc, JValue* sp, JValue& thrown,
+                          exception_ptr& error) {
+    try {
+        switch (originalOpcode(loadOpcode(pc))) {
+            case op_ldc:
+                interp.loadConstantPoolItem2Stack(jc, pc->index, sp);
+                break;
+            case op_idiv:
+                Interpreter::binaryArithmetic<JInt>(sp,
+                                                    IntegerDivides<int32_t>());
+                break;
+            case op_ldiv:
+                Interpreter::binaryArithmetic<JLong>(sp,
+                                                     IntegerDivides<int64_t>());
+                break;
+            case op_irem:
+                Interpreter::binaryArithmetic<JInt>(sp,
+                                                    IntegerModulus<int32_t>());
+                break;
+            case op_lrem:
+                Interpreter::binaryArithmetic<JLong>(sp,
+                                                     IntegerModulus<int64_t>());
+                break;
+            case op_frem:
+                Interpreter::binaryArithmetic<JFloat>(
+                    sp, [](float a, float b) -> float { return fmod(a, b); });
+                break;
+            case op_drem:
+                Interpreter::binaryArithmetic<JDouble>(
+                    sp,
+                    [](double a, double b) -> double { return fmod(a, b); });
+                break;
+            case op_f2i:
+                Interpreter::typeCast<JFloat, JInt>(sp);
+                break;
+            case op_f2l:
+                Interpreter::typeCast<JFloat, JLong>(sp);
+                break;
+            case op_d2i:
+                Interpreter::typeCast<JDouble, JInt>(sp);
+                break;
+            case op_d2l:
+                Interpreter::typeCast<JDouble, JLong>(sp);
+                break;
+            case op_fcmpl:
+            case op_fcmpg:
+                Interpreter::compareFloating<JFloat>(
+                    sp, pc->opcode == op_fcmpg ? 1 : -1);
+                break;
+            case op_dcmpl:
+            case op_dcmpg:
+                Interpreter::compareFloating<JDouble>(
+                    sp, pc->opcode == op_dcmpg ? 1 : -1);
+                break;
+            case op_iaload:
+            case op_baload:
+            case op_caload:
+            case op_saload:
+                Interpreter::arrayLoad<JInt>(sp);
+                break;
+            case op_laload:
+                Interpreter::arrayLoad<JLong>(sp);
+                break;
+            case op_faload:
+                Interpreter::arrayLoad<JFloat>(sp);
+                break;
+            case op_daload:
+                Interpreter::arrayLoad<JDouble>(sp);
+                break;
+            case op_aaload:
+                Interpreter::arrayLoad<JRef>(sp);
+                break;
+            case op_iastore:
+                Interpreter::arrayStore<JInt>(sp);
+                break;
+            case op_lastore:
+                Interpreter::arrayStore<JLong>(sp);
+                break;
+            case op_fastore:
+                Interpreter::arrayStore<JFloat>(sp);
+                break;
+            case op_dastore:
+                Interpreter::arrayStore<JDouble>(sp);
+                break;
+            case op_aastore:
+                Interpreter::arrayStore<JRef>(sp);
+                break;
+            case op_bastore:
+                Interpreter::arrayStore<JInt>(sp, [](int32_t value) {
+                    return static_cast<int8_t>(value);
+                });
+                break;
+            case op_sastore:
+                Interpreter::arrayStore<JInt>(sp, [](int32_t value) {
+                    return static_cast<int16_t>(value);
+                });
+                break;
+            case op_castore:
+                Interpreter::arrayStore<JInt>(sp, [](int32_t value) {
+                    return static_cast<uint16_t>(value);
+                });
+                break;
+            case op_getstatic:
+            case op_putstatic: {
+                const u1 opcode = loadOpcode(pc);
+                const bool isGet = originalOpcode(opcode) == op_getstatic;
+                const StaticFieldCache field =
+                    opcode == op_fast_getstatic || opcode == op_fast_putstatic
+                        ? decoded->staticFieldCaches[pc->operand]
+                        : interp.resolveStaticField(jc, decoded, pc);
+                if (isGet) {
+                    pushOperandValue(sp, unboxValue(*field.slot, field.type));
+                } else {
+                    putStaticValue(field,
+                                   Interpreter::popFieldValue(sp, field.type));
+                }
+                break;
+            }
+            case op_getfield:
+            case op_putfield: {
+                u1 opcode = loadOpcode(pc);
+                if (opcode == op_getfield || opcode == op_putfield) {
+                    Interpreter::quickenFieldAccess(jc, decoded, pc, sp);
+                    opcode = loadOpcode(pc);
+                }
+                const FieldCache& cache = decoded->fieldCaches[pc->operand];
+                if (opcode == op_fast_getfield) {
+                    JObject* objectref = popOperand<JObject>(sp);
+                    pushOperandValue(sp, getFieldValue(cache, objectref));
+                } else {
+                    const JValue value =
+                        Interpreter::popFieldValue(sp, cache.type);
+                    putFieldValue(cache, popOperand<JObject>(sp), value);
+                }
+                break;
+            }
+            case op_invokevirtual:
+            case op_invokespecial:
+            case op_invokestatic:
+            case op_invokeinterface: {
+                bool isObjectMethod = false;
+                const CallSite csite = interp.resolveInvocation(
+                    jc, decoded->inlineCaches.data(), pc, isObjectMethod);
+                if (!csite.isCallable()) {
+                    throw runtime_error("unsupported method invocation");
+                }
+                interp.invokeMethod(csite, isObjectMethod);
+                if (interp.exception.hasUnhandledException()) {
+                    // Callee pushed the exception it propagates onto our
+                    // operand stack
+                    thrown = frame->popSlot();
+                    return false;
+                }
+                break;
+            }
+            case op_new:
+                pushOperand<JObject>(sp, interp.execNew(jc, pc->index));
+                break;
+            case op_newarray: {
+                const int32_t count = popOperand<JInt>(sp);
+                pushOperand<JArray>(sp,
+                                    Interpreter::execNewArray(pc->index, count));
+                break;
+            }
+            case op_anewarray: {
+                const int32_t count = popOperand<JInt>(sp);
+                pushOperand<JArray>(
+                    sp, Interpreter::execANewArray(jc, pc->index, count));
+                break;
+            }
+            case op_arraylength: {
+                JArray* arrayref = popOperand<JArray>(sp);
+                if (arrayref == nullptr) {
+                    throw runtime_error("null pointer\n");
+                }
+                pushOperand<JInt>(sp, arrayref->length);
+                break;
+            }
+            case op_instanceof: {
+                auto* objectref = popOperand<JObject>(sp);
+                pushOperand<JInt>(
+                    sp, objectref != nullptr &&
+                                interp.checkInstanceof(jc, pc->index, objectref)
+                            ? 1
+                            : 0);
+                break;
+            }
+            case op_athrow: {
+                // Compiled methods have no exception handlers, so the
+                // exception always propagates to caller
+                JObject* throwobj = popOperand<JObject>(sp);
+                if (throwobj == nullptr) {
+                    throw runtime_error("null pointer");
+                }
+                if (!hasInheritanceRelationship(
+                        throwobj->jc,
+                        yrt.ma->loadClassIfAbsent("java/lang/Throwable"))) {
+                    throw runtime_error("it's not a throwable object");
+                }
+                if (!interp.exception.hasUnhandledException()) {
+                    interp.exception.markException();
+                    interp.exception.setThrowExceptionInfo(throwobj);
+                }
+                thrown = makeValue<JObject>(throwobj);
+                return false;
+            }
+            default:
+                throw runtime_error("no runtime helper for opcode " +
+                                    to_string(pc->opcode));
+        }
+    } catch (...) {
+        error = current_exception();
+        return false;
+    }
+    return true;
+}
+
+bool TemplateJIT::sameReference(const JType* value1, const JType* value2) {
+    return Interpreter::isSameReference(value1, value2);
+}
+
+int32_t TemplateJIT::tableSwitchTarget(const int32_t* table, int32_t key) {
+    // [default, low, high, target...]
+    if (key < table[1] || key > table[2]) {
+        return table[0];
+    }
+    return table[3 + (static_cast<int64_t>(key) - table[1])];
+}
+
+int32_t TemplateJIT::lookupSwitchTarget(const int32_t* table, int32_t key) {
+    // [default, npairs, match, target...], pairs are sorted by match value
+    int32_t low = 0;
+    int32_t high = table[1] - 1;
+    while (low <= high) {
+        const int32_t mid = low + (high - low) / 2;
+        const int32_t match = table[2 + mid * 2];
+        if (match == key) {
+            return table[3 + mid * 2];
+        } else if (match < key) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return table[0];
+}
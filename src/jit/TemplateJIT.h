@@ -0,0 +1,201 @@
+#ifndef YVM_TEMPLATEJIT_H
+#define YVM_TEMPLATEJIT_H
+
+#include <atomic>
+#include <exception>
+#include <utility>
+#include <vector>
+#include "../interpreter/CallSite.h"
+#include "../interpreter/TypeInference.h"
+#include "../runtime/JavaType.h"
+#include "../runtime/RuntimeEnv.h"
+#include "X86Assembler.h"
+
+class Interpreter;
+class Slots;
+struct JitContext;
+
+//--------------------------------------------------------------------------------
+// Machine code of a compiled method. It runs on the frame pushed for the
+// invocation with local variables in rbx, operand stack in r12 and JitContext
+// in r13, it returns the slot holding return value, or nullptr if an exception
+// was thrown. entries holds the address of each instruction, jump tables of
+// switches index into it. osrEntry takes over an interpreted activation and
+// continues from the instruction address given as its last argument, the
+// frame is laid out the same way for both tiers so nothing is migrated. Code
+// compiled ahead of time has neither entries nor osrEntry, see AotLoader
+//--------------------------------------------------------------------------------
+typedef JValue* (*CompiledEntry)(JitContext* ctx, JValue* locals,
+                                 JValue* stack);
+typedef JValue* (*OsrEntry)(JitContext* ctx, JValue* locals, JValue* stack,
+                            const void* start);
+
+//--------------------------------------------------------------------------------
+// A method inlined into a compiled method by optimizing compiler. Its frame is
+// not pushed, it lies above operand stack of the compiled method, which takes
+// extraStack more slots for the deepest one. caller is the inlined method it
+// was inlined into, or -1 for the compiled method, and invokeIndex is the
+// invocation of the compiled method whose inlined body it's part of
+//--------------------------------------------------------------------------------
+struct InlinedMethod {
+    const JavaClass* jc;
+    const MethodInfo* method;
+    DecodedCode* decoded;
+    int caller;
+    u4 invokeIndex;
+};
+
+//--------------------------------------------------------------------------------
+// dependencies are the methods optimizing compiler bound invocations to since
+// no loaded subclass of the paired class overrides them. Once a class that
+// does gets loaded the code is invalidated, its invocations are no longer
+// bound, and the method is compiled again when it gets hot again
+//--------------------------------------------------------------------------------
+struct CompiledMethod {
+    CompiledEntry entry;
+    OsrEntry osrEntry;
+    std::vector<const void*> entries;
+    std::vector<InlinedMethod> inlined;
+    u4 extraStack = 0;
+    std::vector<std::pair<const JavaClass*, const MethodInfo*>> dependencies;
+    std::atomic<bool> invalidated{false};
+};
+
+//--------------------------------------------------------------------------------
+// Baseline compiler. A hot method is translated by stitching together machine
+// code templates of its instructions, the depth of operand stack before every
+// instruction is known from type inference, so operand stack slots are
+// addressed directly and never pushed or popped at runtime. Instructions
+// touching heap, constant pool or other methods call back into runtime
+// helpers. Methods that have exception handlers or instructions without
+// template are left to interpreter
+//--------------------------------------------------------------------------------
+class TemplateJIT {
+    friend class AotLoader;
+
+public:
+    // Count an invocation of given bytecode method and compile it once it got
+    // hot. Returns the compiled code to run the invocation, or nullptr if
+    // interpreter should run it
+    static CompiledMethod* enter(const CallSite& csite) {
+        return yrt.jit || yrt.aot ? prepare(csite) : nullptr;
+    }
+
+    // Count an iteration of given loop of an interpreted method, loop is the
+    // counter index of its backward branch. Returns the compiled code to
+    // continue current activation once the loop got hot, or nullptr if
+    // interpreter should keep running it
+    static CompiledMethod* backedge(const JavaClass* jc, const MethodInfo* m,
+                                    DecodedCode* decoded, u2 loop) {
+        return yrt.jit ? countBackedge(jc, m, decoded, loop) : nullptr;
+    }
+
+    // Run compiled code on top frame, which was pushed for the invocation.
+    // Like Interpreter::execByteCode(), it returns the thrown object if the
+    // method completes abruptly
+    static JValue run(Interpreter& interp, const CallSite& csite,
+                      CompiledMethod* compiled);
+
+    // On-stack replacement, the interpreted activation of top frame continues
+    // in compiled code from instruction start until the method completes
+    static JValue runOsr(Interpreter& interp, CompiledMethod* compiled,
+                         u4 start);
+
+    // Invalidate code compiled for decoded, see CompiledMethod. Activations
+    // running it keep running it, so it's never freed
+    static void invalidate(DecodedCode* decoded, CompiledMethod* compiled);
+
+protected:
+    TemplateJIT(const JavaClass* jc, DecodedCode* decoded,
+                const std::vector<TypeState>* states,
+                CompiledMethod* compiled);
+    virtual ~TemplateJIT() = default;
+
+    // Operand stack slots are addressed from r12 and local variables from
+    // rbx, each slot is 16 bytes
+    static Mem stackSlot(size_t slot, int32_t offset = 0);
+    static Mem localSlot(size_t slot, int32_t offset = 0);
+
+    template <typename Function>
+    static uint64_t addressOf(Function function) {
+        return reinterpret_cast<uint64_t>(function);
+    }
+
+    // Copy assembled code into code cache, returns nullptr if it's exhausted
+    static const uint8_t* install(const X86Assembler& as);
+
+    // Assemble the method and install it into compiled, returns false if it
+    // could not be compiled
+    bool assemble();
+
+    // Machine code of method body, the offset of each instruction is
+    // recorded into offsets
+    virtual bool emitBody();
+    void emitPrologue();
+    bool emitInstruction(u4 i, size_t depth);
+    virtual void emitSlowPath(u4 i, size_t depth);
+    void emitHelperCall(uint64_t helper, u4 argument, size_t depth);
+    void emitShuffle(const SlotTag* tags, size_t depth, size_t popped,
+                     const char* pushed);
+    void emitLoadSlot(Reg dst, Mem src, SlotTag tag);
+    void emitStoreSlot(Mem dst, Reg src, SlotTag tag);
+    void emitTag(size_t slot, SlotTag tag);
+    void emitConstant(size_t slot, uint64_t bits, SlotTag tag);
+    void emitBranch(Cond cond, int32_t target);
+    // Jump to misses unless receiver holds a non-null object, which must be
+    // of receiverClass if it's not nullptr
+    void emitClassGuard(Mem receiver, const JavaClass* receiverClass,
+                        std::vector<size_t>& misses);
+
+    // Execute instruction pc of given method by runtime helpers, see
+    // slowPath(). frame is the top frame running the method, which was
+    // suspended at sp by caller, it may be nullptr if the instruction is not
+    // an invocation
+    static bool execute(Interpreter& interp, Slots* frame,
+                        const JavaClass* jc, DecodedCode* decoded,
+                        Instruction* pc, JValue* sp, JValue& thrown,
+                        std::exception_ptr& error);
+    static int32_t tableSwitchTarget(const int32_t* table, int32_t key);
+    static int32_t lookupSwitchTarget(const int32_t* table, int32_t key);
+    static bool sameReference(const JType* value1, const JType* value2);
+    // Runtime helper executing instructions of inlined methods, argument is
+    // the index of the method in upper half and the instruction in lower half
+    static bool inlinedPath(JitContext* ctx, JValue* sp, u4 argument);
+
+    // Instruction templates read the method they belong to from these
+    const JavaClass* jc;
+    DecodedCode* decoded;
+    const std::vector<TypeState>* states;
+    X86Assembler as;
+    CompiledMethod* compiled;
+    // Code offset of each instruction, branches waiting for their targets,
+    // exits of returning instructions and exits to exception path
+    std::vector<size_t> offsets;
+    std::vector<std::pair<size_t, int32_t>> branches;
+    std::vector<size_t> returnExits;
+    std::vector<size_t> exceptionExits;
+
+private:
+    static CompiledMethod* prepare(const CallSite& csite);
+    static CompiledMethod* countBackedge(const JavaClass* jc,
+                                         const MethodInfo* m,
+                                         DecodedCode* decoded, u2 loop);
+    static CompiledMethod* compiledCode(const JavaClass* jc,
+                                        const MethodInfo* m,
+                                        DecodedCode* decoded);
+    static CompiledMethod* compile(const JavaClass* jc, const MethodInfo* m,
+                                   DecodedCode* decoded);
+    static JValue complete(const JitContext& ctx, const JValue* result,
+                           const MethodInfo* m);
+
+    bool emitMethod();
+    void emitReturn(size_t slot);
+
+    // Runtime helper called by compiled code
+    static bool slowPath(JitContext* ctx, JValue* sp, u4 index);
+
+    // Code offset of the entry of on-stack replacement
+    size_t osrOffset = 0;
+};
+
+#endif  // YVM_TEMPLATEJIT_H
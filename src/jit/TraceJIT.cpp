@@ -0,0 +1,559 @@
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include "../interpreter/Decoder.h"
+#include "../interpreter/Interpreter.hpp"
+#include "../misc/Option.h"
+#include "../runtime/JavaClass.h"
+#include "TraceJIT.h"
+
+// Traces follow System V AMD64 calling convention like compiled methods
+#if defined(__x86_64__) && !defined(_WIN32)
+#define YVM_JIT_SUPPORTED
+#endif
+
+using namespace std;
+
+//--------------------------------------------------------------------------------
+// State of a running trace shared with runtime helpers, see JitContext
+//--------------------------------------------------------------------------------
+struct TraceContext {
+    Interpreter* interp;
+    Slots* root;
+    const CompiledTrace* trace;
+    JValue thrown;
+    exception_ptr error;
+};
+
+static const int32_t TAG_OFFSET = offsetof(JValue, tag);
+
+static bool isInvocation(u1 opcode) {
+    return opcode >= op_invokevirtual && opcode <= op_invokeinterface;
+}
+
+static bool isReturn(u1 opcode) {
+    return opcode >= op_ireturn && opcode <= op_return;
+}
+
+CompiledTrace* TraceJIT::backedge(DecodedCode* decoded, u2 loop,
+                                  bool& record) {
+    LoopProfile& profile = decoded->loops[loop - 1];
+    CompiledTrace* trace = profile.trace.load(memory_order_acquire);
+    if (trace != nullptr) {
+        return trace;
+    }
+    const u4 count = profile.backedges.load(memory_order_relaxed);
+    if (count < yrt.traceThreshold) {
+        profile.backedges.store(count + 1, memory_order_relaxed);
+        return nullptr;
+    }
+    // Counting starts over, a loop whose recording was given up is recorded
+    // again after another round until it failed too many times
+    profile.backedges.store(0, memory_order_relaxed);
+    const u1 attempts = profile.traceAttempts.load(memory_order_relaxed);
+    if (attempts < YVM_TRACE_MAX_ATTEMPTS) {
+        profile.traceAttempts.store(attempts + 1, memory_order_relaxed);
+        record = true;
+    }
+    return nullptr;
+}
+
+bool TraceJIT::run(Interpreter& interp, const CompiledTrace* trace) {
+    // Inlined frames are placed relative to the end of operand stack of top
+    // frame, which must be where it was when the trace was recorded
+    Slots* frame = interp.frames->top();
+    if (frame->maxStack != trace->frames[0].maxStack ||
+        !interp.frames->hasRoom(frame->localSlots + trace->extent,
+                                trace->depth)) {
+        return false;
+    }
+    TraceContext ctx{&interp, frame, trace, JValue{}, nullptr};
+    trace->entry(&ctx, frame->localSlots, frame->stackSlots);
+    if (ctx.error) {
+        rethrow_exception(ctx.error);
+    }
+    return true;
+}
+
+CompiledTrace* TraceJIT::compile(const vector<TraceFrame>& frames,
+                                 const vector<TraceStep>& steps, u4 header) {
+#ifdef YVM_JIT_SUPPORTED
+    // A method is inferred once however many times it was inlined
+    map<const DecodedCode*, vector<TypeState>> inferred;
+    vector<const vector<TypeState>*> frameStates;
+    for (const TraceFrame& frame : frames) {
+        auto iter = inferred.find(frame.decoded);
+        if (iter == inferred.end()) {
+            iter = inferred.emplace(frame.decoded, vector<TypeState>()).first;
+            if (!inferTypes(frame.jc, frame.method, frame.decoded,
+                            iter->second)) {
+                return nullptr;
+            }
+        }
+        frameStates.push_back(&iter->second);
+    }
+
+    TraceJIT compiler(frames, steps, frameStates);
+    if (!compiler.emitTrace(header)) {
+        return nullptr;
+    }
+    const uint8_t* base = install(compiler.as);
+    if (base == nullptr) {
+        return nullptr;
+    }
+    auto* trace = new CompiledTrace;
+    trace->entry = reinterpret_cast<TraceEntry>(base);
+    trace->frames = frames;
+    trace->sites = move(compiler.sites);
+    trace->extent = 0;
+    trace->depth = 0;
+    for (const TraceFrame& frame : frames) {
+        trace->extent = max(trace->extent,
+                            frame.base + frame.maxLocal + frame.maxStack);
+        trace->depth = max(trace->depth, frame.level);
+    }
+    return trace;
+#else
+    return nullptr;
+#endif
+}
+
+TraceJIT::TraceJIT(const vector<TraceFrame>& frames,
+                   const vector<TraceStep>& steps,
+                   const vector<const vector<TypeState>*>& frameStates)
+    : TemplateJIT(frames[0].jc, frames[0].decoded, frameStates[0], nullptr),
+      frames(frames),
+      steps(steps),
+      frameStates(frameStates) {}
+
+bool TraceJIT::emitTrace(u4 header) {
+    emitPrologue();
+    // r14 keeps local variables of frame 0, inlined frames are addressed
+    // from there
+    as.mov(R14, RSI, true);
+
+    const size_t loopStart = as.size();
+    FOR_EACH(s, steps.size()) {
+        const TraceStep next =
+            s + 1 < steps.size() ? steps[s + 1] : TraceStep{0, header, 0};
+        if (!emitStep(steps[s], next)) {
+            return false;
+        }
+    }
+    switchFrame(0);
+    as.bind(as.jmp(), loopStart);
+
+    // Each side exit passes its site to sideExit(), which leaves frames the
+    // way interpreter would have them before the instruction of the site
+    vector<size_t> exitJumps;
+    for (const auto& exit : exits) {
+        as.bind(exit.first, as.size());
+        as.movImm(RSI, exit.second);
+        exitJumps.push_back(as.jmp());
+    }
+    const size_t exitPath = as.size();
+    as.mov(RDI, R13, true);
+    as.movImm(RAX, addressOf(&TraceJIT::sideExit));
+    as.call(RAX);
+    const size_t epilogue = as.size();
+    as.pop(R14);
+    as.pop(R13);
+    as.pop(R12);
+    as.pop(RBX);
+    as.pop(RBP);
+    as.ret();
+
+    for (size_t jump : exitJumps) {
+        as.bind(jump, exitPath);
+    }
+    // Helpers that threw already left frames to interpreter
+    for (size_t exit : exceptionExits) {
+        as.bind(exit, epilogue);
+    }
+    return true;
+}
+
+bool TraceJIT::emitStep(const TraceStep& step, const TraceStep& next) {
+    switchFrame(step.frame);
+
+    // A superinstruction is compiled as its components. One that stopped
+    // halfway, since its second half had to be quickened first, continues
+    // with the next recorded step
+    u4 count = superinstructionLength(loadOpcode(&decoded->code[step.index]));
+    if (next.frame == step.frame && next.index > step.index &&
+        next.index < step.index + count) {
+        count = next.index - step.index;
+    }
+    FOR_EACH(k, count) {
+        const u4 i = step.index + k;
+        const TypeState& state = (*states)[i];
+        if (!state.reached || (k == 0 && state.stack.size() != step.depth)) {
+            return false;
+        }
+        const TraceStep following =
+            k + 1 < count ? TraceStep{step.frame, i + 1, 0} : next;
+        if (!emitTraced(i, state.stack.size(), following)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TraceJIT::emitTraced(u4 i, size_t depth, const TraceStep& next) {
+    const Instruction& insn = decoded->code[i];
+    const u1 opcode = originalOpcode(loadOpcode(&insn));
+    const bool fallsThrough = next.frame == current && next.index == i + 1;
+    const bool jumps = next.frame == current &&
+                       next.index == static_cast<u4>(insn.operand);
+
+    switch (opcode) {
+        case op_goto:
+            return jumps;
+        case op_ifeq:
+        case op_ifne:
+        case op_iflt:
+        case op_ifge:
+        case op_ifgt:
+        case op_ifle:
+        case op_if_icmpeq:
+        case op_if_icmpne:
+        case op_if_icmplt:
+        case op_if_icmpge:
+        case op_if_icmpgt:
+        case op_if_icmple:
+        case op_if_acmpeq:
+        case op_if_acmpne:
+        case op_ifnull:
+        case op_ifnonnull: {
+            if (!(jumps || fallsThrough) || !emitInstruction(i, depth)) {
+                return false;
+            }
+            // The template branches to the target, a guard leaves the trace
+            // on the direction that was not recorded instead
+            const size_t fixup = branches.back().first;
+            branches.pop_back();
+            if (jumps && fallsThrough) {
+                as.bind(fixup, as.size());
+            } else {
+                if (jumps) {
+                    as.invert(fixup);
+                }
+                exits.emplace_back(fixup, site(i, depth));
+            }
+            return true;
+        }
+        case op_tableswitch:
+        case op_lookupswitch:
+            if (next.frame != current) {
+                return false;
+            }
+            as.movImm(RDI, addressOf(decoded->switchTables.data() +
+                                     insn.operand));
+            as.load(RSI, stackSlot(depth - 1), false);
+            as.movImm(RAX, opcode == op_tableswitch
+                               ? addressOf(&TemplateJIT::tableSwitchTarget)
+                               : addressOf(&TemplateJIT::lookupSwitchTarget));
+            as.call(RAX);
+            as.movImm(RCX, next.index);
+            as.alu(AluCmp, RAX, RCX, false);
+            exits.emplace_back(as.jcc(CondNE), site(i, depth));
+            return true;
+        case op_invokevirtual:
+        case op_invokespecial:
+        case op_invokestatic:
+        case op_invokeinterface:
+            if (next.frame != current) {
+                const TraceFrame& callee = frames[next.frame];
+                if (callee.parent != static_cast<int>(current) ||
+                    callee.invokeIndex != i || next.index != 0) {
+                    return false;
+                }
+                if (callee.receiverClass != nullptr) {
+                    emitReceiverGuard(callee, i, depth);
+                }
+                // Local variables after arguments are cleared the same way
+                // JavaFrame::pushFrame() does, in case the frame is
+                // materialized later
+                for (int k = callee.argSlots; k < callee.maxLocal; k++) {
+                    as.storeImm8(
+                        Mem{R14, static_cast<int32_t>((callee.base + k) *
+                                                      sizeof(JValue)) +
+                                     TAG_OFFSET},
+                        static_cast<uint8_t>(SlotTag::Top));
+                }
+                return true;
+            }
+            if (!fallsThrough) {
+                return false;
+            }
+            emitSlowPath(i, depth);
+            return true;
+        case op_ireturn:
+        case op_lreturn:
+        case op_freturn:
+        case op_dreturn:
+        case op_areturn:
+        case op_return: {
+            const TraceFrame& callee = frames[current];
+            if (callee.level == 0 ||
+                next.frame != static_cast<u4>(callee.parent) ||
+                next.index != callee.invokeIndex + 1) {
+                return false;
+            }
+            emitInlinedReturn(i, depth);
+            return true;
+        }
+        default:
+            return fallsThrough && emitInstruction(i, depth);
+    }
+}
+
+void TraceJIT::emitReceiverGuard(const TraceFrame& callee, u4 i,
+                                 size_t depth) {
+    // A null receiver exits too, interpreter then throws
+    const u4 exit = site(i, depth);
+    vector<size_t> misses;
+    emitClassGuard(stackSlot(depth - callee.argSlots), callee.receiverClass,
+                   misses);
+    for (size_t miss : misses) {
+        exits.emplace_back(miss, exit);
+    }
+}
+
+void TraceJIT::emitInlinedReturn(u4 i, size_t depth) {
+    // Return value goes where caller had its arguments, which is where
+    // interpreter would push it after popping the frame
+    const TraceFrame& callee = frames[current];
+    const TraceFrame& caller = frames[callee.parent];
+    const int32_t result = caller.base + caller.maxLocal +
+                           static_cast<int32_t>(callee.invokeDepth) -
+                           callee.argSlots;
+    const TypeState& state = (*states)[i];
+    size_t n = 0;
+    switch (originalOpcode(loadOpcode(&decoded->code[i]))) {
+        case op_ireturn:
+        case op_freturn:
+        case op_areturn:
+            n = 1;
+            break;
+        case op_lreturn:
+        case op_dreturn:
+            n = 2;
+            break;
+        default:
+            break;
+    }
+    FOR_EACH(k, n) {
+        const SlotTag tag = state.stack[depth - n + k];
+        emitLoadSlot(RAX, stackSlot(depth - n + k), tag);
+        emitStoreSlot(
+            Mem{R14, static_cast<int32_t>((result + k) * sizeof(JValue))},
+            RAX, tag);
+    }
+}
+
+void TraceJIT::emitSlowPath(u4 i, size_t depth) {
+    emitHelperCall(addressOf(&TraceJIT::slowPath), site(i, depth), depth);
+}
+
+void TraceJIT::switchFrame(u4 index) {
+    const TraceFrame& frame = frames[index];
+    jc = frame.jc;
+    decoded = frame.decoded;
+    states = frameStates[index];
+    if (index != current) {
+        as.lea(RBX,
+               Mem{R14, static_cast<int32_t>(frame.base * sizeof(JValue))});
+        as.lea(R12, localSlot(frame.maxLocal));
+        current = index;
+    }
+}
+
+u4 TraceJIT::site(u4 i, size_t depth) {
+    sites.push_back(TraceStep{current, i, static_cast<u4>(depth)});
+    return static_cast<u4>(sites.size() - 1);
+}
+
+//--------------------------------------------------------------------------------
+// Execute an instruction of the trace that has no machine code template. Only
+// a method invocation within an inlined frame needs the frames of inlined
+// calls materialized, they are popped again once it returned
+//--------------------------------------------------------------------------------
+bool TraceJIT::slowPath(TraceContext* ctx, JValue* sp, u4 site) {
+    const TraceStep& step = ctx->trace->sites[site];
+    const TraceFrame& traced = ctx->trace->frames[step.frame];
+    Instruction* pc = traced.decoded->code.data() + step.index;
+
+    Slots* frame = ctx->root;
+    if (traced.level > 0) {
+        frame = isInvocation(originalOpcode(loadOpcode(pc)))
+                    ? materialize(ctx, step.frame)
+                    : nullptr;
+    }
+    if (frame != nullptr) {
+        frame->stackTop = static_cast<int>(sp - frame->stackSlots);
+        frame->pc = pc;
+    }
+    if (execute(*ctx->interp, frame, traced.jc, traced.decoded, pc, sp,
+                ctx->thrown, ctx->error)) {
+        if (frame != nullptr && frame != ctx->root) {
+            FOR_EACH(k, traced.level) { ctx->interp->frames->popFrame(); }
+        }
+        return true;
+    }
+    // Interpreter finds the exception on operand stack of the frame it
+    // resumes in, as if a call it made had thrown
+    if (!ctx->error && frame != nullptr) {
+        frame->pushSlot(ctx->thrown);
+    }
+    return false;
+}
+
+void TraceJIT::sideExit(TraceContext* ctx, u4 site) {
+    const TraceStep& step = ctx->trace->sites[site];
+    Slots* frame = materialize(ctx, step.frame);
+    frame->pc =
+        ctx->trace->frames[step.frame].decoded->code.data() + step.index;
+    frame->stackTop = static_cast<int>(step.depth);
+}
+
+Slots* TraceJIT::materialize(TraceContext* ctx, u4 frame) {
+    if (frame == 0) {
+        return ctx->root;
+    }
+    const TraceFrame& traced = ctx->trace->frames[frame];
+    const TraceFrame& parent = ctx->trace->frames[traced.parent];
+    Slots* caller = materialize(ctx, static_cast<u4>(traced.parent));
+    caller->pc = parent.decoded->code.data() + traced.invokeIndex;
+    caller->stackTop = static_cast<int>(traced.invokeDepth);
+
+    // Room was checked before entering the trace, and local variables were
+    // already written in place
+    JavaFrame* frames = ctx->interp->frames;
+    if (!frames->pushFrame(traced.maxLocal, traced.maxStack, traced.argSlots,
+                           false)) {
+        throw runtime_error("frame stack exhausted");
+    }
+    Slots* slots = frames->top();
+    slots->jc = traced.jc;
+    slots->method = traced.method;
+    slots->decoded = traced.decoded;
+    return slots;
+}
+
+TraceRecorder::TraceRecorder(Slots* root, u2 loop, u4 header)
+    : root(root), loop(loop), header(header) {
+    frames.push_back(TraceFrame{root->jc, root->method, root->decoded, -1, 0,
+                                0, 0, 0, root->maxLocal, root->maxStack, 0,
+                                nullptr});
+    active.push_back(root);
+    activeFrames.push_back(0);
+}
+
+bool TraceRecorder::record(Slots* frame, const Instruction* pc,
+                           const JValue* sp) {
+    // Every frame change is either a call from or a return to the frame
+    // recorded last, anything else left the loop
+    if (frame != active.back()) {
+        if (frame->next == active.back()) {
+            if (!enter(frame)) {
+                return false;
+            }
+        } else if (active.size() > 1 && frame == active[active.size() - 2]) {
+            active.pop_back();
+            activeFrames.pop_back();
+        } else {
+            return false;
+        }
+    }
+
+    const u4 current = activeFrames.back();
+    const u4 index = static_cast<u4>(pc - frame->decoded->code.data());
+    if (current == 0 && index == header && !steps.empty()) {
+        finish();
+        return false;
+    }
+    // An instruction quickened in place is dispatched once more
+    if (!steps.empty() && steps.back().frame == current &&
+        steps.back().index == index) {
+        return true;
+    }
+
+    const u1 opcode = originalOpcode(loadOpcode(pc));
+    switch (opcode) {
+        case op_athrow:
+        case op_checkcast:
+        case op_monitorenter:
+        case op_monitorexit:
+        case op_multianewarray:
+        case op_invokedynamic:
+        case op_jsr:
+        case op_ret:
+        case op_jsr_w:
+            return false;
+        default:
+            if (current == 0 && isReturn(opcode)) {
+                return false;
+            }
+            break;
+    }
+    if (steps.size() == YVM_TRACE_MAX_LENGTH) {
+        return false;
+    }
+    steps.push_back(TraceStep{current, index,
+                              static_cast<u4>(sp - frame->stackSlots)});
+    return true;
+}
+
+bool TraceRecorder::enter(Slots* frame) {
+    if (steps.empty() || active.size() > YVM_TRACE_MAX_INLINE_DEPTH) {
+        return false;
+    }
+    const TraceStep& invoke = steps.back();
+    Slots* caller = active.back();
+    const u1 opcode =
+        originalOpcode(loadOpcode(&caller->decoded->code[invoke.index]));
+    if (invoke.frame != activeFrames.back() || !isInvocation(opcode)) {
+        return false;
+    }
+
+    // Guards of virtual calls compare the class of receiver, calls on arrays
+    // are not inlined
+    const JavaClass* receiverClass = nullptr;
+    if (opcode == op_invokevirtual || opcode == op_invokeinterface) {
+        auto* receiver = dynamic_cast<JObject*>(frame->localSlots[0].ref);
+        if (receiver == nullptr) {
+            return false;
+        }
+        receiverClass = receiver->jc;
+    }
+    // A method without parameters gets its frame after the whole operand
+    // stack of caller instead
+    const ptrdiff_t argSlots =
+        caller->stackSlots + invoke.depth - frame->localSlots;
+    frames.push_back(TraceFrame{
+        frame->jc, frame->method, frame->decoded,
+        static_cast<int>(activeFrames.back()), static_cast<int>(active.size()),
+        invoke.index, invoke.depth,
+        static_cast<int>(max<ptrdiff_t>(argSlots, 0)), frame->maxLocal,
+        frame->maxStack,
+        static_cast<int32_t>(frame->localSlots - root->localSlots),
+        receiverClass});
+    active.push_back(frame);
+    activeFrames.push_back(static_cast<u4>(frames.size() - 1));
+    return true;
+}
+
+void TraceRecorder::finish() {
+    CompiledTrace* trace = TraceJIT::compile(frames, steps, header);
+    if (trace == nullptr) {
+        return;
+    }
+    // Another thread may have compiled the same loop meanwhile, its machine
+    // code stays in code cache
+    CompiledTrace* expected = nullptr;
+    if (!root->decoded->loops[loop - 1].trace.compare_exchange_strong(
+            expected, trace)) {
+        delete trace;
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef YVM_TRACEJIT_H
+#define YVM_TRACEJIT_H
+
+#include <vector>
+#include "TemplateJIT.h"
+
+struct TraceContext;
+
+//--------------------------------------------------------------------------------
+// An activation taking part in a trace. Frame 0 runs the loop, any other frame
+// was entered by invocation instruction invokeIndex of its parent, whose
+// operand stack was invokeDepth slots deep before it. base is the distance
+// from local variables of frame 0 to its local variables, in slots, it's the
+// same every iteration since frames are pushed in place of their arguments.
+// Virtual and interface calls were made on an object of receiverClass
+//--------------------------------------------------------------------------------
+struct TraceFrame {
+    const JavaClass* jc;
+    const MethodInfo* method;
+    DecodedCode* decoded;
+    int parent;
+    int level;
+    u4 invokeIndex;
+    u4 invokeDepth;
+    int argSlots;
+    int maxLocal;
+    int maxStack;
+    int32_t base;
+    const JavaClass* receiverClass;
+};
+
+// A recorded instruction, and the depth of operand stack before it
+struct TraceStep {
+    u4 frame;
+    u4 index;
+    u4 depth;
+};
+
+//--------------------------------------------------------------------------------
+// Machine code of a trace. It runs on the frame of the loop with the same
+// register assignment as compiled methods, frames of inlined calls are laid
+// out above it exactly where interpreter would push them but they are only
+// materialized when the trace exits inside a callee. A side exit or a runtime
+// helper refers to the instruction it belongs to by an index of sites
+//--------------------------------------------------------------------------------
+typedef void (*TraceEntry)(TraceContext* ctx, JValue* locals, JValue* stack);
+
+struct CompiledTrace {
+    TraceEntry entry;
+    std::vector<TraceFrame> frames;
+    std::vector<TraceStep> sites;
+    // Slots used above local variables of frame 0 and the deepest level of
+    // inlined calls
+    int32_t extent;
+    int depth;
+};
+
+//--------------------------------------------------------------------------------
+// Trace compiler, which is enabled by --trace. Once a loop got hot, interpreter
+// records the instructions executed in one iteration, following calls into
+// their callees, and the linear path is compiled by instruction templates of
+// baseline compiler. Conditional branches become guards which exit to
+// interpreter when they go the other way than recorded, and inlined virtual
+// calls are guarded by the class of their receivers. Everything else is known
+// from type inference of each method, so no other guards are needed
+//--------------------------------------------------------------------------------
+class TraceJIT : public TemplateJIT {
+public:
+    // Count an iteration of given loop. Returns its trace if it was compiled,
+    // otherwise record is set if the loop should be recorded from now on
+    static CompiledTrace* backedge(DecodedCode* decoded, u2 loop, bool& record);
+
+    // Run the trace on top frame, which is at the loop header. Returns false
+    // if frames of inlined calls would not fit in frame stack, otherwise the
+    // trace ran until it exited and top frame is where interpreter resumes
+    static bool run(Interpreter& interp, const CompiledTrace* trace);
+
+    // Compile a recorded iteration of loop whose header is instruction
+    // header of frame 0
+    static CompiledTrace* compile(const std::vector<TraceFrame>& frames,
+                                  const std::vector<TraceStep>& steps,
+                                  u4 header);
+
+private:
+    TraceJIT(const std::vector<TraceFrame>& frames,
+             const std::vector<TraceStep>& steps,
+             const std::vector<const std::vector<TypeState>*>& frameStates);
+
+    bool emitTrace(u4 header);
+    bool emitStep(const TraceStep& step, const TraceStep& next);
+    bool emitTraced(u4 i, size_t depth, const TraceStep& next);
+    void emitReceiverGuard(const TraceFrame& callee, u4 i, size_t depth);
+    void emitInlinedReturn(u4 i, size_t depth);
+    void emitSlowPath(u4 i, size_t depth) override;
+    void switchFrame(u4 index);
+    u4 site(u4 i, size_t depth);
+
+    // Runtime helpers called by trace
+    static bool slowPath(TraceContext* ctx, JValue* sp, u4 site);
+    static void sideExit(TraceContext* ctx, u4 site);
+    static Slots* materialize(TraceContext* ctx, u4 frame);
+
+    const std::vector<TraceFrame>& frames;
+    const std::vector<TraceStep>& steps;
+    const std::vector<const std::vector<TypeState>*>& frameStates;
+    u4 current = 0;
+    std::vector<TraceStep> sites;
+    // Guards waiting for side exit stubs, and the site each one exits at
+    std::vector<std::pair<size_t, u4>> exits;
+};
+
+//--------------------------------------------------------------------------------
+// Records the instructions interpreter executes from the header of a hot loop
+// until control comes back to it in the same frame. Recording gives up when
+// the method returns or throws, when calls nest too deep or the trace gets
+// too long, and on instructions a trace can not contain
+//--------------------------------------------------------------------------------
+class TraceRecorder {
+public:
+    TraceRecorder(Slots* root, u2 loop, u4 header);
+
+    // Record the instruction at pc which frame is about to execute, sp is its
+    // operand stack pointer. Returns false once recording ended, the trace
+    // was then compiled or given up
+    bool record(Slots* frame, const Instruction* pc, const JValue* sp);
+
+private:
+    bool enter(Slots* frame);
+    void finish();
+
+    Slots* root;
+    u2 loop;
+    u4 header;
+    std::vector<TraceFrame> frames;
+    std::vector<TraceStep> steps;
+    // Slots and trace frame of every level of calls made so far
+    std::vector<Slots*> active;
+    std::vector<u4> activeFrames;
+};
+
+#endif  // YVM_TRACEJIT_H
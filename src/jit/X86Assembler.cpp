@@ -0,0 +1,225 @@
+#include "X86Assembler.h"
+
+using namespace std;
+
+void X86Assembler::emit32(uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        emit(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+void X86Assembler::rex(bool wide, int reg, int index, int base) {
+    const uint8_t prefix = 0x40 | (wide ? 0x08 : 0) | ((reg >> 3) << 2) |
+                           ((index >> 3) << 1) | (base >> 3);
+    if (prefix != 0x40) {
+        emit(prefix);
+    }
+}
+
+void X86Assembler::encode(uint8_t prefix, bool wide,
+                          initializer_list<uint8_t> op, int reg, Mem rm) {
+    if (prefix != 0) {
+        emit(prefix);
+    }
+    rex(wide, reg, 0, rm.base);
+    for (uint8_t byte : op) {
+        emit(byte);
+    }
+    // A displacement is always present so rbp and r13 need no special
+    // treatment, rsp and r12 as base register require a SIB byte
+    const bool shortDisp = rm.disp >= -128 && rm.disp <= 127;
+    emit(static_cast<uint8_t>((shortDisp ? 0x40 : 0x80) | ((reg & 7) << 3) |
+                              (rm.base & 7)));
+    if ((rm.base & 7) == RSP) {
+        emit(0x24);
+    }
+    if (shortDisp) {
+        emit(static_cast<uint8_t>(rm.disp));
+    } else {
+        emit32(static_cast<uint32_t>(rm.disp));
+    }
+}
+
+void X86Assembler::encode(uint8_t prefix, bool wide,
+                          initializer_list<uint8_t> op, int reg, int rm) {
+    if (prefix != 0) {
+        emit(prefix);
+    }
+    rex(wide, reg, 0, rm);
+    for (uint8_t byte : op) {
+        emit(byte);
+    }
+    emit(static_cast<uint8_t>(0xc0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+void X86Assembler::load(Reg dst, Mem src, bool wide) {
+    encode(0, wide, {0x8b}, dst, src);
+}
+
+void X86Assembler::store(Mem dst, Reg src, bool wide) {
+    encode(0, wide, {0x89}, src, dst);
+}
+
+void X86Assembler::storeImm8(Mem dst, uint8_t imm) {
+    encode(0, false, {0xc6}, 0, dst);
+    emit(imm);
+}
+
+void X86Assembler::storeImm32(Mem dst, int32_t imm, bool wide) {
+    // The immediate is sign-extended to 64 bits for a wide store
+    encode(0, wide, {0xc7}, 0, dst);
+    emit32(static_cast<uint32_t>(imm));
+}
+
+void X86Assembler::movImm(Reg dst, uint64_t imm) {
+    if (imm <= 0xffffffffu) {
+        // Writing a 32-bit register clears its upper half
+        rex(false, 0, 0, dst);
+        emit(static_cast<uint8_t>(0xb8 + (dst & 7)));
+        emit32(static_cast<uint32_t>(imm));
+    } else {
+        rex(true, 0, 0, dst);
+        emit(static_cast<uint8_t>(0xb8 + (dst & 7)));
+        emit32(static_cast<uint32_t>(imm));
+        emit32(static_cast<uint32_t>(imm >> 32));
+    }
+}
+
+void X86Assembler::mov(Reg dst, Reg src, bool wide) {
+    encode(0, wide, {0x8b}, dst, src);
+}
+
+void X86Assembler::lea(Reg dst, Mem src) { encode(0, true, {0x8d}, dst, src); }
+
+void X86Assembler::loadSignExtend8(Reg dst, Mem src) {
+    encode(0, false, {0x0f, 0xbe}, dst, src);
+}
+
+void X86Assembler::loadSignExtend16(Reg dst, Mem src) {
+    encode(0, false, {0x0f, 0xbf}, dst, src);
+}
+
+void X86Assembler::loadZeroExtend16(Reg dst, Mem src) {
+    encode(0, false, {0x0f, 0xb7}, dst, src);
+}
+
+void X86Assembler::loadSignExtend32(Reg dst, Mem src) {
+    encode(0, true, {0x63}, dst, src);
+}
+
+void X86Assembler::alu(AluOp op, Reg dst, Mem src, bool wide) {
+    encode(0, wide, {op}, dst, src);
+}
+
+void X86Assembler::alu(AluOp op, Reg dst, Reg src, bool wide) {
+    encode(0, wide, {op}, dst, src);
+}
+
+void X86Assembler::addImm32(Mem dst, int32_t imm) {
+    encode(0, false, {0x81}, 0, dst);
+    emit32(static_cast<uint32_t>(imm));
+}
+
+void X86Assembler::xorImm32(Mem dst, int32_t imm) {
+    encode(0, false, {0x81}, 6, dst);
+    emit32(static_cast<uint32_t>(imm));
+}
+
+void X86Assembler::imul(Reg dst, Mem src, bool wide) {
+    encode(0, wide, {0x0f, 0xaf}, dst, src);
+}
+
+void X86Assembler::imul(Reg dst, Reg src, bool wide) {
+    encode(0, wide, {0x0f, 0xaf}, dst, src);
+}
+
+void X86Assembler::neg(Reg dst, bool wide) {
+    encode(0, wide, {0xf7}, 3, dst);
+}
+
+void X86Assembler::shift(ShiftOp op, Reg dst, bool wide) {
+    // Shift distance is taken from cl and masked by processor the same way
+    // as jvm does
+    encode(0, wide, {0xd3}, op, dst);
+}
+
+void X86Assembler::test(Reg a, Reg b, bool wide) {
+    encode(0, wide, {0x85}, b, a);
+}
+
+void X86Assembler::setcc(Cond cond, Reg dst) {
+    if (dst >= RSP) {
+        // Without REX prefix they would be ah, ch, dh and bh
+        emit(static_cast<uint8_t>(0x40 | (dst >> 3)));
+        emit(0x0f);
+        emit(static_cast<uint8_t>(0x90 + cond));
+        emit(static_cast<uint8_t>(0xc0 | (dst & 7)));
+        return;
+    }
+    encode(0, false, {0x0f, static_cast<uint8_t>(0x90 + cond)}, 0, dst);
+}
+
+void X86Assembler::zeroExtend8(Reg dst, Reg src) {
+    encode(0, false, {0x0f, 0xb6}, dst, src);
+}
+
+void X86Assembler::sse(SsePrefix prefix, SseOp op, int xmm, Mem src,
+                       bool wide) {
+    encode(prefix, wide, {0x0f, op}, xmm, src);
+}
+
+void X86Assembler::sse(SsePrefix prefix, SseOp op, int xmm, int src) {
+    encode(prefix, false, {0x0f, op}, xmm, src);
+}
+
+size_t X86Assembler::jcc(Cond cond) {
+    emit(0x0f);
+    emit(static_cast<uint8_t>(0x80 + cond));
+    emit32(0);
+    return buf.size() - 4;
+}
+
+size_t X86Assembler::jmp() {
+    emit(0xe9);
+    emit32(0);
+    return buf.size() - 4;
+}
+
+void X86Assembler::bind(size_t fixup, size_t target) {
+    const auto rel = static_cast<uint32_t>(static_cast<int64_t>(target) -
+                                           static_cast<int64_t>(fixup + 4));
+    for (int i = 0; i < 4; i++) {
+        buf[fixup + i] = static_cast<uint8_t>(rel >> (i * 8));
+    }
+}
+
+void X86Assembler::invert(size_t fixup) {
+    // Conditions come in pairs differing in the lowest bit
+    buf[fixup - 1] ^= 1;
+}
+
+void X86Assembler::call(Reg target) { encode(0, false, {0xff}, 2, target); }
+
+void X86Assembler::jmp(Reg target) { encode(0, false, {0xff}, 4, target); }
+
+void X86Assembler::jmpIndexed(Reg base, Reg index) {
+    // jmp qword [base + index * 8], base can not be rbp or r13 here
+    rex(false, 0, index, base);
+    emit(0xff);
+    emit(0x24);
+    emit(static_cast<uint8_t>(0xc0 | ((index & 7) << 3) | (base & 7)));
+}
+
+void X86Assembler::push(Reg reg) {
+    rex(false, 0, 0, reg);
+    emit(static_cast<uint8_t>(0x50 + (reg & 7)));
+}
+
+void X86Assembler::pop(Reg reg) {
+    rex(false, 0, 0, reg);
+    emit(static_cast<uint8_t>(0x58 + (reg & 7)));
+}
+
+void X86Assembler::ret() { emit(0xc3); }
+
+void X86Assembler::int3() { emit(0xcc); }
@@ -0,0 +1,138 @@
+#ifndef YVM_X86ASSEMBLER_H
+#define YVM_X86ASSEMBLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+//--------------------------------------------------------------------------------
+// A tiny x86-64 assembler covering what templates of baseline compiler need.
+// Memory operands are always [base + disp], instructions are appended to a
+// growable buffer and branches are patched once their targets are known
+//--------------------------------------------------------------------------------
+enum Reg : uint8_t {
+    RAX = 0,
+    RCX,
+    RDX,
+    RBX,
+    RSP,
+    RBP,
+    RSI,
+    RDI,
+    R8,
+    R9,
+    R10,
+    R11,
+    R12,
+    R13,
+    R14,
+    R15
+};
+
+// Condition codes of jcc/setcc
+enum Cond : uint8_t {
+    CondE = 0x4,
+    CondNE = 0x5,
+    CondL = 0xc,
+    CondGE = 0xd,
+    CondLE = 0xe,
+    CondG = 0xf
+};
+
+// Opcodes of "op r, r/m" form of binary integer arithmetic
+enum AluOp : uint8_t {
+    AluAdd = 0x03,
+    AluOr = 0x0b,
+    AluAnd = 0x23,
+    AluSub = 0x2b,
+    AluXor = 0x33,
+    AluCmp = 0x3b
+};
+
+// Opcode extensions of shift instructions
+enum ShiftOp : uint8_t { ShiftLeft = 4, ShiftRightLogical = 5, ShiftRight = 7 };
+
+// Opcodes of scalar SSE arithmetic, they are prefixed by F3(float) or
+// F2(double)
+enum SseOp : uint8_t {
+    SseLoad = 0x10,
+    SseStore = 0x11,
+    SseConvertInt = 0x2a,
+    SseAdd = 0x58,
+    SseMul = 0x59,
+    SseConvertFloat = 0x5a,
+    SseSub = 0x5c,
+    SseDiv = 0x5e
+};
+
+enum SsePrefix : uint8_t { SseSingle = 0xf3, SseDouble = 0xf2 };
+
+struct Mem {
+    Reg base;
+    int32_t disp;
+};
+
+class X86Assembler {
+public:
+    const std::vector<uint8_t>& code() const { return buf; }
+    size_t size() const { return buf.size(); }
+
+    // Data movement, "wide" selects 64-bit operand size
+    void load(Reg dst, Mem src, bool wide);
+    void store(Mem dst, Reg src, bool wide);
+    void storeImm8(Mem dst, uint8_t imm);
+    void storeImm32(Mem dst, int32_t imm, bool wide);
+    void movImm(Reg dst, uint64_t imm);
+    void mov(Reg dst, Reg src, bool wide);
+    void lea(Reg dst, Mem src);
+    void loadSignExtend8(Reg dst, Mem src);
+    void loadSignExtend16(Reg dst, Mem src);
+    void loadZeroExtend16(Reg dst, Mem src);
+    void loadSignExtend32(Reg dst, Mem src);
+
+    // Integer arithmetic
+    void alu(AluOp op, Reg dst, Mem src, bool wide);
+    void alu(AluOp op, Reg dst, Reg src, bool wide);
+    void addImm32(Mem dst, int32_t imm);
+    void xorImm32(Mem dst, int32_t imm);
+    void imul(Reg dst, Mem src, bool wide);
+    void imul(Reg dst, Reg src, bool wide);
+    void neg(Reg dst, bool wide);
+    void shift(ShiftOp op, Reg dst, bool wide);
+    void test(Reg a, Reg b, bool wide);
+    void setcc(Cond cond, Reg dst);
+    void zeroExtend8(Reg dst, Reg src);
+
+    // Scalar floating-point arithmetic
+    void sse(SsePrefix prefix, SseOp op, int xmm, Mem src, bool wide = false);
+    void sse(SsePrefix prefix, SseOp op, int xmm, int src);
+
+    // Control transfer. jcc() and jmp() return the position of their
+    // displacements, which are patched by bind() later, invert() negates the
+    // condition of a jcc
+    size_t jcc(Cond cond);
+    size_t jmp();
+    void bind(size_t fixup, size_t target);
+    void invert(size_t fixup);
+    void call(Reg target);
+    void jmp(Reg target);
+    void jmpIndexed(Reg base, Reg index);
+    void push(Reg reg);
+    void pop(Reg reg);
+    void ret();
+    void int3();
+
+private:
+    void emit(uint8_t byte) { buf.push_back(byte); }
+    void emit32(uint32_t value);
+    void rex(bool wide, int reg, int index, int base);
+    void encode(uint8_t prefix, bool wide, std::initializer_list<uint8_t> op,
+                int reg, Mem rm);
+    void encode(uint8_t prefix, bool wide, std::initializer_list<uint8_t> op,
+                int reg, int rm);
+
+    std::vector<uint8_t> buf;
+};
+
+#endif  // YVM_X86ASSEMBLER_H
@@ -2,6 +2,41 @@
 #include "Debug.h"
 #include "../runtime/JavaType.h"
 
+static const char* getConstantTagName(u1 tag) {
+    switch (tag) {
+        case TAG_Class:
+            return "Class";
+        case TAG_Fieldref:
+            return "Fieldref";
+        case TAG_Methodref:
+            return "Methodref";
+        case TAG_InterfaceMethodref:
+            return "InterfaceMethodref";
+        case TAG_String:
+            return "String";
+        case TAG_Integer:
+            return "Integer";
+        case TAG_Float:
+            return "Float";
+        case TAG_Long:
+            return "Long";
+        case TAG_Double:
+            return "Double";
+        case TAG_NameAndType:
+            return "NameAndType";
+        case TAG_Utf8:
+            return "Utf8";
+        case TAG_MethodHandle:
+            return "MethodHandle";
+        case TAG_MethodType:
+            return "MethodType";
+        case TAG_InvokeDynamic:
+            return "InvokeDynamic";
+        default:
+            return "";
+    }
+}
+
 void Inspector::printConstantPool(const JavaClass& jc) {
     using namespace std;
     DbgPleasant d("Constant pool", 3);
@@ -9,78 +44,50 @@ void Inspector::printConstantPool(const JavaClass& jc) {
     d.addCell("Index");
     d.addCell("Slot Type");
     d.addCell("Extra information");
+    const ConstantPool& cp = jc.raw.constPool;
     for (int i = 1; i <= jc.raw.constPoolCount - 1; i++) {
         d.addCell("#" + std::to_string(i));
-        d.addCell(typeid(*jc.raw.constPoolInfo[i]).name());
+        d.addCell(getConstantTagName(cp.tag(i)));
 
-        // Extra information about specified CONSTANT_* structure
-        if (typeid(*jc.raw.constPoolInfo[i]) == typeid(CONSTANT_Utf8)) {
-            d.addCell(
-                (char*)dynamic_cast<CONSTANT_Utf8*>(jc.raw.constPoolInfo[i])
-                    ->bytes);
-        } else if (typeid(*jc.raw.constPoolInfo[i]) ==
-                   typeid(CONSTANT_String)) {
-            d.addCell(jc.getString(
-                dynamic_cast<CONSTANT_String*>(jc.raw.constPoolInfo[i])
-                    ->stringIndex));
-        } else if (typeid(*jc.raw.constPoolInfo[i]) ==
-                   typeid(CONSTANT_Integer)) {
-            d.addCell(std::to_string(
-                dynamic_cast<CONSTANT_Integer*>(jc.raw.constPoolInfo[i])->val));
-        } else if (typeid(*jc.raw.constPoolInfo[i]) == typeid(CONSTANT_Float)) {
-            d.addCell(std::to_string(
-                dynamic_cast<CONSTANT_Float*>(jc.raw.constPoolInfo[i])->val));
-        } else if (typeid(*jc.raw.constPoolInfo[i]) == typeid(CONSTANT_Long)) {
-            d.addCell(std::to_string(
-                dynamic_cast<CONSTANT_Long*>(jc.raw.constPoolInfo[i])->val));
-            i++;
-        } else if (typeid(*jc.raw.constPoolInfo[i]) ==
-                   typeid(CONSTANT_Double)) {
-            d.addCell(std::to_string(
-                dynamic_cast<CONSTANT_Double*>(jc.raw.constPoolInfo[i])->val));
-            i++;
-        } else if (typeid(*jc.raw.constPoolInfo[i]) ==
-                   typeid(CONSTANT_Fieldref)) {
-            d.addCell(jc.getString(
-                dynamic_cast<CONSTANT_NameAndType*>(
-                    jc.raw.constPoolInfo[dynamic_cast<CONSTANT_Fieldref*>(
-                                             jc.raw.constPoolInfo[i])
-                                             ->nameAndTypeIndex])
-                    ->nameIndex));
-        } else if (typeid(*jc.raw.constPoolInfo[i]) ==
-                   typeid(CONSTANT_Methodref)) {
-            d.addCell(jc.getString(
-                dynamic_cast<CONSTANT_NameAndType*>(
-                    jc.raw.constPoolInfo[dynamic_cast<CONSTANT_Methodref*>(
-                                             jc.raw.constPoolInfo[i])
-                                             ->nameAndTypeIndex])
-                    ->nameIndex));
-        } else if (typeid(*jc.raw.constPoolInfo[i]) ==
-                   typeid(CONSTANT_InterfaceMethodref)) {
-            d.addCell(jc.getString(
-                dynamic_cast<CONSTANT_NameAndType*>(
-                    jc.raw.constPoolInfo
-                        [dynamic_cast<CONSTANT_InterfaceMethodref*>(
-                             jc.raw.constPoolInfo[i])
-                             ->nameAndTypeIndex])
-                    ->nameIndex));
-        } else if (typeid(*jc.raw.constPoolInfo[i]) == typeid(CONSTANT_Class)) {
-            d.addCell(jc.getString(
-                dynamic_cast<CONSTANT_Class*>(jc.raw.constPoolInfo[i])
-                    ->nameIndex));
-        } else if (typeid(*jc.raw.constPoolInfo[i]) ==
-                   typeid(CONSTANT_NameAndType)) {
-            std::string nameAndType;
-            nameAndType += jc.getString(
-                dynamic_cast<CONSTANT_NameAndType*>(jc.raw.constPoolInfo[i])
-                    ->nameIndex);
-            nameAndType += " ! ";
-            nameAndType += jc.getString(
-                dynamic_cast<CONSTANT_NameAndType*>(jc.raw.constPoolInfo[i])
-                    ->descriptorIndex);
-            d.addCell(nameAndType);
-        } else {
-            d.addCell(" ");
+        // Extra information about specified constant
+        switch (cp.tag(i)) {
+            case TAG_Utf8:
+                d.addCell(cp.utf8(i));
+                break;
+            case TAG_String:
+            case TAG_Class:
+                d.addCell(jc.getString(cp.nameIndex(i)));
+                break;
+            case TAG_Integer:
+                d.addCell(std::to_string(cp.intValue(i)));
+                break;
+            case TAG_Float:
+                d.addCell(std::to_string(cp.floatValue(i)));
+                break;
+            case TAG_Long:
+                d.addCell(std::to_string(cp.longValue(i)));
+                i++;
+                break;
+            case TAG_Double:
+                d.addCell(std::to_string(cp.doubleValue(i)));
+                i++;
+                break;
+            case TAG_Fieldref:
+            case TAG_Methodref:
+            case TAG_InterfaceMethodref:
+                d.addCell(
+                    jc.getString(cp.natNameIndex(cp.nameAndTypeIndex(i))));
+                break;
+            case TAG_NameAndType: {
+                std::string nameAndType;
+                nameAndType += jc.getString(cp.natNameIndex(i));
+                nameAndType += " ! ";
+                nameAndType += jc.getString(cp.natDescriptorIndex(i));
+                d.addCell(nameAndType);
+                break;
+            }
+            default:
+                d.addCell(" ");
         }
     }
     d.show();
@@ -242,9 +249,7 @@ void Inspector::printInterfaces(const JavaClass& jc) {
     d.addCell("Interface name");
     FOR_EACH(i, jc.raw.interfacesCount) {
         d.addCell("#" + std::to_string(i));
-        d.addCell(jc.getString(dynamic_cast<CONSTANT_Class*>(
-                                   jc.raw.constPoolInfo[jc.raw.interfaces[i]])
-                                   ->nameIndex));
+        d.addCell(jc.getInterfaceClassName(i));
     }
     d.show();
 }
@@ -280,624 +285,456 @@ void Inspector::printSizeofInternalTypes() {
     d.show();
 }
 
-void Inspector::printOpcode(u1* code, u4 index) {
-    switch (code[index]) {
+const char* Inspector::opcodeName(u1 opcode) {
+    switch (opcode) {
         case 0:
-            std::cout << "nop\n";
-            break;
+            return "nop";
         case 1:
-            std::cout << "aconst_null\n";
-            break;
+            return "aconst_null";
         case 2:
-            std::cout << "iconst_m1\n";
-            break;
+            return "iconst_m1";
         case 3:
-            std::cout << "iconst_0\n";
-            break;
+            return "iconst_0";
         case 4:
-            std::cout << "iconst_1\n";
-            break;
+            return "iconst_1";
         case 5:
-            std::cout << "iconst_2\n";
-            break;
+            return "iconst_2";
         case 6:
-            std::cout << "iconst_3\n";
-            break;
+            return "iconst_3";
         case 7:
-            std::cout << "iconst_4\n";
-            break;
+            return "iconst_4";
         case 8:
-            std::cout << "iconst_5\n";
-            break;
+            return "iconst_5";
         case 9:
-            std::cout << "lconst_0\n";
-            break;
+            return "lconst_0";
         case 10:
-            std::cout << "lconst_1\n";
-            break;
+            return "lconst_1";
         case 11:
-            std::cout << "fconst_0\n";
-            break;
+            return "fconst_0";
         case 12:
-            std::cout << "fconst_1\n";
-            break;
+            return "fconst_1";
         case 13:
-            std::cout << "fconst_2\n";
-            break;
+            return "fconst_2";
         case 14:
-            std::cout << "dconst_0\n";
-            break;
+            return "dconst_0";
         case 15:
-            std::cout << "dconst_1\n";
-            break;
+            return "dconst_1";
         case 16:
-            std::cout << "bipush\n";
-            break;
+            return "bipush";
         case 17:
-            std::cout << "sipush\n";
-            break;
+            return "sipush";
         case 18:
-            std::cout << "ldc\n";
-            break;
+            return "ldc";
         case 19:
-            std::cout << "ldc_w\n";
-            break;
+            return "ldc_w";
         case 20:
-            std::cout << "ldc2_w\n";
-            break;
+            return "ldc2_w";
         case 21:
-            std::cout << "iload\n";
-            break;
+            return "iload";
         case 22:
-            std::cout << "lload\n";
-            break;
+            return "lload";
         case 23:
-            std::cout << "fload\n";
-            break;
+            return "fload";
         case 24:
-            std::cout << "dload\n";
-            break;
+            return "dload";
         case 25:
-            std::cout << "aload\n";
-            break;
+            return "aload";
         case 26:
-            std::cout << "iload_0\n";
-            break;
+            return "iload_0";
         case 27:
-            std::cout << "iload_1\n";
-            break;
+            return "iload_1";
         case 28:
-            std::cout << "iload_2\n";
-            break;
+            return "iload_2";
         case 29:
-            std::cout << "iload_3\n";
-            break;
+            return "iload_3";
         case 30:
-            std::cout << "lload_0\n";
-            break;
+            return "lload_0";
         case 31:
-            std::cout << "lload_1\n";
-            break;
+            return "lload_1";
         case 32:
-            std::cout << "lload_2\n";
-            break;
+            return "lload_2";
         case 33:
-            std::cout << "lload_3\n";
-            break;
+            return "lload_3";
         case 34:
-            std::cout << "fload_0\n";
-            break;
+            return "fload_0";
         case 35:
-            std::cout << "fload_1\n";
-            break;
+            return "fload_1";
         case 36:
-            std::cout << "fload_2\n";
-            break;
+            return "fload_2";
         case 37:
-            std::cout << "fload_3\n";
-            break;
+            return "fload_3";
         case 38:
-            std::cout << "dload_0\n";
-            break;
+            return "dload_0";
         case 39:
-            std::cout << "dload_1\n";
-            break;
+            return "dload_1";
         case 40:
-            std::cout << "dload_2\n";
-            break;
+            return "dload_2";
         case 41:
-            std::cout << "dload_3\n";
-            break;
+            return "dload_3";
         case 42:
-            std::cout << "aload_0\n";
-            break;
+            return "aload_0";
         case 43:
-            std::cout << "aload_1\n";
-            break;
+            return "aload_1";
         case 44:
-            std::cout << "aload_2\n";
-            break;
+            return "aload_2";
         case 45:
-            std::cout << "aload_3\n";
-            break;
+            return "aload_3";
         case 46:
-            std::cout << "iaload\n";
-            break;
+            return "iaload";
         case 47:
-            std::cout << "laload\n";
-            break;
+            return "laload";
         case 48:
-            std::cout << "faload\n";
-            break;
+            return "faload";
         case 49:
-            std::cout << "daload\n";
-            break;
+            return "daload";
         case 50:
-            std::cout << "aaload\n";
-            break;
+            return "aaload";
         case 51:
-            std::cout << "baload\n";
-            break;
+            return "baload";
         case 52:
-            std::cout << "caload\n";
-            break;
+            return "caload";
         case 53:
-            std::cout << "saload\n";
-            break;
+            return "saload";
         case 54:
-            std::cout << "istore\n";
-            break;
+            return "istore";
         case 55:
-            std::cout << "lstore\n";
-            break;
+            return "lstore";
         case 56:
-            std::cout << "fstore\n";
-            break;
+            return "fstore";
         case 57:
-            std::cout << "dstore\n";
-            break;
+            return "dstore";
         case 58:
-            std::cout << "astore\n";
-            break;
+            return "astore";
         case 59:
-            std::cout << "istore_0\n";
-            break;
+            return "istore_0";
         case 60:
-            std::cout << "istore_1\n";
-            break;
+            return "istore_1";
         case 61:
-            std::cout << "istore_2\n";
-            break;
+            return "istore_2";
         case 62:
-            std::cout << "istore_3\n";
-            break;
+            return "istore_3";
         case 63:
-            std::cout << "lstore_0\n";
-            break;
+            return "lstore_0";
         case 64:
-            std::cout << "lstore_1\n";
-            break;
+            return "lstore_1";
         case 65:
-            std::cout << "lstore_2\n";
-            break;
+            return "lstore_2";
         case 66:
-            std::cout << "lstore_3\n";
-            break;
+            return "lstore_3";
         case 67:
-            std::cout << "fstore_0\n";
-            break;
+            return "fstore_0";
         case 68:
-            std::cout << "fstore_1\n";
-            break;
+            return "fstore_1";
         case 69:
-            std::cout << "fstore_2\n";
-            break;
+            return "fstore_2";
         case 70:
-            std::cout << "fstore_3\n";
-            break;
+            return "fstore_3";
         case 71:
-            std::cout << "dstore_0\n";
-            break;
+            return "dstore_0";
         case 72:
-            std::cout << "dstore_1\n";
-            break;
+            return "dstore_1";
         case 73:
-            std::cout << "dstore_2\n";
-            break;
+            return "dstore_2";
         case 74:
-            std::cout << "dstore_3\n";
-            break;
+            return "dstore_3";
         case 75:
-            std::cout << "astore_0\n";
-            break;
+            return "astore_0";
         case 76:
-            std::cout << "astore_1\n";
-            break;
+            return "astore_1";
         case 77:
-            std::cout << "astore_2\n";
-            break;
+            return "astore_2";
         case 78:
-            std::cout << "astore_3\n";
-            break;
+            return "astore_3";
         case 79:
-            std::cout << "iastore\n";
-            break;
+            return "iastore";
         case 80:
-            std::cout << "lastore\n";
-            break;
+            return "lastore";
         case 81:
-            std::cout << "fastore\n";
-            break;
+            return "fastore";
         case 82:
-            std::cout << "dastore\n";
-            break;
+            return "dastore";
         case 83:
-            std::cout << "aastore\n";
-            break;
+            return "aastore";
         case 84:
-            std::cout << "bastore\n";
-            break;
+            return "bastore";
         case 85:
-            std::cout << "castore\n";
-            break;
+            return "castore";
         case 86:
-            std::cout << "sastore\n";
-            break;
+            return "sastore";
         case 87:
-            std::cout << "pop\n";
-            break;
+            return "pop";
         case 88:
-            std::cout << "pop2\n";
-            break;
+            return "pop2";
         case 89:
-            std::cout << "dup\n";
-            break;
+            return "dup";
         case 90:
-            std::cout << "dup_x1\n";
-            break;
+            return "dup_x1";
         case 91:
-            std::cout << "dup_x2\n";
-            break;
+            return "dup_x2";
         case 92:
-            std::cout << "dup2\n";
-            break;
+            return "dup2";
         case 93:
-            std::cout << "dup2_x1\n";
-            break;
+            return "dup2_x1";
         case 94:
-            std::cout << "dup2_x2\n";
-            break;
+            return "dup2_x2";
         case 95:
-            std::cout << "swap\n";
-            break;
+            return "swap";
         case 96:
-            std::cout << "iadd\n";
-            break;
+            return "iadd";
         case 97:
-            std::cout << "ladd\n";
-            break;
+            return "ladd";
         case 98:
-            std::cout << "fadd\n";
-            break;
+            return "fadd";
         case 99:
-            std::cout << "dadd\n";
-            break;
+            return "dadd";
         case 100:
-            std::cout << "isub\n";
-            break;
+            return "isub";
         case 101:
-            std::cout << "lsub\n";
-            break;
+            return "lsub";
         case 102:
-            std::cout << "fsub\n";
-            break;
+            return "fsub";
         case 103:
-            std::cout << "dsub\n";
-            break;
+            return "dsub";
         case 104:
-            std::cout << "imul\n";
-            break;
+            return "imul";
         case 105:
-            std::cout << "lmul\n";
-            break;
+            return "lmul";
         case 106:
-            std::cout << "fmul\n";
-            break;
+            return "fmul";
         case 107:
-            std::cout << "dmul\n";
-            break;
+            return "dmul";
         case 108:
-            std::cout << "idiv\n";
-            break;
+            return "idiv";
         case 109:
-            std::cout << "ldiv\n";
-            break;
+            return "ldiv";
         case 110:
-            std::cout << "fdiv\n";
-            break;
+            return "fdiv";
         case 111:
-            std::cout << "ddiv\n";
-            break;
+            return "ddiv";
         case 112:
-            std::cout << "irem\n";
-            break;
+            return "irem";
         case 113:
-            std::cout << "lrem\n";
-            break;
+            return "lrem";
         case 114:
-            std::cout << "frem\n";
-            break;
+            return "frem";
         case 115:
-            std::cout << "drem\n";
-            break;
+            return "drem";
         case 116:
-            std::cout << "ineg\n";
-            break;
+            return "ineg";
         case 117:
-            std::cout << "lneg\n";
-            break;
+            return "lneg";
         case 118:
-            std::cout << "fneg\n";
-            break;
+            return "fneg";
         case 119:
-            std::cout << "dneg\n";
-            break;
+            return "dneg";
         case 120:
-            std::cout << "ishl\n";
-            break;
+            return "ishl";
         case 121:
-            std::cout << "lshl\n";
-            break;
+            return "lshl";
         case 122:
-            std::cout << "ishr\n";
-            break;
+            return "ishr";
         case 123:
-            std::cout << "lshr\n";
-            break;
+            return "lshr";
         case 124:
-            std::cout << "iushr\n";
-            break;
+            return "iushr";
         case 125:
-            std::cout << "lushr\n";
-            break;
+            return "lushr";
         case 126:
-            std::cout << "iand\n";
-            break;
+            return "iand";
         case 127:
-            std::cout << "land\n";
-            break;
+            return "land";
         case 128:
-            std::cout << "ior\n";
-            break;
+            return "ior";
         case 129:
-            std::cout << "lor\n";
-            break;
+            return "lor";
         case 130:
-            std::cout << "ixor\n";
-            break;
+            return "ixor";
         case 131:
-            std::cout << "lxor\n";
-            break;
+            return "lxor";
         case 132:
-            std::cout << "iinc\n";
-            break;
+            return "iinc";
         case 133:
-            std::cout << "i2l\n";
-            break;
+            return "i2l";
         case 134:
-            std::cout << "i2f\n";
-            break;
+            return "i2f";
         case 135:
-            std::cout << "i2d\n";
-            break;
+            return "i2d";
         case 136:
-            std::cout << "l2i\n";
-            break;
+            return "l2i";
         case 137:
-            std::cout << "l2f\n";
-            break;
+            return "l2f";
         case 138:
-            std::cout << "l2d\n";
-            break;
+            return "l2d";
         case 139:
-            std::cout << "f2i\n";
-            break;
+            return "f2i";
         case 140:
-            std::cout << "f2l\n";
-            break;
+            return "f2l";
         case 141:
-            std::cout << "f2d\n";
-            break;
+            return "f2d";
         case 142:
-            std::cout << "d2i\n";
-            break;
+            return "d2i";
         case 143:
-            std::cout << "d2l\n";
-            break;
+            return "d2l";
         case 144:
-            std::cout << "d2f\n";
-            break;
+            return "d2f";
         case 145:
-            std::cout << "i2b\n";
-            break;
+            return "i2b";
         case 146:
-            std::cout << "i2c\n";
-            break;
+            return "i2c";
         case 147:
-            std::cout << "i2s\n";
-            break;
+            return "i2s";
         case 148:
-            std::cout << "lcmp\n";
-            break;
+            return "lcmp";
         case 149:
-            std::cout << "fcmpl\n";
-            break;
+            return "fcmpl";
         case 150:
-            std::cout << "fcmpg\n";
-            break;
+            return "fcmpg";
         case 151:
-            std::cout << "dcmpl\n";
-            break;
+            return "dcmpl";
         case 152:
-            std::cout << "dcmpg\n";
-            break;
+            return "dcmpg";
         case 153:
-            std::cout << "ifeq\n";
-            break;
+            return "ifeq";
         case 154:
-            std::cout << "ifne\n";
-            break;
+            return "ifne";
         case 155:
-            std::cout << "iflt\n";
-            break;
+            return "iflt";
         case 156:
-            std::cout << "ifge\n";
-            break;
+            return "ifge";
         case 157:
-            std::cout << "ifgt\n";
-            break;
+            return "ifgt";
         case 158:
-            std::cout << "ifle\n";
-            break;
+            return "ifle";
         case 159:
-            std::cout << "if_icmpeq\n";
-            break;
+            return "if_icmpeq";
         case 160:
-            std::cout << "if_icmpne\n";
-            break;
+            return "if_icmpne";
         case 161:
-            std::cout << "if_icmplt\n";
-            break;
+            return "if_icmplt";
         case 162:
-            std::cout << "if_icmpge\n";
-            break;
+            return "if_icmpge";
         case 163:
-            std::cout << "if_icmpgt\n";
-            break;
+            return "if_icmpgt";
         case 164:
-            std::cout << "if_icmple\n";
-            break;
+            return "if_icmple";
         case 165:
-            std::cout << "if_acmpeq\n";
-            break;
+            return "if_acmpeq";
         case 166:
-            std::cout << "if_acmpne\n";
-            break;
+            return "if_acmpne";
         case 167:
-            std::cout << "goto\n";
-            break;
+            return "goto";
         case 168:
-            std::cout << "jsr\n";
-            break;
+            return "jsr";
         case 169:
-            std::cout << "ret\n";
-            break;
+            return "ret";
         case 170:
-            std::cout << "tableswitch\n";
-            break;
+            return "tableswitch";
         case 171:
-            std::cout << "lookupswitch\n";
-            break;
+            return "lookupswitch";
         case 172:
-            std::cout << "ireturn\n";
-            break;
+            return "ireturn";
         case 173:
-            std::cout << "lreturn\n";
-            break;
+            return "lreturn";
         case 174:
-            std::cout << "freturn\n";
-            break;
+            return "freturn";
         case 175:
-            std::cout << "dreturn\n";
-            break;
+            return "dreturn";
         case 176:
-            std::cout << "areturn\n";
-            break;
+            return "areturn";
         case 177:
-            std::cout << "return\n";
-            break;
+            return "return";
         case 178:
-            std::cout << "getstatic\n";
-            break;
+            return "getstatic";
         case 179:
-            std::cout << "putstatic\n";
-            break;
+            return "putstatic";
         case 180:
-            std::cout << "getfield\n";
-            break;
+            return "getfield";
         case 181:
-            std::cout << "putfield\n";
-            break;
+            return "putfield";
         case 182:
-            std::cout << "invokevirtual\n";
-            break;
+            return "invokevirtual";
         case 183:
-            std::cout << "invokespecial\n";
-            break;
+            return "invokespecial";
         case 184:
-            std::cout << "invokestatic\n";
-            break;
+            return "invokestatic";
         case 185:
-            std::cout << "invokeinterface\n";
-            break;
+            return "invokeinterface";
         case 186:
-            std::cout << "invokedynamic\n";
-            break;
+            return "invokedynamic";
         case 187:
-            std::cout << "new\n";
-            break;
+            return "new";
         case 188:
-            std::cout << "newarray\n";
-            break;
+            return "newarray";
         case 189:
-            std::cout << "anewarray\n";
-            break;
+            return "anewarray";
         case 190:
-            std::cout << "arraylength\n";
-            break;
+            return "arraylength";
         case 191:
-            std::cout << "athrow\n";
-            break;
+            return "athrow";
         case 192:
-            std::cout << "checkcast\n";
-            break;
+            return "checkcast";
         case 193:
-            std::cout << "instanceof\n";
-            break;
+            return "instanceof";
         case 194:
-            std::cout << "monitorenter\n";
-            break;
+            return "monitorenter";
         case 195:
-            std::cout << "monitorexit\n";
-            break;
+            return "monitorexit";
         case 196:
-            std::cout << "wide\n";
-            break;
+            return "wide";
         case 197:
-            std::cout << "multianewarray\n";
-            break;
+            return "multianewarray";
         case 198:
-            std::cout << "ifnull\n";
-            break;
+            return "ifnull";
         case 199:
-            std::cout << "ifnonnull\n";
-            break;
+            return "ifnonnull";
         case 200:
-            std::cout << "goto_w\n";
-            break;
+            return "goto_w";
         case 201:
-            std::cout << "jsr_w\n";
-            break;
+            return "jsr_w";
         case 202:
-            std::cout << "breakpoint\n";
-            break;
+            return "breakpoint";
+        case 203:
+            return "fast_getfield";
+        case 204:
+            return "fast_putfield";
+        case 205:
+            return "fast_getstatic";
+        case 206:
+            return "fast_putstatic";
+        case 207:
+            return "iinc_goto";
+        case 208:
+            return "aload_getfield";
+        case 209:
+            return "aload_iload_iaload";
+        case 210:
+            return "iload_iconst_iadd_istore";
+        case 211:
+            return "iload_iload_if_icmpeq";
+        case 212:
+            return "iload_iload_if_icmpne";
+        case 213:
+            return "iload_iload_if_icmplt";
+        case 214:
+            return "iload_iload_if_icmpge";
+        case 215:
+            return "iload_iload_if_icmpgt";
+        case 216:
+            return "iload_iload_if_icmple";
         case 254:
-            std::cout << "impdep1\n";
-            break;
+            return "impdep1";
         case 255:
-            std::cout << "impdep2\n";
-            break;
+            return "impdep2";
         default:
-            std::cout << "Invalid opcode detected!\n";
+            return nullptr;
+    }
+}
+
+void Inspector::printOpcode(const u1* code, u4 index) {
+    const char* name = opcodeName(code[index]);
+    if (name != nullptr) {
+        std::cout << name << "\n";
+    } else {
+        std::cout << "Invalid opcode detected!\n";
     }
 }
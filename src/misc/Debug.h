@@ -20,7 +20,8 @@ struct Inspector {
     static void printClassFileAttrs(const JavaClass& jc);
 
     static void printSizeofInternalTypes();
-    static void printOpcode(u1* code, u4 index);
+    static const char* opcodeName(u1 opcode);
+    static void printOpcode(const u1* code, u4 index);
 };
 
 class DbgPleasant {
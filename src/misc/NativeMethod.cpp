@@ -165,7 +165,9 @@ JType* java_lang_stringbuilder_tostring(RuntimeEnv* env, JType** args,
     JObject* str =
         env->jheap->createObject(*env->ma->findJavaClass("java/lang/String"));
     env->jheap->putFieldByOffset(
-        *str, 0, env->jheap->createCharArray(carr, value->length));
+        *str, 0,
+        env->jheap->createCharArray(std::string(carr, value->length),
+                                    value->length));
     delete[] carr;
 
     return str;
@@ -189,7 +191,7 @@ JType* java_lang_thread_start(RuntimeEnv* env, JType** args, int numArgs) {
         // For each execution thread, we have a code execution engine
         auto* frame = new JavaFrame;
         frame->pushFrame(1, 1);
-        frame->top()->push(runnableTask);
+        frame->top()->push<JObject>(runnableTask);
         Interpreter exec{frame};
 
         yrt.ma->initClassIfAbsent(exec, name);
@@ -38,6 +38,80 @@
 #define YVM_DEBUG_SHOW_CLASS_ATTRIBUTE
 #endif
 
+//--------------------------------------------------------------------------------
+// dispatch bytecode through computed goto instead of a big switch statement.
+// It relies on labels-as-values extension of GCC and Clang, the interpreter
+// falls back to switch dispatching on other compilers(e.g. MSVC)
+//--------------------------------------------------------------------------------
+#define YVM_THREADED_DISPATCH
+
+//--------------------------------------------------------------------------------
+// each java thread owns a contiguous frame stack holding local variables and
+// operand stacks of all its frames. A StackOverflowError is thrown when either
+// the slots or the maximum depth of frames are exhausted
+//--------------------------------------------------------------------------------
+#define YVM_FRAME_STACK_SLOTS (256 * 1024)
+#define YVM_MAX_FRAME_DEPTH 8192
+
+//--------------------------------------------------------------------------------
+// number of receiver classes an inline cache of invokevirtual/invokeinterface
+// can hold, call sites seeing more receiver classes than it always dispatch
+// through vtable
+//--------------------------------------------------------------------------------
+#define YVM_INLINE_CACHE_SIZE 4
+
+//--------------------------------------------------------------------------------
+// count opcode pairs and triples the interpreter executes back to back and dump
+// the most frequent ones to stderr on exit. Superinstructions are not fused
+// while profiling so that every sequence is counted as its original opcodes
+//--------------------------------------------------------------------------------
+#undef YVM_DEBUG_PROFILE_SUPERINSTRUCTIONS
+
+//--------------------------------------------------------------------------------
+// fuse frequent instruction sequences into superinstructions when methods were
+// pre-decoded, so that each sequence is executed by one dispatch. Candidates
+// can be found with YVM_DEBUG_PROFILE_SUPERINSTRUCTIONS
+//--------------------------------------------------------------------------------
+#ifndef YVM_DEBUG_PROFILE_SUPERINSTRUCTIONS
+#define YVM_SUPERINSTRUCTIONS
+#endif
+
+//--------------------------------------------------------------------------------
+// baseline compiler, which is enabled by --jit, translates a method into x86-64
+// machine code once it was invoked YVM_JIT_THRESHOLD times, or once one of its
+// loops repeated YVM_OSR_THRESHOLD times, in which case the running activation
+// continues in compiled code. Both are defaults of --jit-threshold and
+// --osr-threshold. Compiled methods call each other on native stack, so
+// methods nested deeper than YVM_JIT_MAX_NATIVE_DEPTH are interpreted to keep
+// native stack bounded
+//--------------------------------------------------------------------------------
+#define YVM_JIT_THRESHOLD 1000
+#define YVM_OSR_THRESHOLD 10000
+#define YVM_JIT_MAX_NATIVE_DEPTH 1024
+#define YVM_JIT_CODE_CACHE_SIZE (32 * 1024 * 1024)
+
+//--------------------------------------------------------------------------------
+// optimizing compiler, which is enabled by --opt, inlines invoked methods of at
+// most YVM_OPT_INLINE_SIZE bytes of bytecode that run straight through, if the
+// invocation always reaches the same method or has seen only one receiver
+// class so far. Calls are inlined into inlined methods as well, up to
+// YVM_OPT_MAX_INLINE_DEPTH levels
+//--------------------------------------------------------------------------------
+#define YVM_OPT_INLINE_SIZE 35
+#define YVM_OPT_MAX_INLINE_DEPTH 3
+
+//--------------------------------------------------------------------------------
+// trace compiler, which is enabled by --trace, records one iteration of a loop
+// once it repeated YVM_TRACE_THRESHOLD times, the default of --trace-threshold.
+// A recording is given up when it gets longer than YVM_TRACE_MAX_LENGTH
+// instructions or calls nest deeper than YVM_TRACE_MAX_INLINE_DEPTH, a loop is
+// not recorded any more after YVM_TRACE_MAX_ATTEMPTS recordings failed
+//--------------------------------------------------------------------------------
+#define YVM_TRACE_THRESHOLD 1000
+#define YVM_TRACE_MAX_LENGTH 2000
+#define YVM_TRACE_MAX_INLINE_DEPTH 4
+#define YVM_TRACE_MAX_ATTEMPTS 3
+
 //--------------------------------------------------------------------------------
 // to mark a gc safe point
 //--------------------------------------------------------------------------------
@@ -56,16 +56,74 @@ JType* cloneValue(JType* value) {
     return dupvalue;
 }
 
+JType* boxValue(const JValue& value) {
+    switch (value.tag) {
+        case SlotTag::Int:
+            return new JInt(value.i);
+        case SlotTag::Float:
+            return new JFloat(value.f);
+        case SlotTag::Long:
+            return new JLong(value.j);
+        case SlotTag::Double:
+            return new JDouble(value.d);
+        case SlotTag::Ref:
+            return value.ref;
+        default:
+            // The upper half of long/double or an uninitialized slot
+            return nullptr;
+    }
+}
+
+JValue unboxValue(const JType* value, char type) {
+    switch (type) {
+        case 'B':
+        case 'C':
+        case 'I':
+        case 'S':
+        case 'Z':
+            return makeValue<JInt>(static_cast<const JInt*>(value)->val);
+        case 'F':
+            return makeValue<JFloat>(static_cast<const JFloat*>(value)->val);
+        case 'J':
+            return makeValue<JLong>(static_cast<const JLong*>(value)->val);
+        case 'D':
+            return makeValue<JDouble>(static_cast<const JDouble*>(value)->val);
+        case 'V':
+            return JValue{};
+        default:
+            return makeValue<JRef>(const_cast<JType*>(value));
+    }
+}
+
+void assignBoxedValue(JType* box, const JValue& value) {
+    switch (value.tag) {
+        case SlotTag::Int:
+            static_cast<JInt*>(box)->val = value.i;
+            break;
+        case SlotTag::Float:
+            static_cast<JFloat*>(box)->val = value.f;
+            break;
+        case SlotTag::Long:
+            static_cast<JLong*>(box)->val = value.j;
+            break;
+        case SlotTag::Double:
+            static_cast<JDouble*>(box)->val = value.d;
+            break;
+        default:
+            SHOULD_NOT_REACH_HERE
+    }
+}
+
 bool hasInheritanceRelationship(const JavaClass* source,
                                 const JavaClass* super) {
-    if (source->getClassName() == super->getClassName()) {
-        return true;
-    }
-    if (source->hasSuperClass()) {
-        return hasInheritanceRelationship(
-            yrt.ma->loadClassIfAbsent(source->getSuperClassName()), super);
+    // Class names are interned, so classes are compared by their symbols
+    while (source->getClassSymbol() != super->getClassSymbol()) {
+        if (!source->hasSuperClass()) {
+            return false;
+        }
+        source = yrt.ma->loadClassIfAbsent(source->getSuperClassSymbol());
     }
-    return false;
+    return true;
 }
 
 void registerNativeMethod(const char* className, const char* name,
@@ -209,3 +267,13 @@ std::tuple<int, std::vector<int>> peelMethodParameterAndType(
     }
     SHOULD_NOT_REACH_HERE
 }
+
+int countParameterSlots(const std::vector<int>& parameter) {
+    // Values of type long or double occupy two slots in local variables and
+    // operand stack, all the others occupy one
+    int slots = 0;
+    for (int type : parameter) {
+        slots += (type == T_LONG || type == T_DOUBLE) ? 2 : 1;
+    }
+    return slots;
+}
@@ -44,6 +44,9 @@ std::string javastring2stdtring(JObject* objectref);
 // These functions were merely used by code execution engine.
 //--------------------------------------------------------------------------------
 JType* cloneValue(JType* value);
+JType* boxValue(const JValue& value);
+JValue unboxValue(const JType* value, char type);
+void assignBoxedValue(JType* box, const JValue& value);
 bool hasInheritanceRelationship(const JavaClass* source,
                                 const JavaClass* super);
 void registerNativeMethod(const char* className, const char* name,
@@ -76,10 +79,6 @@ inline u4 consumeU4(const u1* code, u4& opidx) {
 // specification to a desirable representation or check whether it's a specific
 // type.
 //--------------------------------------------------------------------------------
-#define IS_SIGNATURE_POLYMORPHIC_METHOD(className, methodName) \
-    (className == "java/lang/invoke/MethodHandle" &&           \
-     (methodName == "invokeExtract" || methodName == "invoke"))
-
 #define IS_TYPE(type, strRepresentation)                          \
     inline bool IS_FIELD_##type(const std::string& descriptor) {  \
         return descriptor == strRepresentation;                   \
@@ -118,4 +117,6 @@ std::string peelArrayComponentTypeFrom(const std::string& descriptor);
 std::tuple<int, std::vector<int> > peelMethodParameterAndType(
     const std::string& descriptor);
 
+int countParameterSlots(const std::vector<int>& parameter);
+
 #endif  // YVM_PARSEUTIL_H
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <vector>
 #include "../classfile/AccessFlag.h"
+#include "../interpreter/SymbolicRef.h"
 #include "../misc/Debug.h"
 #include "../runtime/RuntimeEnv.h"
 #include "../vm/YVM.h"
@@ -13,7 +14,6 @@
 using namespace std;
 
 JavaClass::JavaClass(const string& classFilePath) : reader(classFilePath) {
-    raw.constPoolInfo = nullptr;
     raw.fields = nullptr;
     raw.methods = nullptr;
     raw.attributes = nullptr;
@@ -23,6 +23,11 @@ JavaClass::~JavaClass() {
     for (auto& i : staticVars) {
         delete i.second;
     }
+    if (resolvedRefs) {
+        FOR_EACH(i, raw.constPoolCount) {
+            delete resolvedRefs[i].load(memory_order_relaxed);
+        }
+    }
 }
 
 JavaClass::JavaClass(const JavaClass& rhs) { this->raw = rhs.raw; }
@@ -31,22 +36,33 @@ vector<u2> JavaClass::getInterfacesIndex() const {
     if (raw.interfacesCount == 0) return vector<u2>();
     vector<u2> v;
     FOR_EACH(i, raw.interfacesCount) {
-        v.push_back(
-            dynamic_cast<CONSTANT_Class*>(raw.constPoolInfo[raw.interfaces[i]])
-                ->nameIndex);
+        v.push_back(raw.constPool.nameIndex(raw.interfaces[i]));
     }
     return v;
 }
 
+//--------------------------------------------------------------------------------
+// Member lookups compare interned symbols. Names given as strings are looked up
+// in symbol table first, a string that was never interned can not be the name
+// of any member of a loaded class
+//--------------------------------------------------------------------------------
 MethodInfo* JavaClass::findMethod(const string& methodName,
                                   const string& methodDescriptor) const {
+    const Symbol* name = yrt.symbols->lookup(methodName);
+    const Symbol* descriptor = yrt.symbols->lookup(methodDescriptor);
+    if (name == nullptr || descriptor == nullptr) {
+        return nullptr;
+    }
+    return findMethod(name, descriptor);
+}
+
+MethodInfo* JavaClass::findMethod(const Symbol* methodName,
+                                  const Symbol* methodDescriptor) const {
     FOR_EACH(i, raw.methodsCount) {
-        assert(typeid(*raw.constPoolInfo[raw.methods[i].nameIndex]) ==
-               typeid(CONSTANT_Utf8));
+        assert(raw.constPool.is(raw.methods[i].nameIndex, TAG_Utf8));
 
-        const string& mn = getString(raw.methods[i].nameIndex);
-        const string& md = getString(raw.methods[i].descriptorIndex);
-        if (mn == methodName && md == methodDescriptor) {
+        if (getSymbol(raw.methods[i].nameIndex) == methodName &&
+            getSymbol(raw.methods[i].descriptorIndex) == methodDescriptor) {
             return &raw.methods[i];
         }
     }
@@ -57,8 +73,8 @@ bool JavaClass::setStaticVar(const string& name, const string& descriptor,
                              JType* value) {
     FOR_EACH(i, raw.fieldsCount) {
         if (IS_FIELD_STATIC(raw.fields[i].accessFlags)) {
-            auto n = getString(raw.fields[i].nameIndex);
-            auto d = getString(raw.fields[i].descriptorIndex);
+            const auto& n = getString(raw.fields[i].nameIndex);
+            const auto& d = getString(raw.fields[i].descriptorIndex);
             if (n == name && d == descriptor) {
                 staticVars.find(i)->second = value;
                 return true;
@@ -66,7 +82,7 @@ bool JavaClass::setStaticVar(const string& name, const string& descriptor,
         }
     }
     if (raw.superClass != 0) {
-        return yrt.ma->findJavaClass(getSuperClassName())
+        return yrt.ma->findJavaClass(getSuperClassSymbol())
             ->setStaticVar(name, descriptor, value);
     }
     return false;
@@ -75,20 +91,137 @@ bool JavaClass::setStaticVar(const string& name, const string& descriptor,
 JType* JavaClass::getStaticVar(const string& name, const string& descriptor) {
     FOR_EACH(i, raw.fieldsCount) {
         if (IS_FIELD_STATIC(raw.fields[i].accessFlags)) {
-            auto n = getString(raw.fields[i].nameIndex);
-            auto d = getString(raw.fields[i].descriptorIndex);
+            const auto& n = getString(raw.fields[i].nameIndex);
+            const auto& d = getString(raw.fields[i].descriptorIndex);
             if (n == name && d == descriptor) {
                 return staticVars.find(i)->second;
             }
         }
     }
     if (raw.superClass != 0) {
-        return yrt.ma->findJavaClass(getSuperClassName())
+        return yrt.ma->findJavaClass(getSuperClassSymbol())
             ->getStaticVar(name, descriptor);
     }
     return nullptr;
 }
 
+const JavaClass* JavaClass::findInstanceField(const string& name,
+                                              const string& descriptor,
+                                              u4& ordinal) const {
+    const Symbol* nameSymbol = yrt.symbols->lookup(name);
+    const Symbol* descriptorSymbol = yrt.symbols->lookup(descriptor);
+    if (nameSymbol == nullptr || descriptorSymbol == nullptr) {
+        return nullptr;
+    }
+    return findInstanceField(nameSymbol, descriptorSymbol, ordinal);
+}
+
+//--------------------------------------------------------------------------------
+// Find an instance field declared by this class or its superclasses, returns
+// the declaring class and sets ordinal as the index of field among instance
+// fields of declaring class, returns nullptr if no such field
+//--------------------------------------------------------------------------------
+const JavaClass* JavaClass::findInstanceField(const Symbol* name,
+                                              const Symbol* descriptor,
+                                              u4& ordinal) const {
+    u4 instanceFieldIndex = 0;
+    FOR_EACH(i, raw.fieldsCount) {
+        if (!IS_FIELD_STATIC(raw.fields[i].accessFlags)) {
+            if (getSymbol(raw.fields[i].nameIndex) == name &&
+                getSymbol(raw.fields[i].descriptorIndex) == descriptor) {
+                ordinal = instanceFieldIndex;
+                return this;
+            }
+            instanceFieldIndex++;
+        }
+    }
+    if (raw.superClass != 0) {
+        return yrt.ma->findJavaClass(getSuperClassSymbol())
+            ->findInstanceField(name, descriptor, ordinal);
+    }
+    return nullptr;
+}
+
+//--------------------------------------------------------------------------------
+// Find a static field declared by this class or its superclasses, returns the
+// declaring class and sets fieldIndex as the index of field within it
+//--------------------------------------------------------------------------------
+JavaClass* JavaClass::findStaticField(const Symbol* name,
+                                      const Symbol* descriptor,
+                                      u2& fieldIndex) {
+    FOR_EACH(i, raw.fieldsCount) {
+        if (IS_FIELD_STATIC(raw.fields[i].accessFlags) &&
+            getSymbol(raw.fields[i].nameIndex) == name &&
+            getSymbol(raw.fields[i].descriptorIndex) == descriptor) {
+            fieldIndex = i;
+            return this;
+        }
+    }
+    if (raw.superClass != 0) {
+        return yrt.ma->findJavaClass(getSuperClassSymbol())
+            ->findStaticField(name, descriptor, fieldIndex);
+    }
+    return nullptr;
+}
+
+int JavaClass::findVirtualMethod(const string& name,
+                                 const string& descriptor) const {
+    const Symbol* nameSymbol = yrt.symbols->lookup(name);
+    const Symbol* descriptorSymbol = yrt.symbols->lookup(descriptor);
+    if (nameSymbol == nullptr || descriptorSymbol == nullptr) {
+        return -1;
+    }
+    return findVirtualMethod(nameSymbol, descriptorSymbol);
+}
+
+//--------------------------------------------------------------------------------
+// Find an instance method in vtable by its name and descriptor, returns its
+// vtable index or -1 if absent. Methods of an interface are indexed by their
+// position in vtable of the interface
+//--------------------------------------------------------------------------------
+int JavaClass::findVirtualMethod(const Symbol* name,
+                                 const Symbol* descriptor) const {
+    for (size_t i = 0; i < vtable.size(); i++) {
+        const VirtualMethod& vm = vtable[i];
+        if (name == vm.jc->getSymbol(vm.method->nameIndex) &&
+            descriptor == vm.jc->getSymbol(vm.method->descriptorIndex)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+//--------------------------------------------------------------------------------
+// Find the vtable index of method which implements index-th method of given
+// interface, returns -1 if this class does not implement that interface
+//--------------------------------------------------------------------------------
+int JavaClass::findInterfaceMethod(const JavaClass* interfaceClass,
+                                   u2 index) const {
+    for (const auto& itable : itables) {
+        if (itable.interfaceClass == interfaceClass) {
+            return itable.vtableIndexes[index];
+        }
+    }
+    return -1;
+}
+
+//--------------------------------------------------------------------------------
+// Publish a symbolic reference resolved from given constant pool entry. Several
+// threads may resolve the same entry simultaneously, only one of them wins and
+// the others discard their own copies
+//--------------------------------------------------------------------------------
+const SymbolicRef* JavaClass::publishResolvedRef(u2 index,
+                                                 SymbolicRef* ref) const {
+    SymbolicRef* expected = nullptr;
+    if (resolvedRefs[index].compare_exchange_strong(expected, ref,
+                                                    memory_order_acq_rel,
+                                                    memory_order_acquire)) {
+        return ref;
+    }
+    delete ref;
+    return expected;
+}
+
 void JavaClass::parseClassFile() {
     int ff = 0;
     raw.magic = reader.readget4();
@@ -168,173 +301,64 @@ error:
 }
 
 bool JavaClass::parseConstantPool(u2 cpCount) {
-    raw.constPoolInfo = new ConstantPoolInfo*[cpCount];
-    raw.constPoolInfo[0] = nullptr;
-
-    if (!raw.constPoolInfo) {
-        cerr << "Can not allocate memory to load class file\n";
-        return false;
-    }
+    ConstantPool& cp = raw.constPool;
+    cp.tags.assign(cpCount, 0);
+    cp.payloads.assign(cpCount, 0);
+    resolvedRefs.reset(new atomic<SymbolicRef*>[cpCount]());
+    symbols.reset(new const Symbol*[cpCount]());
 
     // As JVM 8 specification described, the index of constant pool
     // started from 1 to constant_pool_count-1
     for (int i = 1; i <= cpCount - 1; i++) {
-        u1 tag = reader.readget1();
-        ConstantPoolInfo* slot;
+        const u1 tag = reader.readget1();
+        cp.tags[i] = tag;
         switch (tag) {
-            case TAG_Class: {
-                slot = new CONSTANT_Class();
-                dynamic_cast<CONSTANT_Class*>(slot)->nameIndex =
-                    reader.readget2();
-                raw.constPoolInfo[i] = dynamic_cast<CONSTANT_Class*>(slot);
-                break;
-            }
-            case TAG_Fieldref: {
-                slot = new CONSTANT_Fieldref();
-                dynamic_cast<CONSTANT_Fieldref*>(slot)->classIndex =
-                    reader.readget2();
-                dynamic_cast<CONSTANT_Fieldref*>(slot)->nameAndTypeIndex =
-                    reader.readget2();
-                raw.constPoolInfo[i] = dynamic_cast<CONSTANT_Fieldref*>(slot);
+            case TAG_Class:
+            case TAG_String:
+            case TAG_MethodType:
+                cp.payloads[i] = reader.readget2();
                 break;
-            }
-
-            case TAG_Methodref: {
-                slot = new CONSTANT_Methodref();
-                dynamic_cast<CONSTANT_Methodref*>(slot)->classIndex =
-                    reader.readget2();
-                dynamic_cast<CONSTANT_Methodref*>(slot)->nameAndTypeIndex =
-                    reader.readget2();
-                raw.constPoolInfo[i] = dynamic_cast<CONSTANT_Methodref*>(slot);
-                break;
-            }
-
-            case TAG_InterfaceMethodref: {
-                slot = new CONSTANT_InterfaceMethodref();
-                dynamic_cast<CONSTANT_InterfaceMethodref*>(slot)->classIndex =
-                    reader.readget2();
-                dynamic_cast<CONSTANT_InterfaceMethodref*>(slot)
-                    ->nameAndTypeIndex = reader.readget2();
-                raw.constPoolInfo[i] =
-                    dynamic_cast<CONSTANT_InterfaceMethodref*>(slot);
-                break;
-            }
-
-            case TAG_String: {
-                slot = new CONSTANT_String();
-                dynamic_cast<CONSTANT_String*>(slot)->stringIndex =
-                    reader.readget2();
-                raw.constPoolInfo[i] = dynamic_cast<CONSTANT_String*>(slot);
-                break;
-            }
-            case TAG_Integer: {
-                slot = new CONSTANT_Integer();
-                dynamic_cast<CONSTANT_Integer*>(slot)->bytes =
-                    reader.readget4();
-                dynamic_cast<CONSTANT_Integer*>(slot)->val =
-                    dynamic_cast<CONSTANT_Integer*>(slot)->bytes;
-
-                raw.constPoolInfo[i] = dynamic_cast<CONSTANT_Integer*>(slot);
+            case TAG_Fieldref:
+            case TAG_Methodref:
+            case TAG_InterfaceMethodref:
+            case TAG_NameAndType:
+            case TAG_InvokeDynamic: {
+                const u2 low = reader.readget2();
+                const u2 high = reader.readget2();
+                cp.payloads[i] = low | static_cast<u4>(high) << 16;
                 break;
             }
-            case TAG_Float: {
-                slot = new CONSTANT_Float();
-                dynamic_cast<CONSTANT_Float*>(slot)->bytes = reader.readget4();
-
-                dynamic_cast<CONSTANT_Float*>(slot)->val =
-                    *(float*)(&dynamic_cast<CONSTANT_Float*>(slot)->bytes);
-                raw.constPoolInfo[i] = dynamic_cast<CONSTANT_Float*>(slot);
+            case TAG_MethodHandle: {
+                const u1 referenceKind = reader.readget1();
+                const u2 referenceIndex = reader.readget2();
+                cp.payloads[i] =
+                    referenceKind | static_cast<u4>(referenceIndex) << 16;
                 break;
             }
-            case TAG_Long: {
-                slot = new CONSTANT_Long();
-                dynamic_cast<CONSTANT_Long*>(slot)->highBytes =
-                    reader.readget4();
-                dynamic_cast<CONSTANT_Long*>(slot)->lowBytes =
-                    reader.readget4();
-
-                dynamic_cast<CONSTANT_Long*>(slot)->val =
-                    (((int64_t) dynamic_cast<CONSTANT_Long*>(slot)->highBytes)
-                     << 32) +
-                    dynamic_cast<CONSTANT_Long*>(slot)->lowBytes;
-                raw.constPoolInfo[i++] = dynamic_cast<CONSTANT_Long*>(slot);
-                // All 8-byte constants take up two slot in the constant_pool
-                // table
-                raw.constPoolInfo[i] = nullptr;
+            case TAG_Integer:
+            case TAG_Float:
+                cp.payloads[i] = reader.readget4();
                 break;
-            }
+            case TAG_Long:
             case TAG_Double: {
-                slot = new CONSTANT_Double();
-                dynamic_cast<CONSTANT_Double*>(slot)->highBytes =
-                    reader.readget4();
-                dynamic_cast<CONSTANT_Double*>(slot)->lowBytes =
-                    reader.readget4();
-
-                int64_t val =
-                    (((int64_t) dynamic_cast<CONSTANT_Double*>(slot)->highBytes)
-                     << 32) +
-                    dynamic_cast<CONSTANT_Double*>(slot)->lowBytes;
-                dynamic_cast<CONSTANT_Double*>(slot)->val = *(double*)&val;
-                raw.constPoolInfo[i++] = dynamic_cast<CONSTANT_Double*>(slot);
+                const uint64_t highBytes = reader.readget4();
+                cp.payloads[i] = highBytes << 32 | reader.readget4();
                 // All 8-byte constants take up two slot in the constant_pool
                 // table
-                raw.constPoolInfo[i] = nullptr;
-                break;
-            }
-            case TAG_NameAndType: {
-                slot = new CONSTANT_NameAndType();
-                dynamic_cast<CONSTANT_NameAndType*>(slot)->nameIndex =
-                    reader.readget2();
-                dynamic_cast<CONSTANT_NameAndType*>(slot)->descriptorIndex =
-                    reader.readget2();
-                raw.constPoolInfo[i] =
-                    dynamic_cast<CONSTANT_NameAndType*>(slot);
+                if (++i >= cpCount) {
+                    return false;
+                }
                 break;
             }
             case TAG_Utf8: {
-                slot = new CONSTANT_Utf8();
-                u2 len = reader.readget2();
-                dynamic_cast<CONSTANT_Utf8*>(slot)->length = len;
-                dynamic_cast<CONSTANT_Utf8*>(slot)->bytes = new u1[len + 1];
-                // The utf8 string is not end with '\0' since we do not need to
-                // reserve extra 1 byte
-                for (int k = 0; k < len; k++) {
-                    dynamic_cast<CONSTANT_Utf8*>(slot)->bytes[k] =
-                        reader.readget1();
-                }
-                dynamic_cast<CONSTANT_Utf8*>(slot)->bytes[len] =
-                    '\0';  // End with '\0' for simplicity
-
-                raw.constPoolInfo[i] = dynamic_cast<CONSTANT_Utf8*>(slot);
                 // Todo: support unicode string ; here we just add null-char at
                 // the end of char array
-                break;
-            }
-            case TAG_MethodHandle: {
-                slot = new CONSTANT_MethodHandle();
-                dynamic_cast<CONSTANT_MethodHandle*>(slot)->referenceKind =
-                    reader.readget1();
-                dynamic_cast<CONSTANT_MethodHandle*>(slot)->referenceIndex =
-                    reader.readget2();
-                raw.constPoolInfo[i] =
-                    dynamic_cast<CONSTANT_MethodHandle*>(slot);
-                break;
-            }
-            case TAG_MethodType: {
-                slot = new CONSTANT_MethodType();
-                dynamic_cast<CONSTANT_MethodType*>(slot)->descriptorIndex =
-                    reader.readget2();
-                raw.constPoolInfo[i] = dynamic_cast<CONSTANT_MethodType*>(slot);
-                break;
-            }
-            case TAG_InvokeDynamic: {
-                slot = new CONSTANT_InvokeDynamic();
-                dynamic_cast<CONSTANT_InvokeDynamic*>(slot)
-                    ->bootstrapMethodAttrIndex = reader.readget2();
-                dynamic_cast<CONSTANT_InvokeDynamic*>(slot)->nameAndTypeIndex =
-                    reader.readget2();
-                raw.constPoolInfo[i] =
-                    dynamic_cast<CONSTANT_InvokeDynamic*>(slot);
+                const u2 len = reader.readget2();
+                const size_t offset = cp.utf8Arena.size();
+                cp.utf8Arena.resize(offset + len + 1);
+                reader.readBytes(&cp.utf8Arena[offset], len);
+                cp.utf8Arena[offset + len] = '\0';
+                cp.payloads[i] = offset | static_cast<uint64_t>(len) << 32;
                 break;
             }
             default:
@@ -342,6 +366,13 @@ bool JavaClass::parseConstantPool(u2 cpCount) {
                 return false;
         }
     }
+
+    // Arena does not move anymore, intern names from it
+    for (int i = 1; i <= cpCount - 1; i++) {
+        if (cp.is(i, TAG_Utf8)) {
+            symbols[i] = yrt.symbols->intern(cp.utf8(i), cp.utf8Length(i));
+        }
+    }
     return true;
 }
 
@@ -351,8 +382,7 @@ bool JavaClass::parseInterface(u2 interfaceCount) {
         raw.interfaces[i] = reader.readget2();
         // Each index must be a valid constant pool subscript, which pointed to
         // a CONSTANT_Class structure
-        assert(typeid(*raw.constPoolInfo[raw.interfaces[i]]) ==
-               typeid(CONSTANT_Class));
+        assert(raw.constPool.is(raw.interfaces[i], TAG_Class));
     }
 
     return true;
@@ -386,13 +416,51 @@ bool JavaClass::parseMethod(u2 methodCount) {
         raw.methods[i].accessFlags = reader.readget2();
         raw.methods[i].nameIndex = reader.readget2();
         raw.methods[i].descriptorIndex = reader.readget2();
+        auto parameterAndReturnType = peelMethodParameterAndType(
+            getString(raw.methods[i].descriptorIndex));
+        raw.methods[i].shape.returnType = get<0>(parameterAndReturnType);
+        raw.methods[i].shape.parameterTypes =
+            std::move(get<1>(parameterAndReturnType));
+        raw.methods[i].shape.parameterSlots = static_cast<u2>(
+            countParameterSlots(raw.methods[i].shape.parameterTypes));
         raw.methods[i].attributeCount = reader.readget2();
         parseAttribute(raw.methods[i].attributes,
                        raw.methods[i].attributeCount);
+        resolveExecutionDescriptor(raw.methods[i]);
     }
     return true;
 }
 
+void JavaClass::resolveExecutionDescriptor(MethodInfo& m) {
+    ExecutionDescriptor& exec = m.exec;
+    exec.jc = this;
+    exec.code = nullptr;
+    exec.nativeFunc = nullptr;
+    FOR_EACH(i, m.attributeCount) {
+        if (typeid(*m.attributes[i]) == typeid(ATTR_Code)) {
+            exec.code = static_cast<ATTR_Code*>(m.attributes[i]);
+            break;
+        }
+    }
+    if (exec.code != nullptr) {
+        exec.maxStack = exec.code->maxStack;
+        exec.maxLocal = exec.code->maxLocals;
+    } else {
+        exec.maxStack = exec.maxLocal =
+            m.shape.parameterSlots + (IS_METHOD_STATIC(m.accessFlags) ? 0 : 1);
+    }
+
+    const string descriptor = getString(m.descriptorIndex);
+    exec.returnType = descriptor[descriptor.find(')') + 1];
+    if (IS_METHOD_NATIVE(m.accessFlags)) {
+        auto nativeFunc = yrt.nativeMethods.find(
+            getClassName() + "." + getString(m.nameIndex) + "." + descriptor);
+        if (nativeFunc != yrt.nativeMethods.end()) {
+            exec.nativeFunc = nativeFunc->second;
+        }
+    }
+}
+
 bool JavaClass::parseAttribute(AttributeInfo**(&attrs), u2 attributeCount) {
     attrs = new AttributeInfo*[attributeCount];
 
@@ -404,13 +472,12 @@ bool JavaClass::parseAttribute(AttributeInfo**(&attrs), u2 attributeCount) {
     for (decltype(attributeCount) i = 0; i < attributeCount; i++) {
         const u2 attrStrIndex = reader.readget2();
 
-        if (typeid(*raw.constPoolInfo[attrStrIndex]) != typeid(CONSTANT_Utf8)) {
+        if (attrStrIndex >= raw.constPoolCount ||
+            !raw.constPool.is(attrStrIndex, TAG_Utf8)) {
             return false;
         }
 
-        char* attrName =
-            (char*)dynamic_cast<CONSTANT_Utf8*>(raw.constPoolInfo[attrStrIndex])
-                ->bytes;
+        const char* attrName = raw.constPool.utf8(attrStrIndex);
         IS_ATTR_ConstantValue(attrName) {
             auto* attr = new ATTR_ConstantValue;
             attr->attributeNameIndex = attrStrIndex;
@@ -457,10 +524,12 @@ bool JavaClass::parseAttribute(AttributeInfo**(&attrs), u2 attributeCount) {
                 u1 frameType = reader.readget1();
                 if (IS_STACKFRAME_same_frame(frameType)) {
                     auto* frame = new Frame_Same();
+                    frame->frameType = frameType;
                     attr->entries[k] = frame;
                 } else if (IS_STACKFRAME_same_locals_1_stack_item_frame(
                                frameType)) {
                     auto* frame = new Frame_Same_locals_1_stack_item;
+                    frame->frameType = frameType;
                     frame->stack = new VerificationTypeInfo*[1];
                     frame->stack[0] =
                         determineVerificationType(reader.readget1());
@@ -469,6 +538,7 @@ bool JavaClass::parseAttribute(AttributeInfo**(&attrs), u2 attributeCount) {
                     IS_STACKFRAME_same_locals_1_stack_item_frame_extended(
                         frameType)) {
                     auto* frame = new Frame_Same_locals_1_stack_item_extended;
+                    frame->frameType = frameType;
                     frame->offsetDelta = reader.readget2();
                     frame->stack = new VerificationTypeInfo*[1];
                     frame->stack[0] =
@@ -476,10 +546,12 @@ bool JavaClass::parseAttribute(AttributeInfo**(&attrs), u2 attributeCount) {
                     attr->entries[k] = frame;
                 } else if (IS_STACKFRAME_chop_frame(frameType)) {
                     auto* frame = new Frame_Chop;
+                    frame->frameType = frameType;
                     frame->offsetDelta = reader.readget2();
                     attr->entries[k] = frame;
                 } else if (IS_STACKFRAME_same_frame_extended(frameType)) {
                     auto* frame = new Frame_Same_frame_extended;
+                    frame->frameType = frameType;
                     frame->offsetDelta = reader.readget2();
                     attr->entries[k] = frame;
                 } else if (IS_STACKFRAME_append_frame(frameType)) {
@@ -496,6 +568,7 @@ bool JavaClass::parseAttribute(AttributeInfo**(&attrs), u2 attributeCount) {
                     attr->entries[k] = frame;
                 } else if (IS_STACKFRAME_full_frame(frameType)) {
                     auto* frame = new Frame_Full;
+                    frame->frameType = frameType;
                     frame->offsetDelta = reader.readget2();
                     frame->numberOfLocals = reader.readget2();
                     frame->locals =
@@ -1,6 +1,8 @@
 #ifndef YVM_JAVACLASS_H
 #define YVM_JAVACLASS_H
 
+#include <atomic>
+#include <memory>
 #include "../classfile/ClassFile.h"
 #include "../classfile/FileReader.h"
 #include "../interpreter/Internal.h"
@@ -8,6 +10,7 @@
 #include "../vm/YVM.h"
 #include "JavaType.h"
 #include "MethodArea.h"
+#include "SymbolTable.h"
 
 #define JAVA_9_MAJOR 53
 #define JAVA_8_MAJOR 52
@@ -18,6 +21,28 @@
 
 using namespace std;
 
+class JavaClass;
+struct SymbolicRef;
+
+//--------------------------------------------------------------------------------
+// Entry of virtual method table, an overriding method takes the same index
+// as the method it overrides, so a virtual method is selected by indexing
+// vtable of receiver class with the index of resolved method
+//--------------------------------------------------------------------------------
+struct VirtualMethod {
+    const JavaClass* jc;
+    MethodInfo* method;
+};
+
+//--------------------------------------------------------------------------------
+// Interface method table maps each method of an interface to the vtable index
+// of its implementation in the implementing class
+//--------------------------------------------------------------------------------
+struct InterfaceTable {
+    const JavaClass* interfaceClass;
+    vector<u2> vtableIndexes;
+};
+
 //--------------------------------------------------------------------------------
 // JavaClass is an in-memory representation of java class file. We should call
 // parseClassFile() to parse into proper structure before any operation on*
@@ -30,6 +55,7 @@ class JavaClass {
     friend class MethodArea;
     friend class Interpreter;
     friend class ConcurrentGC;
+    friend class AotCompiler;
 
 public:
     explicit JavaClass(const string& classFilePath);
@@ -37,33 +63,42 @@ public:
     JavaClass(const JavaClass& rhs);
 
 public:
-    forceinline ConstantPoolInfo* getConstPoolItem(u2 index) const {
-        return raw.constPoolInfo[index];
+    forceinline const ConstantPool& getConstPool() const {
+        return raw.constPool;
+    }
+
+    // Interned symbol of given Utf8 constant pool entry
+    forceinline const Symbol* getSymbol(u2 index) const {
+        return symbols[index];
     }
 
-    forceinline const string getString(u2 index) const {
-        return reinterpret_cast<const char*>(
-            dynamic_cast<CONSTANT_Utf8*>(raw.constPoolInfo[index])->bytes);
+    forceinline const string& getString(u2 index) const {
+        return symbols[index]->str();
     }
 
-    forceinline const string getClassName() const {
-        return getString(
-            dynamic_cast<CONSTANT_Class*>(raw.constPoolInfo[raw.thisClass])
-                ->nameIndex);
+    forceinline const Symbol* getClassSymbol() const {
+        return getSymbol(raw.constPool.nameIndex(raw.thisClass));
     }
 
-    forceinline const string getSuperClassName() const {
+    // Null if this class has no superclass, i.e. java/lang/Object
+    forceinline const Symbol* getSuperClassSymbol() const {
         return raw.superClass == 0
-                   ? ""
-                   : getString(dynamic_cast<CONSTANT_Class*>(
-                                   raw.constPoolInfo[raw.superClass])
-                                   ->nameIndex);
+                   ? nullptr
+                   : getSymbol(raw.constPool.nameIndex(raw.superClass));
     }
 
-    forceinline const string getInterfaceClassName(u2 index) const {
-        return getString(dynamic_cast<CONSTANT_Class*>(
-                             raw.constPoolInfo[raw.interfaces[index]])
-                             ->nameIndex);
+    forceinline const string& getClassName() const {
+        return getClassSymbol()->str();
+    }
+
+    forceinline const string& getSuperClassName() const {
+        static const string noSuperClass;
+        return raw.superClass == 0 ? noSuperClass
+                                   : getSuperClassSymbol()->str();
+    }
+
+    forceinline const string& getInterfaceClassName(u2 index) const {
+        return getString(raw.constPool.nameIndex(raw.interfaces[index]));
     }
 
     forceinline bool hasSuperClass() const { return raw.superClass != 0; }
@@ -74,12 +109,51 @@ public:
 
     forceinline u2 getAccessFlag() const { return raw.accessFlags; }
 
+    // Count of instance fields including those inherited from superclasses
+    forceinline u4 getInstanceFieldCount() const { return instanceFieldCount; }
+
+    // Whether vtable and itables of this class have been built
+    forceinline bool isLinked() const {
+        return linked.load(memory_order_acquire);
+    }
+
+    forceinline const VirtualMethod& getVirtualMethod(u2 index) const {
+        return vtable[index];
+    }
+
+    forceinline size_t getVirtualMethodCount() const { return vtable.size(); }
+
+    // Whether <clinit> of this class has finished
+    forceinline bool isInitialized() const {
+        return initialized.load(memory_order_acquire);
+    }
+
+    // Symbolic reference resolved from given constant pool entry, null if it
+    // has not been resolved yet
+    forceinline const SymbolicRef* getResolvedRef(u2 index) const {
+        return resolvedRefs[index].load(memory_order_acquire);
+    }
+
 public:
     MethodInfo* findMethod(const string& methodName,
                            const string& methodDescriptor) const;
+    MethodInfo* findMethod(const Symbol* methodName,
+                           const Symbol* methodDescriptor) const;
     bool setStaticVar(const string& name, const string& descriptor,
                       JType* value);
     JType* getStaticVar(const string& name, const string& descriptor);
+    const JavaClass* findInstanceField(const string& name,
+                                       const string& descriptor,
+                                       u4& ordinal) const;
+    const JavaClass* findInstanceField(const Symbol* name,
+                                       const Symbol* descriptor,
+                                       u4& ordinal) const;
+    JavaClass* findStaticField(const Symbol* name, const Symbol* descriptor,
+                               u2& fieldIndex);
+    int findVirtualMethod(const string& name, const string& descriptor) const;
+    int findVirtualMethod(const Symbol* name, const Symbol* descriptor) const;
+    int findInterfaceMethod(const JavaClass* interfaceClass, u2 index) const;
+    const SymbolicRef* publishResolvedRef(u2 index, SymbolicRef* ref) const;
 
 private:
     void parseClassFile();
@@ -88,6 +162,7 @@ private:
     bool parseField(u2 fieldCount);
     bool parseMethod(u2 methodCount);
     bool parseAttribute(AttributeInfo**(&attrs), u2 attributeCount);
+    void resolveExecutionDescriptor(MethodInfo& m);
 
 private:
     VerificationTypeInfo* determineVerificationType(u1 tag);
@@ -96,10 +171,25 @@ private:
     Annotation readToAnnotationStructure();
     vector<u2> getInterfacesIndex() const;
 
+    forceinline const char* getUtf8(u2 index) const {
+        return raw.constPool.utf8(index);
+    }
+
 private:
     ClassFile raw{};
     FileReader reader;
     map<size_t, JType*> staticVars;
+    u4 instanceFieldCount = 0;
+    vector<VirtualMethod> vtable;
+    vector<InterfaceTable> itables;
+    atomic<bool> linked{false};
+    atomic<bool> initialized{false};
+    // Resolved constant pool cache indexed by constant pool index, entries
+    // are filled lazily when the instruction referring to them was executed
+    unique_ptr<atomic<SymbolicRef*>[]> resolvedRefs;
+    // Interned symbols indexed by constant pool index, null for entries other
+    // than Utf8
+    unique_ptr<const Symbol*[]> symbols;
 };
 
 #endif  // YVM_JAVACLASS_H
@@ -1,52 +1,79 @@
 #include <cstring>
 #include "JavaFrame.hpp"
 
-JavaFrame::~JavaFrame() {
-    while (top_) {
-        auto* temp = top_;
-        top_ = top_->next;
-        delete temp;
-    }
+JavaFrame::JavaFrame()
+    : slotBase(new JValue[YVM_FRAME_STACK_SLOTS]),
+      slotLimit(slotBase + YVM_FRAME_STACK_SLOTS),
+      freeSlot(slotBase) {
+    frameStack.reserve(YVM_MAX_FRAME_DEPTH);
 }
 
-void JavaFrame::pushFrame(int maxLocal, int maxStack) {
-    auto* slots = new Slots{maxLocal, maxStack};
+JavaFrame::~JavaFrame() { delete[] slotBase; }
+
+bool JavaFrame::pushFrame(int maxLocal, int maxStack, int argSlots,
+                          bool clearLocals) {
+    // Arguments on top of operand stack of caller are laid out exactly the
+    // same as leading local variables of callee, so the local variables of
+    // callee start right there and arguments are passed without copying
+    JValue *base = freeSlot;
+    if (argSlots > 0) {
+        base = top_->stackSlots + top_->stackTop - argSlots;
+    }
+    // Each frame keeps one slot above its operand stack, where a
+    // StackOverflowError or an exception thrown by its callee is pushed even
+    // if the operand stack is full
+    if (depth == YVM_MAX_FRAME_DEPTH ||
+        maxLocal + maxStack >= slotLimit - base) {
+        return false;
+    }
+    if (depth == frameStack.size()) {
+        frameStack.emplace_back();
+    }
+    if (argSlots > 0) {
+        top_->stackTop -= argSlots;
+    }
+    Slots *slots = &frameStack[depth++];
+    slots->localSlots = base;
+    slots->stackSlots = base + maxLocal;
+    slots->maxLocal = maxLocal;
+    slots->maxStack = maxStack;
+    slots->stackTop = 0;
     slots->next = top_;
+    slots->jc = nullptr;
+    slots->method = nullptr;
+    slots->decoded = nullptr;
+    slots->pc = nullptr;
+    // Local variables are scanned by GC, references left by former frames
+    // must not be seen
+    if (clearLocals) {
+        memset(slots->localSlots + argSlots, 0,
+               sizeof(JValue) * (maxLocal - argSlots));
+    }
+
+    freeSlot = slots->stackSlots + maxStack + 1;
     top_ = slots;
+    return true;
 }
 
 void JavaFrame::popFrame() {
-    auto* temp = top_;
+    // Callee may overlap operand stack of caller, the free region starts
+    // after the whole operand stack of caller again
     top_ = top_->next;
-    delete temp;
+    freeSlot =
+        top_ != nullptr ? top_->stackSlots + top_->maxStack + 1 : slotBase;
+    depth--;
 }
 
-Slots::Slots(int maxLocal, int maxStack)
-    : maxLocal(maxLocal),
-      maxStack(maxStack),
-      next(nullptr),
-      localSlots(nullptr),
-      stackSlots(nullptr) {
-    if (maxLocal > 0) {
-        localSlots = new JType*[maxLocal];
-        memset(localSlots, 0, sizeof(JType*) * maxLocal);
+void JavaFrame::grow(int size) {
+    if (size >= slotLimit - freeSlot) {
+        throw std::runtime_error("frame stack exhausted");
     }
-    if (maxStack > 0) {
-        stackSlots = new JType*[maxStack];
-        memset(stackSlots, 0, sizeof(JType*) * maxStack);
-    }
-
-    stackTop = 0;
-}
-
-Slots::~Slots() {
-    delete[] stackSlots;
-
-    delete[] localSlots;
+    top_->maxStack += size;
+    freeSlot += size;
 }
 
-void Slots::setLocalVariable(u1 index, JType* var) {
-    if (index > maxLocal) {
+void Slots::setLocalVariable(u1 index, const JValue& var) {
+    if (index >= maxLocal) {
         throw std::logic_error("invalid local variable slot index");
     }
     localSlots[index] = var;
@@ -60,14 +87,3 @@ void Slots::dump() {
         temp = temp->next;
     }
 }
-
-void Slots::grow(int size) {
-    JType** newStack = new JType*[size + maxStack];
-    memset(newStack, 0, sizeof(JType*) * (size + maxStack));
-    for (int i = 0; i < maxStack; i++) {
-        newStack[i] = stackSlots[i];
-    }
-    delete[] stackSlots;
-    this->stackSlots = newStack;
-    (int)this->maxStack = maxStack + size;
-}
@@ -2,26 +2,30 @@
 #define YVM_JAVAFRAME_H
 
 #include <exception>
-#include <list>
+#include <vector>
 #include "../gc/Concurrent.hpp"
 #include "../interpreter/Internal.h"
+#include "../misc/Option.h"
 #include "../misc/Utils.h"
 #include "JavaType.h"
 
 using namespace std;
 
+class JavaClass;
+struct DecodedCode;
+struct Instruction;
 struct JType;
+struct MethodInfo;
 
 class Slots {
     friend class JavaFrame;
     friend class ConcurrentGC;
     friend class Interpreter;
+    friend class TemplateJIT;
+    friend class TraceJIT;
+    friend class TraceRecorder;
 
 public:
-    explicit Slots(int maxLocal, int maxStack);
-
-    ~Slots();
-
     // Check if current frame's stack slots were empty
     bool emptyStack() const { return stackTop == 0; }
 
@@ -32,51 +36,78 @@ public:
     // Store variable from stack top to local variable by given index and
     // pop it from stack
     template <typename StoreType>
-    void store(u1 index);
+    void store(u1 localIndex);
 
     // Push new variable to current frame's stack slot
-    void push(JType *var) { stackSlots[stackTop++] = var; }
+    template <typename PushType>
+    void push(typename SlotTraits<PushType>::ValueType value);
 
     // Pop variable from top of the current frame's stack
     template <typename PopType>
-    PopType *pop();
+    typename SlotTraits<PopType>::ValueType pop();
+
+    // Pop variable from top of the current frame's stack and keep its tag
+    template <typename PopType>
+    JValue popValue();
+
+    // Push a tagged value, a long or double value takes up two slots
+    void pushValue(const JValue& value);
+
+    // Push/pop a single raw slot regardless of what it holds
+    void pushSlot(const JValue& slot) { stackSlots[stackTop++] = slot; }
+    JValue popSlot() { return stackSlots[--stackTop]; }
 
     // Set new variable to current frame's local variable slot
-    void setLocalVariable(u1 index, JType *var);
+    void setLocalVariable(u1 index, const JValue& var);
 
     // Get variable from local variables by given index
-    JType *getLocalVariable(u1 index) { return localSlots[index]; }
+    JValue& getLocalVariable(u1 index) { return localSlots[index]; }
 
     // Dump current frame to stdout
     void dump();
 
-    // Reallocate stack slots size accorrding to argument, this can be used when
-    // an exception occurred
-    void grow(int size);
-
 private:
-    std::list<JType *> exceptions;
-    JType **localSlots;
-    JType **stackSlots;
-    const int maxLocal;
-    const int maxStack;
-    int stackTop;
-    Slots *next;
+    JValue *localSlots{};
+    JValue *stackSlots{};
+    int maxLocal{};
+    int maxStack{};
+    int stackTop{};
+    Slots *next{};
+
+    // Method executed by this frame. When it calls another method without
+    // leaving the dispatch loop, pc holds the invoking instruction until
+    // callee returns
+    const JavaClass *jc{};
+    const MethodInfo *method{};
+    DecodedCode *decoded{};
+    Instruction *pc{};
 };
 
 //--------------------------------------------------------------------------------
 // Java frame represents runtime frames. Each interpreter has a JavaFrame, it
 // consists of many Slots, one Slots is logically divided into local variable
-// slots and stack slots
+// slots and stack slots. Slots of all frames are carved out of one contiguous
+// region, pushing a frame bumps the free pointer and popping a frame moves it
+// back, so entering and leaving methods never allocates memory
 //--------------------------------------------------------------------------------
 class JavaFrame {
     friend class ConcurrentGC;
 
 public:
+    JavaFrame();
     ~JavaFrame();
 
-    // Push new frame
-    void pushFrame(int maxLocal, int maxStack);
+    // Push new frame, returns false if the frame stack was exhausted. The
+    // top argSlots slots of operand stack of current frame are popped and
+    // become leading local variables of new frame. Other local variables are
+    // cleared unless they were already written in place
+    bool pushFrame(int maxLocal, int maxStack, int argSlots = 0,
+                   bool clearLocals = true);
+
+    // Check if frameCount more frames whose slots end at end could be pushed
+    bool hasRoom(const JValue *end, int frameCount) const {
+        return depth + frameCount <= YVM_MAX_FRAME_DEPTH && end < slotLimit;
+    }
 
     // Pop top frame
     void popFrame();
@@ -90,59 +121,112 @@ public:
     // Return next to top's frame
     Slots *nextFrame() { return top_->next; }
 
+    // Enlarge operand stack of top frame accorrding to argument, compiled code
+    // entered by OSR keeps frames of inlined methods there
+    void grow(int size);
+
 private:
     Slots *top_{};
+    JValue *slotBase;
+    JValue *slotLimit;
+    JValue *freeSlot;
+    // Frame metadata, its capacity is reserved up front so that elements
+    // never move and Slots::next stays valid
+    std::vector<Slots> frameStack;
+    size_t depth = 0;
 };
 
-template <typename LoadType>
-inline void Slots::load(u1 localIndex) {
-    auto *var = new LoadType;
-    var->val = dynamic_cast<LoadType *>(localSlots[localIndex])->val;
-    stackSlots[stackTop++] = var;
+//--------------------------------------------------------------------------------
+// Primitives over raw slots. Stack pointer always points to the first free
+// slot of operand stack, the interpreter keeps it in a register variable while
+// executing a method and writes it back to Slots::stackTop only when someone
+// else needs to inspect current frame
+//--------------------------------------------------------------------------------
+template <typename Type>
+forceinline void pushOperand(JValue *&sp,
+                             typename SlotTraits<Type>::ValueType value) {
+    SlotTraits<Type>::set(*sp, value);
+    if (SlotTraits<Type>::size == 2) {
+        sp[1].tag = SlotTag::Top;
+    }
+    sp += SlotTraits<Type>::size;
+}
+
+template <typename Type>
+forceinline typename SlotTraits<Type>::ValueType popOperand(JValue *&sp) {
+    sp -= SlotTraits<Type>::size;
+    return SlotTraits<Type>::get(*sp);
+}
+
+template <typename Type>
+forceinline JValue popOperandValue(JValue *&sp) {
+    sp -= SlotTraits<Type>::size;
+    return *sp;
 }
 
-template <>
-inline void Slots::load<JRef>(u1 localIndex) {
-    JType *var{};
-    if (typeid(*localSlots[localIndex]) == typeid(JObject)) {
-        var = new JObject;
-        dynamic_cast<JObject *>(var)->jc =
-            dynamic_cast<JObject *>(localSlots[localIndex])->jc;
-        dynamic_cast<JObject *>(var)->offset =
-            dynamic_cast<JObject *>(localSlots[localIndex])->offset;
-    } else if (typeid(*localSlots[localIndex]) == typeid(JArray)) {
-        var = new JArray;
-        dynamic_cast<JArray *>(var)->length =
-            dynamic_cast<JArray *>(localSlots[localIndex])->length;
-        dynamic_cast<JArray *>(var)->offset =
-            dynamic_cast<JArray *>(localSlots[localIndex])->offset;
-    } else {
-        SHOULD_NOT_REACH_HERE
+forceinline void pushOperandValue(JValue *&sp, const JValue &value) {
+    *sp++ = value;
+    if (value.tag == SlotTag::Long || value.tag == SlotTag::Double) {
+        (sp++)->tag = SlotTag::Top;
     }
-    stackSlots[stackTop++] = var;
 }
 
-template <typename StoreType>
-inline void Slots::store(u1 localIndex) {
-    if (stackTop) {
-        stackTop--;
+template <typename Type>
+forceinline void loadLocal(JValue *&sp, const JValue *locals, u2 index) {
+    *sp++ = locals[index];
+    if (SlotTraits<Type>::size == 2) {
+        *sp++ = locals[index + 1];
     }
-    auto *var = dynamic_cast<StoreType *>(stackSlots[stackTop]);
-    stackSlots[stackTop] = nullptr;
-    localSlots[localIndex] = var;
-    if (IS_JLong(var) || IS_JDouble(var)) {
-        localSlots[localIndex++] = nullptr;
+}
+
+template <typename Type>
+forceinline void storeLocal(JValue *&sp, JValue *locals, u2 index) {
+    sp -= SlotTraits<Type>::size;
+    locals[index] = sp[0];
+    if (SlotTraits<Type>::size == 2) {
+        locals[index + 1] = sp[1];
     }
 }
 
+template <typename LoadType>
+inline void Slots::load(u1 localIndex) {
+    JValue *sp = stackSlots + stackTop;
+    loadLocal<LoadType>(sp, localSlots, localIndex);
+    stackTop = static_cast<int>(sp - stackSlots);
+}
+
+template <typename StoreType>
+inline void Slots::store(u1 localIndex) {
+    JValue *sp = stackSlots + stackTop;
+    storeLocal<StoreType>(sp, localSlots, localIndex);
+    stackTop = static_cast<int>(sp - stackSlots);
+}
+
+template <typename PushType>
+inline void Slots::push(typename SlotTraits<PushType>::ValueType value) {
+    JValue *sp = stackSlots + stackTop;
+    pushOperand<PushType>(sp, value);
+    stackTop = static_cast<int>(sp - stackSlots);
+}
+
 template <typename PopType>
-inline PopType *Slots::pop() {
-    if (stackTop) {
-        stackTop--;
-    }
-    auto *var = dynamic_cast<PopType *>(stackSlots[stackTop]);
-    stackSlots[stackTop] = nullptr;
-    return var;
+inline typename SlotTraits<PopType>::ValueType Slots::pop() {
+    JValue *sp = stackSlots + stackTop;
+    auto value = popOperand<PopType>(sp);
+    stackTop = static_cast<int>(sp - stackSlots);
+    return value;
+}
+
+template <typename PopType>
+inline JValue Slots::popValue() {
+    stackTop -= SlotTraits<PopType>::size;
+    return stackSlots[stackTop];
+}
+
+inline void Slots::pushValue(const JValue &value) {
+    JValue *sp = stackSlots + stackTop;
+    pushOperandValue(sp, value);
+    stackTop = static_cast<int>(sp - stackSlots);
 }
 
 #endif
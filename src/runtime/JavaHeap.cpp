@@ -163,67 +163,24 @@ JArray* JavaHeap::createCharArray(const string& source, size_t length) {
     return arr;
 }
 
-// get object's field by name and descriptor or set object's field by given
-// value note that we should not use object->jc to instead the first
-// argument since we might lookup a field in base class, while the derive
-// class has the same name
-// For example, there might be two classes, which one has field_a, and another
-// has the same field  name and the later(ClassA) extends previous
-// class(ClassB), now if we want to get/set ClassB.field we must set
-// desireLookup as ClassA, and currentLookup for object->jc, which means starts
-// lookup from current object related class(ClassB)
-JType* JavaHeap::getFieldByNameImpl(const JavaClass* desireLookup,
-                                    const JavaClass* currentLookup,
-                                    const string& name,
-                                    const string& descriptor, JObject* object,
-                                    size_t offset /*= 0*/) {
-    lock_guard<recursive_mutex> lock(objMtx);
-    size_t howManyNonStaticFields = 0;
-    FOR_EACH(i, currentLookup->raw.fieldsCount) {
-        if (!IS_FIELD_STATIC(currentLookup->raw.fields[i].accessFlags)) {
-            howManyNonStaticFields++;
-            const string& n = currentLookup->getString(
-                currentLookup->raw.fields[i].nameIndex);
-            const string& d = currentLookup->getString(
-                currentLookup->raw.fields[i].descriptorIndex);
-            if (n == name && d == descriptor && desireLookup == currentLookup) {
-                return objectContainer.find(object->offset)[i + offset];
-            }
-        }
-    }
-    if (currentLookup->raw.superClass != 0) {
-        return getFieldByNameImpl(
-            desireLookup,
-            yrt.ma->findJavaClass(currentLookup->getSuperClassName()), name,
-            descriptor, object, offset + howManyNonStaticFields);
-    }
-    return nullptr;
-}
-
-void JavaHeap::putFieldByNameImpl(const JavaClass* desireLookup,
-                                  const JavaClass* currentLookup,
-                                  const string& name, const string& descriptor,
-                                  JObject* object, JType* value,
-                                  size_t offset /*= 0*/) {
-    lock_guard<recursive_mutex> lock(objMtx);
-    size_t howManyNonStaticFields = 0;
-    FOR_EACH(i, currentLookup->raw.fieldsCount) {
-        if (!IS_FIELD_STATIC(currentLookup->raw.fields[i].accessFlags)) {
-            howManyNonStaticFields++;
-            const string& n = currentLookup->getString(
-                currentLookup->raw.fields[i].nameIndex);
-            const string& d = currentLookup->getString(
-                currentLookup->raw.fields[i].descriptorIndex);
-            if (n == name && d == descriptor && desireLookup == currentLookup) {
-                objectContainer.find(object->offset)[i + offset] = value;
-                return;
-            }
-        }
-    }
-    if (currentLookup->raw.superClass != 0) {
-        putFieldByNameImpl(
-            desireLookup,
-            yrt.ma->findJavaClass(currentLookup->getSuperClassName()), name,
-            descriptor, object, value, offset + howManyNonStaticFields);
+// Locate object's field by field symbolic reference. Fields of an object are
+// laid out from its own class to its farthest superclass, a field declared by
+// class C therefore has the same distance to the end of field list for any
+// object whose class is C or subclass of C, so we don't need to care about
+// which class the object actually is.
+// For example, if ClassA extends ClassB and both of them have field_a, an
+// object of ClassA is laid out as [ClassA.field_a, ClassB.field_a], we can get
+// ClassB.field_a by looking up from ClassB while the object is a ClassA
+bool JavaHeap::findFieldOffset(const JavaClass* jc, const string& name,
+                               const string& descriptor, const JObject* object,
+                               size_t& fieldOffset) {
+    u4 ordinal = 0;
+    const JavaClass* declaringClass =
+        jc->findInstanceField(name, descriptor, ordinal);
+    if (declaringClass == nullptr) {
+        return false;
     }
+    fieldOffset = object->jc->getInstanceFieldCount() -
+                  declaringClass->getInstanceFieldCount() + ordinal;
+    return true;
 }
\ No newline at end of file
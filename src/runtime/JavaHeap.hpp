@@ -124,6 +124,10 @@ struct MonitorContainer : public Container<InternalMonitor> {
         getContainer().insert(make_pair(lastOffset + 1, new ObjectMonitor()));
         return lastOffset + 1;
     }
+    // Monitor of an object shares the same offset with object itself
+    void place(size_t offset) {
+        getContainer().insert(make_pair(offset, new ObjectMonitor()));
+    }
 };
 //--------------------------------------------------------------------------------
 // Java heap holds instance's fields data which object referred to and elements
@@ -142,21 +146,28 @@ public:
     JArray* createObjectArray(const JavaClass& jc, int length);
     JArray* createCharArray(const string& source, size_t length);
 
-    auto getFieldByName(const JavaClass* jc, const string& name,
-                        const string& descriptor, JObject* object) {
-        return getFieldByNameImpl(jc, object->jc, name, descriptor, object, 0);
+    JType* getFieldByName(const JavaClass* jc, const string& name,
+                          const string& descriptor, JObject* object) {
+        size_t fieldOffset = 0;
+        if (!findFieldOffset(jc, name, descriptor, object, fieldOffset)) {
+            return nullptr;
+        }
+        return getFieldByOffset(*object, fieldOffset);
     }
     void putFieldByName(const JavaClass* jc, const string& name,
                         const string& descriptor, JObject* object,
                         JType* value) {
-        putFieldByNameImpl(jc, object->jc, name, descriptor, object, value, 0);
+        size_t fieldOffset = 0;
+        if (findFieldOffset(jc, name, descriptor, object, fieldOffset)) {
+            putFieldByOffset(*object, fieldOffset, value);
+        }
     }
     void putFieldByOffset(const JObject& object, size_t fieldOffset,
                           JType* value) {
         lock_guard<recursive_mutex> lock(objMtx);
         objectContainer.find(object.offset)[fieldOffset] = value;
     }
-    auto getFieldByOffset(const JObject& object, size_t fieldOffset) {
+    JType* getFieldByOffset(const JObject& object, size_t fieldOffset) {
         lock_guard<recursive_mutex> lock(objMtx);
         return objectContainer.find(object.offset)[fieldOffset];
     }
@@ -191,9 +202,9 @@ public:
         lock_guard<recursive_mutex> lock(monitorMtx);
         return monitorContainer.has(dynamic_cast<const JObject*>(ref)->offset);
     }
-    auto createMonitor() {
+    void createMonitor(const JType* ref) {
         lock_guard<recursive_mutex> lock(monitorMtx);
-        return monitorContainer.place();
+        monitorContainer.place(dynamic_cast<const JObject*>(ref)->offset);
     }
     auto findMonitor(const JType* ref) {
         lock_guard<recursive_mutex> lock(monitorMtx);
@@ -203,14 +214,9 @@ public:
 private:
     void createSuperFields(const JavaClass& javaClass, const JObject* object);
 
-    JType* getFieldByNameImpl(const JavaClass* desireLookup,
-                              const JavaClass* currentLookup,
-                              const string& name, const string& descriptor,
-                              JObject* object, size_t offset = 0);
-    void putFieldByNameImpl(const JavaClass* desireLookup,
-                            const JavaClass* currentLookup, const string& name,
-                            const string& descriptor, JObject* object,
-                            JType* value, size_t offset = 0);
+    static bool findFieldOffset(const JavaClass* jc, const string& name,
+                                const string& descriptor,
+                                const JObject* object, size_t& fieldOffset);
 
 private:
     ObjectContainer objectContainer;
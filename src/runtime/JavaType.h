@@ -54,6 +54,75 @@ struct JArray BASE_OF_JTYPE {
     std::size_t offset = 0;  // Offset on java heap
 };
 
+//--------------------------------------------------------------------------------
+// JValue is an unboxed slot of operand stack and local variables. Each slot is
+// 64 bits wide and tagged with the kind of value it holds, so pushing, loading
+// and storing values never allocate memory nor require RTTI. As jvm
+// specification described, long and double take up two consecutive slots, the
+// value lives in the lower one and the higher one is tagged as Top.
+//--------------------------------------------------------------------------------
+enum class SlotTag : uint8_t { Top = 0, Int, Float, Long, Double, Ref };
+
+struct JValue {
+    union {
+        int32_t i;
+        float f;
+        int64_t j;
+        double d;
+        JType* ref;
+    };
+    SlotTag tag;
+};
+
+//--------------------------------------------------------------------------------
+// SlotTraits describes how a JType is represented within JValue slots
+//--------------------------------------------------------------------------------
+template <typename Type>
+struct SlotTraits;
+
+#define DEF_PRIMITIVE_SLOT_TRAITS(type, valueType, field, slotTag, slotSize) \
+    template <>                                                             \
+    struct SlotTraits<type> {                                               \
+        using ValueType = valueType;                                        \
+        static const SlotTag tag = SlotTag::slotTag;                        \
+        static const int size = slotSize;                                   \
+        static ValueType get(const JValue& v) { return v.field; }           \
+        static void set(JValue& v, ValueType val) {                         \
+            v.field = val;                                                  \
+            v.tag = SlotTag::slotTag;                                       \
+        }                                                                   \
+    };
+
+#define DEF_REFERENCE_SLOT_TRAITS(type)                                 \
+    template <>                                                        \
+    struct SlotTraits<type> {                                          \
+        using ValueType = type*;                                       \
+        static const SlotTag tag = SlotTag::Ref;                       \
+        static const int size = 1;                                     \
+        static ValueType get(const JValue& v) {                        \
+            return static_cast<type*>(v.ref);                          \
+        }                                                              \
+        static void set(JValue& v, ValueType val) {                    \
+            v.ref = val;                                               \
+            v.tag = SlotTag::Ref;                                      \
+        }                                                              \
+    };
+
+DEF_PRIMITIVE_SLOT_TRAITS(JInt, int32_t, i, Int, 1)
+DEF_PRIMITIVE_SLOT_TRAITS(JFloat, float, f, Float, 1)
+DEF_PRIMITIVE_SLOT_TRAITS(JLong, int64_t, j, Long, 2)
+DEF_PRIMITIVE_SLOT_TRAITS(JDouble, double, d, Double, 2)
+DEF_REFERENCE_SLOT_TRAITS(JType)
+DEF_REFERENCE_SLOT_TRAITS(JObject)
+DEF_REFERENCE_SLOT_TRAITS(JArray)
+
+template <typename Type>
+inline JValue makeValue(typename SlotTraits<Type>::ValueType val) {
+    JValue v;
+    SlotTraits<Type>::set(v, val);
+    return v;
+}
+
 #define IS_JINT(x) (typeid(*x) == typeid(JInt))
 #define IS_JLong(x) (typeid(*x) == typeid(JLong))
 #define IS_JDouble(x) (typeid(*x) == typeid(JDouble))
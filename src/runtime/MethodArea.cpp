@@ -1,6 +1,9 @@
 #include "../classfile/AccessFlag.h"
+#include "../jit/TemplateJIT.h"
 #include "JavaClass.h"
 #include "MethodArea.h"
+#include "RuntimeEnv.h"
+#include "SymbolTable.h"
 
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
@@ -21,6 +24,12 @@ MethodArea::~MethodArea() {
 }
 
 JavaClass* MethodArea::findJavaClass(const string& jcName) {
+    // A class name that was never interned can not name a loaded class
+    const Symbol* symbol = yrt.symbols->lookup(jcName);
+    return symbol != nullptr ? findJavaClass(symbol) : nullptr;
+}
+
+JavaClass* MethodArea::findJavaClass(const Symbol* jcName) {
     lock_guard<recursive_mutex> lockMA(maMutex);
 
     const auto pos = classTable.find(jcName);
@@ -39,17 +48,31 @@ bool MethodArea::loadJavaClass(const string& jcName) {
         // Load this class which specified by jcName (it' a path string)
         auto* jc = new JavaClass(path);
         jc->parseClassFile();
-        classTable.insert(make_pair(jc->getClassName(), jc));
+        classTable.insert(make_pair(jc->getClassSymbol(), jc));
 
         // Load super class if it doesn't exist in the class table
-        if (!jc->getSuperClassName().empty() &&
-            !findJavaClass(jc->getSuperClassName())) {
+        if (jc->hasSuperClass() && !findJavaClass(jc->getSuperClassSymbol())) {
             this->loadJavaClass(jc->getSuperClassName());
         }
 
+        // Instance fields of an object are laid out from its own class to
+        // its farthest superclass, see JavaHeap::createObject()
+        FOR_EACH(i, jc->raw.fieldsCount) {
+            if (!IS_FIELD_STATIC(jc->raw.fields[i].accessFlags)) {
+                jc->instanceFieldCount++;
+            }
+        }
+        if (jc->hasSuperClass()) {
+            const JavaClass* superClass =
+                findJavaClass(jc->getSuperClassSymbol());
+            if (superClass != nullptr) {
+                jc->instanceFieldCount += superClass->instanceFieldCount;
+            }
+        }
+
         // Load super interfaces if existed
         vector<u2>&& interfacesIdx = jc->getInterfacesIndex();
-        if (jc->getInterfacesIndex().empty()) {
+        if (!interfacesIdx.empty()) {
             for (auto idx : interfacesIdx) {
                 this->loadJavaClass(jc->getString(idx));
             }
@@ -80,12 +103,11 @@ void MethodArea::linkJavaClass(const string& jcName) {
                         typeid(ATTR_ConstantValue)) {
                         if ("Ljava/lang/String;" == descriptor) {
                             const string& constantStr = javaClass->getString(
-                                ((CONSTANT_String*)javaClass->raw.constPoolInfo
-                                     [((ATTR_ConstantValue*)javaClass->raw
-                                           .fields[fieldOffset]
-                                           .attributes[fieldAttr])
-                                          ->constantValueIndex])
-                                    ->stringIndex);
+                                javaClass->raw.constPool.nameIndex(
+                                    ((ATTR_ConstantValue*)javaClass->raw
+                                         .fields[fieldOffset]
+                                         .attributes[fieldAttr])
+                                        ->constantValueIndex));
                             size_t strLen = constantStr.length();
                             fieldObject = yrt.jheap->createObject(
                                 *loadClassIfAbsent("java/lang/String"));
@@ -126,60 +148,31 @@ void MethodArea::linkJavaClass(const string& jcName) {
                     if (typeid(*javaClass->raw.fields[fieldOffset]
                                     .attributes[fieldAttr]) ==
                         typeid(ATTR_ConstantValue)) {
-                        if (typeid(*javaClass->raw.constPoolInfo
-                                        [((ATTR_ConstantValue*)javaClass->raw
-                                              .fields[fieldOffset]
-                                              .attributes[fieldAttr])
-                                             ->constantValueIndex]) ==
-                            typeid(CONSTANT_Long)) {
-                            ((JLong*)basicField)->val =
-                                ((CONSTANT_Long*)javaClass->raw.constPoolInfo
-                                     [((ATTR_ConstantValue*)javaClass->raw
-                                           .fields[fieldOffset]
-                                           .attributes[fieldAttr])
-                                          ->constantValueIndex])
-                                    ->val;
-                        } else if (typeid(*javaClass->raw.constPoolInfo
-                                               [((ATTR_ConstantValue*)javaClass
-                                                     ->raw.fields[fieldOffset]
-                                                     .attributes[fieldAttr])
-                                                    ->constantValueIndex]) ==
-                                   typeid(CONSTANT_Double)) {
-                            ((JDouble*)basicField)->val =
-                                ((CONSTANT_Double*)javaClass->raw.constPoolInfo
-                                     [((ATTR_ConstantValue*)javaClass->raw
-                                           .fields[fieldOffset]
-                                           .attributes[fieldAttr])
-                                          ->constantValueIndex])
-                                    ->val;
-                        } else if (typeid(*javaClass->raw.constPoolInfo
-                                               [((ATTR_ConstantValue*)javaClass
-                                                     ->raw.fields[fieldOffset]
-                                                     .attributes[fieldAttr])
-                                                    ->constantValueIndex]) ==
-                                   typeid(CONSTANT_Float)) {
-                            ((JFloat*)basicField)->val =
-                                ((CONSTANT_Float*)javaClass->raw.constPoolInfo
-                                     [((ATTR_ConstantValue*)javaClass->raw
-                                           .fields[fieldOffset]
-                                           .attributes[fieldAttr])
-                                          ->constantValueIndex])
-                                    ->val;
-                        } else if (typeid(*javaClass->raw.constPoolInfo
-                                               [((ATTR_ConstantValue*)javaClass
-                                                     ->raw.fields[fieldOffset]
-                                                     .attributes[fieldAttr])
-                                                    ->constantValueIndex]) ==
-                                   typeid(CONSTANT_Integer)) {
-                            ((JInt*)basicField)->val =
-                                ((CONSTANT_Integer*)javaClass->raw.constPoolInfo
-                                     [((ATTR_ConstantValue*)javaClass->raw
-                                           .fields[fieldOffset]
-                                           .attributes[fieldAttr])
-                                          ->constantValueIndex])
-                                    ->val;
-                        } else {
-                            SHOULD_NOT_REACH_HERE
+                        const ConstantPool& cp = javaClass->raw.constPool;
+                        const u2 constantIndex =
+                            ((ATTR_ConstantValue*)javaClass->raw
+                                 .fields[fieldOffset]
+                                 .attributes[fieldAttr])
+                                ->constantValueIndex;
+                        switch (cp.tag(constantIndex)) {
+                            case TAG_Long:
+                                ((JLong*)basicField)->val =
+                                    cp.longValue(constantIndex);
+                                break;
+                            case TAG_Double:
+                                ((JDouble*)basicField)->val =
+                                    cp.doubleValue(constantIndex);
+                                break;
+                            case TAG_Float:
+                                ((JFloat*)basicField)->val =
+                                    cp.floatValue(constantIndex);
+                                break;
+                            case TAG_Integer:
+                                ((JInt*)basicField)->val =
+                                    cp.intValue(constantIndex);
+                                break;
+                            default:
+                                SHOULD_NOT_REACH_HERE
                         }
                     }
                 }
@@ -189,16 +182,158 @@ void MethodArea::linkJavaClass(const string& jcName) {
             }
         }
     }
-    linkedClasses.insert(javaClass->getClassName());
+    linkVirtualMethods(javaClass);
+    linkedClasses.insert(javaClass->getClassSymbol());
+    javaClass->linked.store(true, memory_order_release);
+}
+
+//--------------------------------------------------------------------------------
+// Build vtable and itables of given class. A class inherits vtable of its
+// superclass, its own instance methods either override an inherited entry or
+// are appended to the end. Interface methods that are not implemented by the
+// class are appended as well, so that each itable entry refers to a vtable
+// slot. An interface has no superclass vtable, its vtable lists methods of
+// itself and its superinterfaces in declaration order
+//--------------------------------------------------------------------------------
+void MethodArea::linkVirtualMethods(JavaClass* jc) {
+    const bool isInterface = IS_CLASS_INTERFACE(jc->getAccessFlag());
+    if (!isInterface && jc->hasSuperClass()) {
+        const string& superClassName = jc->getSuperClassName();
+        JavaClass* superClass = loadClassIfAbsent(superClassName);
+        if (superClass != nullptr) {
+            linkClassIfAbsent(superClassName);
+            jc->vtable = superClass->vtable;
+            jc->itables = superClass->itables;
+        }
+    }
+
+    FOR_EACH(i, jc->raw.methodsCount) {
+        MethodInfo* m = &jc->raw.methods[i];
+        if (IS_METHOD_STATIC(m->accessFlags) ||
+            IS_METHOD_PRIVATE(m->accessFlags) ||
+            jc->getUtf8(m->nameIndex)[0] == '<') {
+            continue;
+        }
+        const int index = jc->findVirtualMethod(
+            jc->getSymbol(m->nameIndex), jc->getSymbol(m->descriptorIndex));
+        if (index >= 0) {
+            addOverrider(jc->vtable[index].method, jc);
+            jc->vtable[index] = VirtualMethod{jc, m};
+        } else {
+            jc->vtable.push_back(VirtualMethod{jc, m});
+        }
+    }
+
+    // Collect direct superinterfaces and theirs
+    vector<const JavaClass*> interfaces;
+    FOR_EACH(i, jc->getInterfaceCount()) {
+        const string& interfaceName = jc->getInterfaceClassName(i);
+        const JavaClass* interfaceClass = loadClassIfAbsent(interfaceName);
+        if (interfaceClass == nullptr) {
+            continue;
+        }
+        linkClassIfAbsent(interfaceName);
+        interfaces.push_back(interfaceClass);
+        for (const auto& itable : interfaceClass->itables) {
+            interfaces.push_back(itable.interfaceClass);
+        }
+    }
+
+    for (const JavaClass* interfaceClass : interfaces) {
+        if (interfaceClass->vtable.empty() ||
+            jc->findInterfaceMethod(interfaceClass, 0) >= 0) {
+            continue;
+        }
+        InterfaceTable itable{interfaceClass, {}};
+        for (const auto& vm : interfaceClass->vtable) {
+            const Symbol* name = vm.jc->getSymbol(vm.method->nameIndex);
+            const Symbol* descriptor =
+                vm.jc->getSymbol(vm.method->descriptorIndex);
+            int index = jc->findVirtualMethod(name, descriptor);
+            if (index < 0) {
+                index = static_cast<int>(jc->vtable.size());
+                jc->vtable.push_back(vm);
+            } else if (IS_CLASS_INTERFACE(
+                           jc->vtable[index].jc->getAccessFlag()) &&
+                       IS_METHOD_ABSTRACT(
+                           jc->vtable[index].method->accessFlags) &&
+                       !IS_METHOD_ABSTRACT(vm.method->accessFlags)) {
+                // A default method implements an abstract one
+                jc->vtable[index] = vm;
+            }
+            itable.vtableIndexes.push_back(static_cast<u2>(index));
+        }
+        jc->itables.push_back(itable);
+    }
+}
+
+void MethodArea::addOverrider(const MethodInfo* m, const JavaClass* jc) {
+    overriders[m].push_back(jc);
+    const auto pos = dependents.find(m);
+    if (pos == dependents.end()) {
+        return;
+    }
+    auto& list = pos->second;
+    for (auto it = list.begin(); it != list.end();) {
+        if (isSubclassOf(jc, it->base)) {
+            TemplateJIT::invalidate(it->decoded, it->compiled);
+            it = list.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool MethodArea::isSubclassOf(const JavaClass* jc, const JavaClass* base) {
+    while (jc != nullptr && jc != base) {
+        jc = jc->hasSuperClass() ? findJavaClass(jc->getSuperClassSymbol())
+                                 : nullptr;
+    }
+    return jc != nullptr;
+}
+
+bool MethodArea::isEffectivelyFinal(const JavaClass* base,
+                                    const MethodInfo* m) {
+    lock_guard<recursive_mutex> lockMA(maMutex);
+
+    const auto pos = overriders.find(m);
+    if (pos == overriders.end()) {
+        return true;
+    }
+    // Overriders in other branches of the hierarchy are never receivers
+    for (const JavaClass* jc : pos->second) {
+        if (isSubclassOf(jc, base)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MethodArea::publishDependent(DecodedCode* decoded,
+                                  CompiledMethod* compiled) {
+    lock_guard<recursive_mutex> lockMA(maMutex);
+
+    for (const auto& dependency : compiled->dependencies) {
+        if (!isEffectivelyFinal(dependency.first, dependency.second)) {
+            return false;
+        }
+    }
+    for (const auto& dependency : compiled->dependencies) {
+        dependents[dependency.second].push_back(
+            Dependent{dependency.first, decoded, compiled});
+    }
+    decoded->compiled.store(compiled, memory_order_release);
+    return true;
 }
 
 void MethodArea::initJavaClass(Interpreter& exec, const string& jcName) {
     lock_guard<recursive_mutex> lockMA(maMutex);
-    initedClasses.insert(jcName);
     auto* jc = findJavaClass(jcName);
+    initedClasses.insert(jc->getClassSymbol());
     if (jc->findMethod("<clinit>", "()V")) {
         exec.invokeByName(jc, "<clinit>", "()V");
     }
+    jc->initialized.store(true, memory_order_release);
 }
 
 JavaClass* MethodArea::loadClassIfAbsent(const string& jcName) {
@@ -212,16 +347,17 @@ JavaClass* MethodArea::loadClassIfAbsent(const string& jcName) {
     return findJavaClass(jcName);
 }
 
+JavaClass* MethodArea::loadClassIfAbsent(const Symbol* jcName) {
+    JavaClass* jc = findJavaClass(jcName);
+    return jc != nullptr ? jc : loadClassIfAbsent(jcName->str());
+}
+
 void MethodArea::linkClassIfAbsent(const string& jcName) {
     lock_guard<recursive_mutex> lockMA(maMutex);
 
-    bool linked = false;
-    for (auto p : linkedClasses) {
-        if (p == jcName) {
-            linked = true;
-        }
-    }
-    if (!linked) {
+    const Symbol* symbol = yrt.symbols->lookup(jcName);
+    if (symbol == nullptr ||
+        linkedClasses.find(symbol) == linkedClasses.end()) {
         linkJavaClass(jcName);
     }
 }
@@ -229,13 +365,9 @@ void MethodArea::linkClassIfAbsent(const string& jcName) {
 void MethodArea::initClassIfAbsent(Interpreter& exec, const string& jcName) {
     lock_guard<recursive_mutex> lockMA(maMutex);
 
-    bool inited = false;
-    for (auto p : initedClasses) {
-        if (p == jcName) {
-            inited = true;
-        }
-    }
-    if (!inited) {
+    const Symbol* symbol = yrt.symbols->lookup(jcName);
+    if (symbol == nullptr ||
+        initedClasses.find(symbol) == initedClasses.end()) {
         initJavaClass(exec, jcName);
     }
 }
@@ -243,7 +375,7 @@ void MethodArea::initClassIfAbsent(Interpreter& exec, const string& jcName) {
 bool MethodArea::removeJavaClass(const string& jcName) {
     lock_guard<recursive_mutex> lockMA(maMutex);
 
-    auto pos = classTable.find(jcName);
+    auto pos = classTable.find(yrt.symbols->lookup(jcName));
     if (pos != classTable.end()) {
         classTable.erase(pos);
         return true;
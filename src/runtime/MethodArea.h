@@ -15,13 +15,17 @@ using namespace std;
 class Interpreter;
 class JavaClass;
 class ConcurrentGC;
+class Symbol;
+struct CompiledMethod;
+struct DecodedCode;
 
 //--------------------------------------------------------------------------------
 // Method area has responsible to manage all JavaClass objects. A complete
 // lifecycle of java class consists of loading class into jvm, linking those
 // loaded JavaClass which would initialize its static fields and finally
 // initializing them. findJavaClass() used to check if there is a specific
-// JavaClass existed in global class table.
+// JavaClass existed in global class table. Tables are keyed by interned class
+// name symbols, see SymbolTable
 //--------------------------------------------------------------------------------
 class MethodArea {
     friend class ConcurrentGC;
@@ -31,6 +35,7 @@ public:
     ~MethodArea();
 
     JavaClass* findJavaClass(const string& jcName);
+    JavaClass* findJavaClass(const Symbol* jcName);
     bool loadJavaClass(const string& jcName);
     bool removeJavaClass(const string& jcName);
     void linkJavaClass(const string& jcName);
@@ -38,18 +43,43 @@ public:
 
 public:
     JavaClass* loadClassIfAbsent(const string& jcName);
+    JavaClass* loadClassIfAbsent(const Symbol* jcName);
     void linkClassIfAbsent(const string& jcName);
     void initClassIfAbsent(Interpreter& exec, const string& jcName);
 
+public:
+    // Class hierarchy analysis. A virtual method is effectively final for
+    // receivers of class base if no subclass of base loaded so far overrides
+    // it. Code compiled for decoded that relies on it registers itself as its
+    // dependent, which is invalidated as soon as such a subclass is linked.
+    // Registering and publishing the code on decoded happen under the lock
+    // linking takes, so no such subclass is linked in between. Nothing is
+    // registered nor published if one already was
+    bool isEffectivelyFinal(const JavaClass* base, const MethodInfo* m);
+    bool publishDependent(DecodedCode* decoded, CompiledMethod* compiled);
+
 private:
     const string parseNameToPath(const string& name);
+    void linkVirtualMethods(JavaClass* jc);
+    void addOverrider(const MethodInfo* m, const JavaClass* jc);
+    bool isSubclassOf(const JavaClass* jc, const JavaClass* base);
 
 private:
     recursive_mutex maMutex;
 
-    unordered_set<string> linkedClasses;
-    unordered_set<string> initedClasses;
-    unordered_map<string, JavaClass*> classTable;
+    unordered_set<const Symbol*> linkedClasses;
+    unordered_set<const Symbol*> initedClasses;
+    unordered_map<const Symbol*, JavaClass*> classTable;
+
+    // Classes overriding each method, and compiled code depending on each
+    // method not being overridden by subclasses of a class
+    struct Dependent {
+        const JavaClass* base;
+        DecodedCode* decoded;
+        CompiledMethod* compiled;
+    };
+    unordered_map<const MethodInfo*, vector<const JavaClass*>> overriders;
+    unordered_map<const MethodInfo*, vector<Dependent>> dependents;
 
     vector<string> searchPaths;
 };
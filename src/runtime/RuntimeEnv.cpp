@@ -1,11 +1,22 @@
 #include "../gc/GC.h"
+#include "../misc/Option.h"
 #include "JavaHeap.hpp"
 #include "MethodArea.h"
 #include "RuntimeEnv.h"
+#include "SymbolTable.h"
 
 RuntimeEnv yrt;
 
-RuntimeEnv::RuntimeEnv():ma(nullptr) {
+RuntimeEnv::RuntimeEnv()
+    : ma(nullptr),
+      jit(false),
+      jitThreshold(YVM_JIT_THRESHOLD),
+      osrThreshold(YVM_OSR_THRESHOLD),
+      opt(false),
+      trace(false),
+      traceThreshold(YVM_TRACE_THRESHOLD),
+      aot(false) {
+    symbols = new SymbolTable;
     jheap = new JavaHeap;
     gc = new ConcurrentGC;
 }
@@ -13,4 +24,5 @@ RuntimeEnv::RuntimeEnv():ma(nullptr) {
 RuntimeEnv::~RuntimeEnv() {
     delete ma;
     delete jheap;
+    delete symbols;
 }
@@ -8,16 +8,34 @@ class JavaFrame;
 class JavaHeap;
 class MethodArea;
 class ConcurrentGC;
+class SymbolTable;
 
 struct RuntimeEnv {
     RuntimeEnv();
     ~RuntimeEnv();
 
+    SymbolTable* symbols;
     MethodArea* ma;
     JavaHeap* jheap;
     std::unordered_map<std::string, JType* (*)(RuntimeEnv* env, JType**,int)>
         nativeMethods;
     ConcurrentGC* gc;
+    // Compile hot methods into machine code, see TemplateJIT. A method is hot
+    // after jitThreshold invocations, or osrThreshold iterations of one of
+    // its loops
+    bool jit;
+    unsigned jitThreshold;
+    unsigned osrThreshold;
+    // Compile hot methods through register IR and its optimizer instead of
+    // stitching templates, see OptimizingJIT
+    bool opt;
+    // Record and compile traces of hot loops instead of moving their methods
+    // into compiled code, see TraceJIT. A loop is hot after traceThreshold
+    // iterations
+    bool trace;
+    unsigned traceThreshold;
+    // Bind methods compiled ahead of time by yvm-aot, see AotLoader
+    bool aot;
 };
 
 extern RuntimeEnv yrt;
@@ -0,0 +1,31 @@
+#include "SymbolTable.h"
+
+using namespace std;
+
+SymbolTable::SymbolTable() {
+    initName = intern("<init>");
+    invokeName = intern("invoke");
+    invokeExtractName = intern("invokeExtract");
+    methodHandleName = intern("java/lang/invoke/MethodHandle");
+}
+
+const Symbol* SymbolTable::intern(const string& text) {
+    lock_guard<mutex> lock(tableMutex);
+
+    auto& symbol = symbols[text];
+    if (!symbol) {
+        symbol.reset(new Symbol(text));
+    }
+    return symbol.get();
+}
+
+const Symbol* SymbolTable::intern(const char* bytes, size_t length) {
+    return intern(string(bytes, length));
+}
+
+const Symbol* SymbolTable::lookup(const string& text) {
+    lock_guard<mutex> lock(tableMutex);
+
+    const auto pos = symbols.find(text);
+    return pos != symbols.end() ? pos->second.get() : nullptr;
+}
@@ -0,0 +1,51 @@
+#ifndef YVM_SYMBOLTABLE_H
+#define YVM_SYMBOLTABLE_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+//--------------------------------------------------------------------------------
+// Symbol is an interned UTF-8 string such as a class, method or field name.
+// There is exactly one Symbol for each distinct string in the process, so two
+// symbols are equal if and only if they are the same object
+//--------------------------------------------------------------------------------
+class Symbol {
+    friend class SymbolTable;
+
+public:
+    const std::string& str() const { return text; }
+
+private:
+    explicit Symbol(std::string text) : text(std::move(text)) {}
+
+    const std::string text;
+};
+
+//--------------------------------------------------------------------------------
+// Process-wide symbol table. Utf8 constants are interned when class files were
+// parsed, lookup() finds the symbol of a string without creating it, a string
+// that was never interned can not be the name of any loaded member
+//--------------------------------------------------------------------------------
+class SymbolTable {
+public:
+    SymbolTable();
+
+    const Symbol* intern(const std::string& text);
+    const Symbol* intern(const char* bytes, size_t length);
+    const Symbol* lookup(const std::string& text);
+
+    // Names that invocations check, interned up front so that checking them
+    // is a pointer comparison
+    const Symbol* initName;
+    const Symbol* invokeName;
+    const Symbol* invokeExtractName;
+    const Symbol* methodHandleName;
+
+private:
+    std::mutex tableMutex;
+    std::unordered_map<std::string, std::unique_ptr<Symbol>> symbols;
+};
+
+#endif  // YVM_SYMBOLTABLE_H
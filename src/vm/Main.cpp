@@ -1,5 +1,7 @@
 #include <boost/program_options.hpp>
 #include <iostream>
+#include <stdexcept>
+#include "../aot/AotLoader.h"
 #include "../misc/Option.h"
 #include "YVM.h"
 
@@ -11,7 +13,19 @@ int main(int argc, char* argv[]) {
     opts.add_options()("help", "List help documentations and usages.")(
         "runtime", value<std::vector<std::string>>(),
         "Attach java runtime libraries where yvm would lookup classes at")(
-        "run", value<std::string>(), "Program which would be executed soon");
+        "run", value<std::string>(), "Program which would be executed soon")(
+        "jit", "Compile hot methods into native code")(
+        "jit-threshold", value<unsigned>(),
+        "Invocations of a method before it's compiled")(
+        "osr-threshold", value<unsigned>(),
+        "Iterations of a loop before its running method is compiled")(
+        "opt", "Optimize hot methods before compiling them, implies --jit")(
+        "trace", "Record and compile traces of hot loops")(
+        "trace-threshold", value<unsigned>(),
+        "Iterations of a loop before its trace is recorded")(
+        "aot", value<std::vector<std::string>>(),
+        "Bind methods compiled ahead of time into given shared objects by "
+        "yvm-aot");
     positional_options_description p;
     p.add("run", -1);
 
@@ -37,6 +51,28 @@ int main(int argc, char* argv[]) {
     }
 
     // Create virtual machine and executing code
+    yrt.opt = vm.count("opt") > 0;
+    yrt.jit = vm.count("jit") > 0 || yrt.opt;
+    if (vm.count("jit-threshold")) {
+        yrt.jitThreshold = vm["jit-threshold"].as<unsigned>();
+    }
+    if (vm.count("osr-threshold")) {
+        yrt.osrThreshold = vm["osr-threshold"].as<unsigned>();
+    }
+    yrt.trace = vm.count("trace") > 0;
+    if (vm.count("trace-threshold")) {
+        yrt.traceThreshold = vm["trace-threshold"].as<unsigned>();
+    }
+    if (vm.count("aot")) {
+        try {
+            for (const auto& path : vm["aot"].as<std::vector<std::string>>()) {
+                AotLoader::load(path);
+            }
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Fatal error: " << e.what() << "\n";
+            return 1;
+        }
+    }
     YVM yvm;
     yvm.warmUp(vm["runtime"].as<std::vector<std::string>>());
     std::string internalUsedClassName{vm["run"].as<std::string>()};
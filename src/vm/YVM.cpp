@@ -92,13 +92,19 @@ void YVM::callMain(const std::string& name) {
         exec.invokeByName(jc, "main", "([Ljava/lang/String;)V");
     });
 
-    // Block until all sub threads accomplished its task
-    for (const auto& start : executor.getTaskFutures()) {
-        start.get();
-    }
     // Block until main thread accomplished;
     mainFuture.get();
 
+    // Block until all sub threads accomplished its task. Threads may start
+    // other threads before they finish, so wait until no new one shows up
+    size_t waited = 0;
+    for (auto futures = executor.getTaskFutures(); waited < futures.size();
+         futures = executor.getTaskFutures()) {
+        for (; waited < futures.size(); waited++) {
+            futures[waited].get();
+        }
+    }
+
     // Close garbage collection. This is optional since operation system would
     // release all resources when process exited
     yrt.gc->terminateGC();
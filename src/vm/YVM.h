@@ -24,13 +24,16 @@ struct YVM {
         }
         size_t getThreadNum() const { return threads.size(); }
         void storeTaskFuture(shared_future<void> taskFuture) {
+            lock_guard<mutex> lock(taskFuturesMtx);
             taskFutures.push_back(taskFuture);
         }
-        vector<shared_future<void>> getTaskFutures() const {
+        vector<shared_future<void>> getTaskFutures() {
+            lock_guard<mutex> lock(taskFuturesMtx);
             return taskFutures;
         }
 
     private:
+        mutex taskFuturesMtx;
         vector<shared_future<void>> taskFutures;
     };
     static ExecutorThreadPool executor;